@@ -2845,6 +2845,8 @@ bool CApplication::Cleanup()
     delete m_network;
     m_network = NULL;
 
+    CDatabaseManager::GetInstance().Deinitialize();
+
     // Cleanup was called more than once on exit during my tests
     if (m_ServiceManager)
     {
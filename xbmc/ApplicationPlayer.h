@@ -43,6 +43,7 @@ namespace PVR
 }
 
 class CAction;
+class CVariant;
 class CPlayerOptions;
 class CStreamDetails;
 
@@ -99,6 +100,7 @@ public:
   void RenderCapture(unsigned int captureId, unsigned int width, unsigned int height, int flags = 0);
   void RenderCaptureRelease(unsigned int captureId);
   bool RenderCaptureGetPixels(unsigned int captureId, unsigned int millis, uint8_t *buffer, unsigned int size);
+  bool GetFramePacing(CVariant &info, bool samples);
   bool IsExternalPlaying();
 
   // proxy calls
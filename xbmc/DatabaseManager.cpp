@@ -70,6 +70,8 @@ void CDatabaseManager::Initialize(bool addonsOnly)
 
 void CDatabaseManager::Deinitialize()
 {
+  m_connectionPool.Clear();
+
   CSingleLock lock(m_section);
   m_dbStatus.clear();
 }
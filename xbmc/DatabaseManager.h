@@ -22,6 +22,7 @@
 
 #include <map>
 #include <string>
+#include "dbwrappers/DatabaseConnectionPool.h"
 #include "threads/CriticalSection.h"
 
 class CDatabase;
@@ -50,6 +51,7 @@ public:
   void Initialize(bool addonsOnly = false);
 
   /*! \brief Deinitialize the database manager
+   Disconnects the connections kept by the connection pool.
    */
   void Deinitialize();
 
@@ -64,6 +66,17 @@ public:
    */ 
   bool CanOpen(const std::string &name);
 
+  /*! \brief The connections shared by all databases, see CDatabase::Open().
+   */
+  CDatabaseConnectionPool &GetConnectionPool() { return m_connectionPool; }
+
+  /*! \brief Update a database and mark it as ready to be opened.
+   Used by Initialize() for every database, and by tests that use a database of their own.
+   \param db the database to update.
+   \param settings the settings the database is opened with, the defaults if NULL.
+   */
+  void UpdateDatabase(CDatabase &db, DatabaseSettings *settings = NULL);
+
 private:
   // private construction, and no assignements; use the provided singleton methods
   CDatabaseManager();
@@ -73,8 +86,8 @@ private:
 
   enum DB_STATUS { DB_CLOSED, DB_UPDATING, DB_READY, DB_FAILED };
   void UpdateStatus(const std::string &name, DB_STATUS status);
-  void UpdateDatabase(CDatabase &db, DatabaseSettings *settings = NULL);
 
   CCriticalSection            m_section;     ///< Critical section protecting m_dbStatus.
   std::map<std::string, DB_STATUS> m_dbStatus;    ///< Our database status map.
+  CDatabaseConnectionPool     m_connectionPool;
 };
@@ -23,6 +23,7 @@
 #include "Util.h"
 #include "filesystem/File.h"
 #include "utils/log.h"
+#include "utils/RegExp.h"
 #include "utils/URIUtils.h"
 
 CInfoScanner::~CInfoScanner() {}
@@ -34,6 +35,12 @@ bool CInfoScanner::HasNoMedia(const std::string &strDirectory) const
 }
 
 bool CInfoScanner::IsExcluded(const std::string& strDirectory, const std::vector<std::string> &regexps)
+{
+  std::vector<CRegExp> compiled = CUtil::CompileExcludeRegExps(regexps);
+  return IsExcluded(strDirectory, compiled);
+}
+
+bool CInfoScanner::IsExcluded(const std::string& strDirectory, std::vector<CRegExp> &regexps)
 {
   if (CUtil::ExcludeFileOrFolder(strDirectory, regexps))
     return true;
@@ -21,6 +21,8 @@
 #include <string>
 #include <vector>
 
+class CRegExp;
+
 class CInfoScanner
 {
 public:
@@ -32,6 +34,7 @@ public:
    \return true if there is a .nomedia file or one of the regexps is a match
    */
   bool IsExcluded(const std::string& strDirectory, const std::vector<std::string> &regexps);
+  bool IsExcluded(const std::string& strDirectory, std::vector<CRegExp> &regexps);
 private:
   bool HasNoMedia(const std::string& strDirectory) const;
 };
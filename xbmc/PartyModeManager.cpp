@@ -21,14 +21,19 @@
 #include "PartyModeManager.h"
 
 #include <algorithm>
+#include <cstring>
+#include <map>
 
 #include "Application.h"
+#include "FileItem.h"
 #include "dialogs/GUIDialogOK.h"
 #include "dialogs/GUIDialogProgress.h"
 #include "guilib/GUIWindowManager.h"
 #include "GUIUserMessages.h"
 #include "interfaces/AnnouncementManager.h"
+#include "media/MediaType.h"
 #include "music/MusicDatabase.h"
+#include "music/tags/MusicInfoTag.h"
 #include "music/windows/GUIWindowMusicPlaylist.h"
 #include "PlayListPlayer.h"
 #include "playlists/PlayList.h"
@@ -40,10 +45,13 @@
 #include "utils/StringUtils.h"
 #include "utils/Variant.h"
 #include "video/VideoDatabase.h"
+#include "video/VideoInfoTag.h"
 
 using namespace PLAYLIST;
 
 #define QUEUE_DEPTH       10
+// number of changed items above which the pools are reloaded instead of updated
+#define MAX_CHANGES       1000
 
 CPartyModeManager::CPartyModeManager(void)
 {
@@ -112,7 +120,6 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
 
   ClearState();
   unsigned int time = XbmcThreads::SystemClockMillis();
-  std::vector< std::pair<int,int> > songIDs;
   if (StringUtils::EqualsNoCase(m_type, "songs") ||
       StringUtils::EqualsNoCase(m_type, "mixed"))
   {
@@ -124,7 +131,7 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
         m_strCurrentFilterMusic = playlist.GetWhereClause(db, playlists);
 
       CLog::Log(LOGINFO, "PARTY MODE MANAGER: Registering filter:[%s]", m_strCurrentFilterMusic.c_str());
-      m_iMatchingSongs = (int)db.GetSongIDs(m_strCurrentFilterMusic, songIDs);
+      m_iMatchingSongs = (int)db.GetSongIDs(m_strCurrentFilterMusic, m_songPool);
       if (m_iMatchingSongs < 1 && StringUtils::EqualsNoCase(m_type, "songs"))
       {
         pDialog->Close();
@@ -145,7 +152,6 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
   if (StringUtils::EqualsNoCase(m_type, "musicvideos") ||
       StringUtils::EqualsNoCase(m_type, "mixed"))
   {
-    std::vector< std::pair<int,int> > songIDs2;
     CVideoDatabase db;
     if (db.Open())
     {
@@ -154,7 +160,7 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
         m_strCurrentFilterVideo = playlist.GetWhereClause(db, playlists);
 
       CLog::Log(LOGINFO, "PARTY MODE MANAGER: Registering filter:[%s]", m_strCurrentFilterVideo.c_str());
-      m_iMatchingSongs += (int)db.GetMusicVideoIDs(m_strCurrentFilterVideo, songIDs2);
+      m_iMatchingSongs += (int)db.GetMusicVideoIDs(m_strCurrentFilterVideo, m_videoPool);
       if (m_iMatchingSongs < 1)
       {
         pDialog->Close();
@@ -170,7 +176,6 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
       return false;
     }
     db.Close();
-    songIDs.insert(songIDs.end(),songIDs2.begin(),songIDs2.end());
   }
 
   // calculate history size
@@ -193,7 +198,7 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
   pDialog->SetLine(0, CVariant{m_bIsVideo ? 20252 : 20124});
   pDialog->Progress();
   // add initial songs
-  if (!AddInitialSongs(songIDs))
+  if (!AddInitialSongs())
   {
     pDialog->Close();
     return false;
@@ -215,6 +220,8 @@ bool CPartyModeManager::Enable(PartyModeContext context /*= PARTYMODECONTEXT_MUS
 
   // done
   m_bEnabled = true;
+  ANNOUNCEMENT::CAnnouncementManager::GetInstance().RemoveAnnouncer(this);
+  ANNOUNCEMENT::CAnnouncementManager::GetInstance().AddAnnouncer(this);
   Announce();
   return true;
 }
@@ -224,6 +231,7 @@ void CPartyModeManager::Disable()
   if (!IsEnabled())
     return;
   m_bEnabled = false;
+  ANNOUNCEMENT::CAnnouncementManager::GetInstance().RemoveAnnouncer(this);
   Announce();
   CLog::Log(LOGINFO,"PARTY MODE MANAGER: Party mode disabled.");
 }
@@ -300,6 +308,7 @@ void CPartyModeManager::Process()
 {
   ReapSongs();
   MovePlaying();
+  UpdatePools();
   AddRandomSongs();
   UpdateStats();
   SendUpdateMessage();
@@ -334,106 +343,112 @@ bool CPartyModeManager::AddRandomSongs(int iSongs /* = 0 */)
       while (iSongsToAdd+iVidsToAdd < iSongs) // correct any rounding by adding songs
         iSongsToAdd++;
     }
+    // nothing matches of one type, take the other
+    if (m_songPool.IsEmpty())
+    {
+      iVidsToAdd += iSongsToAdd;
+      iSongsToAdd = 0;
+    }
+    else if (m_videoPool.IsEmpty())
+    {
+      iSongsToAdd += iVidsToAdd;
+      iVidsToAdd = 0;
+    }
   }
 
+  if (!StringUtils::EqualsNoCase(m_type, "songs") && !StringUtils::EqualsNoCase(m_type, "mixed"))
+    iSongsToAdd = 0;
+  if (!StringUtils::EqualsNoCase(m_type, "musicvideos") && !StringUtils::EqualsNoCase(m_type, "mixed"))
+    iVidsToAdd = 0;
+
   // add songs to fill queue
-  if (StringUtils::EqualsNoCase(m_type, "songs") ||
-      StringUtils::EqualsNoCase(m_type, "mixed"))
+  if (iSongsToAdd + iVidsToAdd > 0 && !AddPickedSongs(iSongsToAdd, iVidsToAdd))
   {
-    CMusicDatabase database;
-    if (database.Open())
-    {
-      // Method:
-      // 1. Grab a random entry from the database using a where clause
-      // 2. Iterate on iSongs.
-
-      // Note: At present, this method is faster than the alternative, which is to grab
-      // all valid songids, then select a random number of them (as done in AddInitialSongs()).
-      // The reason for this is simply the number of songs we are requesting - we generally
-      // only want one here.  Any more than about 3 songs and it is more efficient
-      // to use the technique in AddInitialSongs.  As it's unlikely that we'll require
-      // more than 1 song at a time here, this method is faster.
-      bool error(false);
-      for (int i = 0; i < iSongsToAdd; i++)
-      {
-        std::pair<std::string,std::string> whereClause = GetWhereClauseWithHistory();
-        CFileItemPtr item(new CFileItem);
-        int songID;
-        if (database.GetRandomSong(item.get(), songID, whereClause.first))
-        { // success
-          Add(item);
-          AddToHistory(1,songID);
-        }
-        else
-        {
-          error = true;
-          break;
-        }
-      }
+    OnError(16034, (std::string)"Cannot get songs from database. Aborting.");
+    return false;
+  }
+  return true;
+}
 
-      if (error)
-      {
-        database.Close();
-        OnError(16034, (std::string)"Cannot get songs from database. Aborting.");
-        return false;
-      }
-    }
+bool CPartyModeManager::AddPickedSongs(int iSongs, int iVideos)
+{
+  // pick the songs, none of them recently played or picked twice
+  std::vector< std::pair<int,int> > picked;
+  std::unordered_set<int> exclude = GetHistory(1);
+  for (int i = 0; i < iSongs; i++)
+  {
+    int songID = m_songPool.Pick(exclude);
+    if (songID < 0)
+      break;
+    exclude.insert(songID);
+    picked.push_back(std::make_pair(1, songID));
+  }
+  exclude = GetHistory(2);
+  for (int i = 0; i < iVideos; i++)
+  {
+    int songID = m_videoPool.Pick(exclude);
+    if (songID < 0)
+      break;
+    exclude.insert(songID);
+    picked.push_back(std::make_pair(2, songID));
+  }
+  if (picked.empty())
+    return false;
+  if (iSongs > 0 && iVideos > 0)
+    KODI::UTILS::RandomShuffle(picked.begin(), picked.end());
+
+  std::vector<std::string> songs;
+  std::vector<std::string> videos;
+  for (std::vector< std::pair<int,int> >::const_iterator it = picked.begin(); it != picked.end(); ++it)
+  {
+    std::string song = StringUtils::Format("%i", it->second);
+    if (it->first == 1)
+      songs.push_back(song);
     else
-    {
-      OnError(16033, (std::string)"Party mode could not open database. Aborting.");
+      videos.push_back(song);
+  }
+
+  // fetch all of them at once
+  std::map<std::pair<int,int>, CFileItemPtr> fetched;
+  if (!songs.empty())
+  {
+    CFileItemList items;
+    CMusicDatabase database;
+    if (!database.Open())
       return false;
-    }
-    database.Close();
+    database.GetSongsByWhere("musicdb://songs/", "songview.idSong IN (" + StringUtils::Join(songs, ",") + ")", items);
+    for (int i = 0; i < items.Size(); i++)
+      fetched[std::make_pair(1, items[i]->GetMusicInfoTag()->GetDatabaseId())] = items[i];
   }
-  if (StringUtils::EqualsNoCase(m_type, "musicvideos") ||
-      StringUtils::EqualsNoCase(m_type, "mixed"))
+  if (!videos.empty())
   {
+    CFileItemList items;
     CVideoDatabase database;
-    if (database.Open())
-    {
-      // Method:
-      // 1. Grab a random entry from the database using a where clause
-      // 2. Iterate on iSongs.
-
-      // Note: At present, this method is faster than the alternative, which is to grab
-      // all valid songids, then select a random number of them (as done in AddInitialSongs()).
-      // The reason for this is simply the number of songs we are requesting - we generally
-      // only want one here.  Any more than about 3 songs and it is more efficient
-      // to use the technique in AddInitialSongs.  As it's unlikely that we'll require
-      // more than 1 song at a time here, this method is faster.
-      bool error(false);
-      for (int i = 0; i < iVidsToAdd; i++)
-      {
-        std::pair<std::string,std::string> whereClause = GetWhereClauseWithHistory();
-        CFileItemPtr item(new CFileItem);
-        int songID;
-        if (database.GetRandomMusicVideo(item.get(), songID, whereClause.second))
-        { // success
-          Add(item);
-          AddToHistory(2,songID);
-        }
-        else
-        {
-          error = true;
-          break;
-        }
-      }
+    if (!database.Open())
+      return false;
+    database.GetMusicVideosByWhere("videodb://musicvideos/titles/", "idMVideo IN (" + StringUtils::Join(videos, ",") + ")", items);
+    for (int i = 0; i < items.Size(); i++)
+      fetched[std::make_pair(2, items[i]->GetVideoInfoTag()->m_iDbId)] = items[i];
+  }
 
-      if (error)
-      {
-        database.Close();
-        OnError(16034, (std::string)"Cannot get songs from database. Aborting.");
-        return false;
-      }
-    }
-    else
+  bool added = false;
+  for (std::vector< std::pair<int,int> >::const_iterator it = picked.begin(); it != picked.end(); ++it)
+  {
+    std::map<std::pair<int,int>, CFileItemPtr>::iterator item = fetched.find(*it);
+    if (item == fetched.end())
     {
-      OnError(16033, (std::string)"Party mode could not open database. Aborting.");
-      return false;
+      // removed from the library without us being told
+      if (it->first == 1)
+        m_songPool.Remove(it->second);
+      else
+        m_videoPool.Remove(it->second);
+      continue;
     }
-    database.Close();
+    Add(item->second);
+    AddToHistory(it->first, it->second);
+    added = true;
   }
-  return true;
+  return added;
 }
 
 void CPartyModeManager::Add(CFileItemPtr &pItem)
@@ -519,6 +534,7 @@ void CPartyModeManager::OnError(int iError, const std::string&  strLogMessage)
   CGUIDialogOK::ShowAndGetInput(CVariant{257}, CVariant{16030}, CVariant{iError}, CVariant{0});
   CLog::Log(LOGERROR, "PARTY MODE MANAGER: %s", strLogMessage.c_str());
   m_bEnabled = false;
+  ANNOUNCEMENT::CAnnouncementManager::GetInstance().RemoveAnnouncer(this);
   SendUpdateMessage();
 }
 
@@ -587,6 +603,14 @@ void CPartyModeManager::ClearState()
 
   m_songsInHistory = 0;
   m_history.clear();
+
+  m_songPool.Clear();
+  m_videoPool.Clear();
+  CSingleLock lock(m_changesSection);
+  m_changedSongs.clear();
+  m_changedVideos.clear();
+  m_reloadSongs = false;
+  m_reloadVideos = false;
 }
 
 void CPartyModeManager::UpdateStats()
@@ -596,7 +620,7 @@ void CPartyModeManager::UpdateStats()
   m_iRelaxedSongs = 0;  // unsupported at this stage
 }
 
-bool CPartyModeManager::AddInitialSongs(std::vector< std::pair<int,int > > &songIDs)
+bool CPartyModeManager::AddInitialSongs()
 {
   int iPlaylist = m_bIsVideo ? PLAYLIST_VIDEO : PLAYLIST_MUSIC;
 
@@ -604,98 +628,148 @@ bool CPartyModeManager::AddInitialSongs(std::vector< std::pair<int,int > > &song
   int iMissingSongs = QUEUE_DEPTH - playlist.size();
   if (iMissingSongs > 0)
   {
-    // generate iMissingSongs random ids from songIDs
-    if (iMissingSongs > (int)songIDs.size())
+    int songs = static_cast<int>(m_songPool.Size());
+    int videos = static_cast<int>(m_videoPool.Size());
+    if (iMissingSongs > songs + videos)
       return false; // can't do it if we have less songs than we need
 
-    std::vector<std::pair<int,int> > chosenSongIDs;
-    GetRandomSelection(songIDs, iMissingSongs, chosenSongIDs);
-    std::string sqlWhereMusic = "songview.idSong IN (";
-    std::string sqlWhereVideo = "idMVideo IN (";
-
-    for (std::vector< std::pair<int,int> >::iterator it = chosenSongIDs.begin(); it != chosenSongIDs.end(); ++it)
+    // split between the types by the number of matching items
+    int iSongsToAdd = 0;
+    for (int i = 0; i < iMissingSongs; i++)
     {
-      std::string song = StringUtils::Format("%i,", it->second);
-      if (it->first == 1)
-        sqlWhereMusic += song;
-      if (it->first == 2)
-        sqlWhereVideo += song;
-    }
-    // add songs to fill queue
-    CFileItemList items;
-
-    if (sqlWhereMusic.size() > 26)
-    {
-      sqlWhereMusic[sqlWhereMusic.size() - 1] = ')'; // replace the last comma with closing bracket
-      CMusicDatabase database;
-      database.Open();
-      database.GetSongsByWhere("musicdb://songs/", sqlWhereMusic, items);
-    }
-    if (sqlWhereVideo.size() > 19)
-    {
-      sqlWhereVideo[sqlWhereVideo.size() - 1] = ')'; // replace the last comma with closing bracket
-      CVideoDatabase database;
-      database.Open();
-      database.GetMusicVideosByWhere("videodb://musicvideos/titles/", sqlWhereVideo, items);
+      if (static_cast<int>(m_songPool.Random(songs + videos)) < songs)
+        iSongsToAdd++;
     }
+    iSongsToAdd = std::max(iSongsToAdd, iMissingSongs - videos);
+    iSongsToAdd = std::min(iSongsToAdd, songs);
 
-    m_history = chosenSongIDs;
-    items.Randomize(); //randomizing the initial list or they will be in database order
-    for (int i = 0; i < items.Size(); i++)
-    {
-      CFileItemPtr item(items[i]);
-      Add(item);
-      //! @todo Allow "relaxed restrictions" later?
-    }
+    //! @todo Allow "relaxed restrictions" later?
+    if (!AddPickedSongs(iSongsToAdd, iMissingSongs - iSongsToAdd))
+      return false;
   }
   return true;
 }
 
-std::pair<std::string,std::string> CPartyModeManager::GetWhereClauseWithHistory() const
+std::unordered_set<int> CPartyModeManager::GetHistory(int type) const
 {
-  // now add this on to the normal where clause
-  std::vector<std::string> historyItemsMusic;
-  std::vector<std::string> historyItemsVideo;
-  for (unsigned int i = 0; i < m_history.size(); i++)
+  std::unordered_set<int> history;
+  for (std::vector< std::pair<int,int> >::const_iterator it = m_history.begin(); it != m_history.end(); ++it)
   {
-    std::string number = StringUtils::Format("%i", m_history[i].second);
-    if (m_history[i].first == 1)
-      historyItemsMusic.push_back(number);
-    if (m_history[i].first == 2)
-      historyItemsVideo.push_back(number);
+    if (it->first == type)
+      history.insert(it->second);
   }
+  return history;
+}
 
-  std::string historyWhereMusic;
-  if (!historyItemsMusic.empty())
+void CPartyModeManager::AddToHistory(int type, int songID)
+{
+  while (m_history.size() >= m_songsInHistory && m_songsInHistory)
+    m_history.erase(m_history.begin());
+  m_history.push_back(std::make_pair(type,songID));
+}
+
+void CPartyModeManager::UpdatePools()
+{
+  bool reloadSongs, reloadVideos;
+  std::set<int> changedSongs, changedVideos;
   {
-    if (!m_strCurrentFilterMusic.empty())
-      historyWhereMusic = m_strCurrentFilterMusic + " and ";
-    historyWhereMusic += "songview.idSong not in (" + StringUtils::Join(historyItemsMusic, ", ") + ")";
+    CSingleLock lock(m_changesSection);
+    reloadSongs = m_reloadSongs;
+    reloadVideos = m_reloadVideos;
+    changedSongs.swap(m_changedSongs);
+    changedVideos.swap(m_changedVideos);
+    m_reloadSongs = m_reloadVideos = false;
   }
 
-  std::string historyWhereVideo;
-  if (!historyItemsVideo.empty())
+  if (reloadSongs || !changedSongs.empty())
   {
-    if (!m_strCurrentFilterVideo.empty())
-      historyWhereVideo = m_strCurrentFilterVideo + " and ";
-    historyWhereVideo += "idMVideo not in (" + StringUtils::Join(historyItemsVideo, ", ") + ")";
+    CMusicDatabase db;
+    if (db.Open())
+    {
+      CDatabase::Filter filter(m_strCurrentFilterMusic);
+      if (reloadSongs)
+        m_songPool.Clear();
+      else
+      {
+        // take the changed songs out and put back those that still match
+        std::vector<int> ids(changedSongs.begin(), changedSongs.end());
+        for (std::vector<int>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+          m_songPool.Remove(*it);
+        filter.AppendWhere(db.PrepareSearchCondition("songview.idSong", ids));
+      }
+      db.GetSongIDs(filter, m_songPool);
+      db.Close();
+    }
   }
 
-  return std::make_pair(historyWhereMusic, historyWhereVideo);
-}
+  if (reloadVideos || !changedVideos.empty())
+  {
+    CVideoDatabase db;
+    if (db.Open())
+    {
+      std::string where = m_strCurrentFilterVideo;
+      if (reloadVideos)
+        m_videoPool.Clear();
+      else
+      {
+        std::vector<int> ids(changedVideos.begin(), changedVideos.end());
+        for (std::vector<int>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+          m_videoPool.Remove(*it);
+        std::string condition = db.PrepareSearchCondition("idMVideo", ids);
+        where = where.empty() ? condition : "(" + where + ") AND " + condition;
+      }
+      db.GetMusicVideoIDs(where, m_videoPool);
+      db.Close();
+    }
+  }
 
-void CPartyModeManager::AddToHistory(int type, int songID)
-{
-  while (m_history.size() >= m_songsInHistory && m_songsInHistory)
-    m_history.erase(m_history.begin());
-  m_history.push_back(std::make_pair(type,songID));
+  if (reloadSongs || reloadVideos || !changedSongs.empty() || !changedVideos.empty())
+  {
+    m_iMatchingSongs = static_cast<int>(m_songPool.Size() + m_videoPool.Size());
+    CLog::Log(LOGDEBUG, "PARTY MODE MANAGER: Updated %u songs and %u music videos, matching songs = %i",
+              static_cast<unsigned int>(changedSongs.size()), static_cast<unsigned int>(changedVideos.size()), m_iMatchingSongs);
+  }
 }
 
-void CPartyModeManager::GetRandomSelection(std::vector< std::pair<int,int> >& in, unsigned int number, std::vector< std::pair<int,int> >& out)
+void CPartyModeManager::Announce(ANNOUNCEMENT::AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
 {
-  number = std::min(number, (unsigned int)in.size());
-  KODI::UTILS::RandomShuffle(in.begin(), in.end());
-  out.assign(in.begin(), in.begin() + number);
+  bool music = flag == ANNOUNCEMENT::AudioLibrary;
+  if (!music && flag != ANNOUNCEMENT::VideoLibrary)
+    return;
+
+  CSingleLock lock(m_changesSection);
+  if (strcmp(message, "OnScanFinished") == 0 || strcmp(message, "OnCleanFinished") == 0)
+  {
+    // the filter may depend on albums, artists or paths that changed
+    if (music)
+      m_reloadSongs = true;
+    else
+      m_reloadVideos = true;
+    return;
+  }
+  if (strcmp(message, "OnUpdate") != 0 && strcmp(message, "OnRemove") != 0)
+    return;
+
+  const CVariant &item = data.isMember("item") ? data["item"] : data;
+  if (!item.isMember("type") || !item.isMember("id"))
+    return;
+  std::string type = item["type"].asString();
+  int id = static_cast<int>(item["id"].asInteger());
+  if (music && type == MediaTypeSong)
+    m_changedSongs.insert(id);
+  else if (!music && type == MediaTypeMusicVideo)
+    m_changedVideos.insert(id);
+
+  if (m_changedSongs.size() > MAX_CHANGES)
+  {
+    m_changedSongs.clear();
+    m_reloadSongs = true;
+  }
+  if (m_changedVideos.size() > MAX_CHANGES)
+  {
+    m_changedVideos.clear();
+    m_reloadVideos = true;
+  }
 }
 
 bool CPartyModeManager::IsEnabled(PartyModeContext context /* = PARTYMODECONTEXT_UNKNOWN */) const
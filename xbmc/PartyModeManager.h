@@ -20,10 +20,16 @@
  */
 
 #include <memory>
+#include <set>
 #include <string>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "interfaces/IAnnouncer.h"
+#include "threads/CriticalSection.h"
+#include "utils/WeightedRandomPool.h"
+
 class CFileItem; typedef std::shared_ptr<CFileItem> CFileItemPtr;
 class CFileItemList;
 namespace PLAYLIST
@@ -38,7 +44,7 @@ typedef enum
   PARTYMODECONTEXT_VIDEO
 } PartyModeContext;
 
-class CPartyModeManager
+class CPartyModeManager : public ANNOUNCEMENT::IAnnouncer
 {
 public:
   CPartyModeManager(void);
@@ -59,10 +65,13 @@ public:
   int GetRandomSongs();
   PartyModeContext GetType() const;
 
+  virtual void Announce(ANNOUNCEMENT::AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data) override;
+
 private:
   void Process();
   bool AddRandomSongs(int iSongs = 0);
-  bool AddInitialSongs(std::vector< std::pair<int,int> > &songIDs);
+  bool AddInitialSongs();
+  bool AddPickedSongs(int iSongs, int iVideos);
   void Add(CFileItemPtr &pItem);
   bool ReapSongs();
   bool MovePlaying();
@@ -70,9 +79,9 @@ private:
   void OnError(int iError, const std::string& strLogMessage);
   void ClearState();
   void UpdateStats();
-  std::pair<std::string,std::string> GetWhereClauseWithHistory() const;
+  std::unordered_set<int> GetHistory(int type) const;
   void AddToHistory(int type, int songID);
-  void GetRandomSelection(std::vector< std::pair<int,int> > &in, unsigned int number, std::vector< std::pair<int, int> > &out);
+  void UpdatePools();
   void Announce();
 
   // state
@@ -94,6 +103,17 @@ private:
   // history
   unsigned int m_songsInHistory;
   std::vector< std::pair<int,int> > m_history;
+
+  // songs and music videos matching the filter, picked from at random
+  CWeightedRandomPool m_songPool;
+  CWeightedRandomPool m_videoPool;
+
+  // library changes since the pools were last updated
+  CCriticalSection m_changesSection;
+  std::set<int> m_changedSongs;
+  std::set<int> m_changedVideos;
+  bool m_reloadSongs;
+  bool m_reloadVideos;
 };
 
 extern CPartyModeManager g_partyModeManager;
@@ -60,3 +60,13 @@ CDataCacheCore &CServiceBroker::GetDataCacheCore()
 {
   return g_application.m_ServiceManager->GetDataCacheCore();
 }
+
+CSmartPlaylistCache &CServiceBroker::GetSmartPlaylistCache()
+{
+  return g_application.m_ServiceManager->GetSmartPlaylistCache();
+}
+
+XFILE::CLibraryDirectoryCache &CServiceBroker::GetLibraryDirectoryCache()
+{
+  return g_application.m_ServiceManager->GetLibraryDirectoryCache();
+}
@@ -42,6 +42,11 @@ namespace PVR
 class CContextMenuManager;
 class XBPython;
 class CDataCacheCore;
+class CSmartPlaylistCache;
+namespace XFILE
+{
+  class CLibraryDirectoryCache;
+}
 
 class CServiceBroker
 {
@@ -54,4 +59,6 @@ public:
   static ActiveAE::CActiveAEDSP& GetADSP();
   static CContextMenuManager& GetContextMenuManager();
   static CDataCacheCore& GetDataCacheCore();
+  static CSmartPlaylistCache& GetSmartPlaylistCache();
+  static XFILE::CLibraryDirectoryCache& GetLibraryDirectoryCache();
 };
@@ -24,9 +24,11 @@
 #include "cores/AudioEngine/Engines/ActiveAE/AudioDSPAddons/ActiveAEDSP.h"
 #include "cores/DataCacheCore.h"
 #include "utils/log.h"
+#include "filesystem/LibraryDirectoryCache.h"
 #include "interfaces/AnnouncementManager.h"
 #include "interfaces/generic/ScriptInvocationManager.h"
 #include "interfaces/python/XBPython.h"
+#include "playlists/SmartPlaylistCache.h"
 #include "pvr/PVRManager.h"
 
 bool CServiceManager::Init1()
@@ -62,6 +64,12 @@ bool CServiceManager::Init2()
 
   m_contextMenuManager.reset(new CContextMenuManager(*m_addonMgr.get()));
 
+  m_smartPlaylistCache.reset(new CSmartPlaylistCache());
+  m_announcementManager->AddAnnouncer(m_smartPlaylistCache.get());
+
+  m_libraryDirectoryCache.reset(new XFILE::CLibraryDirectoryCache());
+  m_announcementManager->AddAnnouncer(m_libraryDirectoryCache.get());
+
   return true;
 }
 
@@ -76,6 +84,12 @@ bool CServiceManager::Init3()
 
 void CServiceManager::Deinit()
 {
+  if (m_libraryDirectoryCache)
+    m_announcementManager->RemoveAnnouncer(m_libraryDirectoryCache.get());
+  m_libraryDirectoryCache.reset();
+  if (m_smartPlaylistCache)
+    m_announcementManager->RemoveAnnouncer(m_smartPlaylistCache.get());
+  m_smartPlaylistCache.reset();
   m_contextMenuManager.reset();
   m_binaryAddonCache.reset();
   m_PVRManager.reset();
@@ -126,6 +140,16 @@ CDataCacheCore& CServiceManager::GetDataCacheCore()
   return *m_dataCacheCore;
 }
 
+CSmartPlaylistCache& CServiceManager::GetSmartPlaylistCache()
+{
+  return *m_smartPlaylistCache;
+}
+
+XFILE::CLibraryDirectoryCache& CServiceManager::GetLibraryDirectoryCache()
+{
+  return *m_libraryDirectoryCache;
+}
+
 CPlatform& CServiceManager::GetPlatform()
 {
   return *m_Platform;
@@ -140,4 +164,14 @@ void CServiceManager::delete_dataCacheCore::operator()(CDataCacheCore *p) const
 void CServiceManager::delete_contextMenuManager::operator()(CContextMenuManager *p) const
 {
   delete p;
-}
\ No newline at end of file
+}
+
+void CServiceManager::delete_smartPlaylistCache::operator()(CSmartPlaylistCache *p) const
+{
+  delete p;
+}
+
+void CServiceManager::delete_libraryDirectoryCache::operator()(XFILE::CLibraryDirectoryCache *p) const
+{
+  delete p;
+}
@@ -45,6 +45,11 @@ class CPVRManager;
 class CContextMenuManager;
 class XBPython;
 class CDataCacheCore;
+class CSmartPlaylistCache;
+namespace XFILE
+{
+  class CLibraryDirectoryCache;
+}
 
 class CServiceManager
 {
@@ -61,6 +66,8 @@ public:
   ActiveAE::CActiveAEDSP& GetADSPManager();
   CContextMenuManager& GetContextMenuManager();
   CDataCacheCore& GetDataCacheCore();
+  CSmartPlaylistCache& GetSmartPlaylistCache();
+  XFILE::CLibraryDirectoryCache& GetLibraryDirectoryCache();
   /**\brief Get the platform object. This is save to be called after Init1() was called
    */
   CPlatform& GetPlatform();
@@ -76,6 +83,16 @@ protected:
     void operator()(CContextMenuManager *p) const;
   };
 
+  struct delete_smartPlaylistCache
+  {
+    void operator()(CSmartPlaylistCache *p) const;
+  };
+
+  struct delete_libraryDirectoryCache
+  {
+    void operator()(XFILE::CLibraryDirectoryCache *p) const;
+  };
+
   std::unique_ptr<ADDON::CAddonMgr> m_addonMgr;
   std::unique_ptr<ADDON::CBinaryAddonCache> m_binaryAddonCache;
   std::unique_ptr<ANNOUNCEMENT::CAnnouncementManager> m_announcementManager;
@@ -84,5 +101,7 @@ protected:
   std::unique_ptr<ActiveAE::CActiveAEDSP> m_ADSPManager;
   std::unique_ptr<CContextMenuManager, delete_contextMenuManager> m_contextMenuManager;
   std::unique_ptr<CDataCacheCore, delete_dataCacheCore> m_dataCacheCore;
+  std::unique_ptr<CSmartPlaylistCache, delete_smartPlaylistCache> m_smartPlaylistCache;
+  std::unique_ptr<XFILE::CLibraryDirectoryCache, delete_libraryDirectoryCache> m_libraryDirectoryCache;
   std::unique_ptr<CPlatform> m_Platform;
 };
@@ -23,6 +23,7 @@
 #include "guilib/Texture.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
+#include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "filesystem/File.h"
 #include "pictures/Picture.h"
@@ -275,3 +276,75 @@ bool CTextureUseCountJob::DoWork()
   }
   return true;
 }
+
+CTextureExportJob::CTextureExportJob(const std::string &image, const std::string &destination, bool overwrite, bool addExtension)
+  : m_image(image),
+    m_destination(destination),
+    m_overwrite(overwrite),
+    m_addExtension(addExtension)
+{
+}
+
+bool CTextureExportJob::DoWork()
+{
+  if (m_addExtension)
+    return CTextureCache::GetInstance().Export(m_image, m_destination, m_overwrite);
+  return CTextureCache::GetInstance().Export(m_image, m_destination);
+}
+
+CTextureExportQueue::CTextureExportQueue(unsigned int jobsAtOnce /* = 4 */)
+  : CJobQueue(false, jobsAtOnce, CJob::PRIORITY_NORMAL),
+    m_pending(0)
+{
+}
+
+CTextureExportQueue::~CTextureExportQueue()
+{
+  Wait();
+}
+
+void CTextureExportQueue::Export(const std::string &image, const std::string &destination, bool overwrite)
+{
+  Add(new CTextureExportJob(image, destination, overwrite, true));
+}
+
+void CTextureExportQueue::Export(const std::string &image, const std::string &destination)
+{
+  Add(new CTextureExportJob(image, destination, false, false));
+}
+
+void CTextureExportQueue::Add(CJob *job)
+{
+  {
+    CSingleLock lock(m_section);
+    while (m_pending >= MaxPending && IsProcessing())
+      m_completed.wait(lock, 100);
+    m_pending++;
+  }
+  if (!AddJob(job))
+  {
+    CSingleLock lock(m_section);
+    m_pending--;
+  }
+}
+
+void CTextureExportQueue::Wait()
+{
+  CSingleLock lock(m_section);
+  // jobs cancelled by the job manager never complete, stop once nothing is processed any more
+  bool processing = true;
+  while (m_pending > 0 && processing)
+  {
+    processing = IsProcessing();
+    m_completed.wait(lock, 100);
+  }
+}
+
+void CTextureExportQueue::OnJobComplete(unsigned int jobID, bool success, CJob *job)
+{
+  CJobQueue::OnJobComplete(jobID, success, job);
+
+  CSingleLock lock(m_section);
+  m_pending--;
+  m_completed.notifyAll();
+}
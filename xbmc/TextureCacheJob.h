@@ -25,7 +25,10 @@
 #include <vector>
 
 #include "pictures/PictureScalingAlgorithm.h"
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
 #include "utils/Job.h"
+#include "utils/JobManager.h"
 
 class CBaseTexture;
 
@@ -141,3 +144,58 @@ public:
 private:
   std::vector<CTextureDetails> m_textures;
 };
+
+/* \brief Job class for exporting a cached image
+ */
+class CTextureExportJob : public CJob
+{
+public:
+  CTextureExportJob(const std::string &image, const std::string &destination, bool overwrite, bool addExtension);
+
+  virtual const char* GetType() const { return "exportimage"; };
+  virtual bool DoWork();
+
+private:
+  std::string m_image;
+  std::string m_destination;
+  bool m_overwrite;
+  bool m_addExtension;
+};
+
+/*!
+ \ingroup textures
+ \brief Exports cached images on several workers while the caller goes on.
+
+ Library exports copy several images per item, which takes most of their time
+ on network shares. The copies are queued here instead and run in parallel.
+ Export() blocks while too many copies are queued, so the queue stays small
+ when the caller is faster than the copies.
+ */
+class CTextureExportQueue : public CJobQueue
+{
+public:
+  explicit CTextureExportQueue(unsigned int jobsAtOnce = 4);
+  virtual ~CTextureExportQueue();
+
+  /*! \brief Queue an export, see CTextureCache::Export()
+   */
+  void Export(const std::string &image, const std::string &destination, bool overwrite);
+  void Export(const std::string &image, const std::string &destination);
+
+  /*! \brief Wait for all queued exports.
+   */
+  void Wait();
+
+  virtual void OnJobComplete(unsigned int jobID, bool success, CJob *job) override;
+
+  /*! \brief Most exports queued at a time.
+   */
+  static const unsigned int MaxPending = 64;
+
+private:
+  void Add(CJob *job);
+
+  CCriticalSection m_section;
+  XbmcThreads::ConditionVariable m_completed;
+  unsigned int m_pending;
+};
@@ -57,6 +57,7 @@
 #ifdef HAS_UPNP
 #include "filesystem/UPnPDirectory.h"
 #endif
+#include "filesystem/LibraryResultCache.h"
 #include "profiles/ProfilesManager.h"
 #include "utils/RegExp.h"
 #include "guilib/GraphicContext.h"
@@ -547,22 +548,40 @@ bool CUtil::ExcludeFileOrFolder(const std::string& strFileOrFolder, const std::v
   if (strFileOrFolder.empty())
     return false;
 
-  CRegExp regExExcludes(true, CRegExp::autoUtf8);  // case insensitive regex
+  std::vector<CRegExp> compiled = CompileExcludeRegExps(regexps);
+  return ExcludeFileOrFolder(strFileOrFolder, compiled);
+}
+
+bool CUtil::ExcludeFileOrFolder(const std::string& strFileOrFolder, std::vector<CRegExp>& regexps)
+{
+  if (strFileOrFolder.empty())
+    return false;
 
   for (unsigned int i = 0; i < regexps.size(); i++)
   {
+    if (regexps[i].RegFind(strFileOrFolder) > -1)
+    {
+      CLog::Log(LOGDEBUG, "%s: File '%s' excluded. (Matches exclude rule RegExp:'%s')", __FUNCTION__, strFileOrFolder.c_str(), regexps[i].GetPattern().c_str());
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<CRegExp> CUtil::CompileExcludeRegExps(const std::vector<std::string>& regexps)
+{
+  std::vector<CRegExp> compiled;
+  for (unsigned int i = 0; i < regexps.size(); i++)
+  {
+    CRegExp regExExcludes(true, CRegExp::autoUtf8);  // case insensitive regex
     if (!regExExcludes.RegComp(regexps[i].c_str()))
     { // invalid regexp - complain in logs
       CLog::Log(LOGERROR, "%s: Invalid exclude RegExp:'%s'", __FUNCTION__, regexps[i].c_str());
       continue;
     }
-    if (regExExcludes.RegFind(strFileOrFolder) > -1)
-    {
-      CLog::Log(LOGDEBUG, "%s: File '%s' excluded. (Matches exclude rule RegExp:'%s')", __FUNCTION__, strFileOrFolder.c_str(), regexps[i].c_str());
-      return true;
-    }
+    compiled.push_back(regExExcludes);
   }
-  return false;
+  return compiled;
 }
 
 void CUtil::GetFileAndProtocol(const std::string& strURL, std::string& strDir)
@@ -1343,12 +1362,14 @@ void CUtil::DeleteMusicDatabaseDirectoryCache()
 {
   CUtil::DeleteDirectoryCache("mdb-");
   CUtil::DeleteDirectoryCache("sp-"); // overkill as it will delete video smartplaylists, but as we can't differentiate based on URL...
+  XFILE::CLibraryResultCache::InvalidateAll(ANNOUNCEMENT::AudioLibrary);
 }
 
 void CUtil::DeleteVideoDatabaseDirectoryCache()
 {
   CUtil::DeleteDirectoryCache("vdb-");
   CUtil::DeleteDirectoryCache("sp-"); // overkill as it will delete music smartplaylists, but as we can't differentiate based on URL...
+  XFILE::CLibraryResultCache::InvalidateAll(ANNOUNCEMENT::VideoLibrary);
 }
 
 void CUtil::DeleteDirectoryCache(const std::string &prefix)
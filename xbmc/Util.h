@@ -34,6 +34,7 @@
 #define LEGAL_FATX            2
 
 class CFileItemList;
+class CRegExp;
 class CURL;
 
 struct ExternalStreamInfo
@@ -66,6 +67,9 @@ public:
   static bool IsLiveTV(const std::string& strFile);
   static bool IsTVRecording(const std::string& strFile);
   static bool ExcludeFileOrFolder(const std::string& strFileOrFolder, const std::vector<std::string>& regexps);
+  /*! \brief Same as above with regexps compiled by CompileExcludeRegExps, for checking many items against the same list */
+  static bool ExcludeFileOrFolder(const std::string& strFileOrFolder, std::vector<CRegExp>& regexps);
+  static std::vector<CRegExp> CompileExcludeRegExps(const std::vector<std::string>& regexps);
   static void GetFileAndProtocol(const std::string& strURL, std::string& strDir);
   static int GetDVDIfoTitle(const std::string& strPathFile);
 
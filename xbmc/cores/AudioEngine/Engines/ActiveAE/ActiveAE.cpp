@@ -37,6 +37,7 @@ using namespace ActiveAE;
 #define MAX_CACHE_LEVEL 0.4   // total cache time of stream in seconds
 #define MAX_WATER_LEVEL 0.2   // buffered time after stream stages in seconds
 #define MAX_BUFFER_TIME 0.1   // max time of a buffer in seconds
+#define MAX_SAMPLE_CACHE (16 * 1024 * 1024) // max bytes of recycled sample memory
 
 void CEngineStats::Reset(unsigned int sampleRate, bool pcm)
 {
@@ -283,6 +284,7 @@ CActiveAE::CActiveAE() :
   m_vizInitialized = false;
   m_sinkHasVolume = false;
   m_aeGUISoundForce = false;
+  m_soundSampleCacheSize = 0;
   m_stats.Reset(44100, true);
   m_streamIdGen = 0;
 }
@@ -290,6 +292,7 @@ CActiveAE::CActiveAE() :
 CActiveAE::~CActiveAE()
 {
   Dispose();
+  ClearSoundSampleCache();
 }
 
 void CActiveAE::Dispose()
@@ -1277,6 +1280,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
         m_discardBufferPools.push_back((*it)->m_processingBuffers->GetAtempoBuffers());
         delete (*it)->m_processingBuffers;
         (*it)->m_processingBuffers = nullptr;
+        ClearDiscardedBuffers();
       }
       if (!(*it)->m_processingBuffers)
       {
@@ -1344,6 +1348,7 @@ void CActiveAE::Configure(AEAudioFormat *desiredFmt)
   {
     m_discardBufferPools.push_back(m_sinkBuffers);
     m_sinkBuffers = NULL;
+    ClearDiscardedBuffers();
   }
   if (!m_sinkBuffers)
   {
@@ -2026,15 +2031,7 @@ bool CActiveAE::RunStages()
 
               for(int j=0; j<out->pkt->planes; j++)
               {
-#if defined(HAVE_SSE) && defined(__SSE__)
-                CAEUtil::SSEMulArray((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
-#else
-                float* fbuffer = (float*) out->pkt->data[j]+i*nb_floats;
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  fbuffer[k] *= volume;
-                }
-#endif
+                CAEUtil::MulArray((float*)out->pkt->data[j]+i*nb_floats, volume, nb_floats);
               }
             }
           }
@@ -2095,24 +2092,12 @@ bool CActiveAE::RunStages()
               {
                 float *dst = (float*)out->pkt->data[j]+i*nb_floats;
                 float *src = (float*)mix->pkt->data[j]+i*nb_floats;
-#if defined(HAVE_SSE) && defined(__SSE__)
-                CAEUtil::SSEMulAddArray(dst, src, volume, nb_floats);
-                for (int k = 0; k < nb_floats; ++k)
-                {
-                  if (fabs(dst[k]) > 1.0f)
-                  {
-                    needClamp = true;
-                    break;
-                  }
-                }
-#else
-                for (int k = 0; k < nb_floats; ++k)
+                CAEUtil::MulAddArray(dst, src, volume, nb_floats);
+                for (int k = 0; k < nb_floats && !needClamp; ++k)
                 {
-                  dst[k] += src[k] * volume;
                   if (fabs(dst[k]) > 1.0f)
                     needClamp = true;
                 }
-#endif
               }
             }
             mix->Return();
@@ -2487,12 +2472,7 @@ void CActiveAE::MixSounds(CSoundPacket &dstSample)
       out = (float*)dstSample.data[j];
       sample_buffer = (float*)(it->sound->GetSound(false)->data[j]+start);
       int nb_floats = mix_samples * dstSample.config.channels / dstSample.planes;
-#if defined(HAVE_SSE) && defined(__SSE__)
-      CAEUtil::SSEMulAddArray(out, sample_buffer, volume, nb_floats);
-#else
-      for (int k = 0; k < nb_floats; ++k)
-        *out++ += *sample_buffer++ * volume;
-#endif
+      CAEUtil::MulAddArray(out, sample_buffer, volume, nb_floats);
     }
 
     it->samples_played += mix_samples;
@@ -2518,13 +2498,7 @@ void CActiveAE::Deamplify(CSoundPacket &dstSample)
     for(int j=0; j<dstSample.planes; j++)
     {
       buffer = (float*)dstSample.data[j];
-#if defined(HAVE_SSE) && defined(__SSE__)
-      CAEUtil::SSEMulArray(buffer, volume, nb_floats);
-#else
-      float *fbuffer = buffer;
-      for (int i = 0; i < nb_floats; i++)
-        *fbuffer++ *= volume;
-#endif
+      CAEUtil::MulArray(buffer, volume, nb_floats);
     }
   }
 }
@@ -2881,19 +2855,70 @@ uint8_t **CActiveAE::AllocSoundSample(SampleConfig &config, int &samples, int &b
   planes = av_sample_fmt_is_planar(config.fmt) ? config.channels : 1;
   buffer = new uint8_t*[planes];
 
+  // reuse memory of a deleted buffer pool if there is a block of matching size,
+  // avoids allocating all buffers again on every format change
+  uint8_t *block = NULL;
+  int size = av_samples_get_buffer_size(NULL, config.channels, samples, config.fmt, 16);
+  {
+    CSingleLock lock(m_soundSampleLock);
+    std::multimap<int, uint8_t*>::iterator it = m_soundSampleCache.lower_bound(size);
+    if (it != m_soundSampleCache.end() && it->first <= size * 2)
+    {
+      block = it->second;
+      m_soundSampleCacheSize -= it->first;
+      if (it->first != size)
+        m_soundSampleReused[block] = it->first;
+      m_soundSampleCache.erase(it);
+    }
+  }
+
   // align buffer to 16 in order to be compatible with sse in CAEConvert
-  av_samples_alloc(buffer, &linesize, config.channels,
-                                 samples, config.fmt, 16);
+  if (block)
+  {
+    av_samples_fill_arrays(buffer, &linesize, block, config.channels,
+                           samples, config.fmt, 16);
+    av_samples_set_silence(buffer, 0, samples, config.channels, config.fmt);
+  }
+  else
+    av_samples_alloc(buffer, &linesize, config.channels,
+                     samples, config.fmt, 16);
   bytes_per_sample = av_get_bytes_per_sample(config.fmt);
   return buffer;
 }
 
-void CActiveAE::FreeSoundSample(uint8_t **data)
+void CActiveAE::FreeSoundSample(uint8_t **data, int size)
 {
+  {
+    CSingleLock lock(m_soundSampleLock);
+
+    // a reused block may be larger than the buffer it served, keep it under its real size
+    std::map<uint8_t*, int>::iterator reused = m_soundSampleReused.find(data[0]);
+    if (reused != m_soundSampleReused.end())
+    {
+      size = reused->second;
+      m_soundSampleReused.erase(reused);
+    }
+
+    if (data[0] && size > 0 && m_soundSampleCacheSize + size <= MAX_SAMPLE_CACHE)
+    {
+      m_soundSampleCache.insert(std::make_pair(size, data[0]));
+      m_soundSampleCacheSize += size;
+      data[0] = NULL;
+    }
+  }
   av_freep(data);
   delete [] data;
 }
 
+void CActiveAE::ClearSoundSampleCache()
+{
+  CSingleLock lock(m_soundSampleLock);
+  for (std::multimap<int, uint8_t*>::iterator it = m_soundSampleCache.begin(); it != m_soundSampleCache.end(); ++it)
+    av_free(it->second);
+  m_soundSampleCache.clear();
+  m_soundSampleCacheSize = 0;
+}
+
 bool CActiveAE::CompareFormat(AEAudioFormat &lhs, AEAudioFormat &rhs)
 {
   if (lhs.m_channelLayout != rhs.m_channelLayout ||
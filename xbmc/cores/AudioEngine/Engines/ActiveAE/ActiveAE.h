@@ -20,6 +20,7 @@
  */
 
 #include <list>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -279,7 +280,8 @@ public:
 protected:
   void PlaySound(CActiveAESound *sound);
   uint8_t **AllocSoundSample(SampleConfig &config, int &samples, int &bytes_per_sample, int &planes, int &linesize);
-  void FreeSoundSample(uint8_t **data);
+  void FreeSoundSample(uint8_t **data, int size);
+  void ClearSoundSampleCache();
   void GetDelay(AEDelayStatus& status, CActiveAEStream *stream) { m_stats.GetDelay(status, stream); }
   void GetSyncInfo(CAESyncInfo& info, CActiveAEStream *stream) { m_stats.GetSyncInfo(info, stream); }
   float GetCacheTime(CActiveAEStream *stream) { return m_stats.GetCacheTime(stream); }
@@ -371,6 +373,12 @@ protected:
   // streams
   std::list<CActiveAEStream*> m_streams;
   std::list<CActiveAEBufferPool*> m_discardBufferPools;
+
+  // sample memory of deleted buffer pools, recycled on re-configure
+  std::multimap<int, uint8_t*> m_soundSampleCache;
+  std::map<uint8_t*, int> m_soundSampleReused; // size of cached blocks that serve a smaller buffer
+  int m_soundSampleCacheSize;
+  CCriticalSection m_soundSampleLock;
   unsigned int m_streamIdGen;
 
   // gui sounds
@@ -42,7 +42,7 @@ CSoundPacket::CSoundPacket(SampleConfig conf, int samples) : config(conf)
 CSoundPacket::~CSoundPacket()
 {
   if (data)
-    AE.FreeSoundSample(data);
+    AE.FreeSoundSample(data, linesize * planes);
 }
 
 CSampleBuffer::CSampleBuffer() : pkt(NULL), pool(NULL)
@@ -22,6 +22,14 @@
 #include "ActiveAEResampleFFMPEG.h"
 #include "utils/log.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(HAVE_SSE2) && defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 extern "C" {
 #include "libavutil/channel_layout.h"
 #include "libavutil/opt.h"
@@ -30,10 +38,155 @@ extern "C" {
 
 using namespace ActiveAE;
 
+namespace
+{
+
+// conversion rules follow the ones of swresample so that the direct path
+// produces the same output as swr_convert would
+inline void ConvertSample(const int16_t in, int16_t &out) { out = in; }
+inline void ConvertSample(const int16_t in, int32_t &out) { out = (int32_t)in * 65536; }
+inline void ConvertSample(const int16_t in, float &out) { out = in * (1.0f / 32768.0f); }
+inline void ConvertSample(const int32_t in, int16_t &out) { out = (int16_t)(in >> 16); }
+inline void ConvertSample(const int32_t in, int32_t &out) { out = in; }
+inline void ConvertSample(const int32_t in, float &out) { out = in * (1.0f / 2147483648.0f); }
+inline void ConvertSample(const float in, float &out) { out = in; }
+
+inline void ConvertSample(const float in, int16_t &out)
+{
+  float v = in * 32768.0f;
+  if (v >= 32767.0f)
+    out = 32767;
+  else if (v <= -32768.0f)
+    out = -32768;
+  else
+    out = (int16_t)lrintf(v);
+}
+
+inline void ConvertSample(const float in, int32_t &out)
+{
+  double v = in * 2147483648.0;
+  if (v >= 2147483647.0)
+    out = 2147483647;
+  else if (v <= -2147483648.0)
+    out = -2147483647 - 1;
+  else
+    out = (int32_t)llrint(v);
+}
+
+template<typename SrcT, typename DstT>
+void ConvertChannel(const uint8_t *src, int src_stride, uint8_t *dst, int dst_stride, int samples)
+{
+  const SrcT *in = (const SrcT*)src;
+  DstT *out = (DstT*)dst;
+
+  if (src_stride == 1 && dst_stride == 1)
+  {
+    for (int i = 0; i < samples; i++)
+      ConvertSample(in[i], out[i]);
+  }
+  else
+  {
+    for (int i = 0; i < samples; i++)
+      ConvertSample(in[i * src_stride], out[i * dst_stride]);
+  }
+}
+
+template<>
+void ConvertChannel<float, int16_t>(const uint8_t *src, int src_stride, uint8_t *dst, int dst_stride, int samples)
+{
+  const float *in = (const float*)src;
+  int16_t *out = (int16_t*)dst;
+  int i = 0;
+
+#if defined(HAVE_SSE2) && defined(__SSE2__)
+  // float to s16 is the common sink conversion, do 8 samples per iteration
+  if (src_stride == 1 && dst_stride == 1)
+  {
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 maxval = _mm_set1_ps(32767.0f);
+    const __m128 minval = _mm_set1_ps(-32768.0f);
+    for (; i + 8 <= samples; i += 8)
+    {
+      __m128 lo = _mm_mul_ps(_mm_loadu_ps(in + i), scale);
+      __m128 hi = _mm_mul_ps(_mm_loadu_ps(in + i + 4), scale);
+      lo = _mm_max_ps(_mm_min_ps(lo, maxval), minval);
+      hi = _mm_max_ps(_mm_min_ps(hi, maxval), minval);
+      __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+      _mm_storeu_si128((__m128i*)(out + i), packed);
+    }
+  }
+#endif
+
+  for (; i < samples; i++)
+    ConvertSample(in[i * src_stride], out[i * dst_stride]);
+}
+
+template<typename SrcT>
+bool ConvertChannel(AVSampleFormat dst_fmt, const uint8_t *src, int src_stride, uint8_t *dst, int dst_stride, int samples)
+{
+  switch (dst_fmt)
+  {
+    case AV_SAMPLE_FMT_S16:
+      ConvertChannel<SrcT, int16_t>(src, src_stride, dst, dst_stride, samples);
+      return true;
+    case AV_SAMPLE_FMT_S32:
+      ConvertChannel<SrcT, int32_t>(src, src_stride, dst, dst_stride, samples);
+      return true;
+    case AV_SAMPLE_FMT_FLT:
+      ConvertChannel<SrcT, float>(src, src_stride, dst, dst_stride, samples);
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ConvertChannel(AVSampleFormat src_fmt, AVSampleFormat dst_fmt, const uint8_t *src, int src_stride, uint8_t *dst, int dst_stride, int samples)
+{
+  src_fmt = av_get_packed_sample_fmt(src_fmt);
+  dst_fmt = av_get_packed_sample_fmt(dst_fmt);
+
+  if (src_fmt == dst_fmt && src_stride == 1 && dst_stride == 1)
+  {
+    memcpy(dst, src, samples * av_get_bytes_per_sample(src_fmt));
+    return true;
+  }
+
+  switch (src_fmt)
+  {
+    case AV_SAMPLE_FMT_S16:
+      return ConvertChannel<int16_t>(dst_fmt, src, src_stride, dst, dst_stride, samples);
+    case AV_SAMPLE_FMT_S32:
+      return ConvertChannel<int32_t>(dst_fmt, src, src_stride, dst, dst_stride, samples);
+    case AV_SAMPLE_FMT_FLT:
+      return ConvertChannel<float>(dst_fmt, src, src_stride, dst, dst_stride, samples);
+    default:
+      return false;
+  }
+}
+
+bool IsDirectFormat(AVSampleFormat fmt)
+{
+  switch (av_get_packed_sample_fmt(fmt))
+  {
+    case AV_SAMPLE_FMT_S16:
+    case AV_SAMPLE_FMT_S32:
+    case AV_SAMPLE_FMT_FLT:
+      return true;
+    default:
+      return false;
+  }
+}
+
+}
+
 CActiveAEResampleFFMPEG::CActiveAEResampleFFMPEG()
 {
   m_pContext = NULL;
   m_doesResample = false;
+  m_directConvert = false;
+  m_directIdentity = false;
+  m_remainderSamples = 0;
+  m_remainderOffset = 0;
 }
 
 CActiveAEResampleFFMPEG::~CActiveAEResampleFFMPEG()
@@ -175,6 +328,49 @@ bool CActiveAEResampleFFMPEG::Init(uint64_t dst_chan_layout, int dst_channels, i
     CLog::Log(LOGERROR, "CActiveAEResampleFFMPEG::Init - init resampler failed");
     return false;
   }
+
+  m_directConvert = InitDirectConvert(upmix, remapLayout);
+  if (m_directConvert)
+    CLog::Log(LOGDEBUG, "CActiveAEResampleFFMPEG::Init - using direct conversion %s -> %s",
+              av_get_sample_fmt_name(m_src_fmt), av_get_sample_fmt_name(m_dst_fmt));
+  return true;
+}
+
+bool CActiveAEResampleFFMPEG::InitDirectConvert(bool upmix, CAEChannelInfo *remapLayout)
+{
+  if (m_doesResample ||
+      !IsDirectFormat(m_src_fmt) || !IsDirectFormat(m_dst_fmt) ||
+      m_src_channels > AE_CH_MAX || m_dst_channels > AE_CH_MAX)
+    return false;
+
+  m_directIdentity = (m_src_channels == m_dst_channels);
+  if (remapLayout)
+  {
+    // same one-to-one mapping that is passed to swresample as matrix
+    if ((int)remapLayout->Count() != m_dst_channels)
+      return false;
+    for (int out = 0; out < m_dst_channels; out++)
+    {
+      m_directMap[out] = CAEUtil::GetAVChannelIndex((*remapLayout)[out], m_src_chan_layout);
+      if (m_directMap[out] != out)
+        m_directIdentity = false;
+    }
+  }
+  else
+  {
+    // anything else than a plain copy of the channels needs the rematrix of swresample
+    if (m_src_chan_layout != m_dst_chan_layout || m_src_channels != m_dst_channels ||
+        (upmix && m_src_channels == 2 && m_dst_channels > 2))
+      return false;
+    for (int out = 0; out < m_dst_channels; out++)
+      m_directMap[out] = out;
+  }
+
+  int planes = av_sample_fmt_is_planar(m_src_fmt) ? m_src_channels : 1;
+  m_remainder.assign(planes, std::vector<uint8_t>());
+  m_remainderPlanes.assign(planes, nullptr);
+  m_remainderSamples = 0;
+  m_remainderOffset = 0;
   return true;
 }
 
@@ -196,9 +392,20 @@ int CActiveAEResampleFFMPEG::Resample(uint8_t **dst_buffer, int dst_samples, uin
       CLog::Log(LOGERROR, "CActiveAEResampleFFMPEG::Resample - set compensation failed");
       return -1;
     }
+
+    // rate is adjusted from now on, hand pending samples over to swresample
+    if (m_directConvert)
+    {
+      FlushRemainderToContext();
+      m_directConvert = false;
+    }
   }
 
-  int ret = swr_convert(m_pContext, dst_buffer, dst_samples, (const uint8_t**)src_buffer, src_samples);
+  int ret;
+  if (m_directConvert)
+    ret = DirectConvert(dst_buffer, dst_samples, src_buffer, src_samples);
+  else
+    ret = swr_convert(m_pContext, dst_buffer, dst_samples, (const uint8_t**)src_buffer, src_samples);
   if (ret < 0)
   {
     CLog::Log(LOGERROR, "CActiveAEResampleFFMPEG::Resample - resample failed");
@@ -258,13 +465,162 @@ int CActiveAEResampleFFMPEG::Resample(uint8_t **dst_buffer, int dst_samples, uin
   return ret;
 }
 
+int CActiveAEResampleFFMPEG::DirectConvert(uint8_t **dst_buffer, int dst_samples, uint8_t **src_buffer, int src_samples)
+{
+  int out = 0;
+
+  // samples which did not fit into the previous destination come first
+  if (m_remainderSamples > 0)
+  {
+    int samples = std::min(m_remainderSamples, dst_samples);
+    ConvertSamples(dst_buffer, 0, GetRemainderPlanes(), 0, samples);
+    ConsumeRemainder(samples);
+    out += samples;
+  }
+
+  if (src_buffer && src_samples > 0)
+  {
+    int samples = std::min(src_samples, dst_samples - out);
+    if (samples > 0)
+      ConvertSamples(dst_buffer, out, src_buffer, 0, samples);
+    if (samples < src_samples)
+      StoreRemainder(src_buffer, samples, src_samples - samples);
+    out += samples;
+  }
+
+  return out;
+}
+
+void CActiveAEResampleFFMPEG::ConvertSamples(uint8_t **dst_buffer, int dst_offset, uint8_t **src_buffer, int src_offset, int samples)
+{
+  int src_bps = av_get_bytes_per_sample(m_src_fmt);
+  int dst_bps = av_get_bytes_per_sample(m_dst_fmt);
+  bool src_planar = av_sample_fmt_is_planar(m_src_fmt) != 0;
+  bool dst_planar = av_sample_fmt_is_planar(m_dst_fmt) != 0;
+
+  // interleaved to interleaved without reordering is a single flat loop
+  if (m_directIdentity && !src_planar && !dst_planar)
+  {
+    ConvertChannel(m_src_fmt, m_dst_fmt,
+                   src_buffer[0] + src_offset * m_src_channels * src_bps, 1,
+                   dst_buffer[0] + dst_offset * m_dst_channels * dst_bps, 1,
+                   samples * m_dst_channels);
+    return;
+  }
+
+  for (int ch = 0; ch < m_dst_channels; ch++)
+  {
+    uint8_t *dst;
+    int dst_stride;
+    if (dst_planar)
+    {
+      dst = dst_buffer[ch] + dst_offset * dst_bps;
+      dst_stride = 1;
+    }
+    else
+    {
+      dst = dst_buffer[0] + (dst_offset * m_dst_channels + ch) * dst_bps;
+      dst_stride = m_dst_channels;
+    }
+
+    int idx = m_directMap[ch];
+    if (idx < 0)
+    {
+      // channel not present in source, all direct formats have zero as silence
+      for (int i = 0; i < samples; i++)
+        memset(dst + i * dst_stride * dst_bps, 0, dst_bps);
+      continue;
+    }
+
+    const uint8_t *src;
+    int src_stride;
+    if (src_planar)
+    {
+      src = src_buffer[idx] + src_offset * src_bps;
+      src_stride = 1;
+    }
+    else
+    {
+      src = src_buffer[0] + (src_offset * m_src_channels + idx) * src_bps;
+      src_stride = m_src_channels;
+    }
+
+    ConvertChannel(m_src_fmt, m_dst_fmt, src, src_stride, dst, dst_stride, samples);
+  }
+}
+
+int CActiveAEResampleFFMPEG::GetRemainderBytesPerSample()
+{
+  int bytes = av_get_bytes_per_sample(m_src_fmt);
+  if (!av_sample_fmt_is_planar(m_src_fmt))
+    bytes *= m_src_channels;
+  return bytes;
+}
+
+uint8_t **CActiveAEResampleFFMPEG::GetRemainderPlanes()
+{
+  int offset = m_remainderOffset * GetRemainderBytesPerSample();
+  for (size_t i = 0; i < m_remainder.size(); i++)
+    m_remainderPlanes[i] = m_remainder[i].data() + offset;
+  return m_remainderPlanes.data();
+}
+
+void CActiveAEResampleFFMPEG::StoreRemainder(uint8_t **src_buffer, int src_offset, int samples)
+{
+  int bytes = GetRemainderBytesPerSample();
+
+  // drop consumed samples once they outnumber the pending ones, so moving
+  // the pending samples to the front costs no more than consuming them did
+  if (m_remainderOffset > 0 && m_remainderOffset >= m_remainderSamples)
+  {
+    for (size_t i = 0; i < m_remainder.size(); i++)
+      m_remainder[i].erase(m_remainder[i].begin(), m_remainder[i].begin() + m_remainderOffset * bytes);
+    m_remainderOffset = 0;
+  }
+
+  for (size_t i = 0; i < m_remainder.size(); i++)
+  {
+    const uint8_t *src = src_buffer[i] + src_offset * bytes;
+    m_remainder[i].insert(m_remainder[i].end(), src, src + samples * bytes);
+  }
+  m_remainderSamples += samples;
+}
+
+void CActiveAEResampleFFMPEG::ConsumeRemainder(int samples)
+{
+  // samples are taken from the front, only move the read position
+  m_remainderSamples -= samples;
+  m_remainderOffset += samples;
+  if (m_remainderSamples <= 0)
+  {
+    for (size_t i = 0; i < m_remainder.size(); i++)
+      m_remainder[i].clear();
+    m_remainderSamples = 0;
+    m_remainderOffset = 0;
+  }
+}
+
+void CActiveAEResampleFFMPEG::FlushRemainderToContext()
+{
+  if (m_remainderSamples <= 0)
+    return;
+
+  // no output space, swresample buffers the input
+  swr_convert(m_pContext, NULL, 0, (const uint8_t**)GetRemainderPlanes(), m_remainderSamples);
+  ConsumeRemainder(m_remainderSamples);
+}
+
 int64_t CActiveAEResampleFFMPEG::GetDelay(int64_t base)
 {
+  if (m_directConvert)
+    return av_rescale_rnd(m_remainderSamples, base, m_src_rate, AV_ROUND_UP);
   return swr_get_delay(m_pContext, base);
 }
 
 int CActiveAEResampleFFMPEG::GetBufferedSamples()
 {
+  if (m_directConvert)
+    return m_remainderSamples;
   return av_rescale_rnd(swr_get_delay(m_pContext, m_src_rate),
                                     m_dst_rate, m_src_rate, AV_ROUND_UP);
 }
@@ -24,6 +24,8 @@
 #include "cores/AudioEngine/Interfaces/AE.h"
 #include "cores/AudioEngine/Interfaces/AEResample.h"
 
+#include <vector>
+
 extern "C" {
 #include "libavutil/samplefmt.h"
 }
@@ -49,6 +51,15 @@ public:
   int GetDstBufferSize(int samples);
 
 protected:
+  bool InitDirectConvert(bool upmix, CAEChannelInfo *remapLayout);
+  int DirectConvert(uint8_t **dst_buffer, int dst_samples, uint8_t **src_buffer, int src_samples);
+  void ConvertSamples(uint8_t **dst_buffer, int dst_offset, uint8_t **src_buffer, int src_offset, int samples);
+  void StoreRemainder(uint8_t **src_buffer, int src_offset, int samples);
+  void ConsumeRemainder(int samples);
+  uint8_t **GetRemainderPlanes();
+  int GetRemainderBytesPerSample();
+  void FlushRemainderToContext();
+
   bool m_loaded;
   bool m_doesResample;
   uint64_t m_src_chan_layout, m_dst_chan_layout;
@@ -59,6 +70,16 @@ protected:
   int m_src_dither_bits, m_dst_dither_bits;
   SwrContext *m_pContext;
   double m_rematrix[AE_CH_MAX][AE_CH_MAX];
+
+  // identity rate conversion bypassing swresample: sample format conversion
+  // and one-to-one channel mapping are done in a single pass
+  bool m_directConvert;
+  bool m_directIdentity;
+  int m_directMap[AE_CH_MAX];
+  std::vector<std::vector<uint8_t> > m_remainder;
+  std::vector<uint8_t*> m_remainderPlanes;
+  int m_remainderSamples;
+  int m_remainderOffset; // samples at the front of m_remainder that were consumed already
 };
 
 }
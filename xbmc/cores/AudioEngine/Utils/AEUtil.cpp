@@ -26,11 +26,27 @@
 #endif
 
 #include "AEUtil.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
 #include "utils/TimeUtils.h"
 
+#include <atomic>
 #include <cassert>
 
+/* AVX kernels are selected at runtime, so they are built with a per function
+   target instead of raising the minimum instruction set of the whole build */
+#if defined(HAVE_SSE) && defined(__SSE__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define AE_HAVE_AVX_KERNELS
+#include <immintrin.h>
+#endif
+
+/* __ARM_NEON is the ACLE name and also set for aarch64, older compilers only set __ARM_NEON__ */
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define AE_HAVE_NEON_KERNELS
+#include <arm_neon.h>
+#endif
+
 extern "C" {
 #include "libavutil/channel_layout.h"
 }
@@ -334,7 +350,239 @@ void CAEUtil::SSEMulAddArray(float *data, float *add, const float mul, uint32_t
 }
 #endif
 
-inline float CAEUtil::SoftClamp(const float x)
+#if defined(HAVE_SSE) && defined(__SSE__)
+static void ClampArraySSE(float *data, uint32_t count)
+{
+  const __m128 c1 = _mm_set_ps1(27.0f);
+  const __m128 c2 = _mm_set_ps1(9.0f);
+  const __m128 lo = _mm_set_ps1(-3.0f);
+  const __m128 hi = _mm_set_ps1(3.0f);
+
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    /* tanh approx clamp, see SoftClamp */
+    __m128 dt  = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(data + i), lo), hi);
+    __m128 tmp = _mm_mul_ps(dt, dt);
+    _mm_storeu_ps(data + i, _mm_div_ps(_mm_mul_ps(dt, _mm_add_ps(c1, tmp)),
+                                       _mm_add_ps(c1, _mm_mul_ps(c2, tmp))));
+  }
+
+  for (; i < count; ++i)
+    data[i] = CAEUtil::SoftClamp(data[i]);
+}
+#endif
+
+#if defined(AE_HAVE_AVX_KERNELS)
+__attribute__((target("avx")))
+static void MulArrayAVX(float *data, const float mul, uint32_t count)
+{
+  const __m256 m = _mm256_set1_ps(mul);
+
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), m));
+
+  for (; i < count; ++i)
+    data[i] *= mul;
+}
+
+__attribute__((target("avx")))
+static void MulAddArrayAVX(float *data, float *add, const float mul, uint32_t count)
+{
+  const __m256 m = _mm256_set1_ps(mul);
+
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256 ad = _mm256_loadu_ps(add + i);
+    __m256 to = _mm256_loadu_ps(data + i);
+    _mm256_storeu_ps(data + i, _mm256_add_ps(to, _mm256_mul_ps(ad, m)));
+  }
+
+  for (; i < count; ++i)
+    data[i] += add[i] * mul;
+}
+
+__attribute__((target("avx")))
+static void ClampArrayAVX(float *data, uint32_t count)
+{
+  const __m256 c1 = _mm256_set1_ps(27.0f);
+  const __m256 c2 = _mm256_set1_ps(9.0f);
+  const __m256 lo = _mm256_set1_ps(-3.0f);
+  const __m256 hi = _mm256_set1_ps(3.0f);
+
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    /* tanh approx clamp, see SoftClamp */
+    __m256 dt  = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(data + i), lo), hi);
+    __m256 tmp = _mm256_mul_ps(dt, dt);
+    _mm256_storeu_ps(data + i, _mm256_div_ps(_mm256_mul_ps(dt, _mm256_add_ps(c1, tmp)),
+                                             _mm256_add_ps(c1, _mm256_mul_ps(c2, tmp))));
+  }
+
+  for (; i < count; ++i)
+    data[i] = CAEUtil::SoftClamp(data[i]);
+}
+#endif
+
+#if defined(AE_HAVE_AVX_KERNELS)
+/* AVX2 processors also have FMA, which the float kernels make use of */
+__attribute__((target("avx2,fma")))
+static void MulAddArrayAVX2(float *data, float *add, const float mul, uint32_t count)
+{
+  const __m256 m = _mm256_set1_ps(mul);
+
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+    _mm256_storeu_ps(data + i, _mm256_fmadd_ps(_mm256_loadu_ps(add + i), m, _mm256_loadu_ps(data + i)));
+
+  for (; i < count; ++i)
+    data[i] += add[i] * mul;
+}
+
+__attribute__((target("avx2,fma")))
+static void ClampArrayAVX2(float *data, uint32_t count)
+{
+  const __m256 c1 = _mm256_set1_ps(27.0f);
+  const __m256 c2 = _mm256_set1_ps(9.0f);
+  const __m256 lo = _mm256_set1_ps(-3.0f);
+  const __m256 hi = _mm256_set1_ps(3.0f);
+
+  uint32_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    /* tanh approx clamp, see SoftClamp */
+    __m256 dt  = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(data + i), lo), hi);
+    __m256 tmp = _mm256_mul_ps(dt, dt);
+    _mm256_storeu_ps(data + i, _mm256_div_ps(_mm256_mul_ps(dt, _mm256_add_ps(c1, tmp)),
+                                             _mm256_fmadd_ps(c2, tmp, c1)));
+  }
+
+  for (; i < count; ++i)
+    data[i] = CAEUtil::SoftClamp(data[i]);
+}
+#endif
+
+#if defined(AE_HAVE_NEON_KERNELS)
+static void MulArrayNEON(float *data, const float mul, uint32_t count)
+{
+  const float32x4_t m = vdupq_n_f32(mul);
+
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_f32(data + i, vmulq_f32(vld1q_f32(data + i), m));
+
+  for (; i < count; ++i)
+    data[i] *= mul;
+}
+
+static void MulAddArrayNEON(float *data, float *add, const float mul, uint32_t count)
+{
+  const float32x4_t m = vdupq_n_f32(mul);
+
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+    vst1q_f32(data + i, vmlaq_f32(vld1q_f32(data + i), vld1q_f32(add + i), m));
+
+  for (; i < count; ++i)
+    data[i] += add[i] * mul;
+}
+
+static void ClampArrayNEON(float *data, uint32_t count)
+{
+  const float32x4_t c1 = vdupq_n_f32(27.0f);
+  const float32x4_t c2 = vdupq_n_f32(9.0f);
+  const float32x4_t lo = vdupq_n_f32(-3.0f);
+  const float32x4_t hi = vdupq_n_f32(3.0f);
+
+  uint32_t i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    /* tanh approx clamp, see SoftClamp */
+    float32x4_t dt  = vminq_f32(vmaxq_f32(vld1q_f32(data + i), lo), hi);
+    float32x4_t tmp = vmulq_f32(dt, dt);
+    float32x4_t num = vmulq_f32(dt, vaddq_f32(c1, tmp));
+    float32x4_t den = vmlaq_f32(c1, c2, tmp);
+#if defined(__aarch64__)
+    vst1q_f32(data + i, vdivq_f32(num, den));
+#else
+    /* there is no vector division on armv7, so multiply by the reciprocal
+       refined with two newton-raphson steps */
+    float32x4_t rcp = vrecpeq_f32(den);
+    rcp = vmulq_f32(vrecpsq_f32(den, rcp), rcp);
+    rcp = vmulq_f32(vrecpsq_f32(den, rcp), rcp);
+    vst1q_f32(data + i, vmulq_f32(num, rcp));
+#endif
+  }
+
+  for (; i < count; ++i)
+    data[i] = CAEUtil::SoftClamp(data[i]);
+}
+#endif
+
+/* the kernel in use, -1 until it was picked */
+static std::atomic<int> g_simdKernel(-1);
+
+bool CAEUtil::IsSIMDKernelSupported(AESIMDKernel kernel)
+{
+  const unsigned int features = g_cpuInfo.GetCPUFeatures();
+  switch (kernel)
+  {
+    case AE_SIMD_NONE:
+      return true;
+#if defined(HAVE_SSE) && defined(__SSE__)
+    case AE_SIMD_SSE:
+      return (features & CPU_FEATURE_SSE) != 0;
+#endif
+#if defined(AE_HAVE_AVX_KERNELS)
+    case AE_SIMD_AVX:
+      return (features & CPU_FEATURE_AVX) != 0;
+    case AE_SIMD_AVX2:
+      return (features & CPU_FEATURE_AVX2) && (features & CPU_FEATURE_FMA3);
+#endif
+#if defined(AE_HAVE_NEON_KERNELS)
+    case AE_SIMD_NEON:
+      return (features & CPU_FEATURE_NEON) != 0;
+#endif
+    default:
+      return false;
+  }
+}
+
+CAEUtil::AESIMDKernel CAEUtil::GetSIMDKernel()
+{
+  int kernel = g_simdKernel;
+  if (kernel < 0)
+  {
+    /* fastest first */
+    const AESIMDKernel kernels[] = { AE_SIMD_AVX2, AE_SIMD_AVX, AE_SIMD_SSE, AE_SIMD_NEON };
+    kernel = AE_SIMD_NONE;
+    for (const auto &candidate : kernels)
+    {
+      if (IsSIMDKernelSupported(candidate))
+      {
+        kernel = candidate;
+        break;
+      }
+    }
+    g_simdKernel = kernel;
+  }
+
+  return static_cast<AESIMDKernel>(kernel);
+}
+
+bool CAEUtil::SetSIMDKernel(AESIMDKernel kernel)
+{
+  if (!IsSIMDKernelSupported(kernel))
+    return false;
+
+  g_simdKernel = kernel;
+  return true;
+}
+
+float CAEUtil::SoftClamp(const float x)
 {
 #if 1
     /*
@@ -371,83 +619,90 @@ inline float CAEUtil::SoftClamp(const float x)
 
 void CAEUtil::ClampArray(float *data, uint32_t count)
 {
-#if !defined(HAVE_SSE) || !defined(__SSE__)
+  switch (GetSIMDKernel())
+  {
+#if defined(AE_HAVE_AVX_KERNELS)
+    case AE_SIMD_AVX2:
+      ClampArrayAVX2(data, count);
+      return;
+    case AE_SIMD_AVX:
+      ClampArrayAVX(data, count);
+      return;
+#endif
+#if defined(HAVE_SSE) && defined(__SSE__)
+    case AE_SIMD_SSE:
+      ClampArraySSE(data, count);
+      return;
+#endif
+#if defined(AE_HAVE_NEON_KERNELS)
+    case AE_SIMD_NEON:
+      ClampArrayNEON(data, count);
+      return;
+#endif
+    default:
+      break;
+  }
+
   for (uint32_t i = 0; i < count; ++i)
     data[i] = SoftClamp(data[i]);
+}
 
-#else
-  const __m128 c1 = _mm_set_ps1(27.0f);
-  const __m128 c2 = _mm_set_ps1(27.0f + 9.0f);
-
-  /* work around invalid alignment */
-  while (((uintptr_t)data & 0xF) && count > 0)
+void CAEUtil::MulArray(float *data, const float mul, uint32_t count)
+{
+  switch (GetSIMDKernel())
   {
-    data[0] = SoftClamp(data[0]);
-    ++data;
-    --count;
+#if defined(AE_HAVE_AVX_KERNELS)
+    case AE_SIMD_AVX2: // a multiplication gains nothing from FMA
+    case AE_SIMD_AVX:
+      MulArrayAVX(data, mul, count);
+      return;
+#endif
+#if defined(HAVE_SSE) && defined(__SSE__)
+    case AE_SIMD_SSE:
+      SSEMulArray(data, mul, count);
+      return;
+#endif
+#if defined(AE_HAVE_NEON_KERNELS)
+    case AE_SIMD_NEON:
+      MulArrayNEON(data, mul, count);
+      return;
+#endif
+    default:
+      break;
   }
 
-  uint32_t even = count & ~0x3;
-  for (uint32_t i = 0; i < even; i+=4, data+=4)
-  {
-    /* tanh approx clamp */
-    __m128 dt = _mm_load_ps(data);
-    __m128 tmp     = _mm_mul_ps(dt, dt);
-    *(__m128*)data = _mm_div_ps(
-      _mm_mul_ps(
-        dt,
-        _mm_add_ps(c1, tmp)
-      ),
-      _mm_add_ps(c2, tmp)
-    );
-  }
+  for (uint32_t i = 0; i < count; ++i)
+    data[i] *= mul;
+}
 
-  if (even != count)
+void CAEUtil::MulAddArray(float *data, float *add, const float mul, uint32_t count)
+{
+  switch (GetSIMDKernel())
   {
-    uint32_t odd = count - even;
-    if (odd == 1)
-      data[0] = SoftClamp(data[0]);
-    else
-    {
-      __m128 dt;
-      __m128 tmp;
-      __m128 out;
-      if (odd == 2)
-      {
-        /* tanh approx clamp */
-        dt  = _mm_setr_ps(data[0], data[1], 0, 0);
-        tmp = _mm_mul_ps(dt, dt);
-        out = _mm_div_ps(
-          _mm_mul_ps(
-            dt,
-            _mm_add_ps(c1, tmp)
-          ),
-          _mm_add_ps(c2, tmp)
-        );
-
-        data[0] = ((float*)&out)[0];
-        data[1] = ((float*)&out)[1];
-      }
-      else
-      {
-        /* tanh approx clamp */
-        dt  = _mm_setr_ps(data[0], data[1], data[2], 0);
-        tmp = _mm_mul_ps(dt, dt);
-        out = _mm_div_ps(
-          _mm_mul_ps(
-            dt,
-            _mm_add_ps(c1, tmp)
-          ),
-          _mm_add_ps(c2, tmp)
-        );
-
-        data[0] = ((float*)&out)[0];
-        data[1] = ((float*)&out)[1];
-        data[2] = ((float*)&out)[2];
-      }
-    }
-  }
+#if defined(AE_HAVE_AVX_KERNELS)
+    case AE_SIMD_AVX2:
+      MulAddArrayAVX2(data, add, mul, count);
+      return;
+    case AE_SIMD_AVX:
+      MulAddArrayAVX(data, add, mul, count);
+      return;
+#endif
+#if defined(HAVE_SSE) && defined(__SSE__)
+    case AE_SIMD_SSE:
+      SSEMulAddArray(data, add, mul, count);
+      return;
+#endif
+#if defined(AE_HAVE_NEON_KERNELS)
+    case AE_SIMD_NEON:
+      MulAddArrayNEON(data, add, mul, count);
+      return;
 #endif
+    default:
+      break;
+  }
+
+  for (uint32_t i = 0; i < count; ++i)
+    data[i] += add[i] * mul;
 }
 
 /*
@@ -142,9 +142,30 @@ private:
     static __m128i m_sseSeed;
   #endif
 
-  static float SoftClamp(const float x);
-
 public:
+  enum AESIMDKernel
+  {
+    AE_SIMD_NONE = 0,
+    AE_SIMD_SSE,
+    AE_SIMD_AVX,
+    AE_SIMD_AVX2,
+    AE_SIMD_NEON
+  };
+
+  /*! \brief the kernel used by MulArray, MulAddArray and ClampArray
+   By default the fastest one supported by the CPU.
+   */
+  static AESIMDKernel GetSIMDKernel();
+
+  /*! \brief whether a kernel was built in and is supported by the CPU
+   */
+  static bool IsSIMDKernelSupported(AESIMDKernel kernel);
+
+  /*! \brief use a specific kernel, meant for tests and benchmarks
+   \return false if the kernel isn't supported
+   */
+  static bool SetSIMDKernel(AESIMDKernel kernel);
+
   static CAEChannelInfo          GuessChLayout     (const unsigned int channels);
   static const char*             GetStdChLayoutName(const enum AEStdChLayout layout);
   static const unsigned int      DataFormatToBits  (const enum AEDataFormat dataFormat);
@@ -215,8 +236,25 @@ public:
   static void SSEMulArray     (float *data, const float mul, uint32_t count);
   static void SSEMulAddArray  (float *data, float *add, const float mul, uint32_t count);
   #endif
+
+  /*! \brief multiply all samples by a factor
+   Runs the fastest kernel supported by the CPU (AVX2, AVX, SSE or NEON, see CCPUInfo)
+   and falls back to plain C.
+   */
+  static void MulArray   (float *data, const float mul, uint32_t count);
+
+  /*! \brief add samples multiplied by a factor: data[i] += add[i] * mul
+   \sa MulArray
+   */
+  static void MulAddArray(float *data, float *add, const float mul, uint32_t count);
+
+  /*! \brief soft clamp all samples to -1.0 .. 1.0
+   \sa MulArray
+   */
   static void ClampArray(float *data, uint32_t count);
 
+  static float SoftClamp(const float x);
+
   /*
     Rand implementations based on:
     http://software.intel.com/en-us/articles/fast-random-number-generator-on-the-intel-pentiumr-4-processor/
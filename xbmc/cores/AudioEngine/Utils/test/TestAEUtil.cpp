@@ -0,0 +1,125 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEUtil.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+  // odd sizes and offsets make sure the unaligned heads and the scalar tails of the kernels are covered
+  const uint32_t sizes[] = { 0, 1, 3, 4, 7, 8, 15, 16, 33, 1027 };
+
+  const CAEUtil::AESIMDKernel kernels[] = { CAEUtil::AE_SIMD_NONE, CAEUtil::AE_SIMD_SSE, CAEUtil::AE_SIMD_AVX, CAEUtil::AE_SIMD_AVX2, CAEUtil::AE_SIMD_NEON };
+
+  // restores the kernel that was in use when a test switched through the kernels
+  class CKernelScope
+  {
+  public:
+    CKernelScope() : m_default(CAEUtil::GetSIMDKernel()) {}
+    ~CKernelScope() { CAEUtil::SetSIMDKernel(m_default); }
+  private:
+    CAEUtil::AESIMDKernel m_default;
+  };
+
+  std::vector<float> MakeSamples(uint32_t count, float range)
+  {
+    std::vector<float> samples(count + 1);
+    for (uint32_t i = 0; i < samples.size(); ++i)
+      samples[i] = range * ((float)((i * 7919) % 2001) / 1000.0f - 1.0f);
+    return samples;
+  }
+}
+
+TEST(TestAEUtil, MulArray)
+{
+  CKernelScope scope;
+  for (CAEUtil::AESIMDKernel kernel : kernels)
+  {
+    if (!CAEUtil::SetSIMDKernel(kernel))
+      continue;
+
+    for (uint32_t count : sizes)
+    {
+      std::vector<float> data(MakeSamples(count, 1.0f));
+      std::vector<float> expected(data);
+      for (uint32_t i = 1; i <= count; ++i)
+        expected[i] *= 0.3f;
+
+      CAEUtil::MulArray(&data[1], 0.3f, count);
+      for (uint32_t i = 0; i <= count; ++i)
+        EXPECT_FLOAT_EQ(expected[i], data[i]);
+    }
+  }
+}
+
+TEST(TestAEUtil, MulAddArray)
+{
+  CKernelScope scope;
+  for (CAEUtil::AESIMDKernel kernel : kernels)
+  {
+    if (!CAEUtil::SetSIMDKernel(kernel))
+      continue;
+
+    for (uint32_t count : sizes)
+    {
+      std::vector<float> data(MakeSamples(count, 1.0f));
+      std::vector<float> add(MakeSamples(count, 0.5f));
+      std::vector<float> expected(data);
+      for (uint32_t i = 1; i <= count; ++i)
+        expected[i] += add[i] * 0.7f;
+
+      CAEUtil::MulAddArray(&data[1], &add[1], 0.7f, count);
+      EXPECT_FLOAT_EQ(expected[0], data[0]);
+      // the AVX2 kernel rounds the fused multiply-add only once
+      for (uint32_t i = 1; i <= count; ++i)
+        EXPECT_NEAR(expected[i], data[i], 1e-6f);
+    }
+  }
+}
+
+TEST(TestAEUtil, ClampArray)
+{
+  CKernelScope scope;
+  for (CAEUtil::AESIMDKernel kernel : kernels)
+  {
+    if (!CAEUtil::SetSIMDKernel(kernel))
+      continue;
+
+    for (uint32_t count : sizes)
+    {
+      std::vector<float> data(MakeSamples(count, 4.0f));
+      std::vector<float> expected(data);
+      for (uint32_t i = 1; i <= count; ++i)
+        expected[i] = CAEUtil::SoftClamp(expected[i]);
+
+      CAEUtil::ClampArray(&data[1], count);
+      EXPECT_FLOAT_EQ(expected[0], data[0]);
+      for (uint32_t i = 1; i <= count; ++i)
+      {
+        EXPECT_NEAR(expected[i], data[i], 1e-5f);
+        EXPECT_LE(data[i], 1.0f + 1e-5f);
+        EXPECT_GE(data[i], -1.0f - 1e-5f);
+      }
+    }
+  }
+}
@@ -0,0 +1,116 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "cores/AudioEngine/Utils/AEUtil.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/* Compares the mixing kernels of CAEUtil. Every kernel supported by the CPU
+ * processes the same buffer of 8 channels of 1024 frames, the size ActiveAE
+ * mixes in, a fixed number of times. The time per sample is printed and
+ * recorded as test properties, so it ends up in the gtest xml output.
+ */
+
+namespace
+{
+  struct SKernel
+  {
+    CAEUtil::AESIMDKernel kernel;
+    const char *name;
+  };
+
+  const SKernel kernels[] =
+  {
+    { CAEUtil::AE_SIMD_NONE, "c" },
+    { CAEUtil::AE_SIMD_SSE,  "sse" },
+    { CAEUtil::AE_SIMD_AVX,  "avx" },
+    { CAEUtil::AE_SIMD_AVX2, "avx2" },
+    { CAEUtil::AE_SIMD_NEON, "neon" }
+  };
+
+  const uint32_t samples = 8 * 1024;
+  const int iterations = 2000;
+
+  template<typename Func>
+  double NanoSecondsPerSample(Func func)
+  {
+    typedef std::chrono::steady_clock clock;
+    clock::time_point start = clock::now();
+    for (int i = 0; i < iterations; ++i)
+      func();
+    std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+    return elapsed.count() / ((double)iterations * samples);
+  }
+}
+
+class TestAEUtilBenchmark : public ::testing::Test
+{
+protected:
+  TestAEUtilBenchmark() : m_default(CAEUtil::GetSIMDKernel()) {}
+  ~TestAEUtilBenchmark() { CAEUtil::SetSIMDKernel(m_default); }
+
+  void Record(const std::string &kernel, const std::string &op, double ns)
+  {
+    std::cout << "[ AEUtil   ] " << kernel << " " << op << ": " << ns << " ns/sample" << std::endl;
+    RecordProperty(kernel + "_" + op + "_ps_per_sample", static_cast<int>(ns * 1000.0));
+  }
+
+  CAEUtil::AESIMDKernel m_default;
+};
+
+TEST_F(TestAEUtilBenchmark, Kernels)
+{
+  std::vector<float> data(samples);
+  std::vector<float> add(samples);
+  for (uint32_t i = 0; i < samples; ++i)
+  {
+    data[i] = (float)((i * 7919) % 2001) / 1000.0f - 1.0f;
+    add[i] = data[samples - 1 - i] * 0.5f;
+  }
+
+  for (const auto &kernel : kernels)
+  {
+    if (!CAEUtil::SetSIMDKernel(kernel.kernel))
+      continue;
+
+    // gains cancel out, so the samples stay in range over all iterations
+    Record(kernel.name, "mul", NanoSecondsPerSample([&data]() {
+      CAEUtil::MulArray(data.data(), 0.5f, samples);
+      CAEUtil::MulArray(data.data(), 2.0f, samples);
+    }) / 2);
+    Record(kernel.name, "muladd", NanoSecondsPerSample([&data, &add]() {
+      CAEUtil::MulAddArray(data.data(), add.data(), 0.5f, samples);
+      CAEUtil::MulAddArray(data.data(), add.data(), -0.5f, samples);
+    }) / 2);
+
+    // clamping is idempotent for samples in range, start over from loud samples every time
+    std::vector<float> loud(samples);
+    Record(kernel.name, "clamp", NanoSecondsPerSample([&data, &loud]() {
+      for (uint32_t i = 0; i < samples; ++i)
+        loud[i] = data[i] * 3.0f;
+      CAEUtil::ClampArray(loud.data(), samples);
+    }));
+  }
+}
@@ -37,6 +37,7 @@ struct TextCacheStruct_t;
 class TiXmlElement;
 class CStreamDetails;
 class CAction;
+class CVariant;
 
 namespace PVR
 {
@@ -392,6 +393,11 @@ public:
   virtual void RenderCapture(unsigned int captureId, unsigned int width, unsigned int height, int flags) {};
   virtual bool RenderCaptureGetPixels(unsigned int captureId, unsigned int millis, uint8_t *buffer, unsigned int size) { return false; };
 
+  /*!
+   \brief frame pacing statistics of the renderer, optionally with the recorded frames
+   */
+  virtual bool GetFramePacing(CVariant &info, bool samples) { return false; };
+
   std::string m_name;
   std::string m_type;
 
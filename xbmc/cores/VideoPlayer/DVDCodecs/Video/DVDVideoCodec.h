@@ -125,6 +125,8 @@ struct DVDVideoPicture
   unsigned int iDisplayHeight;          //< height of the picture without black bars
 
   ERenderFormat format;
+
+  AVFrame*     avFrame;                 //< refcounted frame behind data[] of software pictures, may be referenced by the renderer
 };
 
 struct DVDVideoUserData
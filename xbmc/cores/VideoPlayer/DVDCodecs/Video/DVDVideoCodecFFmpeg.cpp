@@ -945,6 +945,7 @@ bool CDVDVideoCodecFFmpeg::GetPicture(DVDVideoPicture* pDvdVideoPicture)
     pDvdVideoPicture->data[i] = m_pFrame->data[i];
   for (int i = 0; i < 4; i++)
     pDvdVideoPicture->iLineSize[i] = m_pFrame->linesize[i];
+  pDvdVideoPicture->avFrame = m_pFrame;
 
   pDvdVideoPicture->iFlags |= pDvdVideoPicture->data[0] ? 0 : DVP_FLAG_DROPPED;
   pDvdVideoPicture->extended_format = 0;
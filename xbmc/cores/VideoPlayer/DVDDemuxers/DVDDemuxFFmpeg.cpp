@@ -27,6 +27,7 @@
 #include "cores/FFmpeg.h"
 #include "DVDClock.h" // for DVD_TIME_BASE
 #include "DVDDemuxUtils.h"
+#include "MatroskaSeekIndex.h"
 #include "DVDInputStreams/DVDInputStream.h"
 #include "DVDInputStreams/DVDInputStreamFFmpeg.h"
 #include "filesystem/CurlFile.h"
@@ -189,7 +190,7 @@ bool CDVDDemuxFFmpeg::Aborted()
   return false;
 }
 
-bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool fileinfo)
+bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool fileinfo, bool probe)
 {
   AVInputFormat* iformat = NULL;
   std::string strFile;
@@ -383,6 +384,10 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
     m_pFormatContext->pb = m_ioContext;
 
     AVDictionary *options = NULL;
+    // also bounds the search for pat/pmt in transport streams
+    if (probe)
+      av_dict_set_int(&options, "probesize", FFMPEG_PROBE_MAX_SIZE, 0);
+
     if (iformat->name && (strcmp(iformat->name, "mp3") == 0 || strcmp(iformat->name, "mp2") == 0))
     {
       CLog::Log(LOGDEBUG, "%s - setting usetoc to 0 for accurate VBR MP3 seek", __FUNCTION__);
@@ -449,8 +454,19 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
     if(m_pInput->IsStreamType(DVDSTREAM_TYPE_DVD))
       av_opt_set_int(m_pFormatContext, "analyzeduration", 500000, 0);
 
-    CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
-    int iErr = avformat_find_stream_info(m_pFormatContext, NULL);
+    int iErr = 0;
+    if (probe && HasCompleteHeaders())
+      CLog::Log(LOGDEBUG, "%s - using stream parameters of the %s headers", __FUNCTION__, m_pFormatContext->iformat->name);
+    else
+    {
+      if (probe)
+      {
+        av_opt_set_int(m_pFormatContext, "probesize", FFMPEG_PROBE_MAX_SIZE, 0);
+        av_opt_set_int(m_pFormatContext, "analyzeduration", FFMPEG_PROBE_MAX_DURATION, 0);
+      }
+      CLog::Log(LOGDEBUG, "%s - avformat_find_stream_info starting", __FUNCTION__);
+      iErr = avformat_find_stream_info(m_pFormatContext, NULL);
+    }
     if (iErr < 0)
     {
       CLog::Log(LOGWARNING,"could not find codec parameters for %s", CURL::GetRedacted(strFile).c_str());
@@ -491,6 +507,10 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
   // print some extra information
   av_dump_format(m_pFormatContext, 0, strFile.c_str(), 0);
 
+  // only playback seeks, opens for thumbs and stream details don't need the index
+  if (m_bMatroska && !fileinfo)
+    ApplySeekIndex();
+
   UpdateCurrentPTS();
 
   // in case of mpegts and we have not seen pat/pmt, defer creation of streams
@@ -529,6 +549,33 @@ bool CDVDDemuxFFmpeg::Open(CDVDInputStream* pInput, bool streaminfo, bool filein
   return true;
 }
 
+bool CDVDDemuxFFmpeg::HasCompleteHeaders()
+{
+  // matroska and mp4 describe their tracks in the header, other formats need packets
+  if (!m_bMatroska && strncmp(m_pFormatContext->iformat->name, "mov,", 4) != 0)
+    return false;
+
+  if (m_pFormatContext->duration <= 0 || m_pFormatContext->nb_streams == 0)
+    return false;
+
+  for (unsigned int i = 0; i < m_pFormatContext->nb_streams; i++)
+  {
+    AVCodecContext *codec = m_pFormatContext->streams[i]->codec;
+    if (codec->codec_type == AVMEDIA_TYPE_VIDEO)
+    {
+      if (codec->codec_id == AV_CODEC_ID_NONE || codec->width <= 0 || codec->height <= 0)
+        return false;
+    }
+    else if (codec->codec_type == AVMEDIA_TYPE_AUDIO)
+    {
+      // the dts profile, which tells dts-hd from dts, is only known from the bitstream
+      if (codec->codec_id == AV_CODEC_ID_NONE || codec->codec_id == AV_CODEC_ID_DTS || codec->channels <= 0)
+        return false;
+    }
+  }
+  return true;
+}
+
 void CDVDDemuxFFmpeg::Dispose()
 {
   m_pkt.result = -1;
@@ -1123,6 +1170,38 @@ bool CDVDDemuxFFmpeg::SeekTime(int time, bool backwords, double *startpts)
     return false;
 }
 
+void CDVDDemuxFFmpeg::ApplySeekIndex()
+{
+  // only plain files, positions in a stack do not belong to a single segment
+  std::string strFile = m_pInput->GetFileName();
+  if (!m_pInput->IsStreamType(DVDSTREAM_TYPE_FILE) ||
+      m_pInput->IsRealtime() ||
+      URIUtils::IsStack(strFile) ||
+      !m_pInput->Seek(0, SEEK_POSSIBLE))
+    return;
+
+  MatroskaSeekPoints points;
+  if (!CMatroskaSeekIndex::Load(strFile, points))
+  {
+    CMatroskaSeekIndex::BuildAsync(strFile);
+    return;
+  }
+
+  int idx = av_find_default_stream_index(m_pFormatContext);
+  if (idx < 0)
+    return;
+
+  // av_seek_frame picks the default stream, seeking in matroska goes through its index
+  // and skips to the next keyframe after the cluster
+  AVStream *stream = m_pFormatContext->streams[idx];
+  for (auto& point : points)
+  {
+    int64_t timestamp = av_rescale_q(point.time, AVRational{ 1, 1000 }, stream->time_base);
+    av_add_index_entry(stream, point.pos, timestamp, 0, 0, AVINDEX_KEYFRAME);
+  }
+  CLog::Log(LOGDEBUG, "%s - using %d stored seek points", __FUNCTION__, (int)points.size());
+}
+
 bool CDVDDemuxFFmpeg::SeekByte(int64_t pos)
 {
   CSingleLock lock(m_critSection);
@@ -82,6 +82,10 @@ public:
 
 #define FFMPEG_DVDNAV_BUFFER_SIZE 2048  // for dvd's
 
+// limits of the stream probing when only stream details are wanted
+#define FFMPEG_PROBE_MAX_SIZE     (1024 * 1024)
+#define FFMPEG_PROBE_MAX_DURATION (2 * AV_TIME_BASE)
+
 struct StereoModeConversionMap;
 
 class CDVDDemuxFFmpeg : public CDVDDemux
@@ -90,7 +94,12 @@ public:
   CDVDDemuxFFmpeg();
   virtual ~CDVDDemuxFFmpeg();
 
-  bool Open(CDVDInputStream* pInput, bool streaminfo = true, bool fileinfo = false);
+  /*!
+   \brief Open the demuxer.
+   \param probe only the stream parameters are of interest, e.g. for stream details. They are
+   taken from the headers of matroska and mp4 files, other files are probed with tight limits.
+   */
+  bool Open(CDVDInputStream* pInput, bool streaminfo = true, bool fileinfo = false, bool probe = false);
   void Dispose();
   void Reset() override ;
   void Flush() override;
@@ -136,6 +145,8 @@ protected:
   AVDictionary *GetFFMpegOptionsFromInput();
   double ConvertTimestamp(int64_t pts, int den, int num);
   void UpdateCurrentPTS();
+  void ApplySeekIndex();
+  bool HasCompleteHeaders();
   bool IsProgramChange();
 
   std::string GetStereoModeFromMetadata(AVDictionary *pMetadata);
@@ -36,7 +36,7 @@
 
 using namespace PVR;
 
-CDVDDemux* CDVDFactoryDemuxer::CreateDemuxer(CDVDInputStream* pInputStream, bool fileinfo)
+CDVDDemux* CDVDFactoryDemuxer::CreateDemuxer(CDVDInputStream* pInputStream, bool fileinfo, bool probe)
 {
   if (!pInputStream)
     return NULL;
@@ -120,7 +120,7 @@ CDVDDemux* CDVDFactoryDemuxer::CreateDemuxer(CDVDInputStream* pInputStream, bool
   }
 
   std::unique_ptr<CDVDDemuxFFmpeg> demuxer(new CDVDDemuxFFmpeg());
-  if(demuxer->Open(pInputStream, streaminfo, fileinfo))
+  if(demuxer->Open(pInputStream, streaminfo, fileinfo, probe))
   {
     CDVDDemux *pDemuxer = demuxer.release();
     if(CDemuxTimeline *timeline = CDemuxTimeline::CreateTimeline(pDemuxer))
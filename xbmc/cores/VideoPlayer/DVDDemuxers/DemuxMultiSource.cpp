@@ -23,9 +23,255 @@
 #include "DVDDemuxUtils.h"
 #include "DVDFactoryDemuxer.h"
 #include "DVDInputStreams/DVDInputStream.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
 #include "utils/log.h"
 #include "Util.h"
 
+#include <algorithm>
+#include <string.h>
+
+// read ahead of every source
+#define READER_MAX_PACKETS 500
+#define READER_MAX_BYTES   (8 * 1024 * 1024)
+
+// max time to wait for a source that has nothing queued but may
+// deliver a packet before the ones that are queued by the others
+#define READ_ORDER_TIMEOUT 20
+
+namespace
+{
+// copy of a source demuxer's stream, keeps the name the demuxer gave it
+template<class T>
+class CDemuxStreamCopy : public T
+{
+public:
+  CDemuxStreamCopy(const T& stream, const std::string& name) : T(stream), m_name(name)
+  {
+    if (stream.ExtraData)
+    {
+      this->ExtraData = new uint8_t[stream.ExtraSize];
+      memcpy(this->ExtraData, stream.ExtraData, stream.ExtraSize);
+    }
+  }
+
+  virtual std::string GetStreamName() override { return m_name; }
+
+private:
+  std::string m_name;
+};
+
+template<class T>
+CDemuxStream* CopyStream(CDemuxStream* stream)
+{
+  return new CDemuxStreamCopy<T>(*static_cast<T*>(stream), stream->GetStreamName());
+}
+
+CDemuxStream* CopyStream(CDemuxStream* stream)
+{
+  switch (stream->type)
+  {
+  case STREAM_VIDEO:
+    return CopyStream<CDemuxStreamVideo>(stream);
+  case STREAM_AUDIO:
+    return CopyStream<CDemuxStreamAudio>(stream);
+  case STREAM_SUBTITLE:
+    return CopyStream<CDemuxStreamSubtitle>(stream);
+  case STREAM_TELETEXT:
+    return CopyStream<CDemuxStreamTeletext>(stream);
+  case STREAM_RADIO_RDS:
+    return CopyStream<CDemuxStreamRadioRDS>(stream);
+  default:
+    return CopyStream<CDemuxStream>(stream);
+  }
+}
+}
+
+
+CDemuxSourceReader::CDemuxSourceReader(DemuxPtr demuxer, InputStreamPtr input, CEvent& packetEvent)
+  : CThread("DemuxSourceReader")
+  , m_demuxer(demuxer)
+  , m_input(input)
+  , m_queueBytes(0)
+  , m_eof(false)
+  , m_lastTime(DVD_NOPTS_VALUE)
+  , m_waiting(false)
+  , m_packetEvent(packetEvent)
+{
+  RefreshStreams();
+}
+
+CDemuxSourceReader::~CDemuxSourceReader()
+{
+  Stop();
+  Clear();
+}
+
+void CDemuxSourceReader::Start()
+{
+  Create();
+}
+
+void CDemuxSourceReader::Stop()
+{
+  m_bStop = true;
+  m_demuxer->Abort();
+  m_spaceEvent.Set();
+  StopThread(true);
+}
+
+void CDemuxSourceReader::Abort()
+{
+  m_demuxer->Abort();
+}
+
+void CDemuxSourceReader::Process()
+{
+  while (!m_bStop)
+  {
+    {
+      CSingleLock lock(m_queueSection);
+      if (m_eof || m_queue.size() >= READER_MAX_PACKETS || m_queueBytes >= READER_MAX_BYTES)
+      {
+        lock.Leave();
+        m_spaceEvent.WaitMSec(100);
+        continue;
+      }
+    }
+
+    CSingleLock lock(m_demuxSection);
+    DemuxPacket* packet = m_demuxer->Read();
+    if (packet)
+    {
+      UpdateStreams();
+      CSingleLock queueLock(m_queueSection);
+      m_queue.push_back({ packet, m_readStreams });
+      m_queueBytes += packet->iSize;
+      m_waiting = false;
+      m_packetEvent.Set();
+    }
+    else if (m_input->IsEOF())
+    {
+      CSingleLock queueLock(m_queueSection);
+      CLog::Log(LOGDEBUG, "%s - Demuxer for file %s is at eof",
+        __FUNCTION__, CURL::GetRedacted(m_demuxer->GetFileName()).c_str());
+      m_eof = true;
+      m_waiting = false;
+      m_packetEvent.Set();
+    }
+    else
+    {
+      lock.Leave();
+      Sleep(10);
+    }
+  }
+}
+
+void CDemuxSourceReader::UpdateStreams()
+{
+  std::vector<CDemuxStream*> streams = m_demuxer->GetStreams();
+  bool changed = streams.size() != m_streamKeys.size();
+  for (size_t i = 0; i < streams.size() && !changed; i++)
+  {
+    StreamKey key = { streams[i], streams[i]->codec, streams[i]->ExtraSize, streams[i]->changes };
+    changed = !(key == m_streamKeys[i]);
+  }
+  if (!changed)
+    return;
+
+  m_streamKeys.clear();
+  StreamsPtr copies(new DemuxStreams);
+  for (CDemuxStream* stream : streams)
+  {
+    m_streamKeys.push_back({ stream, stream->codec, stream->ExtraSize, stream->changes });
+    copies->push_back(std::unique_ptr<CDemuxStream>(CopyStream(stream)));
+  }
+  m_readStreams = copies;
+}
+
+void CDemuxSourceReader::RefreshStreams()
+{
+  m_streamKeys.clear();
+  UpdateStreams();
+
+  CSingleLock lock(m_queueSection);
+  m_streams = m_readStreams;
+}
+
+StreamsPtr CDemuxSourceReader::GetStreams()
+{
+  CSingleLock lock(m_queueSection);
+  return m_streams;
+}
+
+bool CDemuxSourceReader::Peek(double& time)
+{
+  CSingleLock lock(m_queueSection);
+  if (m_queue.empty())
+    return false;
+
+  DemuxPacket* packet = m_queue.front().packet;
+  time = packet->dts != DVD_NOPTS_VALUE ? packet->dts : packet->pts;
+  return true;
+}
+
+DemuxPacket* CDemuxSourceReader::Pop()
+{
+  CSingleLock lock(m_queueSection);
+  if (m_queue.empty())
+    return NULL;
+
+  DemuxPacket* packet = m_queue.front().packet;
+  m_streams = m_queue.front().streams;
+  m_queue.pop_front();
+  m_queueBytes -= packet->iSize;
+  m_lastTime = packet->dts != DVD_NOPTS_VALUE ? packet->dts : packet->pts;
+  m_spaceEvent.Set();
+  return packet;
+}
+
+bool CDemuxSourceReader::IsAwaited(bool hasNext, double time, unsigned int& millisLeft)
+{
+  CSingleLock lock(m_queueSection);
+  if (!m_queue.empty() || m_eof)
+    return false;
+
+  // packets come in dts order, a source that is already past the
+  // packet to hand out won't deliver one before it
+  if (hasNext && m_lastTime > time)
+    return false;
+
+  if (!m_waiting)
+  {
+    m_waiting = true;
+    m_waitTimeout.Set(READ_ORDER_TIMEOUT);
+  }
+  if (m_waitTimeout.IsTimePast())
+    return false;
+
+  millisLeft = m_waitTimeout.MillisLeft();
+  return true;
+}
+
+bool CDemuxSourceReader::IsEOF()
+{
+  CSingleLock lock(m_queueSection);
+  return m_eof && m_queue.empty();
+}
+
+void CDemuxSourceReader::Clear()
+{
+  CSingleLock lock(m_queueSection);
+  for (auto& entry : m_queue)
+    CDVDDemuxUtils::FreeDemuxPacket(entry.packet);
+  m_queue.clear();
+  m_queueBytes = 0;
+  m_eof = false;
+  m_lastTime = DVD_NOPTS_VALUE;
+  m_waiting = false;
+  m_spaceEvent.Set();
+}
+
 
 CDemuxMultiSource::CDemuxMultiSource()
 {
@@ -38,79 +284,84 @@ CDemuxMultiSource::~CDemuxMultiSource()
 
 void CDemuxMultiSource::Abort()
 {
-  for (auto& iter : m_demuxerMap)
+  for (auto& iter : m_readers)
     iter.second->Abort();
 }
 
 void CDemuxMultiSource::Dispose()
 {
-  while (!m_demuxerQueue.empty())
-  {
-    m_demuxerQueue.pop();
-  }
+  for (auto& iter : m_readers)
+    iter.second->Stop();
 
-  m_demuxerMap.clear();
-  m_DemuxerToInputStreamMap.clear();
+  m_readers.clear();
   m_pInput = NULL;
 
 }
 
 void CDemuxMultiSource::EnableStream(int64_t demuxerId, int id, bool enable)
 {
-  auto iter = m_demuxerMap.find(demuxerId);
-  if (iter != m_demuxerMap.end())
+  auto iter = m_readers.find(demuxerId);
+  if (iter != m_readers.end())
   {
-    DemuxPtr demuxer = iter->second;
-    demuxer->EnableStream(demuxerId, id, enable);
+    CSingleLock lock(iter->second->GetSection());
+    iter->second->GetDemuxer()->EnableStream(demuxerId, id, enable);
   }
 }
 
 void CDemuxMultiSource::Flush()
 {
-  for (auto& iter : m_demuxerMap)
-    iter.second->Flush();
+  for (auto& iter : m_readers)
+  {
+    CSingleLock lock(iter.second->GetSection());
+    iter.second->GetDemuxer()->Flush();
+    iter.second->Clear();
+  }
 }
 
 int CDemuxMultiSource::GetNrOfStreams() const
 {
   int streamsCount = 0;
-  for (auto& iter : m_demuxerMap)
-    streamsCount += iter.second->GetNrOfStreams();
+  for (auto& iter : m_readers)
+    streamsCount += iter.second->GetStreams()->size();
 
   return streamsCount;
 }
 
 CDemuxStream* CDemuxMultiSource::GetStream(int64_t demuxerId, int iStreamId) const
 {
-  auto iter = m_demuxerMap.find(demuxerId);
-  if (iter != m_demuxerMap.end())
+  auto iter = m_readers.find(demuxerId);
+  if (iter == m_readers.end())
+    return NULL;
+
+  // the copies stay alive until a later Read() or Reset() replaces them
+  StreamsPtr streams = iter->second->GetStreams();
+  for (auto& stream : *streams)
   {
-    return iter->second->GetStream(demuxerId, iStreamId);
+    if (stream->uniqueId == iStreamId)
+      return stream.get();
   }
-  else
-    return NULL;
+  return NULL;
 }
 
 std::vector<CDemuxStream*> CDemuxMultiSource::GetStreams() const
 {
   std::vector<CDemuxStream*> streams;
 
-  for (auto& iter : m_demuxerMap)
+  for (auto& iter : m_readers)
   {
-    for (auto& stream : iter.second->GetStreams())
-    {
-      streams.push_back(stream);
-    }
+    for (auto& stream : *iter.second->GetStreams())
+      streams.push_back(stream.get());
   }
   return streams;
 }
 
 std::string CDemuxMultiSource::GetStreamCodecName(int64_t demuxerId, int iStreamId)
 {
-  auto iter = m_demuxerMap.find(demuxerId);
-  if (iter != m_demuxerMap.end())
+  auto iter = m_readers.find(demuxerId);
+  if (iter != m_readers.end())
   {
-    return iter->second->GetStreamCodecName(demuxerId, iStreamId);
+    CSingleLock lock(iter->second->GetSection());
+    return iter->second->GetDemuxer()->GetStreamCodecName(demuxerId, iStreamId);
   }
   else
     return "";
@@ -119,9 +370,10 @@ std::string CDemuxMultiSource::GetStreamCodecName(int64_t demuxerId, int iStream
 int CDemuxMultiSource::GetStreamLength()
 {
   int length = 0;
-  for (auto& iter : m_demuxerMap)
+  for (auto& iter : m_readers)
   {
-    length = std::max(length, iter.second->GetStreamLength());
+    CSingleLock lock(iter.second->GetSection());
+    length = std::max(length, iter.second->GetDemuxer()->GetStreamLength());
   }
 
   return length;
@@ -148,70 +400,91 @@ bool CDemuxMultiSource::Open(CDVDInputStream* pInput)
     else
     {
       SetMissingStreamDetails(demuxer);
-
-      m_demuxerMap[demuxer->GetDemuxerId()] = demuxer;
-      m_DemuxerToInputStreamMap[demuxer] = *iter;
-      m_demuxerQueue.push(std::make_pair((double)DVD_NOPTS_VALUE, demuxer));
+      AddSource(demuxer, *iter);
       ++iter;
     }
   }
-  return !m_demuxerMap.empty();
+
+  return !m_readers.empty();
+}
+
+void CDemuxMultiSource::AddSource(DemuxPtr demuxer, InputStreamPtr input)
+{
+  // every source is read on its own thread so a slow one doesn't hold up the others
+  ReaderPtr reader(new CDemuxSourceReader(demuxer, input, m_packetEvent));
+  m_readers[demuxer->GetDemuxerId()] = reader;
+  reader->Start();
 }
 
 void CDemuxMultiSource::Reset()
 {
-  for (auto& iter : m_demuxerMap)
-    iter.second->Reset();
+  for (auto& iter : m_readers)
+  {
+    CSingleLock lock(iter.second->GetSection());
+    iter.second->GetDemuxer()->Reset();
+    iter.second->Clear();
+    iter.second->RefreshStreams();
+  }
 }
 
 DemuxPacket* CDemuxMultiSource::Read()
 {
-  if (m_demuxerQueue.empty())
-    return NULL;
-
-  DemuxPtr currentDemuxer = m_demuxerQueue.top().second;
-  m_demuxerQueue.pop();
-
-  if (!currentDemuxer)
-    return NULL;
+  // how long to wait for the readers when none of them has a packet
+  XbmcThreads::EndTime idleTimeout(READ_ORDER_TIMEOUT);
 
-  DemuxPacket* packet = currentDemuxer->Read();
-  if (packet)
+  while (true)
   {
-    double readTime = 0;
-    if (packet->dts != DVD_NOPTS_VALUE)
-      readTime = packet->dts;
-    else
-      readTime = packet->pts;
-    m_demuxerQueue.push(std::make_pair(readTime, currentDemuxer));
-  }
-  else
-  {
-    auto input = m_DemuxerToInputStreamMap.find(currentDemuxer);
-    if (input != m_DemuxerToInputStreamMap.end())
+    // merge the sources by dts
+    ReaderPtr next;
+    double nextTime = 0.0;
+    for (auto& iter : m_readers)
     {
-      if (input->second->IsEOF())
+      double time;
+      if (iter.second->Peek(time) && (!next || time < nextTime))
       {
-        CLog::Log(LOGDEBUG, "%s - Demuxer for file %s is at eof, removed it from the queue",
-          __FUNCTION__, CURL::GetRedacted(currentDemuxer->GetFileName()).c_str());
+        next = iter.second;
+        nextTime = time;
       }
-      else    //maybe add an error counter?
-        m_demuxerQueue.push(std::make_pair((double)DVD_NOPTS_VALUE, currentDemuxer));
     }
-  }
 
-  return packet;
+    // a source that has nothing queued yet might still deliver an earlier packet
+    bool waiting = false;
+    unsigned int wait = READ_ORDER_TIMEOUT;
+    for (auto& iter : m_readers)
+    {
+      unsigned int millisLeft;
+      if (iter.second != next && iter.second->IsAwaited(next != nullptr, nextTime, millisLeft))
+      {
+        waiting = true;
+        wait = std::min(wait, millisLeft);
+      }
+    }
+
+    if (next && !waiting)
+      return next->Pop();
+
+    if (!next && !waiting)
+    {
+      // all sources are at eof, or the player retries later
+      bool eof = std::all_of(m_readers.begin(), m_readers.end(),
+                             [](const std::pair<const int64_t, ReaderPtr>& reader) { return reader.second->IsEOF(); });
+      if (eof || idleTimeout.IsTimePast())
+        return NULL;
+      wait = idleTimeout.MillisLeft();
+    }
+
+    m_packetEvent.WaitMSec(std::max(1u, wait));
+  }
 }
 
 bool CDemuxMultiSource::SeekTime(int time, bool backwords, double* startpts)
 {
-  DemuxQueue demuxerQueue = DemuxQueue();
   bool ret = false;
-  for (auto& iter : m_demuxerMap)
+  for (auto& iter : m_readers)
   {
-    if (iter.second->SeekTime(time, false, startpts))
+    CSingleLock lock(iter.second->GetSection());
+    if (iter.second->GetDemuxer()->SeekTime(time, false, startpts))
     {
-      demuxerQueue.push(std::make_pair(*startpts, iter.second));
       CLog::Log(LOGDEBUG, "%s - starting demuxer from: %d", __FUNCTION__, time);
       ret = true;
     }
@@ -219,8 +492,8 @@ bool CDemuxMultiSource::SeekTime(int time, bool backwords, double* startpts)
     {
       CLog::Log(LOGDEBUG, "%s - failed to start demuxing from: %d", __FUNCTION__, time);
     }
+    iter.second->Clear();
   }
-  m_demuxerQueue = demuxerQueue;
   return ret;
 }
 
@@ -21,23 +21,127 @@
 #pragma once
 #include "DVDDemux.h"
 #include "DVDInputStreams/InputStreamMultiSource.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
 
+#include <deque>
 #include <map>
-#include <queue>
+#include <memory>
 #include <string>
-#include <utility>
 #include <vector>
 
 typedef std::shared_ptr<CDVDDemux> DemuxPtr;
 
-struct comparator{
-  bool operator() (std::pair<double, DemuxPtr> x, std::pair<double, DemuxPtr> y) const
+/*!
+ \brief Copies of the streams of a source demuxer
+ */
+typedef std::vector<std::unique_ptr<CDemuxStream>> DemuxStreams;
+typedef std::shared_ptr<DemuxStreams> StreamsPtr;
+
+/*!
+ \brief Reads the packets of one source ahead on a thread of its own
+
+ The demuxer must only be used with the lock of GetSection() held, the
+ thread holds it while reading. The player sees copies of the demuxer's
+ streams, taken whenever they change and handed out along with the first
+ packet read after the change, so they stay valid while the thread reads on.
+ */
+class CDemuxSourceReader : private CThread
+{
+public:
+  CDemuxSourceReader(DemuxPtr demuxer, InputStreamPtr input, CEvent& packetEvent);
+  virtual ~CDemuxSourceReader();
+
+  void Start();
+  void Stop();
+  void Abort();
+
+  /*!
+   \brief dts (pts if unknown) of the next packet, false if none is queued
+   */
+  bool Peek(double& time);
+  DemuxPacket* Pop();
+
+  /*!
+   \brief true if the merge has to wait for this source before handing out a packet
+   An empty source that is not at eof may still deliver an earlier packet. The
+   wait starts when the source is first found empty and ends when it queues a
+   packet again, so a slow source holds the others back once per stall, not
+   on every read.
+   \param hasNext true if there is a packet to hand out, at time
+   \param[out] millisLeft time left to wait for the source
+   */
+  bool IsAwaited(bool hasNext, double time, unsigned int& millisLeft);
+
+  /*!
+   \brief true if the source is at eof and all of its packets were read
+   */
+  bool IsEOF();
+
+  /*!
+   \brief drop the queued packets after the demuxer was seeked or flushed
+   */
+  void Clear();
+
+  /*!
+   \brief take new copies of the streams, with the lock of GetSection() held
+   */
+  void RefreshStreams();
+
+  /*!
+   \brief the streams as of the last packet returned by Pop
+   */
+  StreamsPtr GetStreams();
+
+  DemuxPtr GetDemuxer() const { return m_demuxer; }
+  CCriticalSection& GetSection() { return m_demuxSection; }
+
+protected:
+  virtual void Process() override;
+
+private:
+  struct StreamKey
   {
-    return x.first > y.first;
-  }
+    CDemuxStream* stream;
+    AVCodecID codec;
+    unsigned int extraSize;
+    int changes;
+
+    bool operator==(const StreamKey& other) const
+    {
+      return stream == other.stream && codec == other.codec &&
+             extraSize == other.extraSize && changes == other.changes;
+    }
+  };
+
+  struct QueuedPacket
+  {
+    DemuxPacket* packet;
+    StreamsPtr streams;
+  };
+
+  void UpdateStreams();
+
+  DemuxPtr m_demuxer;
+  InputStreamPtr m_input;
+  CCriticalSection m_demuxSection;
+  CCriticalSection m_queueSection;
+  std::deque<QueuedPacket> m_queue;
+  int m_queueBytes;
+  bool m_eof;
+  double m_lastTime;  // time of the last packet returned by Pop
+  bool m_waiting;     // the merge waits for a packet of this source
+  XbmcThreads::EndTime m_waitTimeout;
+  std::vector<StreamKey> m_streamKeys; // streams of the demuxer at the last copy
+  StreamsPtr m_readStreams;            // copies as of the last packet read
+  StreamsPtr m_streams;                // copies as of the last packet popped
+  CEvent m_spaceEvent;
+  CEvent& m_packetEvent;
 };
 
-typedef std::priority_queue<std::pair<double, DemuxPtr>, std::vector<std::pair<double, DemuxPtr>>, comparator> DemuxQueue;
+typedef std::shared_ptr<CDemuxSourceReader> ReaderPtr;
 
 class CDemuxMultiSource : public CDVDDemux
 {
@@ -62,12 +166,17 @@ public:
   bool SeekTime(int time, bool backwords = false, double* startpts = NULL);
   virtual void SetSpeed(int iSpeed) {};
 
+protected:
+  /*!
+   \brief start reading a source demuxer
+   */
+  void AddSource(DemuxPtr demuxer, InputStreamPtr input);
+
 private:
   void Dispose();
   void SetMissingStreamDetails(DemuxPtr demuxer);
 
   InputStreamMultiStreams* m_pInput = NULL;
-  std::map<DemuxPtr, InputStreamPtr> m_DemuxerToInputStreamMap;
-  DemuxQueue m_demuxerQueue;
-  std::map<int64_t, DemuxPtr> m_demuxerMap;
+  std::map<int64_t, ReaderPtr> m_readers;
+  CEvent m_packetEvent;
 };
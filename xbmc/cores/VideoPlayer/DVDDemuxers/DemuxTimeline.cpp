@@ -200,6 +200,10 @@ std::string CDemuxTimeline::GetStreamCodecName(int iStreamId)
 #define MATROSKA_ID_SEEKID 0x53AB
 #define MATROSKA_ID_SEEKPOS 0x53AC
 
+// private to this file, MatroskaParser.h uses the same names for its own types
+namespace
+{
+
 struct MatroskaFile;
 struct EbmlHeader;
 struct MatroskaSegment;
@@ -507,6 +511,8 @@ bool ParseMatroskaFile(MatroskaFile *mkv, CDVDInputStream *input, bool parseChap
   return true;
 }
 
+} // anonymous namespace
+
 CDemuxTimeline* CDemuxTimeline::CreateTimelineFromEbml(CDVDDemux *primaryDemuxer)
 {
   std::unique_ptr<CDVDInputStreamFile> inStream(new CDVDInputStreamFile(CFileItem(primaryDemuxer->GetFileName(), false)));
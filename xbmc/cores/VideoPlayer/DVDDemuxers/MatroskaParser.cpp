@@ -69,6 +69,19 @@ static const EbmlId MATROSKA_ID_CHAPLANG = 0x437C;
 static const EbmlId MATROSKA_ID_CHAPCOUNTRY = 0x437E;
 static const EbmlId MATROSKA_ID_CHAPTERPHYSEQUIV = 0x63C3;
 
+/* IDs in the cues master */
+static const EbmlId MATROSKA_ID_POINTENTRY = 0xBB;
+
+/* IDs in the pointentry master */
+static const EbmlId MATROSKA_ID_CUETIME = 0xB3;
+static const EbmlId MATROSKA_ID_CUETRACKPOSITION = 0xB7;
+
+/* IDs in the cuetrackposition master */
+static const EbmlId MATROSKA_ID_CUECLUSTERPOSITION = 0xF1;
+
+/* IDs in the cluster master */
+static const EbmlId MATROSKA_ID_CLUSTERTIMECODE = 0xE7;
+
 
 struct MatroskaSeekEntry
 {
@@ -157,9 +170,56 @@ EbmlMasterParser BindMatroskaChaptersParser(MatroskaChapters *chapters)
   return master;
 }
 
+EbmlMasterParser BindMatroskaSegmentInfoParser(MatroskaSegmentInfo *infos)
+{
+  EbmlMasterParser master;
+  master.parser[MATROSKA_ID_SEGMENTUID] = BindEbmlRawParser(&infos->uid, 16);
+  master.parser[MATROSKA_ID_TIMECODESCALE] = BindEbmlUintParser(&infos->timecodeScale);
+  return master;
+}
+
+EbmlMasterParser BindMatroskaCueTrackPositionParser(uint64_t *clusterPos)
+{
+  EbmlMasterParser master;
+  master.parser[MATROSKA_ID_CUECLUSTERPOSITION] = BindEbmlUintParser(clusterPos);
+  return master;
+}
+
+EbmlMasterParser BindMatroskaCuePointParser(MatroskaCuePoint *cuePoint, bool *hasPos)
+{
+  EbmlMasterParser master;
+  master.parser[MATROSKA_ID_CUETIME] = BindEbmlUintParser(&cuePoint->time);
+  master.parser[MATROSKA_ID_CUETRACKPOSITION] = [cuePoint,hasPos](CDVDInputStream *input, uint64_t tagLen)
+    {
+      // all tracks of a cue point share the cluster, the first position is enough
+      if (*hasPos)
+        return true;
+      *hasPos = BindMatroskaCueTrackPositionParser(&cuePoint->clusterPos)(input, tagLen);
+      return *hasPos;
+    };
+  return master;
+}
+
+EbmlMasterParser BindMatroskaCuesParser(MatroskaCues *cues, int64_t basePos = 0)
+{
+  EbmlMasterParser master;
+  master.parser[MATROSKA_ID_POINTENTRY] = [cues,basePos](CDVDInputStream *input, uint64_t tagLen)
+    {
+      MatroskaCuePoint cuePoint;
+      bool hasPos = false;
+      if (!BindMatroskaCuePointParser(&cuePoint, &hasPos)(input, tagLen) || !hasPos)
+        return false;
+      cuePoint.clusterPos += basePos;
+      cues->push_back(cuePoint);
+      return true;
+    };
+  return master;
+}
+
 EbmlMasterParser BindMatroskaSegmentParser(MatroskaSegment *segment)
 {
   EbmlMasterParser master;
+  master.parser[MATROSKA_ID_INFO] = BindMatroskaSegmentInfoParser(&segment->infos);
   master.parser[MATROSKA_ID_SEEKHEAD] = BindMatroskaSeekMapParser(&segment->seekMap, segment->offset);
   master.parser[MATROSKA_ID_CHAPTERS] = BindMatroskaChaptersParser(&segment->chapters);
   master.parser[MATROSKA_ID_CLUSTER]; // break on cluster
@@ -173,9 +233,73 @@ bool MatroskaSegment::Parse(CDVDInputStream *input)
     return false;
   if (!EbmlReadLen(input, &len))
     return false;
+  offset = input->Seek(0, SEEK_CUR);
+  length = len;
   return BindMatroskaSegmentParser(this)(input, len);
 }
 
+bool MatroskaSegment::ParseCues(CDVDInputStream *input, MatroskaCues *cues)
+{
+  auto it = seekMap.find(MATROSKA_ID_CUES);
+  if (it == seekMap.end())
+    return false;
+  uint64_t len;
+  if (input->Seek(it->second, SEEK_SET) < 0)
+    return false;
+  if (EbmlReadId(input) != MATROSKA_ID_CUES)
+    return false;
+  if (!EbmlReadLen(input, &len))
+    return false;
+  BindMatroskaCuesParser(cues, offset)(input, len);
+  return !cues->empty();
+}
+
+bool MatroskaSegment::ScanClusters(CDVDInputStream *input, MatroskaCues *cues)
+{
+  // only the head of every cluster is read, the blocks in between are skipped
+  int64_t end = offset + length;
+  int64_t fileLength = input->GetLength();
+  if (fileLength > 0 && (length > static_cast<uint64_t>(fileLength) || end > fileLength))
+    end = fileLength;
+
+  int64_t pos = offset;
+  while (pos < end && input->Seek(pos, SEEK_SET) == pos)
+  {
+    EbmlId id;
+    uint64_t len;
+    if (!EbmlReadId(input, &id) || !EbmlReadLen(input, &len))
+      break;
+    int64_t dataPos = input->Seek(0, SEEK_CUR);
+    if (len > static_cast<uint64_t>(end - dataPos))
+      break; // unknown size, e.g. a live recording
+
+    if (id == MATROSKA_ID_CLUSTER)
+    {
+      // the timecode is the first child, possibly behind a crc
+      for (int child = 0; child < 2; ++child)
+      {
+        EbmlId childId;
+        uint64_t childLen;
+        if (!EbmlReadId(input, &childId) || !EbmlReadLen(input, &childLen))
+          break;
+        if (childId == MATROSKA_ID_CLUSTERTIMECODE)
+        {
+          MatroskaCuePoint cuePoint;
+          if (EbmlReadUint(input, &cuePoint.time, childLen))
+          {
+            cuePoint.clusterPos = pos;
+            cues->push_back(cuePoint);
+          }
+          break;
+        }
+        input->Seek(childLen, SEEK_CUR);
+      }
+    }
+    pos = dataPos + len;
+  }
+  return !cues->empty();
+}
+
 bool MatroskaFile::Parse(CDVDInputStream *input)
 {
   offsetBegin = input->Seek(0, SEEK_CUR);
@@ -2,6 +2,8 @@
 
 #include "EbmlParser.h"
 
+#include <vector>
+
 using MatroskaSegmentUID = std::string;
 using MatroskaChapterDisplayMap = std::map<std::string,std::string>;
 
@@ -33,6 +35,14 @@ struct MatroskaChapters
 
 typedef std::multimap<EbmlId,uint64_t> MatroskaSeekMap;
 
+struct MatroskaCuePoint
+{
+  uint64_t time = 0;
+  uint64_t clusterPos = 0;
+};
+
+typedef std::vector<MatroskaCuePoint> MatroskaCues;
+
 struct MatroskaSegmentInfo
 {
   MatroskaSegmentUID uid;
@@ -41,12 +51,15 @@ struct MatroskaSegmentInfo
 
 struct MatroskaSegment
 {
-  int64_t offset;
+  int64_t offset = 0;
+  uint64_t length = 0;
   MatroskaSegmentInfo infos;
   MatroskaSeekMap seekMap;
   MatroskaChapters chapters;
 
   bool Parse(CDVDInputStream *input);
+  bool ParseCues(CDVDInputStream *input, MatroskaCues *cues);
+  bool ScanClusters(CDVDInputStream *input, MatroskaCues *cues);
 };
 
 struct MatroskaFile
@@ -0,0 +1,194 @@
+/*
+ *      Copyright (C) 2005-2016 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MatroskaSeekIndex.h"
+#include "MatroskaParser.h"
+#include "DVDInputStreams/DVDInputStreamFile.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/Crc32.h"
+#include "utils/JobManager.h"
+#include "utils/StringUtils.h"
+#include "utils/log.h"
+
+#include <string.h>
+
+using namespace XFILE;
+
+#define SEEK_INDEX_FOLDER  "special://temp/mkvindex/"
+#define SEEK_INDEX_VERSION 1
+
+// sanity limits for reading back a damaged file
+#define SEEK_INDEX_MAX_PATH   4096
+#define SEEK_INDEX_MAX_POINTS (1 << 22)
+
+namespace
+{
+struct SeekIndexHeader
+{
+  char     magic[4];
+  uint32_t version;
+  int64_t  size;
+  int64_t  mtime;
+  uint32_t count;
+  uint32_t pathLength;
+};
+
+const char SEEK_INDEX_MAGIC[4] = { 'M', 'K', 'V', 'I' };
+}
+
+CCriticalSection CMatroskaSeekIndex::m_section;
+std::set<std::string> CMatroskaSeekIndex::m_building;
+
+bool CMatroskaSeekIndex::Load(const std::string& path, MatroskaSeekPoints& points)
+{
+  std::string indexPath = GetIndexPath(path);
+  if (!CFile::Exists(indexPath))
+    return false;
+
+  CFile file;
+  if (!file.Open(indexPath))
+    return false;
+
+  SeekIndexHeader header;
+  if (file.Read(&header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, SEEK_INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != SEEK_INDEX_VERSION ||
+      header.pathLength > SEEK_INDEX_MAX_PATH ||
+      header.count == 0 || header.count > SEEK_INDEX_MAX_POINTS)
+    return false;
+
+  std::string storedPath(header.pathLength, '\0');
+  if (file.Read(&storedPath[0], header.pathLength) != static_cast<ssize_t>(header.pathLength) ||
+      storedPath != path)
+    return false;
+
+  int64_t size, mtime;
+  if (!GetFileKey(path, size, mtime) || size != header.size || mtime != header.mtime)
+  {
+    CLog::Log(LOGDEBUG, "CMatroskaSeekIndex::Load - index of %s is outdated", CURL::GetRedacted(path).c_str());
+    return false;
+  }
+
+  points.resize(header.count);
+  ssize_t bytes = header.count * sizeof(MatroskaSeekPoint);
+  if (file.Read(points.data(), bytes) != bytes)
+  {
+    points.clear();
+    return false;
+  }
+  return true;
+}
+
+void CMatroskaSeekIndex::BuildAsync(const std::string& path)
+{
+  {
+    CSingleLock lock(m_section);
+    if (!m_building.insert(path).second)
+      return;
+  }
+
+  CJobManager::GetInstance().Submit([path]() {
+    CDVDInputStreamFile input(CFileItem(path, false));
+    MatroskaSeekPoints points;
+    if (input.Open() && Build(&input, points))
+    {
+      if (Save(path, points))
+        CLog::Log(LOGDEBUG, "CMatroskaSeekIndex - stored %d seek points for %s", (int)points.size(), CURL::GetRedacted(path).c_str());
+    }
+    else
+      CLog::Log(LOGDEBUG, "CMatroskaSeekIndex - unable to index %s", CURL::GetRedacted(path).c_str());
+
+    CSingleLock lock(m_section);
+    m_building.erase(path);
+  });
+}
+
+bool CMatroskaSeekIndex::Build(CDVDInputStream* input, MatroskaSeekPoints& points)
+{
+  MatroskaFile mkv;
+  if (!mkv.Parse(input))
+    return false;
+
+  MatroskaSegment& segment = mkv.segment;
+  MatroskaCues cues;
+  if (!segment.ParseCues(input, &cues))
+  {
+    cues.clear();
+    if (!segment.ScanClusters(input, &cues))
+      return false;
+  }
+
+  points.clear();
+  points.reserve(cues.size());
+  for (auto& cue : cues)
+  {
+    MatroskaSeekPoint point;
+    point.time = cue.time * segment.infos.timecodeScale / 1000000;
+    point.pos = cue.clusterPos;
+    if (!points.empty() && point.time <= points.back().time)
+      continue;
+    points.push_back(point);
+  }
+  return !points.empty();
+}
+
+bool CMatroskaSeekIndex::Save(const std::string& path, const MatroskaSeekPoints& points)
+{
+  SeekIndexHeader header;
+  memcpy(header.magic, SEEK_INDEX_MAGIC, sizeof(header.magic));
+  header.version = SEEK_INDEX_VERSION;
+  header.count = points.size();
+  header.pathLength = path.size();
+  if (header.pathLength > SEEK_INDEX_MAX_PATH || header.count > SEEK_INDEX_MAX_POINTS)
+    return false;
+  if (!GetFileKey(path, header.size, header.mtime))
+    return false;
+
+  if (!CDirectory::Exists(SEEK_INDEX_FOLDER))
+    CDirectory::Create(SEEK_INDEX_FOLDER);
+
+  CFile file;
+  if (!file.OpenForWrite(GetIndexPath(path), true))
+    return false;
+
+  ssize_t bytes = points.size() * sizeof(MatroskaSeekPoint);
+  return file.Write(&header, sizeof(header)) == sizeof(header) &&
+         file.Write(path.c_str(), path.size()) == static_cast<ssize_t>(path.size()) &&
+         file.Write(points.data(), bytes) == bytes;
+}
+
+bool CMatroskaSeekIndex::GetFileKey(const std::string& path, int64_t& size, int64_t& mtime)
+{
+  struct __stat64 st;
+  if (CFile::Stat(path, &st) != 0)
+    return false;
+  size = st.st_size;
+  mtime = st.st_mtime;
+  return true;
+}
+
+std::string CMatroskaSeekIndex::GetIndexPath(const std::string& path)
+{
+  return StringUtils::Format(SEEK_INDEX_FOLDER "%08x.idx", Crc32::Compute(path));
+}
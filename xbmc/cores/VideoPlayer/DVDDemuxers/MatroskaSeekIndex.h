@@ -0,0 +1,71 @@
+/*
+ *      Copyright (C) 2005-2016 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include <set>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "threads/CriticalSection.h"
+
+class CDVDInputStream;
+
+struct MatroskaSeekPoint
+{
+  int64_t time; ///< ms from the start of the segment
+  int64_t pos;  ///< absolute byte position of the cluster
+};
+
+typedef std::vector<MatroskaSeekPoint> MatroskaSeekPoints;
+
+/*!
+ \brief Persistent seek index for matroska files.
+
+ The index is taken from the cues, or from the cluster heads when a file has
+ none, and stored below special://temp/mkvindex/. An index is only used as long
+ as size and modification time of the file match the ones it was built from.
+ */
+class CMatroskaSeekIndex
+{
+public:
+  /*!
+   \brief Load the stored index of a file.
+   \return false if there is none or the file changed since it was built
+   */
+  static bool Load(const std::string& path, MatroskaSeekPoints& points);
+
+  /*!
+   \brief Build and store the index of a file in a background job.
+   Does nothing while a job for the same file is still running.
+   */
+  static void BuildAsync(const std::string& path);
+
+  static bool Build(CDVDInputStream* input, MatroskaSeekPoints& points);
+
+private:
+  static bool Save(const std::string& path, const MatroskaSeekPoints& points);
+  static bool GetFileKey(const std::string& path, int64_t& size, int64_t& mtime);
+  static std::string GetIndexPath(const std::string& path);
+
+  static CCriticalSection m_section;
+  static std::set<std::string> m_building;
+};
@@ -51,10 +51,18 @@
 #include "cores/FFmpeg.h"
 #include "TextureCache.h"
 #include "Util.h"
+#include "utils/CPUInfo.h"
+#include "utils/JobManager.h"
 #include "utils/LangCodeExpander.h"
+#include "utils/StringUtils.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <functional>
 #include <memory>
+#include <utility>
 
 bool CDVDFileInfo::GetFileDuration(const std::string &path, int& duration)
 {
@@ -95,20 +103,251 @@ int DegreeToOrientation(int degrees)
   }
 }
 
+namespace
+{
+// decoded frames a decoder holds at most, used to estimate its memory
+const size_t THUMB_DECODER_FRAMES = 20;
+
+// packets per stream read after a seek before giving up on a picture
+const int THUMB_PACKETS_PER_STREAM = 160;
+
+// video packets without a keyframe after which all frames are decoded, half
+// the budget of a file with a single stream so there is time left for that
+const int THUMB_KEYFRAME_PACKETS = THUMB_PACKETS_PER_STREAM / 2;
+
+size_t GetThumbDecoderMemory(const CDVDStreamInfo &hint)
+{
+  return (size_t)hint.width * hint.height * 3 / 2 * THUMB_DECODER_FRAMES;
+}
+
+int GetThumbLowres(const CDVDStreamInfo &hint)
+{
+  // decode at the smallest scale still at least as wide as the cached image,
+  // decoders without lowres support clamp this to 0
+  int lowres = 0;
+  while (lowres < 3 && (unsigned int)(hint.width >> (lowres + 1)) >= g_advancedSettings.m_imageRes)
+    lowres++;
+  return lowres;
+}
+
+/* Runs a batch of tasks on the calling thread and on helper jobs. Every
+ * worker pulls task indices from the shared counter until none is left. The
+ * calling thread is a worker too, so the batch completes even if none of the
+ * helpers gets a job worker. It cancels the helpers that never started and
+ * only waits for the ones that took a task, never for queued ones, as it may
+ * run on a job worker itself. */
+class CBatchJob : public CJob
+{
+public:
+  /*! \brief Get the next task, false if none is left. */
+  typedef std::function<bool(size_t &task)> NextTask;
+
+  /*! \brief Work through tasks until next() returns false.
+   \return the amount the worker adds to the result of the batch.
+   */
+  typedef std::function<unsigned int(const NextTask &next)> Worker;
+
+  static unsigned int Run(size_t tasks, unsigned int threads, CJob::PRIORITY priority, const Worker &worker)
+  {
+    if (tasks == 0)
+      return 0;
+
+    std::shared_ptr<CState> state(new CState(tasks, worker));
+    if (threads == 0)
+      threads = g_cpuInfo.getCPUCount();
+    threads = std::max(1u, std::min<unsigned int>(threads, tasks));
+
+    std::vector<unsigned int> helpers;
+    for (unsigned int i = 1; i < threads; i++)
+      helpers.push_back(CJobManager::GetInstance().AddJob(new CBatchJob(state), nullptr, priority));
+
+    Work(*state);
+    for (unsigned int job : helpers)
+      CJobManager::GetInstance().CancelJob(job);
+
+    CSingleLock lock(state->m_critSection);
+    while (state->m_active > 0)
+      state->m_idle.wait(lock);
+    return state->m_result;
+  }
+
+  virtual bool DoWork() override
+  {
+    Work(*m_state);
+    return true;
+  }
+
+  virtual const char *GetType() const override { return "batch"; }
+
+private:
+  class CState
+  {
+  public:
+    CState(size_t tasks, const Worker &worker)
+      : m_tasks(tasks), m_worker(worker), m_next(0), m_result(0), m_active(0) {}
+
+    const size_t m_tasks;
+    const Worker m_worker;
+    CCriticalSection m_critSection;
+    XbmcThreads::ConditionVariable m_idle;
+    size_t m_next;
+    unsigned int m_result;
+    unsigned int m_active;
+  };
+
+  explicit CBatchJob(const std::shared_ptr<CState> &state) : m_state(state) {}
+
+  /* Workers only call the worker function if there was a task left when they
+   * started, so helpers starting after the batch returned touch nothing of
+   * the caller's. */
+  static void Work(CState &state)
+  {
+    {
+      CSingleLock lock(state.m_critSection);
+      if (state.m_next >= state.m_tasks)
+        return;
+      state.m_active++;
+    }
+
+    unsigned int result = state.m_worker([&state](size_t &task) {
+      CSingleLock lock(state.m_critSection);
+      if (state.m_next >= state.m_tasks)
+        return false;
+      task = state.m_next++;
+      return true;
+    });
+
+    CSingleLock lock(state.m_critSection);
+    state.m_result += result;
+    if (--state.m_active == 0)
+      state.m_idle.notifyAll();
+  }
+
+  std::shared_ptr<CState> m_state;
+};
+}
+
+void CDVDThumbMemoryBudget::Acquire(size_t size)
+{
+  CSingleLock lock(m_critSection);
+  // a single decoder is always admitted, even if it exceeds the limit on its own
+  while (m_used > 0 && m_used + size > m_limit)
+    m_released.wait(lock);
+  m_used += size;
+}
+
+void CDVDThumbMemoryBudget::Release(size_t size)
+{
+  CSingleLock lock(m_critSection);
+  m_used -= std::min(size, m_used);
+  m_released.notifyAll();
+}
+
+CDVDThumbDecoder::CDVDThumbDecoder(CDVDThumbMemoryBudget *budget)
+  : m_processInfo(CProcessInfo::CreateInstance())
+  , m_hint(new CDVDStreamInfo)
+  , m_codec(nullptr)
+  , m_budget(budget)
+  , m_reserved(0)
+  , m_keyframesOnly(true)
+{
+}
+
+CDVDThumbDecoder::~CDVDThumbDecoder()
+{
+  Close();
+}
+
+CDVDVideoCodec* CDVDThumbDecoder::Open(CDVDStreamInfo &hint)
+{
+  if (m_codec && m_keyframesOnly && m_hint->Equal(hint, true))
+  {
+    m_codec->Reset();
+    return m_codec;
+  }
+
+  Close();
+
+  CDVDCodecOptions options;
+  options.m_formats.push_back(RENDER_FMT_YUV420P);
+  options.m_opaque_pointer = nullptr;
+  options.m_keys.push_back(CDVDCodecOption("skip_frame", "nonkey"));
+  int lowres = GetThumbLowres(hint);
+  if (lowres > 0)
+    options.m_keys.push_back(CDVDCodecOption("lowres", StringUtils::Format("%d", lowres)));
+
+  m_reserved = GetThumbDecoderMemory(hint);
+  if (m_budget)
+    m_budget->Acquire(m_reserved);
+
+  CDVDVideoCodec *codec = new CDVDVideoCodecFFmpeg(*m_processInfo);
+  if (!codec->Open(hint, options))
+  {
+    delete codec;
+    Close();
+    return nullptr;
+  }
+
+  m_codec = codec;
+  m_hint->Assign(hint, true);
+  m_keyframesOnly = true;
+  return m_codec;
+}
+
+void CDVDThumbDecoder::DecodeAllFrames()
+{
+  if (m_codec && m_keyframesOnly)
+  {
+    m_codec->SetDropState(false);
+    m_keyframesOnly = false;
+  }
+}
+
+void CDVDThumbDecoder::Close()
+{
+  delete m_codec;
+  m_codec = nullptr;
+  m_hint->Clear();
+  if (m_budget && m_reserved)
+    m_budget->Release(m_reserved);
+  m_reserved = 0;
+}
+
 bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
                                 CTextureDetails &details,
                                 CStreamDetails *pStreamDetails, int pos)
 {
+  std::vector<CTextureDetails> allDetails(1, details);
+  std::vector<bool> extracted = ExtractThumbs(strPath, std::vector<int>(1, pos), allDetails, pStreamDetails);
+  details = allDetails[0];
+  return extracted[0];
+}
+
+std::vector<bool> CDVDFileInfo::ExtractThumbs(const std::string &strPath,
+                                              const std::vector<int> &positions,
+                                              std::vector<CTextureDetails> &details,
+                                              CStreamDetails *pStreamDetails,
+                                              CDVDThumbDecoder *decoder,
+                                              const CJob *job)
+{
+  std::vector<bool> extracted(positions.size(), false);
   std::string redactPath = CURL::GetRedacted(strPath);
   unsigned int nTime = XbmcThreads::SystemClockMillis();
   CFileItem item(strPath, false);
 
+  std::unique_ptr<CDVDThumbDecoder> localDecoder;
+  if (!decoder)
+  {
+    localDecoder.reset(new CDVDThumbDecoder);
+    decoder = localDecoder.get();
+  }
+
   item.SetMimeTypeForInternetFile();
   CDVDInputStream *pInputStream = CDVDFactoryInputStream::CreateInputStream(NULL, item);
   if (!pInputStream)
   {
     CLog::Log(LOGERROR, "InputStream: Error creating stream for %s", redactPath.c_str());
-    return false;
+    return extracted;
   }
 
   if (!pInputStream->Open())
@@ -116,7 +355,7 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
     CLog::Log(LOGERROR, "InputStream: Error opening, %s", redactPath.c_str());
     if (pInputStream)
       delete pInputStream;
-    return false;
+    return extracted;
   }
 
   CDVDDemux *pDemuxer = NULL;
@@ -128,7 +367,7 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
     {
       delete pInputStream;
       CLog::Log(LOGERROR, "%s - Error creating demuxer", __FUNCTION__);
-      return false;
+      return extracted;
     }
   }
   catch(...)
@@ -137,7 +376,7 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
     if (pDemuxer)
       delete pDemuxer;
     delete pInputStream;
-    return false;
+    return extracted;
   }
 
   if (pStreamDetails)
@@ -190,34 +429,47 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
     }
   }
 
-  bool bOk = false;
   int packetsTried = 0;
 
   if (nVideoStream != -1)
   {
-    CDVDVideoCodec *pVideoCodec;
-    std::unique_ptr<CProcessInfo> pProcessInfo(CProcessInfo::CreateInstance());
-
     CDVDStreamInfo hint(*pDemuxer->GetStream(demuxerId, nVideoStream), true);
     hint.software = true;
 
-    pVideoCodec = CDVDFactoryCodec::CreateVideoCodec(hint, *pProcessInfo);
+    CDVDVideoCodec *pVideoCodec = decoder->Open(hint);
 
     if (pVideoCodec)
     {
       int nTotalLen = pDemuxer->GetStreamLength();
-      int nSeekTo = (pos==-1) ? nTotalLen / 3 : pos;
+      struct SwsContext *context = NULL;
+      bool cancelled = false;
 
-      CLog::Log(LOGDEBUG,"%s - seeking to pos %dms (total: %dms) in %s", __FUNCTION__, nSeekTo, nTotalLen, redactPath.c_str());
-      if (pDemuxer->SeekTime(nSeekTo, true))
+      for (size_t i = 0; i < positions.size(); i++)
       {
+        // report the previous position as done before taking the next one
+        if (i > 0 && job && job->ShouldCancel(i, positions.size()))
+        {
+          cancelled = true;
+          break;
+        }
+
+        int nSeekTo = (positions[i]==-1) ? nTotalLen / 3 : positions[i];
+
+        CLog::Log(LOGDEBUG,"%s - seeking to pos %dms (total: %dms) in %s", __FUNCTION__, nSeekTo, nTotalLen, redactPath.c_str());
+        if (!pDemuxer->SeekTime(nSeekTo, true))
+          continue;
+
+        if (i > 0)
+          pVideoCodec->Reset();
+
         int iDecoderState = VC_ERROR;
         DVDVideoPicture picture;
 
         memset(&picture, 0, sizeof(picture));
 
         // num streams * 160 frames, should get a valid frame, if not abort.
-        int abort_index = pDemuxer->GetNrOfStreams() * 160;
+        int abort_index = pDemuxer->GetNrOfStreams() * THUMB_PACKETS_PER_STREAM;
+        int videoPackets = 0;
         do
         {
           DemuxPacket* pPacket = pDemuxer->Read();
@@ -232,6 +484,10 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
             continue;
           }
 
+          // only keyframes are decoded, fall back to all frames for streams that have too few
+          if (++videoPackets == THUMB_KEYFRAME_PACKETS)
+            decoder->DecodeAllFrames();
+
           iDecoderState = pVideoCodec->Decode(pPacket->pData, pPacket->iSize, pPacket->dts, pPacket->pts);
           CDVDDemuxUtils::FreeDemuxPacket(pPacket);
 
@@ -252,41 +508,41 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
 
         if (iDecoderState & VC_PICTURE && !(picture.iFlags & DVP_FLAG_DROPPED))
         {
-          {
-            unsigned int nWidth = g_advancedSettings.m_imageRes;
-            double aspect = (double)picture.iDisplayWidth / (double)picture.iDisplayHeight;
-            if(hint.forced_aspect && hint.aspect != 0)
-              aspect = hint.aspect;
-            unsigned int nHeight = (unsigned int)((double)g_advancedSettings.m_imageRes / aspect);
+          unsigned int nWidth = g_advancedSettings.m_imageRes;
+          double aspect = (double)picture.iDisplayWidth / (double)picture.iDisplayHeight;
+          if(hint.forced_aspect && hint.aspect != 0)
+            aspect = hint.aspect;
+          unsigned int nHeight = (unsigned int)((double)g_advancedSettings.m_imageRes / aspect);
 
-            uint8_t *pOutBuf = (uint8_t*)av_malloc(nWidth * nHeight * 4);
-            struct SwsContext *context = sws_getContext(picture.iWidth, picture.iHeight,
-                  AV_PIX_FMT_YUV420P, nWidth, nHeight, AV_PIX_FMT_BGRA, SWS_FAST_BILINEAR, NULL, NULL, NULL);
+          uint8_t *pOutBuf = (uint8_t*)av_malloc(nWidth * nHeight * 4);
+          context = sws_getCachedContext(context, picture.iWidth, picture.iHeight,
+                AV_PIX_FMT_YUV420P, nWidth, nHeight, AV_PIX_FMT_BGRA, SWS_FAST_BILINEAR, NULL, NULL, NULL);
 
-            if (context)
-            {
-              uint8_t *src[] = { picture.data[0], picture.data[1], picture.data[2], 0 };
-              int     srcStride[] = { picture.iLineSize[0], picture.iLineSize[1], picture.iLineSize[2], 0 };
-              uint8_t *dst[] = { pOutBuf, 0, 0, 0 };
-              int     dstStride[] = { (int)nWidth*4, 0, 0, 0 };
-              int orientation = DegreeToOrientation(hint.orientation);
-              sws_scale(context, src, srcStride, 0, picture.iHeight, dst, dstStride);
-              sws_freeContext(context);
-
-              details.width = nWidth;
-              details.height = nHeight;
-              CPicture::CacheTexture(pOutBuf, nWidth, nHeight, nWidth * 4, orientation, nWidth, nHeight, CTextureCache::GetCachedPath(details.file));
-              bOk = true;
-            }
-            av_free(pOutBuf);
+          if (context)
+          {
+            uint8_t *src[] = { picture.data[0], picture.data[1], picture.data[2], 0 };
+            int     srcStride[] = { picture.iLineSize[0], picture.iLineSize[1], picture.iLineSize[2], 0 };
+            uint8_t *dst[] = { pOutBuf, 0, 0, 0 };
+            int     dstStride[] = { (int)nWidth*4, 0, 0, 0 };
+            int orientation = DegreeToOrientation(hint.orientation);
+            sws_scale(context, src, srcStride, 0, picture.iHeight, dst, dstStride);
+
+            details[i].width = nWidth;
+            details[i].height = nHeight;
+            CPicture::CacheTexture(pOutBuf, nWidth, nHeight, nWidth * 4, orientation, nWidth, nHeight, CTextureCache::GetCachedPath(details[i].file));
+            extracted[i] = true;
           }
+          av_free(pOutBuf);
         }
         else
         {
           CLog::Log(LOGDEBUG,"%s - decode failed in %s after %d packets.", __FUNCTION__, redactPath.c_str(), packetsTried);
         }
       }
-      delete pVideoCodec;
+      sws_freeContext(context);
+
+      if (job && !cancelled && !positions.empty())
+        job->ShouldCancel(positions.size(), positions.size());
     }
   }
 
@@ -295,23 +551,70 @@ bool CDVDFileInfo::ExtractThumb(const std::string &strPath,
 
   delete pInputStream;
 
-  if(!bOk)
+  for (size_t i = 0; i < positions.size(); i++)
   {
-    XFILE::CFile file;
-    if(file.OpenForWrite(CTextureCache::GetCachedPath(details.file)))
-      file.Close();
+    if (!extracted[i])
+    {
+      XFILE::CFile file;
+      if(file.OpenForWrite(CTextureCache::GetCachedPath(details[i].file)))
+        file.Close();
+    }
   }
 
   unsigned int nTotalTime = XbmcThreads::SystemClockMillis() - nTime;
-  CLog::Log(LOGDEBUG,"%s - measured %u ms to extract thumb from file <%s> in %d packets. ", __FUNCTION__, nTotalTime, redactPath.c_str(), packetsTried);
-  return bOk;
+  CLog::Log(LOGDEBUG,"%s - measured %u ms to extract %u thumbs from file <%s> in %d packets. ", __FUNCTION__, nTotalTime,
+            (unsigned int)std::count(extracted.begin(), extracted.end(), true), redactPath.c_str(), packetsTried);
+  return extracted;
+}
+
+unsigned int CDVDFileInfo::ExtractThumbBatch(std::vector<DVDThumbRequest> &requests,
+                                             unsigned int threads,
+                                             size_t memoryLimit)
+{
+  if (requests.empty())
+    return 0;
+
+  // files of a folder are usually encoded alike, let one worker take all of
+  // them so it can keep its decoder open
+  std::vector<std::pair<size_t, size_t>> folders;
+  size_t first = 0;
+  std::string folder = URIUtils::GetDirectory(requests[0].path);
+  for (size_t i = 1; i <= requests.size(); i++)
+  {
+    std::string next = i < requests.size() ? URIUtils::GetDirectory(requests[i].path) : "";
+    if (i == requests.size() || next != folder)
+    {
+      folders.push_back(std::make_pair(first, i));
+      first = i;
+      folder = next;
+    }
+  }
+
+  std::shared_ptr<CDVDThumbMemoryBudget> budget(new CDVDThumbMemoryBudget(memoryLimit));
+  return CBatchJob::Run(folders.size(), threads, CJob::PRIORITY_LOW_PAUSABLE,
+    [&requests, folders, budget](const CBatchJob::NextTask &next) {
+      CDVDThumbDecoder decoder(budget.get());
+      unsigned int extracted = 0;
+      size_t task;
+      while (next(task))
+      {
+        for (size_t i = folders[task].first; i < folders[task].second; i++)
+        {
+          DVDThumbRequest &request = requests[i];
+          request.extracted = CDVDFileInfo::ExtractThumbs(request.path, request.positions, request.details, request.streamDetails, &decoder);
+          extracted += std::count(request.extracted.begin(), request.extracted.end(), true);
+        }
+      }
+      decoder.Close();
+      return extracted;
+    });
 }
 
 /**
  * \brief Open the item pointed to by pItem and extact streamdetails
  * \return true if the stream details have changed
  */
-bool CDVDFileInfo::GetFileStreamDetails(CFileItem *pItem)
+bool CDVDFileInfo::GetFileStreamDetails(CFileItem *pItem, bool probe)
 {
   if (!pItem)
     return false;
@@ -345,7 +648,7 @@ bool CDVDFileInfo::GetFileStreamDetails(CFileItem *pItem)
     return false;
   }
 
-  CDVDDemux *pDemuxer = CDVDFactoryDemuxer::CreateDemuxer(pInputStream, true);
+  CDVDDemux *pDemuxer = CDVDFactoryDemuxer::CreateDemuxer(pInputStream, true, probe);
   if (pDemuxer)
   {
     bool retVal = DemuxerToStreamDetails(pInputStream, pDemuxer, pItem->GetVideoInfoTag()->m_streamDetails, strFileNameAndPath);
@@ -360,6 +663,24 @@ bool CDVDFileInfo::GetFileStreamDetails(CFileItem *pItem)
   }
 }
 
+unsigned int CDVDFileInfo::GetFileStreamDetailsBatch(const std::vector<CFileItem*> &items, unsigned int threads)
+{
+  // most of the time is spent waiting for the file system, so probe several
+  // files at once. The workers keep their own copy of the list, the caller's
+  // may be gone before a helper that never got a task returns.
+  return CBatchJob::Run(items.size(), threads, CJob::PRIORITY_LOW,
+    [items](const CBatchJob::NextTask &next) {
+      unsigned int changed = 0;
+      size_t task;
+      while (next(task))
+      {
+        if (CDVDFileInfo::GetFileStreamDetails(items[task]))
+          changed++;
+      }
+      return changed;
+    });
+}
+
 bool CDVDFileInfo::DemuxerToStreamDetails(CDVDInputStream *pInputStream, CDVDDemux *pDemuxer, const std::vector<CStreamDetailSubtitle> &subs, CStreamDetails &details)
 {
   bool result = DemuxerToStreamDetails(pInputStream, pDemuxer, details);
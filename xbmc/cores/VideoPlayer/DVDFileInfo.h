@@ -20,15 +20,80 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "TextureCacheJob.h"
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+
 class CFileItem;
 class CDVDDemux;
+class CDVDStreamInfo;
+class CDVDVideoCodec;
+class CProcessInfo;
 class CStreamDetails;
 class CStreamDetailSubtitle;
 class CDVDInputStream;
-class CTextureDetails;
+class CJob;
+
+/** \brief Limits the memory held by the decoders of a thumbnail batch.
+ */
+class CDVDThumbMemoryBudget
+{
+public:
+  explicit CDVDThumbMemoryBudget(size_t limit) : m_limit(limit), m_used(0) {}
+
+  /** \brief Reserve size bytes, waits until other decoders released enough memory.
+   */
+  void Acquire(size_t size);
+  void Release(size_t size);
+
+private:
+  CCriticalSection m_critSection;
+  XbmcThreads::ConditionVariable m_released;
+  size_t m_limit;
+  size_t m_used;
+};
+
+/** \brief Software video decoder used for thumbnail extraction. Only keyframes are
+ *  decoded, at a reduced resolution where the codec supports it. The codec stays
+ *  open between files and is reused for files with identical stream parameters.
+ */
+class CDVDThumbDecoder
+{
+public:
+  explicit CDVDThumbDecoder(CDVDThumbMemoryBudget *budget = nullptr);
+  ~CDVDThumbDecoder();
+
+  /** \brief Get a decoder for the stream described by hint.
+   *  \return the decoder or nullptr if the stream can't be decoded.
+   */
+  CDVDVideoCodec* Open(CDVDStreamInfo &hint);
+
+  /** \brief Decode all frames from now on, for streams with too few keyframes.
+   */
+  void DecodeAllFrames();
+  void Close();
+
+private:
+  std::unique_ptr<CProcessInfo> m_processInfo;
+  std::unique_ptr<CDVDStreamInfo> m_hint;
+  CDVDVideoCodec *m_codec;
+  CDVDThumbMemoryBudget *m_budget;
+  size_t m_reserved;
+  bool m_keyframesOnly;
+};
+
+struct DVDThumbRequest
+{
+  std::string path;
+  std::vector<int> positions;           ///< positions in ms to take the images from, -1 for the default position
+  std::vector<CTextureDetails> details; ///< one per position, file names the cached image
+  std::vector<bool> extracted;          ///< set by the extraction, one per position
+  CStreamDetails *streamDetails = nullptr; ///< filled with the file's streams if set
+};
 
 class CDVDFileInfo
 {
@@ -38,8 +103,40 @@ public:
                            CTextureDetails &details,
                            CStreamDetails *pStreamDetails, int pos=-1);
 
-  // Probe the files streams and store the info in the VideoInfoTag
-  static bool GetFileStreamDetails(CFileItem *pItem);
+  /** \brief Extract thumbnail images from several positions of the media at strPath, opening it only once.
+  *   \param positions the positions in ms to take the images from, -1 takes the image at a third of the file.
+  *   \param[in,out] details one CTextureDetails per position, file names the cached image.
+  *   \param decoder decoder to use and keep open for the next file, a new one is used if nullptr.
+  *   \param job if set, reports every position that is done with CJob::ShouldCancel() and stops when cancelled.
+  *   \return one flag per position, true if the image was extracted.
+  */
+  static std::vector<bool> ExtractThumbs(const std::string &strPath,
+                                         const std::vector<int> &positions,
+                                         std::vector<CTextureDetails> &details,
+                                         CStreamDetails *pStreamDetails,
+                                         CDVDThumbDecoder *decoder = nullptr,
+                                         const CJob *job = nullptr);
+
+  /** \brief Extract the thumbnails of many files in parallel and wait for them.
+  *   \param threads amount of files decoded at once, 0 uses one per cpu.
+  *   \param memoryLimit bound in bytes on the estimated frame memory of all decoders together.
+  *   \return amount of extracted images.
+  */
+  static unsigned int ExtractThumbBatch(std::vector<DVDThumbRequest> &requests,
+                                        unsigned int threads = 0,
+                                        size_t memoryLimit = 256 * 1024 * 1024);
+
+  /** \brief Probe the files streams and store the info in the VideoInfoTag.
+  *   \param probe read only the container headers where possible instead of opening the file for playback.
+  */
+  static bool GetFileStreamDetails(CFileItem *pItem, bool probe = true);
+
+  /** \brief Probe the streams of many files in parallel.
+  *   The calling thread probes files itself, so this never waits on queued jobs.
+  *   \param threads amount of files probed at once, 0 uses one per cpu.
+  *   \return amount of items whose stream details changed.
+  */
+  static unsigned int GetFileStreamDetailsBatch(const std::vector<CFileItem*> &items, unsigned int threads = 0);
   static bool DemuxerToStreamDetails(CDVDInputStream* pInputStream, CDVDDemux *pDemux, CStreamDetails &details, const std::string &path = "");
 
   /** \brief Probe the file's internal and external streams and store the info in the StreamDetails parameter.
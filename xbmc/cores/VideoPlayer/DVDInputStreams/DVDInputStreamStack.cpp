@@ -22,17 +22,47 @@
 #include "FileItem.h"
 #include "filesystem/File.h"
 #include "filesystem/StackDirectory.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 
 #include <limits.h>
 
 using namespace XFILE;
 
+// start opening the next part when the read position gets this close to its start
+#define PREOPEN_DISTANCE (32 * 1024 * 1024)
+
+// how long to wait at the boundary for a pre-open that is still running
+#define PREOPEN_WAIT_MS 100
+
+class CDVDInputStreamStack::CPreOpenJob : public CJob
+{
+public:
+  explicit CPreOpenJob(const std::shared_ptr<TPreOpen>& preopen) : m_preopen(preopen) {}
+
+  virtual bool DoWork() override
+  {
+    TFile file(new CFile());
+    if (file->Open(m_preopen->path, READ_TRUNCATED))
+      m_preopen->file = file;
+    else
+      CLog::Log(LOGERROR, "CDVDInputStreamStack::PreOpenNext - failed to open stack part '%s'", m_preopen->path.c_str());
+    m_preopen->done.Set();
+    return true;
+  }
+
+private:
+  // the job keeps its own reference, the stream may be closed before it is done
+  std::shared_ptr<TPreOpen> m_preopen;
+};
+
 CDVDInputStreamStack::CDVDInputStreamStack(const CFileItem& fileitem) : CDVDInputStream(DVDSTREAM_TYPE_FILE, fileitem)
 {
   m_eof = true;
   m_pos = 0;
   m_length = 0;
+  m_segment = 0;
+  m_segmentStart = 0;
 }
 
 CDVDInputStreamStack::~CDVDInputStreamStack()
@@ -63,22 +93,37 @@ bool CDVDInputStreamStack::Open()
   m_length = 0;
   m_eof    = false;
 
+  // only the first part is opened now, the others when playback gets close to them
   for(int index = 0; index < items.Size(); index++)
   {
-    TFile file(new CFile());
+    TSeg segment;
+    segment.path = items[index]->GetPath();
 
-    if (!file->Open(items[index]->GetPath(), READ_TRUNCATED))
+    if (m_files.empty())
     {
-      CLog::Log(LOGERROR, "CDVDInputStreamStack::Open - failed to open stack part '%s' - skipping", items[index]->GetPath().c_str());
-      continue;
+      TFile file(new CFile());
+      if (!file->Open(segment.path, READ_TRUNCATED))
+      {
+        CLog::Log(LOGERROR, "CDVDInputStreamStack::Open - failed to open stack part '%s' - skipping", segment.path.c_str());
+        continue;
+      }
+      segment.file   = file;
+      segment.length = file->GetLength();
+    }
+    else
+    {
+      struct __stat64 st;
+      if (CFile::Stat(segment.path, &st) != 0)
+      {
+        CLog::Log(LOGERROR, "CDVDInputStreamStack::Open - failed to stat stack part '%s' - skipping", segment.path.c_str());
+        continue;
+      }
+      segment.length = st.st_size;
     }
-    TSeg segment;
-    segment.file   = file;
-    segment.length = file->GetLength();
 
     if(segment.length <= 0)
     {
-      CLog::Log(LOGERROR, "CDVDInputStreamStack::Open - failed to get file length for '%s' - skipping", items[index]->GetPath().c_str());
+      CLog::Log(LOGERROR, "CDVDInputStreamStack::Open - failed to get file length for '%s' - skipping", segment.path.c_str());
       continue;
     }
 
@@ -91,6 +136,8 @@ bool CDVDInputStreamStack::Open()
     return false;
 
   m_file = m_files[0].file;
+  m_segment = 0;
+  m_segmentStart = 0;
   m_eof  = false;
 
   return true;
@@ -102,9 +149,63 @@ void CDVDInputStreamStack::Close()
   CDVDInputStream::Close();
   m_files.clear();
   m_file.reset();
+  CancelPreOpen();
   m_eof = true;
 }
 
+CDVDInputStreamStack::TFile CDVDInputStreamStack::OpenPart(size_t index)
+{
+  TSeg& segment = m_files[index];
+  if (segment.file)
+    return segment.file;
+
+  std::shared_ptr<TPreOpen> preopen = m_preopen;
+  if (preopen && preopen->index == index)
+  {
+    // usually done long before the boundary is reached. If the job workers
+    // are busy with other jobs, don't stall playback and open it right here
+    if (preopen->done.WaitMSec(PREOPEN_WAIT_MS))
+      segment.file = preopen->file;
+    CancelPreOpen();
+  }
+
+  if (!segment.file)
+  {
+    TFile file(new CFile());
+    if (!file->Open(segment.path, READ_TRUNCATED))
+    {
+      CLog::Log(LOGERROR, "CDVDInputStreamStack::OpenPart - failed to open stack part '%s'", segment.path.c_str());
+      return TFile();
+    }
+    segment.file = file;
+  }
+  return segment.file;
+}
+
+void CDVDInputStreamStack::PreOpenNext()
+{
+  size_t next = m_segment + 1;
+  if (next >= m_files.size() || m_files[next].file || m_preopen)
+    return;
+
+  if (m_segmentStart + m_files[m_segment].length - m_pos > PREOPEN_DISTANCE)
+    return;
+
+  std::shared_ptr<TPreOpen> preopen(new TPreOpen);
+  preopen->index = next;
+  preopen->path  = m_files[next].path;
+  preopen->jobId = CJobManager::GetInstance().AddJob(new CPreOpenJob(preopen), nullptr);
+  m_preopen = preopen;
+}
+
+void CDVDInputStreamStack::CancelPreOpen()
+{
+  // removes the job if it is still queued, a running one finishes on its own
+  if (m_preopen)
+    CJobManager::GetInstance().CancelJob(m_preopen->jobId);
+  m_preopen.reset();
+}
+
 int CDVDInputStreamStack::Read(uint8_t* buf, int buf_size)
 {
   if(m_file == NULL || m_eof)
@@ -129,6 +230,8 @@ int CDVDInputStreamStack::Read(uint8_t* buf, int buf_size)
 
   m_pos += ret;
 
+  PreOpenNext();
+
   return (int)ret;
 }
 
@@ -146,12 +249,15 @@ int64_t CDVDInputStreamStack::Seek(int64_t offset, int whence)
     return -1;
 
   len = 0;
-  for(TSegVec::iterator it = m_files.begin(); it != m_files.end(); ++it)
+  for(size_t index = 0; index < m_files.size(); index++)
   {
-    if(len + it->length > pos)
+    if(len + m_files[index].length > pos)
     {
-      TFile   file     = it->file;
+      TFile   file     = OpenPart(index);
       int64_t file_pos = pos - len;
+      if(!file)
+        return -1;
+
       if(file->GetPosition() != file_pos)
       {
         if(file->Seek(file_pos, SEEK_SET) < 0)
@@ -159,11 +265,18 @@ int64_t CDVDInputStreamStack::Seek(int64_t offset, int whence)
       }
 
       m_file = file;
+      m_segment = index;
+      m_segmentStart = len;
       m_pos  = pos;
       m_eof  = false;
+
+      // a part opened ahead for the old position is of no use after a seek
+      // and would keep the part after the new position from being opened ahead
+      if (m_preopen && m_preopen->index != m_segment + 1)
+        CancelPreOpen();
       return pos;
     }
-    len += it->length;
+    len += m_files[index].length;
   }
 
   return -1;
@@ -21,7 +21,10 @@
  */
 
 #include "DVDInputStream.h"
+#include "threads/CriticalSection.h"
+#include "threads/Event.h"
 #include <memory>
+#include <string>
 #include <vector>
 
 class CDVDInputStreamStack : public CDVDInputStream
@@ -44,15 +47,35 @@ protected:
 
   struct TSeg
   {
-    TFile   file;
+    std::string path;
+    TFile   file;   ///< opened when first needed
     int64_t length;
   };
 
+  /// a part that is opened in the background, ahead of the boundary
+  struct TPreOpen
+  {
+    size_t          index;
+    std::string     path;
+    TFile           file;
+    CEvent          done;
+    unsigned int    jobId;
+  };
+
+  class CPreOpenJob;
+
   typedef std::vector<TSeg> TSegVec;
 
-  TSegVec m_files;  ///< collection of open ptr's to all files in stack
+  TFile OpenPart(size_t index);
+  void  PreOpenNext();
+  void  CancelPreOpen();
+
+  TSegVec m_files;  ///< collection of all files in stack
   TFile   m_file;   ///< currently active file
+  size_t  m_segment; ///< index of the active file
+  int64_t m_segmentStart; ///< position of the active file in the stack
   bool    m_eof;
   int64_t m_pos;
   int64_t m_length;
+  std::shared_ptr<TPreOpen> m_preopen;
 };
@@ -21,6 +21,7 @@
 #include "DVDFactorySubtitle.h"
 
 #include "DVDSubtitleStream.h"
+#include "DVDSubtitleIndexCache.h"
 //#include "DVDSubtitleParserSpu.h"
 #include "DVDSubtitleParserSubrip.h"
 #include "DVDSubtitleParserMicroDVD.h"
@@ -35,6 +36,16 @@ CDVDSubtitleParser* CDVDFactorySubtitle::CreateParser(std::string& strFile)
   int i;
   CDVDSubtitleParser* pParser = NULL;
 
+  // the file was indexed before, the parser picks up the cached index in Open
+  std::string strParser;
+  if (CDVDSubtitleIndexCache::GetInstance().Get(strFile, strParser))
+  {
+    if (strParser == SUBRIP_PARSER_NAME)
+      return new CDVDSubtitleParserSubrip(NULL, strFile.c_str());
+    else if (strParser == SSA_PARSER_NAME)
+      return new CDVDSubtitleParserSSA(NULL, strFile.c_str());
+  }
+
   CDVDSubtitleStream* pStream = new CDVDSubtitleStream();
   if(!pStream->Open(strFile))
   {
@@ -0,0 +1,111 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDSubtitleIndexCache.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+
+#define MAX_CACHED_INDEXES 8
+
+CDVDSubtitleIndexCache& CDVDSubtitleIndexCache::GetInstance()
+{
+  static CDVDSubtitleIndexCache instance;
+  return instance;
+}
+
+bool CDVDSubtitleIndexCache::GetFileStamp(const std::string& strFile, int64_t& iModified, int64_t& iSize)
+{
+  struct __stat64 st;
+  if (XFILE::CFile::Stat(strFile, &st) != 0)
+    return false;
+
+  iModified = st.st_mtime;
+  iSize = st.st_size;
+  return true;
+}
+
+std::shared_ptr<CDVDSubtitleIndex> CDVDSubtitleIndexCache::Get(const std::string& strFile, std::string& strParser)
+{
+  int64_t iModified, iSize;
+  if (!GetFileStamp(strFile, iModified, iSize))
+    return std::shared_ptr<CDVDSubtitleIndex>();
+
+  CSingleLock lock(m_critSection);
+  for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+  {
+    if (it->strFile != strFile)
+      continue;
+
+    if (it->iModified != iModified || it->iSize != iSize)
+    {
+      m_entries.erase(it);
+      break;
+    }
+
+    m_entries.splice(m_entries.begin(), m_entries, it);
+    strParser = it->strParser;
+    return it->index;
+  }
+  return std::shared_ptr<CDVDSubtitleIndex>();
+}
+
+void CDVDSubtitleIndexCache::Add(const std::string& strFile, const std::string& strParser, const std::shared_ptr<CDVDSubtitleIndex>& index, bool bTransient)
+{
+  SEntry entry;
+  if (!index || !GetFileStamp(strFile, entry.iModified, entry.iSize))
+    return;
+
+  entry.strFile = strFile;
+  entry.strParser = strParser;
+  entry.bTransient = bTransient;
+  entry.index = index;
+
+  CSingleLock lock(m_critSection);
+  for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+  {
+    if (it->strFile == strFile)
+    {
+      m_entries.erase(it);
+      break;
+    }
+  }
+
+  m_entries.push_front(entry);
+  if (m_entries.size() > MAX_CACHED_INDEXES)
+    m_entries.pop_back();
+}
+
+void CDVDSubtitleIndexCache::ClearTransient()
+{
+  CSingleLock lock(m_critSection);
+  for (auto it = m_entries.begin(); it != m_entries.end();)
+  {
+    if (it->bTransient)
+      it = m_entries.erase(it);
+    else
+      ++it;
+  }
+}
+
+void CDVDSubtitleIndexCache::Clear()
+{
+  CSingleLock lock(m_critSection);
+  m_entries.clear();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "DVDSubtitleLineCollection.h"
+#include "threads/CriticalSection.h"
+
+#include <list>
+#include <memory>
+#include <string>
+
+// keeps the parsed index of the most recently opened subtitle files, so
+// switching between subtitles doesn't parse a file again. an entry is valid
+// as long as modification time and size of the file don't change
+class CDVDSubtitleIndexCache
+{
+public:
+  static CDVDSubtitleIndexCache& GetInstance();
+
+  // get the index of strFile and the name of the parser that created it
+  std::shared_ptr<CDVDSubtitleIndex> Get(const std::string& strFile, std::string& strParser);
+
+  // bTransient marks indexes holding resources of the running playback,
+  // they are dropped by ClearTransient
+  void Add(const std::string& strFile, const std::string& strParser, const std::shared_ptr<CDVDSubtitleIndex>& index, bool bTransient = false);
+
+  void ClearTransient();
+  void Clear();
+
+private:
+  CDVDSubtitleIndexCache() {}
+
+  typedef struct
+  {
+    std::string strFile;
+    std::string strParser;
+    int64_t iModified;
+    int64_t iSize;
+    bool bTransient;
+    std::shared_ptr<CDVDSubtitleIndex> index;
+  } SEntry;
+
+  static bool GetFileStamp(const std::string& strFile, int64_t& iModified, int64_t& iSize);
+
+  std::list<SEntry> m_entries; // most recently used first
+  CCriticalSection m_critSection;
+};
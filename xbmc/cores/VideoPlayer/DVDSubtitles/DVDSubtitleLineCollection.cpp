@@ -19,16 +19,20 @@
  */
 
 #include "DVDSubtitleLineCollection.h"
+#include "threads/SingleLock.h"
+
+#include <algorithm>
 #include <stddef.h>
 
+CDVDSubtitleIndex::~CDVDSubtitleIndex()
+{
+  for (auto& line : m_lines)
+    line.pOverlay->Release();
+}
 
 CDVDSubtitleLineCollection::CDVDSubtitleLineCollection()
 {
-  m_pHead = NULL;
-  m_pCurrent = NULL;
-  m_pTail = NULL;
-
-  m_iSize = 0;
+  m_current = 0;
 }
 
 CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
@@ -36,87 +40,119 @@ CDVDSubtitleLineCollection::~CDVDSubtitleLineCollection()
   Clear();
 }
 
-void CDVDSubtitleLineCollection::Add(CDVDOverlay* pOverlay)
+void CDVDSubtitleLineCollection::Add(CDVDOverlay* pOverlay, const std::string& payload)
 {
-  ListElement* pElement = new ListElement;
-  pElement->pOverlay = pOverlay;
-  pElement->pNext = NULL;
-
-  if (!m_pHead)
-  {
-    m_pHead = m_pTail = pElement;
-    m_pCurrent = m_pHead;
-  }
-  else
-  {
-    m_pTail->pNext = pElement;
-    m_pTail = pElement;
-  }
-
-  m_iSize++;
+  if (!m_index)
+    m_index.reset(new CDVDSubtitleIndex);
+
+  CDVDSubtitleIndex::SLine line;
+  line.pOverlay = pOverlay;
+  line.payload = payload;
+  m_index->m_lines.push_back(line);
+  m_index->m_bSorted = false;
 }
 
 void CDVDSubtitleLineCollection::Sort()
 {
-  if (!m_pHead || !m_pHead->pNext)
+  if (!m_index)
     return;
-  
-  for (ListElement* p1 = m_pHead; p1->pNext != NULL; p1 = p1->pNext)
+
+  std::vector<CDVDSubtitleIndex::SLine>& lines = m_index->m_lines;
+  std::stable_sort(lines.begin(), lines.end(), [](const CDVDSubtitleIndex::SLine& l, const CDVDSubtitleIndex::SLine& r)
   {
-    for (ListElement* p2 = p1->pNext; p2 != NULL; p2 = p2->pNext)
-    {
-      if (p1->pOverlay->iPTSStartTime > p2->pOverlay->iPTSStartTime)
-      {
-        CDVDOverlay* temp = p1->pOverlay;
-        p1->pOverlay = p2->pOverlay;
-        p2->pOverlay = temp;
-      }
-    }
+    return l.pOverlay->iPTSStartTime < r.pOverlay->iPTSStartTime;
+  });
+
+  // stop times aren't sorted, their running maximum is. the first line
+  // where it reaches a pts is the first line that ends at or after it
+  m_index->m_maxStopTime.resize(lines.size());
+  double maxStopTime = 0.0;
+  for (size_t i = 0; i < lines.size(); i++)
+  {
+    maxStopTime = std::max(maxStopTime, lines[i].pOverlay->iPTSStopTime);
+    m_index->m_maxStopTime[i] = maxStopTime;
   }
+  m_index->m_bSorted = true;
+}
+
+size_t CDVDSubtitleLineCollection::Find(double iPts) const
+{
+  const std::vector<CDVDSubtitleIndex::SLine>& lines = m_index->m_lines;
+  const std::vector<double>& maxStopTime = m_index->m_maxStopTime;
+
+  // all lines before the cursor are done, search the rest
+  size_t first = std::lower_bound(maxStopTime.begin(), maxStopTime.end(), iPts) - maxStopTime.begin();
+  if (first >= m_current)
+    return first;
+
+  // a line ending before iPts can still follow the cursor, walk from there
+  size_t i = m_current;
+  while (i < lines.size() && lines[i].pOverlay->iPTSStopTime < iPts)
+    i++;
+  return i;
 }
 
 CDVDOverlay* CDVDSubtitleLineCollection::Get(double iPts)
 {
-  CDVDOverlay* pOverlay = NULL;
+  if (!m_index)
+    return NULL;
 
-  if (m_pCurrent)
-  {
-    while (m_pCurrent && m_pCurrent->pOverlay->iPTSStopTime < iPts)
-    {
-      m_pCurrent = m_pCurrent->pNext;
-    }
+  if (!m_index->m_bSorted)
+    Sort();
 
-    if (m_pCurrent)
-    {
-      pOverlay = m_pCurrent->pOverlay;
+  m_current = Find(iPts);
+  if (m_current >= m_index->m_lines.size())
+    return NULL;
+
+  // advance to the next overlay
+  return m_index->m_lines[m_current++].pOverlay;
+}
+
+CDVDOverlay* CDVDSubtitleLineCollection::Get(double iPts, double iMaxStartTime, IDVDSubtitleLineDecoder* pDecoder)
+{
+  if (!m_index)
+    return NULL;
 
-      // advance to the next overlay
-      m_pCurrent = m_pCurrent->pNext;
+  if (!m_index->m_bSorted)
+    Sort();
+
+  m_current = Find(iPts);
+  if (m_current >= m_index->m_lines.size())
+    return NULL;
+
+  CDVDSubtitleIndex::SLine& line = m_index->m_lines[m_current];
+  if (line.pOverlay->iPTSStartTime > iMaxStartTime)
+    return NULL;
+
+  {
+    // the index may be shared, decode each line only once
+    CSingleLock lock(m_index->m_critSection);
+    if (!line.payload.empty())
+    {
+      if (pDecoder)
+        pDecoder->DecodeLine(line.pOverlay, line.payload);
+      line.payload.clear();
     }
   }
-  return pOverlay;
+
+  // advance to the next overlay
+  m_current++;
+  return line.pOverlay;
 }
 
 void CDVDSubtitleLineCollection::Reset()
 {
-  m_pCurrent = m_pHead;
+  m_current = 0;
 }
 
-void CDVDSubtitleLineCollection::Clear()
+void CDVDSubtitleLineCollection::SetIndex(const std::shared_ptr<CDVDSubtitleIndex>& index)
 {
-  ListElement* pElement = NULL;
-
-  while (m_pHead)
-  {
-    pElement = m_pHead;
-    m_pHead = pElement->pNext;
-
-    pElement->pOverlay->Release();
-    delete pElement;
-  }
+  m_index = index;
+  m_current = 0;
+}
 
-  m_pTail    = NULL;
-  m_pHead    = NULL;
-  m_pCurrent = NULL;
-  m_iSize    = 0;
+void CDVDSubtitleLineCollection::Clear()
+{
+  m_index.reset();
+  m_current = 0;
 }
@@ -21,13 +21,40 @@
  */
 
 #include "../DVDCodecs/Overlay/DVDOverlay.h"
+#include "threads/CriticalSection.h"
 
-typedef struct stListElement
+#include <memory>
+#include <string>
+#include <vector>
+
+class IDVDSubtitleLineDecoder
 {
-  CDVDOverlay* pOverlay;
-  struct stListElement* pNext;
+public:
+  virtual ~IDVDSubtitleLineDecoder() {}
+
+  // decode the payload stored with an overlay into the overlay on first use
+  virtual void DecodeLine(CDVDOverlay* pOverlay, const std::string& payload) = 0;
+};
+
+// the overlays of a subtitle file sorted by start time. once sorted the index
+// can be shared by several collections, see CDVDSubtitleIndexCache
+class CDVDSubtitleIndex
+{
+public:
+  typedef struct
+  {
+    CDVDOverlay* pOverlay;
+    std::string payload; // not yet decoded content of the overlay
+  } SLine;
 
-} ListElement;
+  CDVDSubtitleIndex() : m_bSorted(false) {}
+  ~CDVDSubtitleIndex();
+
+  std::vector<SLine> m_lines;
+  std::vector<double> m_maxStopTime; // highest stop time of all lines up to this one
+  bool m_bSorted;
+  CCriticalSection m_critSection;
+};
 
 class CDVDSubtitleLineCollection
 {
@@ -35,26 +62,26 @@ public:
   CDVDSubtitleLineCollection();
   virtual ~CDVDSubtitleLineCollection();
 
-  //void Lock()   { EnterCriticalSection(&m_critSection); }
-  //void Unlock() { LeaveCriticalSection(&m_critSection); }
-
-  void Add(CDVDOverlay* pSubtitle);
+  void Add(CDVDOverlay* pSubtitle, const std::string& payload = "");
   void Sort();
 
   CDVDOverlay* Get(double iPts = 0LL); // get the first overlay in this fifo
 
+  // get the next overlay that ends after iPts, if it starts before iMaxStartTime.
+  // overlays with a payload are decoded with pDecoder first
+  CDVDOverlay* Get(double iPts, double iMaxStartTime, IDVDSubtitleLineDecoder* pDecoder);
+
   void Reset();
 
-  void Remove();
   void Clear();
-  int GetSize() { return m_iSize; }
+  int GetSize() { return m_index ? (int)m_index->m_lines.size() : 0; }
+
+  const std::shared_ptr<CDVDSubtitleIndex>& GetIndex() const { return m_index; }
+  void SetIndex(const std::shared_ptr<CDVDSubtitleIndex>& index);
 
 private:
-  ListElement* m_pHead;
-  ListElement* m_pCurrent;
-  ListElement* m_pTail;
+  size_t Find(double iPts) const;
 
-  int m_iSize;
-  //CRITICAL_SECTION m_critSection;
+  std::shared_ptr<CDVDSubtitleIndex> m_index;
+  size_t m_current;
 };
-
@@ -23,6 +23,8 @@
 #include "../DVDCodecs/Overlay/DVDOverlay.h"
 #include "DVDSubtitleStream.h"
 #include "DVDSubtitleLineCollection.h"
+#include "DVDSubtitleIndexCache.h"
+#include "DVDClock.h"
 
 #include <string>
 #include <stdio.h>
@@ -39,15 +41,19 @@ public:
   virtual CDVDOverlay* Parse(double iPts) = 0;
 };
 
+// overlays starting later than this are left in the collection for the next call
+#define SUBTITLE_PARSE_LOOKAHEAD DVD_SEC_TO_TIME(10)
+
 class CDVDSubtitleParserCollection
   : public CDVDSubtitleParser
+  , public IDVDSubtitleLineDecoder
 {
 public:
   CDVDSubtitleParserCollection(const std::string& strFile) : m_filename(strFile) {}
   virtual ~CDVDSubtitleParserCollection() { }
   virtual CDVDOverlay* Parse(double iPts)
   {
-    CDVDOverlay* o = m_collection.Get(iPts);
+    CDVDOverlay* o = m_collection.Get(iPts, iPts + SUBTITLE_PARSE_LOOKAHEAD, this);
     if(o == NULL)
       return o;
     return o->Clone();
@@ -55,7 +61,25 @@ public:
   virtual void         Reset()            { m_collection.Reset(); }
   virtual void         Dispose()          { m_collection.Clear(); }
 
+  virtual void DecodeLine(CDVDOverlay* pOverlay, const std::string& payload) {}
+
 protected:
+  // use the index cached for m_filename if it was created by strParser
+  bool LoadCachedIndex(const std::string& strParser)
+  {
+    std::string strCachedParser;
+    std::shared_ptr<CDVDSubtitleIndex> index = CDVDSubtitleIndexCache::GetInstance().Get(m_filename, strCachedParser);
+    if (!index || strCachedParser != strParser)
+      return false;
+    m_collection.SetIndex(index);
+    return true;
+  }
+
+  void StoreIndex(const std::string& strParser, bool bTransient = false)
+  {
+    CDVDSubtitleIndexCache::GetInstance().Add(m_filename, strParser, m_collection.GetIndex(), bTransient);
+  }
+
   CDVDSubtitleLineCollection m_collection;
   std::string                m_filename;
 };
@@ -26,7 +26,7 @@
 CDVDSubtitleParserSSA::CDVDSubtitleParserSSA(CDVDSubtitleStream* pStream, const std::string& strFile)
     : CDVDSubtitleParserText(pStream, strFile)
 {
-  m_libass = new CDVDSubtitlesLibass();
+  m_libass = NULL;
 }
 
 CDVDSubtitleParserSSA::~CDVDSubtitleParserSSA()
@@ -36,10 +36,16 @@ CDVDSubtitleParserSSA::~CDVDSubtitleParserSSA()
 
 bool CDVDSubtitleParserSSA::Open(CDVDStreamInfo &hints)
 {
+  // the cached overlays hold their own reference to the ass library
+  if (LoadCachedIndex(SSA_PARSER_NAME))
+    return true;
 
   if (!CDVDSubtitleParserText::Open())
     return false;
 
+  if (!m_libass)
+    m_libass = new CDVDSubtitlesLibass();
+
   std::string buffer = m_pStream->m_stringstream.str();
   if(!m_libass->CreateTrack((char*) buffer.c_str(), buffer.length()))
     return false;
@@ -64,6 +70,9 @@ bool CDVDSubtitleParserSSA::Open(CDVDStreamInfo &hints)
     }
   }
   m_collection.Sort();
+
+  // the overlays keep libass alive, don't hold on to it past playback
+  StoreIndex(SSA_PARSER_NAME, true);
   return true;
 }
 
@@ -24,6 +24,8 @@
 #include "DVDSubtitlesLibass.h"
 
 
+#define SSA_PARSER_NAME "ssa"
+
 class CDVDSubtitleParserSSA : public CDVDSubtitleParserText
 {
 public:
@@ -22,10 +22,10 @@
 #include "DVDCodecs/Overlay/DVDOverlayText.h"
 #include "DVDClock.h"
 #include "utils/StringUtils.h"
-#include "DVDSubtitleTagSami.h"
 
 CDVDSubtitleParserSubrip::CDVDSubtitleParserSubrip(CDVDSubtitleStream* pStream, const std::string& strFile)
     : CDVDSubtitleParserText(pStream, strFile)
+    , m_tagConvInit(false)
 {
 }
 
@@ -36,11 +36,17 @@ CDVDSubtitleParserSubrip::~CDVDSubtitleParserSubrip()
 
 bool CDVDSubtitleParserSubrip::Open(CDVDStreamInfo &hints)
 {
-  if (!CDVDSubtitleParserText::Open())
-    return false;
+  if (!m_tagConvInit)
+  {
+    if (!m_tagConv.Init())
+      return false;
+    m_tagConvInit = true;
+  }
+
+  if (LoadCachedIndex(SUBRIP_PARSER_NAME))
+    return true;
 
-  CDVDSubtitleTagSami TagConv;
-  if (!TagConv.Init())
+  if (!CDVDSubtitleParserText::Open())
     return false;
 
   char line[1024];
@@ -71,6 +77,9 @@ bool CDVDSubtitleParserSubrip::Open(CDVDStreamInfo &hints)
         pOverlay->iPTSStartTime = ((double)(((hh1 * 60 + mm1) * 60) + ss1) * 1000 + ms1) * (DVD_TIME_BASE / 1000);
         pOverlay->iPTSStopTime  = ((double)(((hh2 * 60 + mm2) * 60) + ss2) * 1000 + ms2) * (DVD_TIME_BASE / 1000);
 
+        // only the timing is needed to index the file, the text is
+        // converted when the overlay is displayed for the first time
+        std::string payload;
         while (m_pStream->ReadLine(line, sizeof(line)))
         {
           strLine = line;
@@ -79,14 +88,28 @@ bool CDVDSubtitleParserSubrip::Open(CDVDStreamInfo &hints)
           // empty line, next subtitle is about to start
           if (strLine.length() <= 0) break;
 
-          TagConv.ConvertLine(pOverlay, strLine.c_str(), strLine.length());
+          payload += strLine;
+          payload += '\n';
         }
-        TagConv.CloseTag(pOverlay);
-        m_collection.Add(pOverlay);
+        m_collection.Add(pOverlay, payload);
       }
     }
   }
   m_collection.Sort();
+  StoreIndex(SUBRIP_PARSER_NAME);
   return true;
 }
 
+void CDVDSubtitleParserSubrip::DecodeLine(CDVDOverlay* pOverlay, const std::string& payload)
+{
+  CDVDOverlayText* pText = static_cast<CDVDOverlayText*>(pOverlay);
+
+  std::vector<std::string> lines = StringUtils::Split(payload, "\n");
+  for (const auto& strLine : lines)
+  {
+    if (!strLine.empty())
+      m_tagConv.ConvertLine(pText, strLine.c_str(), strLine.length());
+  }
+  m_tagConv.CloseTag(pText);
+}
+
@@ -21,6 +21,9 @@
  */
 
 #include "DVDSubtitleParser.h"
+#include "DVDSubtitleTagSami.h"
+
+#define SUBRIP_PARSER_NAME "subrip"
 
 class CDVDSubtitleParserSubrip : public CDVDSubtitleParserText
 {
@@ -29,5 +32,9 @@ public:
   virtual ~CDVDSubtitleParserSubrip();
 
   virtual bool Open(CDVDStreamInfo &hints);
+  virtual void DecodeLine(CDVDOverlay* pOverlay, const std::string& payload);
+
 private:
+  CDVDSubtitleTagSami m_tagConv;
+  bool m_tagConvInit;
 };
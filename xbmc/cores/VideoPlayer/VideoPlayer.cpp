@@ -5135,6 +5135,15 @@ bool CVideoPlayer::RenderCaptureGetPixels(unsigned int captureId, unsigned int m
   return m_renderManager.RenderCaptureGetPixels(captureId, millis, buffer, size);
 }
 
+bool CVideoPlayer::GetFramePacing(CVariant &info, bool samples)
+{
+  if (!m_renderManager.IsConfigured())
+    return false;
+
+  m_renderManager.GetFramePacing(info, samples);
+  return true;
+}
+
 void CVideoPlayer::VideoParamsChange()
 {
   m_messenger.Put(new CDVDMsg(CDVDMsg::PLAYER_AVCHANGE));
@@ -386,6 +386,7 @@ public:
   virtual void RenderCapture(unsigned int captureId, unsigned int width, unsigned int height, int flags);
   virtual void RenderCaptureRelease(unsigned int captureId);
   virtual bool RenderCaptureGetPixels(unsigned int captureId, unsigned int millis, uint8_t *buffer, unsigned int size);
+  virtual bool GetFramePacing(CVariant &info, bool samples);
 
   // IDispResource interface
   virtual void OnLostDisplay();
@@ -24,6 +24,7 @@
 #include "DVDCodecs/Overlay/DVDOverlayCodec.h"
 #include "DVDClock.h"
 #include "DVDSubtitles/DVDSubtitleParser.h"
+#include "DVDSubtitles/DVDSubtitleIndexCache.h"
 #include "DVDCodecs/DVDFactoryCodec.h"
 #include "DVDDemuxers/DVDDemuxPacket.h"
 #include "utils/log.h"
@@ -46,6 +47,7 @@ CVideoPlayerSubtitle::CVideoPlayerSubtitle(CDVDOverlayContainer* pOverlayContain
 CVideoPlayerSubtitle::~CVideoPlayerSubtitle()
 {
   CloseStream(true);
+  CDVDSubtitleIndexCache::GetInstance().ClearTransient();
 }
 
 
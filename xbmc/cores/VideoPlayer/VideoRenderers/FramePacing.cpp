@@ -0,0 +1,236 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "FramePacing.h"
+#include "filesystem/File.h"
+#include "threads/SingleLock.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/log.h"
+#include "utils/Variant.h"
+
+#include <algorithm>
+#include <cmath>
+
+SFramePacingStats::SFramePacingStats()
+  : frames(0)
+  , fps(0.0)
+  , refreshRate(0.0)
+  , expectedInterval(0.0)
+  , meanInterval(0.0)
+  , deviation(0.0)
+  , judder(0.0)
+  , maxJudder(0.0)
+  , irregular(0)
+  , repeats(0)
+  , skipped(0)
+  , missedVblanks(0)
+  , clockAdjustments(0)
+  , histogram(CFramePacingRecorder::HISTOGRAM_SIZE, 0)
+{
+}
+
+CFramePacingRecorder::CFramePacingRecorder(unsigned int capacity)
+  : m_samples(capacity > 0 ? capacity : 1)
+  , m_head(0)
+  , m_count(0)
+  , m_fps(0.0)
+  , m_refreshRate(0.0)
+{
+}
+
+void CFramePacingRecorder::Reset(double fps, double refreshRate)
+{
+  CSingleLock lock(m_section);
+  m_head = 0;
+  m_count = 0;
+  m_fps = fps;
+  m_refreshRate = refreshRate;
+}
+
+double CFramePacingRecorder::GetFps() const
+{
+  CSingleLock lock(m_section);
+  return m_fps;
+}
+
+double CFramePacingRecorder::GetRefreshRate() const
+{
+  CSingleLock lock(m_section);
+  return m_refreshRate;
+}
+
+void CFramePacingRecorder::AddFrame(const SFramePacingSample &sample)
+{
+  CSingleLock lock(m_section);
+  m_samples[m_head] = sample;
+  m_head = (m_head + 1) % m_samples.size();
+  if (m_count < m_samples.size())
+    m_count++;
+}
+
+void CFramePacingRecorder::GetSamples(std::vector<SFramePacingSample> &samples) const
+{
+  CSingleLock lock(m_section);
+  samples.clear();
+  samples.reserve(m_count);
+
+  unsigned int first = (m_head + m_samples.size() - m_count) % m_samples.size();
+  for (unsigned int i = 0; i < m_count; i++)
+    samples.push_back(m_samples[(first + i) % m_samples.size()]);
+}
+
+void CFramePacingRecorder::GetStats(SFramePacingStats &stats) const
+{
+  std::vector<SFramePacingSample> samples;
+  {
+    CSingleLock lock(m_section);
+    stats = SFramePacingStats();
+    stats.fps = m_fps;
+    stats.refreshRate = m_refreshRate;
+  }
+  GetSamples(samples);
+
+  stats.frames = samples.size();
+  if (samples.empty())
+    return;
+
+  stats.missedVblanks = samples.back().missedVblanks - samples.front().missedVblanks;
+  for (unsigned int i = 1; i < samples.size(); i++)
+  {
+    stats.skipped += samples[i].skipped;
+    if (samples[i].syncOffset != samples[i - 1].syncOffset)
+      stats.clockAdjustments++;
+  }
+
+  if (stats.fps <= 0.0 || stats.refreshRate <= 0.0 || samples.size() < 2)
+    return;
+
+  // the clock runs at adjusted speed to match the display, frames are due accordingly
+  double speed = samples.back().clockSpeed > 0.0 ? samples.back().clockSpeed : 1.0;
+  double expected = 1.0 / (stats.fps * speed);
+  double vblank = 1.0 / stats.refreshRate;
+
+  // a frame lasts this many vblanks on average, 2.5 for 24p on 60Hz
+  double cadence = stats.refreshRate / (stats.fps * speed);
+  int cadenceLow = (int)floor(cadence + 0.01);
+  int cadenceHigh = (int)ceil(cadence - 0.01);
+
+  double sum = 0.0, sumSquares = 0.0, sumJudder = 0.0;
+  int intervals = 0;
+  for (unsigned int i = 1; i < samples.size(); i++)
+  {
+    if (samples[i].discontinuity)
+      continue;
+
+    double interval = samples[i].presentTime - samples[i - 1].presentTime;
+    double judder = fabs(interval - expected * (1 + samples[i].skipped));
+
+    sum += interval;
+    sumSquares += interval * interval;
+    sumJudder += judder;
+    if (judder > stats.maxJudder)
+      stats.maxJudder = judder;
+    intervals++;
+
+    int vblanks = (int)floor(interval / vblank + 0.5);
+    if (vblanks < 0)
+      vblanks = 0;
+    stats.histogram[std::min(vblanks, HISTOGRAM_SIZE - 1)]++;
+
+    if (samples[i].skipped == 0)
+    {
+      if (vblanks < cadenceLow || vblanks > cadenceHigh)
+        stats.irregular++;
+      if (vblanks > cadenceHigh)
+        stats.repeats++;
+    }
+  }
+
+  if (intervals == 0)
+    return;
+
+  double mean = sum / intervals;
+  stats.expectedInterval = expected * 1000.0;
+  stats.meanInterval = mean * 1000.0;
+  stats.deviation = sqrt(std::max(0.0, sumSquares / intervals - mean * mean)) * 1000.0;
+  stats.judder = sumJudder / intervals * 1000.0;
+  stats.maxJudder *= 1000.0;
+}
+
+void CFramePacingRecorder::Serialize(CVariant &value, bool samples) const
+{
+  SFramePacingStats stats;
+  GetStats(stats);
+
+  value["frames"] = stats.frames;
+  value["fps"] = stats.fps;
+  value["refreshrate"] = stats.refreshRate;
+  value["expectedinterval"] = stats.expectedInterval;
+  value["meaninterval"] = stats.meanInterval;
+  value["deviation"] = stats.deviation;
+  value["judder"] = stats.judder;
+  value["maxjudder"] = stats.maxJudder;
+  value["irregular"] = stats.irregular;
+  value["repeats"] = stats.repeats;
+  value["skipped"] = stats.skipped;
+  value["missedvblanks"] = stats.missedVblanks;
+  value["clockadjustments"] = stats.clockAdjustments;
+
+  value["histogram"] = CVariant(CVariant::VariantTypeArray);
+  for (const auto &count : stats.histogram)
+    value["histogram"].push_back(count);
+
+  if (samples)
+  {
+    std::vector<SFramePacingSample> list;
+    GetSamples(list);
+
+    value["samples"] = CVariant(CVariant::VariantTypeArray);
+    for (const auto &sample : list)
+    {
+      CVariant item;
+      item["pts"] = sample.pts;
+      item["presenttime"] = sample.presentTime;
+      item["skipped"] = sample.skipped;
+      item["missedvblanks"] = sample.missedVblanks;
+      item["clockspeed"] = sample.clockSpeed;
+      item["syncoffset"] = sample.syncOffset;
+      item["discontinuity"] = sample.discontinuity;
+      value["samples"].push_back(item);
+    }
+  }
+}
+
+bool CFramePacingRecorder::Dump(const std::string &path) const
+{
+  CVariant value;
+  Serialize(value, true);
+
+  std::string json = CJSONVariantWriter::Write(value, false);
+
+  XFILE::CFile file;
+  if (!file.OpenForWrite(path, true) || file.Write(json.c_str(), json.size()) != (ssize_t)json.size())
+  {
+    CLog::Log(LOGERROR, "CFramePacingRecorder::%s - failed to write %s", __FUNCTION__, path.c_str());
+    return false;
+  }
+  return true;
+}
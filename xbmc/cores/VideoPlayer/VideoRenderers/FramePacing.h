@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "threads/CriticalSection.h"
+
+#include <string>
+#include <vector>
+
+class CVariant;
+
+struct SFramePacingSample
+{
+  double pts;           // pts of the presented frame
+  double presentTime;   // time the frame was flipped to screen, in seconds
+  int    skipped;       // frames skipped to present this one
+  int    missedVblanks; // missed vblanks counted by the reference clock
+  double clockSpeed;    // speed the dvd clock is adjusted to for the display
+  double syncOffset;    // offset of clock sync, DVD_TIME_BASE
+  bool   discontinuity; // first frame after a flush, no interval to the previous one
+};
+
+struct SFramePacingStats
+{
+  SFramePacingStats();
+
+  int    frames;            // number of recorded frames
+  double fps;               // video frame rate
+  double refreshRate;       // display refresh rate
+  double expectedInterval;  // ms a frame should be shown
+  double meanInterval;      // ms a frame was shown on average
+  double deviation;         // standard deviation of the display interval in ms
+  double judder;            // mean difference between expected and actual interval in ms
+  double maxJudder;         // largest difference between expected and actual interval in ms
+  int    irregular;         // intervals not matching the cadence of fps on the refresh rate
+  int    repeats;           // intervals that were held for an extra vblank
+  int    skipped;           // frames skipped by the render manager
+  int    missedVblanks;     // vblanks missed by the reference clock
+  int    clockAdjustments;  // changes of the clock sync offset
+  std::vector<int> histogram; // display interval in vblanks, the last bucket counts all longer ones
+};
+
+/*!
+ \brief Ring buffer of the frames presented by the render manager
+
+ Records when each frame was flipped to screen and derives judder statistics
+ from it. Times are passed in by the caller, so the recorder can be driven by
+ a simulated vsync as well.
+ */
+class CFramePacingRecorder
+{
+public:
+  static const int HISTOGRAM_SIZE = 8;
+
+  CFramePacingRecorder(unsigned int capacity = 1024);
+
+  /*!
+   \brief Drop all samples and start recording for new rates
+   */
+  void Reset(double fps, double refreshRate);
+  double GetFps() const;
+  double GetRefreshRate() const;
+
+  void AddFrame(const SFramePacingSample &sample);
+
+  void GetSamples(std::vector<SFramePacingSample> &samples) const;
+  void GetStats(SFramePacingStats &stats) const;
+
+  void Serialize(CVariant &value, bool samples) const;
+  bool Dump(const std::string &path) const;
+
+private:
+  mutable CCriticalSection m_section;
+  std::vector<SFramePacingSample> m_samples;
+  unsigned int m_head;
+  unsigned int m_count;
+  double m_fps;
+  double m_refreshRate;
+};
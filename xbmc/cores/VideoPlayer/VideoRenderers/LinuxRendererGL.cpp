@@ -51,6 +51,7 @@
 #include "cores/FFmpeg.h"
 
 extern "C" {
+#include "libavutil/frame.h"
 #include "libswscale/swscale.h"
 }
 
@@ -112,11 +113,12 @@ CLinuxRendererGL::YUVBUFFER::YUVBUFFER()
   memset(&pbo   , 0, sizeof(pbo));
   flipindex = 0;
   hwDec = NULL;
+  frameRef = NULL;
 }
 
 CLinuxRendererGL::YUVBUFFER::~YUVBUFFER()
 {
-
+  av_frame_free(&frameRef);
 }
 
 CLinuxRendererGL::CLinuxRendererGL()
@@ -372,6 +374,38 @@ int CLinuxRendererGL::GetImage(YV12Image *image, int source, bool readonly)
   return source;
 }
 
+bool CLinuxRendererGL::AddVideoPictureRef(DVDVideoPicture &picture, int index)
+{
+  YUVBUFFER &buf = m_buffers[index];
+
+  // drop the frame this buffer showed before
+  if (buf.frameRef)
+    av_frame_unref(buf.frameRef);
+
+  // with pbo the copy into the mapped buffer is the upload itself. without pbo
+  // glTexSubImage2D can read straight from the decoder frame and the copy into
+  // the image is pure overhead
+  if (m_pboUsed || m_format != picture.format || !picture.avFrame)
+    return false;
+
+  AVFrame *frame = picture.avFrame;
+  for (int p = 0; p < 3; p++)
+  {
+    // planes may have been replaced by post processing
+    if (!frame->buf[0] || picture.data[p] != frame->data[p] || picture.iLineSize[p] != frame->linesize[p])
+      return false;
+  }
+  if (picture.iWidth != buf.image.width || picture.iHeight != buf.image.height)
+    return false;
+
+  if (!buf.frameRef)
+    buf.frameRef = av_frame_alloc();
+  if (!buf.frameRef || av_frame_ref(buf.frameRef, frame) < 0)
+    return false;
+
+  return true;
+}
+
 void CLinuxRendererGL::ReleaseImage(int source, bool preserve)
 {
   YV12Image &im = m_buffers[source].image;
@@ -1822,6 +1856,23 @@ bool CLinuxRendererGL::UploadYV12Texture(int source)
   else
     deinterlacing = true;
 
+  // planes come from the referenced decoder frame if there is one
+  BYTE *plane[3];
+  int stride[3];
+  for (int p = 0; p < 3; p++)
+  {
+    if (buf.frameRef && buf.frameRef->buf[0])
+    {
+      plane[p] = buf.frameRef->data[p];
+      stride[p] = buf.frameRef->linesize[p];
+    }
+    else
+    {
+      plane[p] = im->plane[p];
+      stride[p] = im->stride[p];
+    }
+  }
+
   glEnable(m_textureTarget);
   VerifyGLState();
 
@@ -1832,47 +1883,47 @@ bool CLinuxRendererGL::UploadYV12Texture(int source)
     // Load Even Y Field
     LoadPlane( fields[FIELD_TOP][0] , GL_LUMINANCE, buf.flipindex
              , im->width, im->height >> 1
-             , im->stride[0]*2, im->bpp, im->plane[0] );
+             , stride[0]*2, im->bpp, plane[0] );
 
     //load Odd Y Field
     LoadPlane( fields[FIELD_BOT][0], GL_LUMINANCE, buf.flipindex
              , im->width, im->height >> 1
-             , im->stride[0]*2, im->bpp, im->plane[0] + im->stride[0]) ;
+             , stride[0]*2, im->bpp, plane[0] + stride[0]) ;
 
     // Load Even U & V Fields
     LoadPlane( fields[FIELD_TOP][1], GL_LUMINANCE, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[1]*2, im->bpp, im->plane[1] );
+             , stride[1]*2, im->bpp, plane[1] );
 
     LoadPlane( fields[FIELD_TOP][2], GL_ALPHA, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[2]*2, im->bpp, im->plane[2] );
+             , stride[2]*2, im->bpp, plane[2] );
 
     // Load Odd U & V Fields
     LoadPlane( fields[FIELD_BOT][1], GL_LUMINANCE, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[1]*2, im->bpp, im->plane[1] + im->stride[1] );
+             , stride[1]*2, im->bpp, plane[1] + stride[1] );
 
     LoadPlane( fields[FIELD_BOT][2], GL_ALPHA, buf.flipindex
              , im->width >> im->cshift_x, im->height >> (im->cshift_y + 1)
-             , im->stride[2]*2, im->bpp, im->plane[2] + im->stride[2] );
+             , stride[2]*2, im->bpp, plane[2] + stride[2] );
   }
   else
   {
     //Load Y plane
     LoadPlane( fields[FIELD_FULL][0], GL_LUMINANCE, buf.flipindex
              , im->width, im->height
-             , im->stride[0], im->bpp, im->plane[0] );
+             , stride[0], im->bpp, plane[0] );
 
     //load U plane
     LoadPlane( fields[FIELD_FULL][1], GL_LUMINANCE, buf.flipindex
              , im->width >> im->cshift_x, im->height >> im->cshift_y
-             , im->stride[1], im->bpp, im->plane[1] );
+             , stride[1], im->bpp, plane[1] );
 
     //load V plane
     LoadPlane( fields[FIELD_FULL][2], GL_ALPHA, buf.flipindex
              , im->width >> im->cshift_x, im->height >> im->cshift_y
-             , im->stride[2], im->bpp, im->plane[2] );
+             , stride[2], im->bpp, plane[2] );
   }
 
   VerifyGLState();
@@ -1889,6 +1940,9 @@ void CLinuxRendererGL::DeleteYV12Texture(int index)
   YUVFIELDS &fields = m_buffers[index].fields;
   GLuint    *pbo    = m_buffers[index].pbo;
 
+  if (m_buffers[index].frameRef)
+    av_frame_unref(m_buffers[index].frameRef);
+
   if( fields[FIELD_FULL][0].id == 0 ) return;
 
   /* finish up all textures, and delete them */
@@ -39,6 +39,7 @@
 #include "threads/Event.h"
 
 class CRenderCapture;
+struct AVFrame;
 
 class CBaseTexture;
 namespace Shaders { class BaseYUV2RGBShader; }
@@ -123,6 +124,7 @@ public:
   virtual bool IsConfigured() { return m_bConfigured; }
   virtual int GetImage(YV12Image *image, int source = AUTOSOURCE, bool readonly = false);
   virtual void ReleaseImage(int source, bool preserve = false);
+  virtual bool AddVideoPictureRef(DVDVideoPicture &picture, int index);
   virtual void FlipPage(int source);
   virtual void PreInit();
   virtual void UnInit();
@@ -239,6 +241,7 @@ protected:
     GLuint    pbo[MAX_PLANES];
 
     void *hwDec;
+    AVFrame *frameRef; /* decoder frame uploaded instead of image, see AddVideoPictureRef */
   };
 
   typedef YUVBUFFER          YUVBUFFERS[NUM_BUFFERS];
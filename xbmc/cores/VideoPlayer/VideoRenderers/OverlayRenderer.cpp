@@ -63,6 +63,7 @@ unsigned int CRenderer::m_textureid = 1;
 
 CRenderer::CRenderer()
 {
+  m_glyphAtlas = NULL;
   m_font = "__subtitle__";
   m_fontBorder = "__subtitleborder__";
 }
@@ -121,6 +122,9 @@ void CRenderer::ReleaseCache()
   }
   m_textureCache.clear();
   m_textureid++;
+
+  delete m_glyphAtlas;
+  m_glyphAtlas = NULL;
 }
 
 void CRenderer::ReleaseUnused()
@@ -363,14 +367,17 @@ COverlay* CRenderer::Convert(CDVDOverlaySSA* o, double pts)
     if(changes == 0)
     {
       std::map<unsigned int, COverlay*>::iterator it = m_textureCache.find(o->m_textureid);
-      if (it != m_textureCache.end())
+      if (it != m_textureCache.end() && it->second->IsValid())
         return it->second;
     }
   }
 
   COverlay *overlay = NULL;
 #if defined(HAS_GL) || defined(HAS_GLES)
-  overlay = new COverlayGlyphGL(images, targetWidth, targetHeight);
+  // glyphs of unchanged events are still in the atlas, only new ones get uploaded
+  if (!m_glyphAtlas)
+    m_glyphAtlas = new CGlyphAtlasGL();
+  overlay = new COverlayGlyphGL(images, targetWidth, targetHeight, static_cast<CGlyphAtlasGL*>(m_glyphAtlas));
 #elif defined(HAS_DX)
   overlay = new COverlayQuadsDX(images, targetWidth, targetHeight);
 #endif
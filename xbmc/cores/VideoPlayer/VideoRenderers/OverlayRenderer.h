@@ -34,6 +34,8 @@ class CDVDOverlaySSA;
 
 namespace OVERLAY {
 
+  class CGlyphAtlas;
+
   struct SRenderState
   {
     float x;
@@ -50,6 +52,8 @@ namespace OVERLAY {
 
     virtual void Render(SRenderState& state) = 0;
     virtual void PrepareRender() {};
+    // false if resources shared with other overlays changed under it
+    virtual bool IsValid() const { return true; }
 
     enum EType
     { TYPE_NONE
@@ -112,6 +116,7 @@ namespace OVERLAY {
     CCriticalSection m_section;
     std::vector<SElement> m_buffers[NUM_BUFFERS];
     std::map<unsigned int, COverlay*> m_textureCache;
+    CGlyphAtlas* m_glyphAtlas;
     static unsigned int m_textureid;
     CRect m_rv, m_rs, m_rd;
     std::string m_font, m_fontBorder;
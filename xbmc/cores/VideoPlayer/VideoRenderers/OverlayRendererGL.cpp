@@ -39,6 +39,8 @@
 #include "utils/log.h"
 #include "utils/GLUtils.h"
 
+#include <algorithm>
+
 #if defined(HAS_GL) || HAS_GLES == 2
 
 #if HAS_GLES == 2
@@ -289,9 +291,56 @@ COverlayTextureGL::COverlayTextureGL(CDVDOverlaySpu* o)
   m_pma    = !!USE_PREMULTIPLIED_ALPHA;
 }
 
-COverlayGlyphGL::COverlayGlyphGL(ASS_Image* images, int width, int height)
+CGlyphAtlasGL::CGlyphAtlasGL()
+  : CGlyphAtlas(std::min(2048, (int)g_Windowing.GetMaxTextureSize()))
+{
+  m_texture  = 0;
+  m_uploaded = 0;
+}
+
+CGlyphAtlasGL::~CGlyphAtlasGL()
+{
+  if (m_texture)
+    glDeleteTextures(1, &m_texture);
+}
+
+GLuint CGlyphAtlasGL::Upload()
+{
+  int y0, y1;
+  bool full = !m_texture || m_uploaded != GetGeneration();
+  if (!full && !GetDirty(y0, y1))
+    return m_texture;
+
+  if (!m_texture)
+    glGenTextures(1, &m_texture);
+
+  glEnable(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, m_texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+  // the atlas size is a power of two, no padding needed
+  if (full)
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA
+               , GetSize(), GetSize(), 0
+               , GL_ALPHA, GL_UNSIGNED_BYTE, GetData());
+  else
+    glTexSubImage2D(GL_TEXTURE_2D, 0
+                  , 0, y0, GetSize(), y1 - y0
+                  , GL_ALPHA, GL_UNSIGNED_BYTE
+                  , GetData() + y0 * GetSize());
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glDisable(GL_TEXTURE_2D);
+
+  ClearDirty();
+  m_uploaded = GetGeneration();
+  return m_texture;
+}
+
+COverlayGlyphGL::COverlayGlyphGL(ASS_Image* images, int width, int height, CGlyphAtlasGL* atlas)
 {
   m_vertex = NULL;
+  m_count  = 0;
   m_width  = 1.0;
   m_height = 1.0;
   m_align  = ALIGN_VIDEO;
@@ -299,23 +348,39 @@ COverlayGlyphGL::COverlayGlyphGL(ASS_Image* images, int width, int height)
   m_x      = 0.0f;
   m_y      = 0.0f;
   m_texture = 0;
+  m_atlas   = NULL;
+  m_generation = 0;
 
   SQuads quads;
-  if(!convert_quad(images, quads))
-    return;
-
-  glGenTextures(1, &m_texture);
-  glEnable(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, m_texture);
-
-  LoadTexture(GL_TEXTURE_2D
-            , quads.size_x
-            , quads.size_y
-            , quads.size_x
-            , &m_u, &m_v
-            , true
-            , quads.data);
-
+  if(atlas && atlas->Convert(images, quads))
+  {
+    m_atlas      = atlas;
+    m_generation = atlas->GetGeneration();
+    m_texture    = atlas->Upload();
+    m_u = 1.0f;
+    m_v = 1.0f;
+  }
+  else
+  {
+    // doesn't fit into the atlas, use a texture of its own
+    if(!convert_quad(images, quads))
+      return;
+
+    glGenTextures(1, &m_texture);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+
+    LoadTexture(GL_TEXTURE_2D
+              , quads.size_x
+              , quads.size_y
+              , quads.size_x
+              , &m_u, &m_v
+              , true
+              , quads.data);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+  }
 
   float scale_u = m_u / quads.size_x;
   float scale_v = m_v / quads.size_y;
@@ -389,22 +454,30 @@ COverlayGlyphGL::COverlayGlyphGL(ASS_Image* images, int width, int height)
     vs += 1;
     vt += 4;
   }
-
-  glBindTexture(GL_TEXTURE_2D, 0);
-  glDisable(GL_TEXTURE_2D);
 }
 
 COverlayGlyphGL::~COverlayGlyphGL()
 {
-  glDeleteTextures(1, &m_texture);
+  if (!m_atlas)
+    glDeleteTextures(1, &m_texture);
   free(m_vertex);
 }
 
+bool COverlayGlyphGL::IsValid() const
+{
+  return !m_atlas || m_atlas->GetGeneration() == m_generation;
+}
+
 void COverlayGlyphGL::Render(SRenderState& state)
 {
   if ((m_texture == 0) || (m_count == 0))
     return;
 
+  // the atlas was repacked after this overlay was converted,
+  // it gets converted again on the next frame
+  if (!IsValid())
+    return;
+
   glEnable(GL_TEXTURE_2D);
   glEnable(GL_BLEND);
 
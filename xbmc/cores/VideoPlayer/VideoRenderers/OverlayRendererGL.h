@@ -22,6 +22,7 @@
 #pragma once
 #include "system_gl.h"
 #include "OverlayRenderer.h"
+#include "OverlayRendererUtil.h"
 
 class CDVDOverlay;
 class CDVDOverlayImage;
@@ -48,14 +49,29 @@ namespace OVERLAY {
     bool   m_pma; /*< is alpha in texture premultipled in the values */
   };
 
+  class CGlyphAtlasGL : public CGlyphAtlas
+  {
+  public:
+    CGlyphAtlasGL();
+    virtual ~CGlyphAtlasGL();
+
+    // bring the texture up to date, only the dirty rows are uploaded
+    GLuint Upload();
+
+  private:
+    GLuint       m_texture;
+    unsigned int m_uploaded; /*< generation the texture contains */
+  };
+
   class COverlayGlyphGL : public COverlay
   {
   public:
-   COverlayGlyphGL(ASS_Image* images, int width, int height);
+   COverlayGlyphGL(ASS_Image* images, int width, int height, CGlyphAtlasGL* atlas = NULL);
 
    virtual ~COverlayGlyphGL();
 
    void Render(SRenderState& state);
+   bool IsValid() const;
 
     struct VERTEX
     {
@@ -70,6 +86,9 @@ namespace OVERLAY {
    GLuint m_texture;
    float  m_u;
    float  m_v;
+
+   CGlyphAtlasGL* m_atlas;      /*< owner of m_texture if set */
+   unsigned int   m_generation;
   };
 
 }
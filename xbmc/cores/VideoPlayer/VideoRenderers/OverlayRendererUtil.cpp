@@ -296,6 +296,188 @@ bool convert_quad(ASS_Image* images, SQuads& quads)
   return true;
 }
 
+static uint64_t hash_image(ASS_Image* img)
+{
+  // 64 bit FNV-1a, fed 8 pixels at a time
+  uint64_t hash = 14695981039346656037ULL ^ ((uint64_t)img->w << 32 | (uint32_t)img->h);
+  for(int y = 0; y < img->h; y++)
+  {
+    const uint8_t* row = img->bitmap + img->stride * y;
+    int x = 0;
+    for(; x + 8 <= img->w; x += 8)
+    {
+      uint64_t v;
+      memcpy(&v, row + x, sizeof(v));
+      hash = (hash ^ v) * 1099511628211ULL;
+    }
+    for(; x < img->w; x++)
+      hash = (hash ^ row[x]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+CGlyphAtlas::CGlyphAtlas(int size)
+  : m_size(size)
+  , m_data(size * size, 0)
+  , m_generation(0)
+{
+  Reset();
+}
+
+void CGlyphAtlas::Reset()
+{
+  if (!m_glyphs.empty())
+    memset(&m_data[0], 0, m_data.size());
+  m_glyphs.clear();
+  m_shelfX = 0;
+  m_shelfY = 0;
+  m_shelfH = 0;
+  m_dirtyY0 = 0;
+  m_dirtyY1 = m_size;
+  m_generation++;
+}
+
+bool CGlyphAtlas::GetDirty(int& y0, int& y1) const
+{
+  if (m_dirtyY0 >= m_dirtyY1)
+    return false;
+  y0 = m_dirtyY0;
+  y1 = m_dirtyY1;
+  return true;
+}
+
+void CGlyphAtlas::ClearDirty()
+{
+  m_dirtyY0 = m_size;
+  m_dirtyY1 = 0;
+}
+
+bool CGlyphAtlas::Insert(ASS_Image* img, SGlyph& glyph)
+{
+  uint64_t hash = hash_image(img);
+
+  std::unordered_map<uint64_t, SGlyph>::iterator it = m_glyphs.find(hash);
+  if (it != m_glyphs.end() && it->second.w == img->w && it->second.h == img->h)
+  {
+    bool equal = true;
+    for(int i = 0; equal && i < img->h; i++)
+      equal = memcmp(&m_data[(it->second.v + i) * m_size + it->second.u]
+                   , img->bitmap + img->stride * i
+                   , img->w) == 0;
+    if (equal)
+    {
+      glyph = it->second;
+      return true;
+    }
+  }
+
+  if (img->w >= m_size || img->h >= m_size)
+    return false;
+
+  // simple shelf packing, keep a pixel of space between the
+  // glyphs so they don't bleed into each other when filtered
+  if (m_shelfX + img->w >= m_size)
+  {
+    m_shelfY += m_shelfH + 1;
+    m_shelfX  = 0;
+    m_shelfH  = 0;
+  }
+  if (m_shelfY + img->h >= m_size)
+    return false;
+
+  glyph.u = m_shelfX;
+  glyph.v = m_shelfY;
+  glyph.w = img->w;
+  glyph.h = img->h;
+
+  for(int i = 0; i < img->h; i++)
+    memcpy(&m_data[(glyph.v + i) * m_size + glyph.u]
+         , img->bitmap + img->stride * i
+         , img->w);
+
+  if (glyph.v < m_dirtyY0)
+    m_dirtyY0 = glyph.v;
+  if (glyph.v + glyph.h > m_dirtyY1)
+    m_dirtyY1 = glyph.v + glyph.h;
+
+  m_shelfX += img->w + 1;
+  if (img->h > m_shelfH)
+    m_shelfH = img->h;
+
+  m_glyphs[hash] = glyph;
+  return true;
+}
+
+bool CGlyphAtlas::Convert(ASS_Image* images, SQuads& quads)
+{
+  ASS_Image* img;
+
+  if (!images)
+    return false;
+
+  int count = 0;
+  for(img = images; img; img = img->next)
+  {
+    if((img->color & 0xff) == 0xff || img->w == 0 || img->h == 0)
+      continue;
+    count++;
+  }
+
+  if (count == 0)
+    return false;
+
+  quads.quad = (SQuad*)calloc(count, sizeof(SQuad));
+
+  // if the atlas runs full, start over with the glyphs of this frame only
+  for(int pass = 0; pass < 2; pass++)
+  {
+    SQuad* v = quads.quad;
+    bool   full = false;
+
+    for(img = images; img; img = img->next)
+    {
+      if((img->color & 0xff) == 0xff || img->w == 0 || img->h == 0)
+        continue;
+
+      SGlyph glyph;
+      if (!Insert(img, glyph))
+      {
+        full = true;
+        break;
+      }
+
+      unsigned int color = img->color;
+
+      v->a = 255 - (color & 0xff);
+      v->r = ((color >> 24) & 0xff);
+      v->g = ((color >> 16) & 0xff);
+      v->b = ((color >> 8 ) & 0xff);
+
+      v->u = glyph.u;
+      v->v = glyph.v;
+
+      v->x = img->dst_x;
+      v->y = img->dst_y;
+
+      v->w = img->w;
+      v->h = img->h;
+
+      v++;
+    }
+
+    if (!full)
+    {
+      quads.count  = count;
+      quads.size_x = m_size;
+      quads.size_y = m_size;
+      return true;
+    }
+
+    Reset();
+  }
+  return false;
+}
+
 int GetStereoscopicDepth()
 {
   int depth = 0;
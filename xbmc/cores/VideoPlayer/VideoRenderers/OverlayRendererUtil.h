@@ -20,7 +20,10 @@
 
 #pragma once
 
+#include <stdint.h>
 #include <stdlib.h>
+#include <unordered_map>
+#include <vector>
 
 class CDVDOverlayImage;
 class CDVDOverlaySpu;
@@ -66,4 +69,43 @@ namespace OVERLAY {
   bool      convert_quad(ASS_Image* images, SQuads& quads);
   int       GetStereoscopicDepth();
 
+  // alpha texture of libass bitmaps that is kept across frames. bitmaps
+  // are found again by a hash of their content, so only images that are
+  // new since the last frame are copied in and have to be uploaded
+  class CGlyphAtlas
+  {
+  public:
+    CGlyphAtlas(int size);
+    virtual ~CGlyphAtlas() {}
+
+    // like convert_quad, but the quads point into the atlas and
+    // quads.data stays empty. returns false if the images don't fit
+    bool Convert(ASS_Image* images, SQuads& quads);
+
+    int            GetSize() const       { return m_size; }
+    const uint8_t* GetData() const       { return &m_data[0]; }
+    unsigned int   GetGeneration() const { return m_generation; }
+
+    // rows [y0, y1) were modified since the last call to ClearDirty
+    bool GetDirty(int& y0, int& y1) const;
+    void ClearDirty();
+
+  protected:
+    struct SGlyph
+    {
+      int u, v;
+      int w, h;
+    };
+
+    bool Insert(ASS_Image* img, SGlyph& glyph);
+    void Reset();
+
+    int                  m_size;
+    std::vector<uint8_t> m_data;
+    std::unordered_map<uint64_t, SGlyph> m_glyphs;
+    int                  m_shelfX, m_shelfY, m_shelfH;
+    int                  m_dirtyY0, m_dirtyY1;
+    unsigned int         m_generation; // increased whenever glyphs move
+  };
+
 }
@@ -26,6 +26,7 @@
 #include "threads/SingleLock.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
 #include "windowing/WindowingFactory.h"
 
 #include "Application.h"
@@ -134,6 +135,9 @@ CRenderManager::CRenderManager(CDVDClock &clock, IRenderMsg *player) :
   m_rendermethod(0),
   m_renderedOverlay(false),
   m_renderDebug(false),
+  m_overlayRenderTime(0.0),
+  m_framePacingSkip(0),
+  m_framePacingFlush(false),
   m_renderState(STATE_UNCONFIGURED),
   m_displayLatency(0.0),
   m_videoDelay(0),
@@ -317,6 +321,9 @@ bool CRenderManager::Configure()
     m_renderedOverlay = false;
     m_renderDebug = false;
     m_clockSync.Reset();
+    m_framePacing.Reset(m_fps, g_graphicsContext.GetFPS());
+    m_framePacingSkip = m_QueueSkip;
+    m_framePacingFlush = false;
 
     m_renderState = STATE_CONFIGURED;
 
@@ -401,6 +408,7 @@ void CRenderManager::FrameMove()
       m_pRenderer->FlipPage(m_presentsource);
       m_presentstep = PRESENT_FRAME;
       m_presentevent.notifyAll();
+      RecordFramePacing();
     }
 
     /* release all previous */
@@ -459,6 +467,9 @@ void CRenderManager::UnInit()
 
   CSingleLock lock(m_statelock);
 
+  if (g_advancedSettings.m_videoFramePacingLog && m_renderState == STATE_CONFIGURED)
+    m_framePacing.Dump("special://logpath/framepacing.json");
+
   m_overlays.Flush();
   m_debugRenderer.Flush();
 
@@ -901,7 +912,10 @@ void CRenderManager::Render(bool clear, DWORD flags, DWORD alpha, bool gui)
     CRect src, dst, view;
     m_pRenderer->GetVideoRect(src, dst, view);
     m_overlays.SetVideoRect(src, dst, view);
+
+    int64_t start = CurrentHostCounter();
     m_overlays.Render(m_presentsource);
+    m_overlayRenderTime = (double)(CurrentHostCounter() - start) * 1000.0 / CurrentHostFrequency();
 
     if (m_renderDebug)
     {
@@ -919,6 +933,7 @@ void CRenderManager::Render(bool clear, DWORD flags, DWORD alpha, bool gui)
                                      missedvblanks,
                                      clockspeed * 100);
       }
+      vsync += StringUtils::Format("  Sub: %.2fms", m_overlayRenderTime);
 
       m_debugRenderer.SetInfo(audio, video, player, vsync);
       m_debugRenderer.Render(src, dst, view);
@@ -1135,7 +1150,8 @@ int CRenderManager::AddVideoPicture(DVDVideoPicture& pic)
        || pic.format == RENDER_FMT_YUV420P10
        || pic.format == RENDER_FMT_YUV420P16)
   {
-    CDVDCodecUtils::CopyPicture(&image, &pic);
+    if (!m_pRenderer->AddVideoPictureRef(pic, index))
+      CDVDCodecUtils::CopyPicture(&image, &pic);
   }
   else if(pic.format == RENDER_FMT_NV12)
   {
@@ -1330,6 +1346,8 @@ void CRenderManager::DiscardBuffer()
   while(!m_queued.empty())
     requeue(m_discard, m_queued);
 
+  m_framePacingFlush = true;
+
   if(m_presentstep == PRESENT_READY)
     m_presentstep = PRESENT_IDLE;
   m_presentevent.notifyAll();
@@ -1345,6 +1363,37 @@ bool CRenderManager::GetStats(int &lateframes, double &pts, int &queued, int &di
   return true;
 }
 
+void CRenderManager::RecordFramePacing()
+{
+  double refreshrate = g_graphicsContext.GetFPS();
+  if (m_framePacing.GetFps() != m_fps || m_framePacing.GetRefreshRate() != refreshrate)
+    m_framePacing.Reset(m_fps, refreshrate);
+
+  SFramePacingSample sample;
+  sample.pts = m_Queue[m_presentsource].pts;
+  sample.presentTime = (double)CurrentHostCounter() / CurrentHostFrequency();
+  sample.skipped = m_QueueSkip - m_framePacingSkip;
+  sample.syncOffset = m_clockSync.m_syncOffset;
+  sample.discontinuity = m_framePacingFlush;
+
+  double clockspeed;
+  if (!m_dvdClock.GetClockInfo(sample.missedVblanks, clockspeed, refreshrate))
+  {
+    sample.missedVblanks = 0;
+    clockspeed = 1.0;
+  }
+  sample.clockSpeed = clockspeed;
+
+  m_framePacing.AddFrame(sample);
+  m_framePacingSkip = m_QueueSkip;
+  m_framePacingFlush = false;
+}
+
+void CRenderManager::GetFramePacing(CVariant &info, bool samples)
+{
+  m_framePacing.Serialize(info, samples);
+}
+
 void CRenderManager::CheckEnableClockSync()
 {
   // refresh rate can be a multiple of video fps
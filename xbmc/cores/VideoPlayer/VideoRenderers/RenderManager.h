@@ -30,6 +30,7 @@
 #include "settings/VideoSettings.h"
 #include "OverlayRenderer.h"
 #include "DebugRenderer.h"
+#include "FramePacing.h"
 #include <deque>
 #include <map>
 #include <atomic>
@@ -152,6 +153,13 @@ public:
    */
   void DiscardBuffer();
 
+  /**
+   * Timing of the recently presented frames and judder statistics derived from it
+   * @param info receives the statistics
+   * @param samples also return the recorded frames
+   */
+  void GetFramePacing(CVariant &info, bool samples);
+
   void SetDelay(int delay) { m_videoDelay = delay; };
   int GetDelay() { return m_videoDelay; };
 
@@ -170,6 +178,7 @@ protected:
 
   void UpdateDisplayLatency();
   void CheckEnableClockSync();
+  void RecordFramePacing();
 
   CBaseRenderer *m_pRenderer;
   OVERLAY::CRenderer m_overlays;
@@ -183,6 +192,10 @@ protected:
   int m_rendermethod;
   bool m_renderedOverlay;
   bool m_renderDebug;
+  double m_overlayRenderTime; // ms spent on overlays in the last frame
+  CFramePacingRecorder m_framePacing;
+  int m_framePacingSkip;  // m_QueueSkip at the last recorded frame
+  bool m_framePacingFlush; // next recorded frame follows a flush
   XbmcThreads::EndTime m_debugTimer;
 
 
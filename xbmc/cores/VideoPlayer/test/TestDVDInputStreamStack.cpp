@@ -0,0 +1,171 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "cores/VideoPlayer/DVDInputStreams/DVDInputStreamStack.h"
+#include "filesystem/File.h"
+#include "filesystem/StackDirectory.h"
+#include "test/TestUtils.h"
+#include "threads/Event.h"
+#include "threads/SystemClock.h"
+#include "utils/Job.h"
+#include "utils/JobManager.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define PART_SIZE 4096
+#define PARTS     4
+
+namespace
+{
+
+class CTestInputStreamStack : public CDVDInputStreamStack
+{
+public:
+  explicit CTestInputStreamStack(const CFileItem& item) : CDVDInputStreamStack(item) {}
+
+  int GetPreOpenIndex() const { return m_preopen ? (int)m_preopen->index : -1; }
+};
+
+class CBlockingJob : public CJob
+{
+public:
+  explicit CBlockingJob(const std::shared_ptr<CEvent> &release) : m_release(release) {}
+  virtual bool DoWork() override
+  {
+    m_release->Wait();
+    return true;
+  }
+
+private:
+  std::shared_ptr<CEvent> m_release;
+};
+
+}
+
+class TestDVDInputStreamStack : public testing::Test
+{
+protected:
+  TestDVDInputStreamStack()
+  {
+    std::vector<std::string> paths;
+    for (int i = 0; i < PARTS; i++)
+    {
+      XFILE::CFile *file = XBMC_CREATETEMPFILE(".avi");
+      if (!file)
+        continue;
+      file->Close();
+
+      // every part is filled with its own letter
+      std::string data(PART_SIZE, (char)('a' + i));
+      if (file->OpenForWrite(XBMC_TEMPFILEPATH(file), true))
+      {
+        file->Write(data.c_str(), data.size());
+        file->Close();
+      }
+      m_files.push_back(file);
+      paths.push_back(XBMC_TEMPFILEPATH(file));
+    }
+    XFILE::CStackDirectory::ConstructStackPath(paths, m_stackPath);
+  }
+
+  ~TestDVDInputStreamStack()
+  {
+    for (XFILE::CFile *file : m_files)
+      XBMC_DELETETEMPFILE(file);
+  }
+
+  std::vector<XFILE::CFile*> m_files;
+  std::string m_stackPath;
+};
+
+TEST_F(TestDVDInputStreamStack, ReadAcrossParts)
+{
+  ASSERT_EQ(PARTS, (int)m_files.size());
+  CTestInputStreamStack stack(CFileItem(m_stackPath, false));
+  ASSERT_TRUE(stack.Open());
+  EXPECT_EQ(PARTS * PART_SIZE, stack.GetLength());
+
+  std::string data;
+  uint8_t buf[1000];
+  int read;
+  while ((read = stack.Read(buf, sizeof(buf))) > 0)
+    data.append((const char*)buf, read);
+
+  ASSERT_EQ((size_t)(PARTS * PART_SIZE), data.size());
+  for (int i = 0; i < PARTS; i++)
+    EXPECT_EQ(std::string(PART_SIZE, (char)('a' + i)), data.substr(i * PART_SIZE, PART_SIZE));
+  EXPECT_TRUE(stack.IsEOF());
+}
+
+TEST_F(TestDVDInputStreamStack, PreOpenAfterSeek)
+{
+  ASSERT_EQ(PARTS, (int)m_files.size());
+  CTestInputStreamStack stack(CFileItem(m_stackPath, false));
+  ASSERT_TRUE(stack.Open());
+
+  // the parts are small, so reading the first one already opens the second ahead
+  uint8_t buf[16];
+  ASSERT_EQ((int)sizeof(buf), stack.Read(buf, sizeof(buf)));
+  EXPECT_EQ(1, stack.GetPreOpenIndex());
+
+  // after a seek into the third part, the fourth is the one to open ahead
+  ASSERT_EQ(2 * PART_SIZE + 10, stack.Seek(2 * PART_SIZE + 10, SEEK_SET));
+  ASSERT_EQ((int)sizeof(buf), stack.Read(buf, sizeof(buf)));
+  EXPECT_EQ('c', buf[0]);
+  EXPECT_EQ(3, stack.GetPreOpenIndex());
+
+  // and seeking back into the pre-opened part picks it up
+  ASSERT_EQ(3 * PART_SIZE, stack.Seek(3 * PART_SIZE, SEEK_SET));
+  ASSERT_EQ((int)sizeof(buf), stack.Read(buf, sizeof(buf)));
+  EXPECT_EQ('d', buf[0]);
+  EXPECT_EQ(-1, stack.GetPreOpenIndex());
+}
+
+TEST_F(TestDVDInputStreamStack, BusyWorkersDontStallBoundary)
+{
+  ASSERT_EQ(PARTS, (int)m_files.size());
+
+  // with every low priority worker busy the pre-open job never starts
+  std::shared_ptr<CEvent> release(new CEvent(true));
+  for (int i = 0; i < 8; i++)
+    CJobManager::GetInstance().AddJob(new CBlockingJob(release), nullptr, CJob::PRIORITY_LOW);
+
+  CTestInputStreamStack stack(CFileItem(m_stackPath, false));
+  ASSERT_TRUE(stack.Open());
+
+  std::string data;
+  uint8_t buf[1000];
+  int read;
+  XbmcThreads::EndTime timeout(10000);
+  while ((read = stack.Read(buf, sizeof(buf))) > 0)
+    data.append((const char*)buf, read);
+  unsigned int elapsed = timeout.GetInitialTimeoutValue() - timeout.MillisLeft();
+  release->Set();
+
+  // the parts are opened on the spot after a short wait at each boundary
+  ASSERT_EQ((size_t)(PARTS * PART_SIZE), data.size());
+  EXPECT_EQ(std::string(PART_SIZE, 'd'), data.substr(3 * PART_SIZE));
+  EXPECT_LT(elapsed, 2000u);
+}
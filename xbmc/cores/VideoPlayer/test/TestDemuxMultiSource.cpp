@@ -0,0 +1,214 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "cores/VideoPlayer/DVDDemuxers/DemuxMultiSource.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/VideoPlayer/DVDInputStreams/DVDInputStream.h"
+#include "threads/Event.h"
+#include "threads/SystemClock.h"
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+/* Demuxer handing out one packet per given time, with a single audio stream
+ * that is replaced by one with another codec from packet changeAt on. */
+class CFakeDemux : public CDVDDemux
+{
+public:
+  CFakeDemux(const std::vector<double>& times, size_t changeAt = SIZE_MAX, bool stall = false)
+    : m_times(times)
+    , m_next(0)
+    , m_changeAt(changeAt)
+    , m_stall(stall)
+  {
+    m_stream.reset(NewStream(AV_CODEC_ID_MP2));
+  }
+
+  virtual void Reset() override { m_next = 0; }
+  virtual void Abort() override { m_abort.Set(); }
+  virtual void Flush() override {}
+
+  virtual DemuxPacket* Read() override
+  {
+    // a source that is slow to deliver, like a file on a busy network share
+    if (m_stall)
+    {
+      m_abort.Wait();
+      return NULL;
+    }
+    if (m_next >= m_times.size())
+      return NULL;
+
+    if (m_next == m_changeAt)
+      m_stream.reset(NewStream(AV_CODEC_ID_AC3));
+
+    DemuxPacket* packet = CDVDDemuxUtils::AllocateDemuxPacket(0);
+    packet->iStreamId = 0;
+    packet->demuxerId = GetDemuxerId();
+    packet->dts = packet->pts = m_times[m_next++];
+    return packet;
+  }
+
+  virtual bool SeekTime(int time, bool backwords = false, double* startpts = NULL) override { return false; }
+  virtual void SetSpeed(int iSpeed) override {}
+  virtual int GetStreamLength() override { return 0; }
+  virtual CDemuxStream* GetStream(int iStreamId) const override { return iStreamId == 0 ? m_stream.get() : NULL; }
+  virtual std::vector<CDemuxStream*> GetStreams() const override { return std::vector<CDemuxStream*>(1, m_stream.get()); }
+  virtual int GetNrOfStreams() const override { return 1; }
+  virtual std::string GetFileName() override { return ""; }
+
+private:
+  CDemuxStream* NewStream(AVCodecID codec)
+  {
+    CDemuxStreamAudio* stream = new CDemuxStreamAudio();
+    stream->uniqueId = 0;
+    stream->demuxerId = GetDemuxerId();
+    stream->codec = codec;
+    return stream;
+  }
+
+  std::vector<double> m_times;
+  size_t m_next;
+  size_t m_changeAt;
+  bool m_stall;
+  CEvent m_abort;
+  std::unique_ptr<CDemuxStream> m_stream;
+};
+
+// always at eof, the fake demuxer decides when the source ends
+class CFakeInputStream : public CDVDInputStream
+{
+public:
+  CFakeInputStream() : CDVDInputStream(DVDSTREAM_TYPE_MEMORY, CFileItem("memory://", false)) {}
+
+  virtual int Read(uint8_t* buf, int buf_size) override { return 0; }
+  virtual int64_t Seek(int64_t offset, int whence) override { return -1; }
+  virtual bool Pause(double dTime) override { return false; }
+  virtual int64_t GetLength() override { return 0; }
+  virtual bool IsEOF() override { return true; }
+};
+
+class CTestDemuxMultiSource : public CDemuxMultiSource
+{
+public:
+  void AddSource(std::shared_ptr<CFakeDemux> demuxer)
+  {
+    CDemuxMultiSource::AddSource(demuxer, InputStreamPtr(new CFakeInputStream()));
+  }
+};
+
+// gives the reader threads time to queue their packets
+void WaitForReaders()
+{
+  CEvent event;
+  event.WaitMSec(200);
+}
+
+std::vector<double> Times(double first, double step, size_t count)
+{
+  std::vector<double> times;
+  for (size_t i = 0; i < count; i++)
+    times.push_back(first + i * step);
+  return times;
+}
+
+}
+
+TEST(TestDemuxMultiSource, MergesByDts)
+{
+  CTestDemuxMultiSource demuxer;
+  demuxer.AddSource(std::make_shared<CFakeDemux>(Times(0, 2, 100)));
+  demuxer.AddSource(std::make_shared<CFakeDemux>(Times(1, 2, 100)));
+  WaitForReaders();
+
+  double last = -1;
+  int packets = 0;
+  XbmcThreads::EndTime timeout(10000);
+  while (packets < 200 && !timeout.IsTimePast())
+  {
+    DemuxPacket* packet = demuxer.Read();
+    if (!packet)
+      continue;
+    EXPECT_GE(packet->dts, last);
+    last = packet->dts;
+    packets++;
+    CDVDDemuxUtils::FreeDemuxPacket(packet);
+  }
+  EXPECT_EQ(200, packets);
+  EXPECT_EQ(nullptr, demuxer.Read());
+}
+
+TEST(TestDemuxMultiSource, StalledSourceWaitedForOnce)
+{
+  CTestDemuxMultiSource demuxer;
+  demuxer.AddSource(std::make_shared<CFakeDemux>(Times(0, 1, 500)));
+  demuxer.AddSource(std::make_shared<CFakeDemux>(std::vector<double>(), SIZE_MAX, true));
+
+  // waiting on the stalled source for every packet would take 10 seconds
+  int packets = 0;
+  XbmcThreads::EndTime timeout(10000);
+  while (packets < 500 && !timeout.IsTimePast())
+  {
+    DemuxPacket* packet = demuxer.Read();
+    if (!packet)
+      continue;
+    packets++;
+    CDVDDemuxUtils::FreeDemuxPacket(packet);
+  }
+  EXPECT_EQ(500, packets);
+  EXPECT_LT(timeout.GetInitialTimeoutValue() - timeout.MillisLeft(), 2000u);
+}
+
+TEST(TestDemuxMultiSource, StreamsMatchPacket)
+{
+  CTestDemuxMultiSource demuxer;
+  std::shared_ptr<CFakeDemux> source = std::make_shared<CFakeDemux>(Times(0, 1, 100), 50);
+  demuxer.AddSource(source);
+
+  CDemuxStream* stream = demuxer.GetStream(source->GetDemuxerId(), 0);
+  ASSERT_NE(nullptr, stream);
+  EXPECT_EQ(AV_CODEC_ID_MP2, stream->codec);
+
+  // the reader is far ahead and has replaced the stream long before the
+  // player gets to the packets of the new one
+  WaitForReaders();
+  int packets = 0;
+  XbmcThreads::EndTime timeout(10000);
+  while (packets < 100 && !timeout.IsTimePast())
+  {
+    DemuxPacket* packet = demuxer.Read();
+    if (!packet)
+      continue;
+
+    stream = demuxer.GetStream(packet->demuxerId, packet->iStreamId);
+    ASSERT_NE(nullptr, stream);
+    EXPECT_EQ(packet->dts < 50 ? AV_CODEC_ID_MP2 : AV_CODEC_ID_AC3, stream->codec) << "packet " << packet->dts;
+    EXPECT_EQ(1u, demuxer.GetStreams().size());
+    packets++;
+    CDVDDemuxUtils::FreeDemuxPacket(packet);
+  }
+  EXPECT_EQ(100, packets);
+}
@@ -0,0 +1,116 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "cores/VideoPlayer/VideoRenderers/FramePacing.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/* Simulated vsync: every frame is flipped on the first vblank at or after
+ * its pts, like the render manager does with a locked display clock.
+ * vblanks listed in dropped are missed and the frame waits for the next one.
+ */
+static void Simulate(CFramePacingRecorder &recorder, double fps, double refreshRate,
+                     int frames, const std::vector<int> &dropped = std::vector<int>())
+{
+  recorder.Reset(fps, refreshRate);
+
+  int vblank = 0;
+  for (int i = 0; i < frames; i++)
+  {
+    double pts = i / fps;
+    while (vblank / refreshRate < pts - 1e-9)
+      vblank++;
+    while (std::find(dropped.begin(), dropped.end(), vblank) != dropped.end())
+      vblank++;
+
+    SFramePacingSample sample;
+    sample.pts = pts;
+    sample.presentTime = vblank / refreshRate;
+    sample.skipped = 0;
+    sample.missedVblanks = 0;
+    sample.clockSpeed = 1.0;
+    sample.syncOffset = 0.0;
+    sample.discontinuity = false;
+    recorder.AddFrame(sample);
+  }
+}
+
+TEST(TestFramePacing, MatchedRefreshRate)
+{
+  CFramePacingRecorder recorder(256);
+  Simulate(recorder, 24.0, 24.0, 200);
+
+  SFramePacingStats stats;
+  recorder.GetStats(stats);
+  EXPECT_EQ(200, stats.frames);
+  EXPECT_NEAR(1000.0 / 24.0, stats.expectedInterval, 0.001);
+  EXPECT_NEAR(stats.expectedInterval, stats.meanInterval, 0.001);
+  EXPECT_NEAR(0.0, stats.judder, 0.001);
+  EXPECT_EQ(0, stats.irregular);
+  EXPECT_EQ(0, stats.repeats);
+  EXPECT_EQ(199, stats.histogram[1]);
+}
+
+TEST(TestFramePacing, Pulldown)
+{
+  CFramePacingRecorder recorder(256);
+  Simulate(recorder, 24.0, 60.0, 101);
+
+  // 3:2 pulldown, alternating 2 and 3 vblanks is the cadence, not an error
+  SFramePacingStats stats;
+  recorder.GetStats(stats);
+  EXPECT_EQ(50, stats.histogram[2]);
+  EXPECT_EQ(50, stats.histogram[3]);
+  EXPECT_EQ(0, stats.irregular);
+  EXPECT_NEAR(1000.0 / 120.0, stats.judder, 0.001);
+  EXPECT_NEAR(1000.0 / 120.0, stats.maxJudder, 0.001);
+}
+
+TEST(TestFramePacing, MissedVblank)
+{
+  CFramePacingRecorder recorder(256);
+  std::vector<int> dropped;
+  dropped.push_back(50);
+  Simulate(recorder, 30.0, 60.0, 100, dropped);
+
+  SFramePacingStats stats;
+  recorder.GetStats(stats);
+  EXPECT_EQ(2, stats.irregular);
+  EXPECT_EQ(1, stats.repeats);
+  EXPECT_EQ(97, stats.histogram[2]);
+  EXPECT_EQ(1, stats.histogram[3]);
+  EXPECT_EQ(1, stats.histogram[1]);
+}
+
+TEST(TestFramePacing, RingBuffer)
+{
+  CFramePacingRecorder recorder(16);
+  Simulate(recorder, 25.0, 50.0, 40);
+
+  std::vector<SFramePacingSample> samples;
+  recorder.GetSamples(samples);
+  ASSERT_EQ(16u, samples.size());
+  EXPECT_NEAR(24 / 25.0, samples.front().pts, 1e-9);
+  EXPECT_NEAR(39 / 25.0, samples.back().pts, 1e-9);
+}
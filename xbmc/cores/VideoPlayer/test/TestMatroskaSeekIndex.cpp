@@ -0,0 +1,288 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "cores/VideoPlayer/DVDDemuxers/EbmlParser.h"
+#include "cores/VideoPlayer/DVDDemuxers/MatroskaSeekIndex.h"
+#include "cores/VideoPlayer/DVDInputStreams/DVDInputStream.h"
+
+#include <algorithm>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+class CMemoryInputStream : public CDVDInputStream
+{
+public:
+  explicit CMemoryInputStream(const std::string& data)
+    : CDVDInputStream(DVDSTREAM_TYPE_MEMORY, CFileItem("memory://", false))
+    , m_data(data)
+    , m_pos(0)
+  {
+  }
+
+  virtual int Read(uint8_t* buf, int buf_size) override
+  {
+    int size = std::min<int64_t>(buf_size, m_data.size() - m_pos);
+    memcpy(buf, m_data.data() + m_pos, size);
+    m_pos += size;
+    return size;
+  }
+
+  virtual int64_t Seek(int64_t offset, int whence) override
+  {
+    if (whence == SEEK_POSSIBLE)
+      return 1;
+
+    int64_t pos = offset;
+    if (whence == SEEK_CUR)
+      pos += m_pos;
+    else if (whence == SEEK_END)
+      pos += m_data.size();
+    if (pos < 0 || pos > (int64_t)m_data.size())
+      return -1;
+    m_pos = pos;
+    return m_pos;
+  }
+
+  virtual bool Pause(double dTime) override { return false; }
+  virtual int64_t GetLength() override { return m_data.size(); }
+  virtual bool IsEOF() override { return m_pos >= (int64_t)m_data.size(); }
+
+private:
+  std::string m_data;
+  int64_t m_pos;
+};
+
+const EbmlId ID_SEGMENT = 0x18538067;
+const EbmlId ID_SEEKHEAD = 0x114D9B74;
+const EbmlId ID_SEEKENTRY = 0x4DBB;
+const EbmlId ID_SEEKID = 0x53AB;
+const EbmlId ID_SEEKPOSITION = 0x53AC;
+const EbmlId ID_INFO = 0x1549A966;
+const EbmlId ID_TIMECODESCALE = 0x2AD7B1;
+const EbmlId ID_CLUSTER = 0x1F43B675;
+const EbmlId ID_CLUSTERTIMECODE = 0xE7;
+const EbmlId ID_SIMPLEBLOCK = 0xA3;
+const EbmlId ID_CUES = 0x1C53BB6B;
+const EbmlId ID_POINTENTRY = 0xBB;
+const EbmlId ID_CUETIME = 0xB3;
+const EbmlId ID_CUETRACKPOSITION = 0xB7;
+const EbmlId ID_CUETRACK = 0xF7;
+const EbmlId ID_CUECLUSTERPOSITION = 0xF1;
+
+std::string Id(EbmlId id)
+{
+  std::string result;
+  for (int shift = 24; shift >= 0; shift -= 8)
+  {
+    if ((id >> shift) || !result.empty() || shift == 0)
+      result += (char)((id >> shift) & 0xFF);
+  }
+  return result;
+}
+
+// sizes are always written with 8 bytes, like muxers that patch them in later
+std::string Len(uint64_t len)
+{
+  std::string result(1, '\x01');
+  for (int shift = 48; shift >= 0; shift -= 8)
+    result += (char)((len >> shift) & 0xFF);
+  return result;
+}
+
+std::string Uint(uint64_t value, int bytes = 0)
+{
+  std::string result;
+  for (int shift = 56; shift >= 0; shift -= 8)
+  {
+    if ((value >> shift) || !result.empty() || shift == 0 || shift < bytes * 8)
+      result += (char)((value >> shift) & 0xFF);
+  }
+  return result;
+}
+
+std::string Element(EbmlId id, const std::string& payload)
+{
+  return Id(id) + Len(payload.size()) + payload;
+}
+
+std::string EbmlHead()
+{
+  return Element(EBML_ID_HEADER, Element(EBML_ID_EBMLVERSION, Uint(1)) +
+                                 Element(EBML_ID_DOCTYPE, "matroska"));
+}
+
+std::string Cluster(uint64_t timecode, bool crc = false)
+{
+  std::string payload;
+  if (crc)
+    payload += Element(EBML_ID_CRC32, std::string(4, '\0'));
+  payload += Element(ID_CLUSTERTIMECODE, Uint(timecode));
+  payload += Element(ID_SIMPLEBLOCK, std::string(100, 'x'));
+  return Element(ID_CLUSTER, payload);
+}
+
+}
+
+TEST(TestEbmlParser, ReadId)
+{
+  CMemoryInputStream input(Id(EBML_ID_HEADER) + Id(EBML_ID_VOID) + Id(ID_SEEKID));
+  EXPECT_EQ(EBML_ID_HEADER, EbmlReadId(&input));
+  EXPECT_EQ(EBML_ID_VOID, EbmlReadId(&input));
+  EXPECT_EQ(ID_SEEKID, EbmlReadId(&input));
+  EXPECT_TRUE(input.IsEOF());
+}
+
+TEST(TestEbmlParser, ReadLen)
+{
+  // one, two and eight byte sizes, each followed by a marker byte
+  std::string data;
+  data += "\x85" "A";
+  data += std::string("\x40\x02", 2) + "B";
+  data += Len(0x0102030405) + "C";
+  CMemoryInputStream input(data);
+
+  uint8_t marker;
+  EXPECT_EQ(5u, EbmlReadLen(&input));
+  ASSERT_EQ(1, input.Read(&marker, 1));
+  EXPECT_EQ('A', marker);
+  EXPECT_EQ(2u, EbmlReadLen(&input));
+  ASSERT_EQ(1, input.Read(&marker, 1));
+  EXPECT_EQ('B', marker);
+  EXPECT_EQ(0x0102030405u, EbmlReadLen(&input));
+  ASSERT_EQ(1, input.Read(&marker, 1));
+  EXPECT_EQ('C', marker);
+}
+
+TEST(TestEbmlParser, ReadUint)
+{
+  CMemoryInputStream input(std::string("\x01\x02\x00\x00\x00\xFF", 6));
+  EXPECT_EQ(0x0102u, EbmlReadUint(&input, 2));
+  EXPECT_EQ(0xFFu, EbmlReadUint(&input, 4));
+}
+
+TEST(TestEbmlParser, ReadString)
+{
+  CMemoryInputStream input(std::string("abcde\0\0", 7) + "xyz");
+  EXPECT_EQ("abcde", EbmlReadString(&input, 7));
+  // no terminating NUL at all
+  EXPECT_EQ("xyz", EbmlReadString(&input, 3));
+}
+
+TEST(TestEbmlParser, ParseHeader)
+{
+  CMemoryInputStream input(EbmlHead());
+  EbmlHeader header;
+  header.doctype.clear();
+  ASSERT_TRUE(header.Parse(&input));
+  EXPECT_EQ(1u, header.version);
+  EXPECT_EQ("matroska", header.doctype);
+}
+
+TEST(TestMatroskaSeekIndex, BuildFromCues)
+{
+  std::string info = Element(ID_INFO, Element(ID_TIMECODESCALE, Uint(1000000)));
+  std::vector<uint64_t> timecodes = { 0, 5000, 10000 };
+  std::string clusters;
+  std::vector<uint64_t> clusterPos;
+
+  // the seek head has a fixed size, the cues position is written with 8 bytes
+  std::string seekHead = Element(ID_SEEKHEAD, Element(ID_SEEKENTRY, Element(ID_SEEKID, Id(ID_CUES)) +
+                                                                     Element(ID_SEEKPOSITION, Uint(0, 8))));
+  uint64_t pos = seekHead.size() + info.size();
+  for (uint64_t timecode : timecodes)
+  {
+    clusterPos.push_back(pos);
+    std::string cluster = Cluster(timecode);
+    clusters += cluster;
+    pos += cluster.size();
+  }
+  seekHead = Element(ID_SEEKHEAD, Element(ID_SEEKENTRY, Element(ID_SEEKID, Id(ID_CUES)) +
+                                                        Element(ID_SEEKPOSITION, Uint(pos, 8))));
+
+  std::string cues;
+  for (size_t i = 0; i < timecodes.size(); i++)
+  {
+    cues += Element(ID_POINTENTRY, Element(ID_CUETIME, Uint(timecodes[i])) +
+                                   Element(ID_CUETRACKPOSITION, Element(ID_CUETRACK, Uint(1)) +
+                                                                Element(ID_CUECLUSTERPOSITION, Uint(clusterPos[i]))));
+  }
+
+  std::string head = EbmlHead();
+  std::string segment = Element(ID_SEGMENT, seekHead + info + clusters + Element(ID_CUES, cues));
+  uint64_t segmentData = head.size() + Id(ID_SEGMENT).size() + Len(0).size();
+
+  CMemoryInputStream input(head + segment);
+  MatroskaSeekPoints points;
+  ASSERT_TRUE(CMatroskaSeekIndex::Build(&input, points));
+  ASSERT_EQ(timecodes.size(), points.size());
+  for (size_t i = 0; i < timecodes.size(); i++)
+  {
+    EXPECT_EQ((int64_t)timecodes[i], points[i].time);
+    EXPECT_EQ((int64_t)(segmentData + clusterPos[i]), points[i].pos);
+  }
+}
+
+TEST(TestMatroskaSeekIndex, BuildFromClusters)
+{
+  // no cues, and a timecode scale of 2ms
+  std::string info = Element(ID_INFO, Element(ID_TIMECODESCALE, Uint(2000000)));
+  std::string head = EbmlHead();
+  uint64_t segmentData = head.size() + Id(ID_SEGMENT).size() + Len(0).size();
+
+  std::vector<uint64_t> timecodes = { 0, 1000, 1000, 2500 };
+  std::string clusters;
+  std::vector<uint64_t> clusterPos;
+  uint64_t pos = segmentData + info.size();
+  for (size_t i = 0; i < timecodes.size(); i++)
+  {
+    clusterPos.push_back(pos);
+    std::string cluster = Cluster(timecodes[i], i == 1);
+    clusters += cluster;
+    pos += cluster.size();
+  }
+
+  CMemoryInputStream input(head + Element(ID_SEGMENT, info + clusters));
+  MatroskaSeekPoints points;
+  ASSERT_TRUE(CMatroskaSeekIndex::Build(&input, points));
+
+  // the cluster with a repeated timecode adds nothing
+  ASSERT_EQ(3u, points.size());
+  EXPECT_EQ(0, points[0].time);
+  EXPECT_EQ((int64_t)clusterPos[0], points[0].pos);
+  EXPECT_EQ(2000, points[1].time);
+  EXPECT_EQ((int64_t)clusterPos[1], points[1].pos);
+  EXPECT_EQ(5000, points[2].time);
+  EXPECT_EQ((int64_t)clusterPos[3], points[2].pos);
+}
+
+TEST(TestMatroskaSeekIndex, BuildRejectsOtherFiles)
+{
+  CMemoryInputStream input(std::string(64, 'x'));
+  MatroskaSeekPoints points;
+  EXPECT_FALSE(CMatroskaSeekIndex::Build(&input, points));
+  EXPECT_TRUE(points.empty());
+}
@@ -0,0 +1,222 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "cores/VideoPlayer/DVDFileInfo.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+#include "threads/Event.h"
+#include "utils/Job.h"
+#include "utils/JobManager.h"
+#include "utils/StreamDetails.h"
+#include "video/VideoInfoTag.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/* The stream details of the files given with --add-streamdetails-probe-file
+ * are read twice, once with the header probe and once with a full open of
+ * the file as done for playback, and have to match. Without files those tests
+ * do nothing, the batch is also tested with generated wav files.
+ */
+
+namespace
+{
+
+void ExpectSameDetails(const CStreamDetails &full, const CStreamDetails &probed, const std::string &file)
+{
+  ASSERT_EQ(full.GetVideoStreamCount(), probed.GetVideoStreamCount()) << file;
+  ASSERT_EQ(full.GetAudioStreamCount(), probed.GetAudioStreamCount()) << file;
+  ASSERT_EQ(full.GetSubtitleStreamCount(), probed.GetSubtitleStreamCount()) << file;
+
+  for (int i = 1; i <= full.GetVideoStreamCount(); i++)
+  {
+    EXPECT_EQ(full.GetVideoCodec(i), probed.GetVideoCodec(i)) << file << " video " << i;
+    EXPECT_EQ(full.GetVideoWidth(i), probed.GetVideoWidth(i)) << file << " video " << i;
+    EXPECT_EQ(full.GetVideoHeight(i), probed.GetVideoHeight(i)) << file << " video " << i;
+    EXPECT_NEAR(full.GetVideoAspect(i), probed.GetVideoAspect(i), 0.01f) << file << " video " << i;
+    EXPECT_NEAR(full.GetVideoDuration(i), probed.GetVideoDuration(i), 1) << file << " video " << i;
+    EXPECT_EQ(full.GetStereoMode(i), probed.GetStereoMode(i)) << file << " video " << i;
+    EXPECT_EQ(full.GetVideoLanguage(i), probed.GetVideoLanguage(i)) << file << " video " << i;
+  }
+
+  for (int i = 1; i <= full.GetAudioStreamCount(); i++)
+  {
+    EXPECT_EQ(full.GetAudioCodec(i), probed.GetAudioCodec(i)) << file << " audio " << i;
+    EXPECT_EQ(full.GetAudioChannels(i), probed.GetAudioChannels(i)) << file << " audio " << i;
+    EXPECT_EQ(full.GetAudioLanguage(i), probed.GetAudioLanguage(i)) << file << " audio " << i;
+  }
+
+  for (int i = 1; i <= full.GetSubtitleStreamCount(); i++)
+    EXPECT_EQ(full.GetSubtitleLanguage(i), probed.GetSubtitleLanguage(i)) << file << " subtitle " << i;
+}
+
+// 100ms of 16 bit stereo silence
+std::string WavData()
+{
+  const uint32_t rate = 48000;
+  const uint16_t channels = 2;
+  const uint16_t bits = 16;
+  const uint32_t size = rate / 10 * channels * bits / 8;
+
+  std::string data;
+  auto add = [&data](uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++)
+      data += (char)((value >> (i * 8)) & 0xFF);
+  };
+  data += "RIFF";
+  add(36 + size, 4);
+  data += "WAVEfmt ";
+  add(16, 4);
+  add(1, 2);
+  add(channels, 2);
+  add(rate, 4);
+  add(rate * channels * bits / 8, 4);
+  add(channels * bits / 8, 2);
+  add(bits, 2);
+  data += "data";
+  add(size, 4);
+  data.append(size, '\0');
+  return data;
+}
+
+// keeps a job worker busy until released
+class CBlockingJob : public CJob
+{
+public:
+  explicit CBlockingJob(const std::shared_ptr<CEvent> &release) : m_release(release) {}
+  virtual bool DoWork() override
+  {
+    m_release->Wait();
+    return true;
+  }
+
+private:
+  std::shared_ptr<CEvent> m_release;
+};
+
+}
+
+class TestStreamDetailsBatch : public testing::Test
+{
+protected:
+  TestStreamDetailsBatch()
+  {
+    std::string data = WavData();
+    for (int i = 0; i < 6; i++)
+    {
+      XFILE::CFile *file = XBMC_CREATETEMPFILE(".wav");
+      if (!file)
+        continue;
+      file->Close();
+      if (file->OpenForWrite(XBMC_TEMPFILEPATH(file), true))
+      {
+        file->Write(data.c_str(), data.size());
+        file->Close();
+      }
+      m_files.push_back(file);
+      m_items.emplace_back(new CFileItem(XBMC_TEMPFILEPATH(file), false));
+      m_batch.push_back(m_items.back().get());
+    }
+  }
+
+  ~TestStreamDetailsBatch()
+  {
+    for (XFILE::CFile *file : m_files)
+      XBMC_DELETETEMPFILE(file);
+  }
+
+  void ExpectDetails()
+  {
+    for (const auto &item : m_items)
+    {
+      const CStreamDetails &details = item->GetVideoInfoTag()->m_streamDetails;
+      EXPECT_EQ(1, details.GetAudioStreamCount()) << item->GetPath();
+      EXPECT_EQ(2, details.GetAudioChannels()) << item->GetPath();
+      EXPECT_EQ(0, details.GetVideoStreamCount()) << item->GetPath();
+    }
+  }
+
+  std::vector<XFILE::CFile*> m_files;
+  std::vector<std::unique_ptr<CFileItem>> m_items;
+  std::vector<CFileItem*> m_batch;
+};
+
+TEST_F(TestStreamDetailsBatch, ProbesAllItems)
+{
+  ASSERT_EQ(6u, m_batch.size());
+  EXPECT_EQ(6u, CDVDFileInfo::GetFileStreamDetailsBatch(m_batch, 4));
+  ExpectDetails();
+}
+
+TEST_F(TestStreamDetailsBatch, DoesNotWaitForQueuedJobs)
+{
+  ASSERT_EQ(6u, m_batch.size());
+
+  // with every low priority worker busy, the helpers never start and the
+  // calling thread has to probe all the files on its own
+  std::shared_ptr<CEvent> release(new CEvent(true));
+  for (int i = 0; i < 8; i++)
+    CJobManager::GetInstance().AddJob(new CBlockingJob(release), nullptr, CJob::PRIORITY_LOW);
+
+  unsigned int changed = CDVDFileInfo::GetFileStreamDetailsBatch(m_batch, 4);
+  release->Set();
+
+  EXPECT_EQ(6u, changed);
+  ExpectDetails();
+}
+
+TEST(TestStreamDetailsProbe, MatchesFullOpen)
+{
+  for (const std::string &file : CXBMCTestUtils::Instance().getStreamDetailsProbeFiles())
+  {
+    CFileItem full(file, false);
+    CFileItem probed(file, false);
+    EXPECT_TRUE(CDVDFileInfo::GetFileStreamDetails(&full, false)) << file;
+    EXPECT_TRUE(CDVDFileInfo::GetFileStreamDetails(&probed, true)) << file;
+    ExpectSameDetails(full.GetVideoInfoTag()->m_streamDetails, probed.GetVideoInfoTag()->m_streamDetails, file);
+  }
+}
+
+TEST(TestStreamDetailsProbe, BatchMatchesSingle)
+{
+  const std::vector<std::string> &files = CXBMCTestUtils::Instance().getStreamDetailsProbeFiles();
+  if (files.empty())
+    return;
+
+  std::vector<std::unique_ptr<CFileItem>> single;
+  std::vector<std::unique_ptr<CFileItem>> batch;
+  std::vector<CFileItem*> batchItems;
+  for (const std::string &file : files)
+  {
+    single.emplace_back(new CFileItem(file, false));
+    CDVDFileInfo::GetFileStreamDetails(single.back().get());
+    batch.emplace_back(new CFileItem(file, false));
+    batchItems.push_back(batch.back().get());
+  }
+
+  CDVDFileInfo::GetFileStreamDetailsBatch(batchItems, 4);
+
+  for (size_t i = 0; i < files.size(); i++)
+    ExpectSameDetails(single[i]->GetVideoInfoTag()->m_streamDetails, batch[i]->GetVideoInfoTag()->m_streamDetails, files[i]);
+}
@@ -0,0 +1,491 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "TextureCache.h"
+#include "cores/FFmpeg.h"
+#include "cores/VideoPlayer/DVDClock.h"
+#include "cores/VideoPlayer/DVDFileInfo.h"
+#include "cores/VideoPlayer/DVDStreamInfo.h"
+#include "cores/VideoPlayer/DVDCodecs/DVDCodecUtils.h"
+#include "cores/VideoPlayer/DVDCodecs/DVDFactoryCodec.h"
+#include "cores/VideoPlayer/DVDCodecs/Audio/DVDAudioCodec.h"
+#include "cores/VideoPlayer/DVDCodecs/Video/DVDVideoCodec.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemux.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDDemuxUtils.h"
+#include "cores/VideoPlayer/DVDDemuxers/DVDFactoryDemuxer.h"
+#include "cores/VideoPlayer/DVDInputStreams/DVDFactoryInputStream.h"
+#include "cores/VideoPlayer/DVDInputStreams/DVDInputStream.h"
+#include "cores/VideoPlayer/Process/ProcessInfo.h"
+#include "cores/VideoPlayer/VideoRenderers/BaseRenderer.h"
+#include "filesystem/File.h"
+#include "test/TestUtils.h"
+#include "threads/Event.h"
+#include "utils/JSONVariantWriter.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
+#include "utils/Variant.h"
+
+#if defined(TARGET_POSIX)
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/* Headless throughput benchmark of the VideoPlayer decode pipeline. The
+ * files to play are given to the test program with
+ * --add-videoplayer-benchmark-file, the result is written as json to stdout
+ * or to the file given with --set-videoplayer-benchmark-output. Without
+ * files the test does nothing.
+ *
+ * Every packet is read from the demuxer and decoded with the software
+ * codecs. Video pictures are copied to a YV12Image the way
+ * CRenderManager::AddVideoPicture does for a renderer without hardware
+ * surfaces. Audio is decoded but not sent to a sink, as a sink would pace
+ * the benchmark to real time. At the end of the stream the video decoder is
+ * drained so the pictures it still holds are counted.
+ *
+ * The codecs are driven directly, not through CVideoPlayerVideo and
+ * CVideoPlayerAudio, and no message queue, renderer or audio sink is
+ * involved. The figures are the demux, decode and picture copy costs only,
+ * regressions in the player threads or their message queues don't show up
+ * in them.
+ *
+ * The thumb extraction benchmark compares extracting the thumbs one file
+ * after the other, the way a single CThumbExtractor job does, with
+ * CDVDFileInfo::ExtractThumbBatch, which CThumbBatchExtractor uses for the
+ * thumbs of a directory listing. Its files are given with
+ * --add-thumbextract-benchmark-file.
+ *
+ * peak_memory_kb is the sampled peak of the resident memory above the one
+ * at the start of the run.
+ */
+
+namespace
+{
+
+class CStageStats
+{
+public:
+  void Add(int64_t ticks) { m_samples.push_back(ticks); }
+  int64_t Total() const
+  {
+    int64_t total = 0;
+    for (int64_t sample : m_samples)
+      total += sample;
+    return total;
+  }
+
+  CVariant ToVariant() const
+  {
+    CVariant result(CVariant::VariantTypeObject);
+    result["count"] = (uint64_t)m_samples.size();
+    result["total_ms"] = ToMicroSeconds(Total()) / 1000.0;
+    if (m_samples.empty())
+      return result;
+
+    std::vector<int64_t> sorted(m_samples);
+    std::sort(sorted.begin(), sorted.end());
+    result["avg_us"] = ToMicroSeconds(Total()) / sorted.size();
+    result["p95_us"] = ToMicroSeconds(sorted[sorted.size() * 95 / 100]);
+    result["max_us"] = ToMicroSeconds(sorted.back());
+    return result;
+  }
+
+  static double ToMicroSeconds(int64_t ticks)
+  {
+    return (double)ticks * 1000000.0 / CurrentHostFrequency();
+  }
+
+private:
+  std::vector<int64_t> m_samples;
+};
+
+int64_t GetResidentMemoryKB()
+{
+#if defined(TARGET_POSIX)
+  // second field of statm is the resident set size in pages
+  std::ifstream statm("/proc/self/statm");
+  int64_t size = 0, resident = 0;
+  if (statm >> size >> resident)
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+  return 0;
+}
+
+/* Samples the resident set size while a benchmark runs, so every run
+ * reports the memory it added itself and not the peak of the whole
+ * process, which only grows from run to run. */
+class CMemorySampler
+{
+public:
+  CMemorySampler()
+    : m_base(GetResidentMemoryKB())
+    , m_peak(m_base)
+    , m_thread([this]() { Run(); })
+  {
+  }
+
+  ~CMemorySampler() { Stop(); }
+
+  /*! \brief Stop sampling.
+   \return the peak resident memory above the one at construction in KB.
+   */
+  int64_t Stop()
+  {
+    m_stopEvent.Set();
+    if (m_thread.joinable())
+      m_thread.join();
+    return m_peak - m_base;
+  }
+
+private:
+  void Run()
+  {
+    do
+    {
+      m_peak = std::max(m_peak, GetResidentMemoryKB());
+    } while (!m_stopEvent.WaitMSec(5));
+  }
+
+  int64_t m_base;
+  int64_t m_peak;
+  CEvent m_stopEvent;
+  std::thread m_thread;
+};
+
+class CHandoffImage
+{
+public:
+  bool Copy(DVDVideoPicture &picture)
+  {
+    if (picture.format != RENDER_FMT_YUV420P &&
+        picture.format != RENDER_FMT_YUV420P10 &&
+        picture.format != RENDER_FMT_YUV420P16 &&
+        picture.format != RENDER_FMT_NV12)
+      return false;
+
+    Configure(picture);
+    if (picture.format == RENDER_FMT_NV12)
+      return CDVDCodecUtils::CopyNV12Picture(&m_image, &picture);
+    return CDVDCodecUtils::CopyPicture(&m_image, &picture);
+  }
+
+private:
+  void Configure(const DVDVideoPicture &picture)
+  {
+    unsigned bpp = (picture.format == RENDER_FMT_YUV420P10 ||
+                    picture.format == RENDER_FMT_YUV420P16) ? 2 : 1;
+    if (m_image.width == picture.iWidth && m_image.height == picture.iHeight && m_image.bpp == bpp)
+      return;
+
+    // same layout CLinuxRendererGL uses for its yuv buffers
+    m_image.width = picture.iWidth;
+    m_image.height = picture.iHeight;
+    m_image.cshift_x = 1;
+    m_image.cshift_y = 1;
+    m_image.bpp = bpp;
+    m_image.stride[0] = bpp * m_image.width;
+    m_image.stride[1] = bpp * (m_image.width >> m_image.cshift_x);
+    m_image.stride[2] = bpp * (m_image.width >> m_image.cshift_x);
+    if (picture.format == RENDER_FMT_NV12)
+      m_image.stride[1] = m_image.stride[0];
+    for (int p = 0; p < MAX_PLANES; p++)
+    {
+      unsigned height = p == 0 ? m_image.height : (m_image.height >> m_image.cshift_y);
+      m_image.planesize[p] = m_image.stride[p] * height;
+      m_planes[p].resize(m_image.planesize[p]);
+      m_image.plane[p] = m_planes[p].data();
+    }
+  }
+
+  YV12Image m_image = {};
+  std::vector<uint8_t> m_planes[MAX_PLANES];
+};
+
+CVariant RunBenchmark(const std::string &path)
+{
+  CVariant result(CVariant::VariantTypeObject);
+  result["file"] = path;
+  result["opened"] = false;
+
+  CFileItem item(path, false);
+  std::unique_ptr<CDVDInputStream> input(CDVDFactoryInputStream::CreateInputStream(nullptr, item));
+  if (!input || !input->Open())
+    return result;
+
+  std::unique_ptr<CDVDDemux> demuxer(CDVDFactoryDemuxer::CreateDemuxer(input.get(), true));
+  if (!demuxer)
+    return result;
+
+  std::unique_ptr<CProcessInfo> processInfo(CProcessInfo::CreateInstance());
+  std::unique_ptr<CDVDVideoCodec> videoCodec;
+  std::unique_ptr<CDVDAudioCodec> audioCodec;
+  int videoStream = -1;
+  int audioStream = -1;
+
+  for (CDemuxStream* stream : demuxer->GetStreams())
+  {
+    if (!stream)
+      continue;
+
+    if (stream->type == STREAM_VIDEO && videoStream < 0 && !(stream->flags & AV_DISPOSITION_ATTACHED_PIC))
+    {
+      CDVDStreamInfo hint(*stream, true);
+      hint.software = true;
+      videoCodec.reset(CDVDFactoryCodec::CreateVideoCodec(hint, *processInfo));
+      if (videoCodec)
+      {
+        videoStream = stream->uniqueId;
+        continue;
+      }
+    }
+    else if (stream->type == STREAM_AUDIO && audioStream < 0)
+    {
+      CDVDStreamInfo hint(*stream, true);
+      audioCodec.reset(CDVDFactoryCodec::CreateAudioCodec(hint, *processInfo, false, true));
+      if (audioCodec)
+      {
+        audioStream = stream->uniqueId;
+        continue;
+      }
+    }
+    demuxer->EnableStream(stream->demuxerId, stream->uniqueId, false);
+  }
+
+  result["opened"] = true;
+  result["video_codec"] = videoCodec ? videoCodec->GetName() : "";
+  result["audio_codec"] = audioCodec ? audioCodec->GetName() : "";
+
+  CHandoffImage handoff;
+  CStageStats demuxStats, videoDecodeStats, audioDecodeStats, copyStats;
+  uint64_t frames = 0, dropped = 0, errors = 0, audioFrames = 0, packets = 0;
+  CMemorySampler memory;
+  int64_t start = CurrentHostCounter();
+
+  // every Decode() and GetPicture() call counts as decode time, whether it
+  // delivers a picture or only buffers the packet
+  auto decodeVideo = [&](uint8_t *data, int size, double dts, double pts)
+  {
+    int64_t decodeStart = CurrentHostCounter();
+    int state = videoCodec->Decode(data, size, dts, pts);
+    while (true)
+    {
+      if (state & VC_ERROR)
+      {
+        videoDecodeStats.Add(CurrentHostCounter() - decodeStart);
+        errors++;
+        return;
+      }
+      if (state & VC_PICTURE)
+      {
+        DVDVideoPicture picture;
+        videoCodec->ClearPicture(&picture);
+        bool gotPicture = videoCodec->GetPicture(&picture);
+        videoDecodeStats.Add(CurrentHostCounter() - decodeStart);
+        if (gotPicture && !(picture.iFlags & DVP_FLAG_DROPPED))
+        {
+          int64_t copyStart = CurrentHostCounter();
+          if (handoff.Copy(picture))
+            copyStats.Add(CurrentHostCounter() - copyStart);
+          frames++;
+        }
+        else
+          dropped++;
+      }
+      else
+      {
+        videoDecodeStats.Add(CurrentHostCounter() - decodeStart);
+        if (state & VC_DROPPED)
+          dropped++;
+      }
+
+      if (state & VC_BUFFER || !(state & VC_PICTURE))
+        return;
+      decodeStart = CurrentHostCounter();
+      state = videoCodec->Decode(nullptr, 0, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
+    }
+  };
+
+  while (true)
+  {
+    int64_t stageStart = CurrentHostCounter();
+    DemuxPacket* packet = demuxer->Read();
+    demuxStats.Add(CurrentHostCounter() - stageStart);
+    if (!packet)
+      break;
+    packets++;
+
+    if (videoCodec && packet->iStreamId == videoStream)
+      decodeVideo(packet->pData, packet->iSize, packet->dts, packet->pts);
+    else if (audioCodec && packet->iStreamId == audioStream)
+    {
+      stageStart = CurrentHostCounter();
+      int consumed = audioCodec->Decode(packet->pData, packet->iSize, packet->dts, packet->pts);
+      DVDAudioFrame audioframe;
+      while (consumed >= 0)
+      {
+        audioCodec->GetData(audioframe);
+        if (audioframe.nb_frames == 0)
+        {
+          if (consumed >= packet->iSize)
+            break;
+          int ret = audioCodec->Decode(packet->pData + consumed, packet->iSize - consumed, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
+          if (ret < 0)
+          {
+            consumed = ret;
+            break;
+          }
+          consumed += ret;
+          continue;
+        }
+        audioFrames += audioframe.nb_frames;
+      }
+      if (consumed < 0)
+      {
+        errors++;
+        audioCodec->Reset();
+      }
+      audioDecodeStats.Add(CurrentHostCounter() - stageStart);
+    }
+    CDVDDemuxUtils::FreeDemuxPacket(packet);
+  }
+
+  // squeeze out the pictures the decoder still holds at the end of the
+  // stream, like CVideoPlayerVideo does on VIDEO_DRAIN
+  if (videoCodec)
+  {
+    videoCodec->SetCodecControl(DVD_CODEC_CTRL_DRAIN);
+    decodeVideo(nullptr, 0, DVD_NOPTS_VALUE, DVD_NOPTS_VALUE);
+  }
+
+  double seconds = CStageStats::ToMicroSeconds(CurrentHostCounter() - start) / 1000000.0;
+  int64_t memoryKB = memory.Stop();
+  double decodeSeconds = CStageStats::ToMicroSeconds(videoDecodeStats.Total()) / 1000000.0;
+
+  result["packets"] = packets;
+  result["frames"] = frames;
+  result["dropped_frames"] = dropped;
+  result["errors"] = errors;
+  result["audio_samples"] = audioFrames;
+  result["wall_seconds"] = seconds;
+  result["fps"] = seconds > 0 ? frames / seconds : 0.0;
+  result["decode_fps"] = decodeSeconds > 0 ? frames / decodeSeconds : 0.0;
+  result["peak_memory_kb"] = memoryKB;
+  result["stages"]["demux"] = demuxStats.ToVariant();
+  result["stages"]["video_decode"] = videoDecodeStats.ToVariant();
+  result["stages"]["audio_decode"] = audioDecodeStats.ToVariant();
+  result["stages"]["picture_copy"] = copyStats.ToVariant();
+  return result;
+}
+
+CVariant RunThumbBenchmark(const std::vector<std::string> &files, bool batch)
+{
+  std::vector<DVDThumbRequest> requests(files.size());
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    requests[i].path = files[i];
+    requests[i].positions.push_back(-1);
+    requests[i].details.resize(1);
+    requests[i].details[0].file = StringUtils::Format("thumbextract-benchmark/%s-%u.jpg", batch ? "batch" : "single", (unsigned int)i);
+  }
+
+  unsigned int extracted = 0;
+  CMemorySampler memory;
+  int64_t start = CurrentHostCounter();
+  if (batch)
+    extracted = CDVDFileInfo::ExtractThumbBatch(requests);
+  else
+  {
+    // one file after the other with a new decoder each, like a CThumbExtractor job per file
+    for (DVDThumbRequest &request : requests)
+    {
+      if (CDVDFileInfo::ExtractThumb(request.path, request.details[0], nullptr))
+        extracted++;
+    }
+  }
+  double seconds = CStageStats::ToMicroSeconds(CurrentHostCounter() - start) / 1000000.0;
+  int64_t memoryKB = memory.Stop();
+
+  for (const DVDThumbRequest &request : requests)
+    XFILE::CFile::Delete(CTextureCache::GetCachedPath(request.details[0].file));
+
+  CVariant result(CVariant::VariantTypeObject);
+  result["mode"] = batch ? "batch" : "single";
+  result["files"] = (uint64_t)files.size();
+  result["extracted"] = extracted;
+  result["wall_seconds"] = seconds;
+  result["files_per_second"] = seconds > 0 ? files.size() / seconds : 0.0;
+  result["peak_memory_kb"] = memoryKB;
+  return result;
+}
+
+void WriteResults(const CVariant &results, const std::string &output)
+{
+  std::string json = CJSONVariantWriter::Write(results, false);
+  if (output.empty())
+    std::cout << json << std::endl;
+  else
+  {
+    std::ofstream stream(output.c_str());
+    stream << json << std::endl;
+    EXPECT_TRUE(stream.good()) << "unable to write " << output;
+  }
+}
+
+}
+
+TEST(TestVideoPlayerBenchmark, Throughput)
+{
+  const std::vector<std::string> &files = CXBMCTestUtils::Instance().getVideoPlayerBenchmarkFiles();
+  if (files.empty())
+    return;
+
+  CVariant results(CVariant::VariantTypeArray);
+  for (const std::string &file : files)
+  {
+    CVariant result = RunBenchmark(file);
+    EXPECT_TRUE(result["opened"].asBoolean()) << "unable to open " << file;
+    results.push_back(result);
+  }
+
+  WriteResults(results, CXBMCTestUtils::Instance().getVideoPlayerBenchmarkOutput());
+}
+
+TEST(TestVideoPlayerBenchmark, ThumbExtraction)
+{
+  const std::vector<std::string> &files = CXBMCTestUtils::Instance().getThumbExtractBenchmarkFiles();
+  if (files.empty())
+    return;
+
+  CVariant results(CVariant::VariantTypeArray);
+  results.push_back(RunThumbBenchmark(files, false));
+  results.push_back(RunThumbBenchmark(files, true));
+  EXPECT_EQ(results[0]["extracted"].asUnsignedInteger(), results[1]["extracted"].asUnsignedInteger());
+
+  WriteResults(results, CXBMCTestUtils::Instance().getThumbExtractBenchmarkOutput());
+}
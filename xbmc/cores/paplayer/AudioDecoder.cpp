@@ -42,7 +42,9 @@ CAudioDecoder::CAudioDecoder()
   memset(&m_pcmInputBuffer, 0, INPUT_SIZE * sizeof(BYTE));
   memset(&m_inputBuffer, 0, INPUT_SAMPLES * sizeof(float));
 
+  m_rawBuffer = NULL;
   m_rawBufferSize = 0;
+  m_decodedSize = 0;
 }
 
 CAudioDecoder::~CAudioDecoder()
@@ -56,6 +58,8 @@ void CAudioDecoder::Destroy()
   m_status = STATUS_NO_FILE;
 
   m_pcmBuffer.Destroy();
+  m_bufferReservation.reset();
+  m_decodedSize = 0;
 
   if ( m_codec )
     delete m_codec;
@@ -138,6 +142,66 @@ bool CAudioDecoder::Create(const CFileItem &file, int64_t seekOffset)
   return true;
 }
 
+bool CAudioDecoder::Adopt(CAudioDecoder &decoder)
+{
+  Destroy();
+
+  CSingleLock lock(m_critSection);
+  CSingleLock decoderLock(decoder.m_critSection);
+  if (!decoder.m_codec)
+    return false;
+
+  unsigned int size = decoder.m_pcmBuffer.getMaxReadSize();
+  if (!m_pcmBuffer.Create(decoder.m_pcmBuffer.getSize()) ||
+      (size && !decoder.m_pcmBuffer.ReadData(m_pcmBuffer, size)))
+  {
+    m_pcmBuffer.Destroy();
+    return false;
+  }
+
+  m_codec = decoder.m_codec;
+  decoder.m_codec = NULL;
+  m_rawBuffer = decoder.m_rawBuffer;
+  m_rawBufferSize = decoder.m_rawBufferSize;
+  m_eof = decoder.m_eof;
+  m_status = decoder.m_status;
+  m_canPlay = false;
+  m_decodedSize = decoder.m_decodedSize;
+  m_bufferReservation = decoder.m_bufferReservation;
+
+  decoder.Destroy();
+  return true;
+}
+
+void CAudioDecoder::SetBufferReservation(const std::shared_ptr<void> &reservation)
+{
+  CSingleLock lock(m_critSection);
+  m_bufferReservation = reservation;
+}
+
+bool CAudioDecoder::SetBufferSize(unsigned int size)
+{
+  CSingleLock lock(m_critSection);
+  if (!m_codec || m_pcmBuffer.getMaxReadSize() > 0)
+    return false;
+
+  unsigned int oldSize = m_pcmBuffer.getSize();
+  m_pcmBuffer.Destroy();
+  if (!m_pcmBuffer.Create(size))
+  {
+    m_pcmBuffer.Create(oldSize);
+    return false;
+  }
+  return true;
+}
+
+unsigned int CAudioDecoder::GetBytesPerSecond()
+{
+  if (!m_codec)
+    return 0;
+  return (m_codec->m_bitsPerSample >> 3) * m_codec->m_format.m_channelLayout.Count() * m_codec->m_format.m_sampleRate;
+}
+
 AEAudioFormat CAudioDecoder::GetFormat()
 {
   AEAudioFormat format;
@@ -258,6 +322,7 @@ int CAudioDecoder::ReadSamples(int numsamples)
       {
         // move it into our buffer
         m_pcmBuffer.WriteData((char *)m_pcmInputBuffer, readSize);
+        m_decodedSize += readSize;
 
         // update status
         if (m_status == STATUS_QUEUING && m_pcmBuffer.getMaxReadSize() > m_pcmBuffer.getSize() * 0.9)
@@ -20,6 +20,8 @@
  *
  */
 
+#include <memory>
+
 #include "ICodec.h"
 #include "threads/CriticalSection.h"
 #include "utils/RingBuffer.h"
@@ -58,6 +60,22 @@ public:
   bool Create(const CFileItem &file, int64_t seekOffset);
   void Destroy();
 
+  /*! \brief Take over the codec and the decoded data of another decoder, leaving it without a file. */
+  bool Adopt(CAudioDecoder &decoder);
+  /*! \brief Replace the pcm buffer, only valid before anything was decoded. */
+  bool SetBufferSize(unsigned int size);
+  unsigned int GetBufferSize() { return m_pcmBuffer.getSize(); }
+  unsigned int GetBufferedSize() { return m_pcmBuffer.getMaxReadSize(); }
+  /*! \brief Bytes the codec delivered since the file was opened, including those of an adopted decoder. */
+  uint64_t GetDecodedSize() { return m_decodedSize; }
+
+  /*! \brief Keep a reservation alive as long as the pcm buffer.
+   It is passed on by Adopt() and dropped by Destroy(), so memory handed out
+   for an enlarged buffer is accounted for until the stream is closed.
+   */
+  void SetBufferReservation(const std::shared_ptr<void> &reservation);
+  unsigned int GetBytesPerSecond();
+
   int ReadSamples(int numsamples);
 
   bool CanSeek() { if (m_codec) return m_codec->CanSeek(); else return false; };
@@ -91,6 +109,9 @@ private:
   uint8_t *m_rawBuffer;
   int m_rawBufferSize;
 
+  uint64_t m_decodedSize;
+  std::shared_ptr<void> m_bufferReservation;
+
   // status
   bool m_eof;
   int m_status;
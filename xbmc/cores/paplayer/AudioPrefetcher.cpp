@@ -0,0 +1,235 @@
+/*
+ *      Copyright (C) 2005-2016 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "AudioPrefetcher.h"
+#include "AudioDecoder.h"
+#include "URL.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/Event.h"
+#include "threads/SingleLock.h"
+#include "threads/Thread.h"
+#include "utils/JobManager.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <atomic>
+
+/* Bytes taken from the pool, given back when the decoder holding it closes. */
+class CAudioPrefetcher::CReservation
+{
+public:
+  explicit CReservation(unsigned int size) : m_size(size) {}
+  ~CReservation() { CAudioPrefetcher::Release(m_size); }
+
+private:
+  unsigned int m_size;
+};
+
+struct CAudioPrefetcher::CEntry
+{
+  CEntry(const CFileItem &file) : item(file), running(false), aborted(false), done(true) {}
+
+  CFileItem item;
+  CAudioDecoder decoder;
+  CCriticalSection section;
+  bool running;                 /* if the job has started */
+  std::atomic<bool> aborted;    /* if the job should stop decoding */
+  CEvent done;
+};
+
+class CAudioPrefetchJob : public CJob
+{
+  CAudioPrefetcher::EntryPtr m_entry;
+
+public:
+                CAudioPrefetchJob(const CAudioPrefetcher::EntryPtr &entry)
+                  : m_entry(entry) {}
+  virtual       ~CAudioPrefetchJob() {}
+  virtual bool  DoWork()
+  {
+    CAudioPrefetcher::Fill(m_entry);
+    return true;
+  }
+};
+
+CCriticalSection CAudioPrefetcher::m_poolSection;
+unsigned int CAudioPrefetcher::m_poolUsed = 0;
+
+CAudioPrefetcher::CAudioPrefetcher() :
+  m_jobQueue(false, 1, CJob::PRIORITY_NORMAL)
+{
+}
+
+CAudioPrefetcher::~CAudioPrefetcher()
+{
+  Clear();
+}
+
+void CAudioPrefetcher::SetUpcoming(const std::vector<CFileItemPtr> &items)
+{
+  CSingleLock lock(m_section);
+
+  std::vector<EntryPtr> entries;
+  for (const CFileItemPtr &item : items)
+  {
+    auto it = std::find_if(m_entries.begin(), m_entries.end(),
+                           [&item](const EntryPtr &entry) { return IsSameTrack(entry->item, *item); });
+    if (it != m_entries.end())
+    {
+      entries.push_back(*it);
+      m_entries.erase(it);
+      continue;
+    }
+
+    EntryPtr entry(new CEntry(*item));
+    entries.push_back(entry);
+    m_jobQueue.AddJob(new CAudioPrefetchJob(entry));
+  }
+
+  for (const EntryPtr &entry : m_entries)
+    Abort(entry, false);
+  m_entries.swap(entries);
+}
+
+bool CAudioPrefetcher::Take(const CFileItem &file, CAudioDecoder &decoder)
+{
+  EntryPtr entry;
+  {
+    CSingleLock lock(m_section);
+    auto it = std::find_if(m_entries.begin(), m_entries.end(),
+                           [&file](const EntryPtr &entry) { return IsSameTrack(entry->item, file); });
+    if (it == m_entries.end())
+      return false;
+    entry = *it;
+    m_entries.erase(it);
+  }
+
+  Abort(entry, true);
+  if (!decoder.Adopt(entry->decoder))
+    return false;
+
+  CLog::Log(LOGDEBUG, "CAudioPrefetcher::Take - using %u prefetched bytes of %s",
+            decoder.GetBufferedSize(), CURL::GetRedacted(file.GetPath()).c_str());
+  return true;
+}
+
+bool CAudioPrefetcher::IsReady(const CFileItem &file)
+{
+  CSingleLock lock(m_section);
+  auto it = std::find_if(m_entries.begin(), m_entries.end(),
+                         [&file](const EntryPtr &entry) { return IsSameTrack(entry->item, file); });
+  return it != m_entries.end() && (*it)->done.WaitMSec(0);
+}
+
+void CAudioPrefetcher::Clear()
+{
+  CSingleLock lock(m_section);
+  for (const EntryPtr &entry : m_entries)
+    Abort(entry, false);
+  m_entries.clear();
+}
+
+unsigned int CAudioPrefetcher::GetPoolUsed()
+{
+  CSingleLock lock(m_poolSection);
+  return m_poolUsed;
+}
+
+void CAudioPrefetcher::Fill(const EntryPtr &entry)
+{
+  {
+    CSingleLock lock(entry->section);
+    if (entry->aborted)
+      return;
+    entry->running = true;
+  }
+
+  CAudioDecoder &decoder = entry->decoder;
+  if (!decoder.Create(entry->item, (entry->item.m_lStartOffset * 1000) / 75))
+  {
+    entry->done.Set();
+    return;
+  }
+
+  // passthrough streams are only opened, their packets are not buffered
+  if (decoder.GetFormat().m_dataFormat != AE_FMT_RAW)
+  {
+    unsigned int bytesPerSecond = decoder.GetBytesPerSecond();
+    unsigned int seconds = Reserve(bytesPerSecond, g_advancedSettings.m_audioPrefetchSeconds);
+    unsigned int reserved = seconds * bytesPerSecond;
+    if (reserved > decoder.GetBufferSize())
+      decoder.SetBufferSize(reserved);
+
+    // the decoder keeps the reservation, also after the player adopted it
+    decoder.SetBufferReservation(std::make_shared<CReservation>(reserved));
+
+    while (!entry->aborted && decoder.GetStatus() == STATUS_QUEUING)
+    {
+      int ret = decoder.ReadSamples(PACKET_SIZE);
+      if (ret == RET_ERROR)
+      {
+        CLog::Log(LOGDEBUG, "CAudioPrefetcher::Fill - error decoding %s", CURL::GetRedacted(entry->item.GetPath()).c_str());
+        decoder.Destroy();
+        break;
+      }
+      if (ret == RET_SLEEP)
+        XbmcThreads::ThreadSleep(1);
+    }
+  }
+
+  entry->done.Set();
+}
+
+void CAudioPrefetcher::Abort(const EntryPtr &entry, bool wait)
+{
+  bool running;
+  {
+    CSingleLock lock(entry->section);
+    entry->aborted = true;
+    running = entry->running;
+  }
+
+  if (running && wait)
+    entry->done.Wait();
+}
+
+unsigned int CAudioPrefetcher::Reserve(unsigned int bytesPerSecond, unsigned int seconds)
+{
+  if (bytesPerSecond == 0)
+    return 0;
+
+  CSingleLock lock(m_poolSection);
+  uint64_t limit = (uint64_t)g_advancedSettings.m_audioPrefetchMemory * 1024 * 1024;
+  uint64_t available = limit > m_poolUsed ? limit - m_poolUsed : 0;
+  seconds = (unsigned int)std::min<uint64_t>(seconds, available / bytesPerSecond);
+  m_poolUsed += seconds * bytesPerSecond;
+  return seconds;
+}
+
+void CAudioPrefetcher::Release(unsigned int size)
+{
+  CSingleLock lock(m_poolSection);
+  m_poolUsed -= std::min(size, m_poolUsed);
+}
+
+bool CAudioPrefetcher::IsSameTrack(const CFileItem &a, const CFileItem &b)
+{
+  return a.GetPath() == b.GetPath() && a.m_lStartOffset == b.m_lStartOffset;
+}
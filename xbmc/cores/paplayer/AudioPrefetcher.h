@@ -0,0 +1,94 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2016 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <memory>
+#include <vector>
+
+#include "FileItem.h"
+#include "threads/CriticalSection.h"
+#include "utils/JobManager.h"
+
+class CAudioDecoder;
+
+/*!
+ \brief Opens and pre-decodes upcoming tracks in background jobs.
+
+ Every prefetched track gets a decoder that is filled with its first seconds
+ of audio, so the player can start it without waiting for the source. The
+ buffers of all prefetchers come from one pool, whose size is bounded by
+ <prefetchmemory> in advancedsettings.xml.
+ */
+class CAudioPrefetcher
+{
+  friend class CAudioPrefetchJob;
+public:
+  CAudioPrefetcher();
+  ~CAudioPrefetcher();
+
+  /*!
+   \brief Set the tracks to prefetch, in playback order.
+   Tracks that are not in the list any more are dropped.
+   */
+  void SetUpcoming(const std::vector<CFileItemPtr> &items);
+
+  /*!
+   \brief Hand the decoder of a prefetched track over to the player.
+   A job still decoding the track is stopped, the data it has is kept.
+   \return false if the track has not been prefetched
+   */
+  bool Take(const CFileItem &file, CAudioDecoder &decoder);
+
+  /*!
+   \brief Whether a track has been opened and pre-decoded.
+   */
+  bool IsReady(const CFileItem &file);
+
+  /*!
+   \brief Drop all tracks and stop their jobs.
+   */
+  void Clear();
+
+  /*!
+   \brief Bytes of the pool currently handed out.
+   The buffer of a decoder that was taken over by the player is counted until
+   that decoder closes its stream.
+   */
+  static unsigned int GetPoolUsed();
+
+private:
+  struct CEntry;
+  typedef std::shared_ptr<CEntry> EntryPtr;
+  class CReservation;
+
+  static void Fill(const EntryPtr &entry);
+  static void Abort(const EntryPtr &entry, bool wait);
+  static unsigned int Reserve(unsigned int bytesPerSecond, unsigned int seconds);
+  static void Release(unsigned int size);
+  static bool IsSameTrack(const CFileItem &a, const CFileItem &b);
+
+  CCriticalSection m_section;
+  std::vector<EntryPtr> m_entries;
+  CJobQueue m_jobQueue;
+
+  static CCriticalSection m_poolSection;
+  static unsigned int m_poolUsed;
+};
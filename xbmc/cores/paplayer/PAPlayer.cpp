@@ -21,7 +21,9 @@
 #include "PAPlayer.h"
 #include "CodecFactory.h"
 #include "FileItem.h"
+#include "PlayListPlayer.h"
 #include "ServiceBroker.h"
+#include "playlists/PlayList.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "music/tags/MusicInfoTag.h"
@@ -343,7 +345,8 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */, b
   }
 
   StreamInfo *si = new StreamInfo();
-  if (!si->m_decoder.Create(file, (file.m_lStartOffset * 1000) / 75))
+  if (!m_prefetcher.Take(file, si->m_decoder) &&
+      !si->m_decoder.Create(file, (file.m_lStartOffset * 1000) / 75))
   {
     CLog::Log(LOGWARNING, "PAPlayer::QueueNextFileEx - Failed to create the decoder");
 
@@ -445,10 +448,48 @@ bool PAPlayer::QueueNextFileEx(const CFileItem &file, bool fadeIn/* = true */, b
   UpdateStreamInfoPlayNextAtFrame(m_currentStream, m_upcomingCrossfadeMS);
 
   *m_FileItem = file;
+  lock.Leave();
+
+  PrefetchUpcoming(file);
 
   return true;
 }
 
+void PAPlayer::PrefetchUpcoming(const CFileItem &file)
+{
+  std::vector<CFileItemPtr> items;
+  if (g_advancedSettings.m_audioPrefetchTracks > 0 && g_advancedSettings.m_audioPrefetchMemory > 0)
+  {
+    // the queued file is either the current song of the playlist or the next one
+    const PLAYLIST::CPlayListPlayer &playlistPlayer = g_playlistPlayer;
+    const PLAYLIST::CPlayList &playlist = playlistPlayer.GetPlaylist(playlistPlayer.GetCurrentPlaylist());
+    bool found = false;
+    for (int offset = 0; offset <= g_advancedSettings.m_audioPrefetchTracks + 1; offset++)
+    {
+      int song = playlistPlayer.GetNextSong(offset);
+      if (song < 0 || song >= playlist.size())
+        break;
+
+      CFileItemPtr item = playlist[song];
+      if (!found)
+      {
+        found = item->GetPath() == file.GetPath();
+        continue;
+      }
+
+      // cd drives and streams are not read ahead, cue sheet tracks continue the stream
+      if (item->GetPath() == file.GetPath() || item->IsCDDA() || item->IsInternetStream() ||
+          item->IsVideo() || item->m_lStartOffset)
+        break;
+
+      items.push_back(item);
+      if ((int)items.size() == g_advancedSettings.m_audioPrefetchTracks)
+        break;
+    }
+  }
+  m_prefetcher.SetUpcoming(items);
+}
+
 void PAPlayer::UpdateStreamInfoPlayNextAtFrame(StreamInfo *si, unsigned int crossFadingTime)
 {
   // if no crossfading or cue sheet, wait for eof
@@ -526,6 +567,7 @@ bool PAPlayer::CloseFile(bool reopen)
   if (!m_isPaused)
     SoftStop(true, true);
   CloseAllStreams(false);
+  m_prefetcher.Clear();
 
   /* wait for the thread to terminate */
   StopThread(true);//true - wait for end of thread
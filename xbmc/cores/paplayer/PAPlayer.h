@@ -27,6 +27,7 @@
 #include "cores/IPlayer.h"
 #include "threads/Thread.h"
 #include "AudioDecoder.h"
+#include "AudioPrefetcher.h"
 #include "threads/CriticalSection.h"
 #include "utils/Job.h"
 
@@ -146,8 +147,10 @@ private:
   bool                m_continueStream;
   int64_t             m_newForcedPlayerTime;
   int64_t             m_newForcedTotalTime;
+  CAudioPrefetcher    m_prefetcher;          /* opens and pre-decodes the upcoming tracks */
 
   bool QueueNextFileEx(const CFileItem &file, bool fadeIn = true, bool job = false);
+  void PrefetchUpcoming(const CFileItem &file);
   void SoftStart(bool wait = false);
   void SoftStop(bool wait = false, bool close = true);
   void CloseAllStreams(bool fade = true);
@@ -0,0 +1,237 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "cores/paplayer/AudioDecoder.h"
+#include "cores/paplayer/AudioPrefetcher.h"
+#include "filesystem/File.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestUtils.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+
+#include <memory>
+#include <string.h>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#define SAMPLE_RATE 44100
+#define CHANNELS    2
+
+namespace
+{
+
+void PutLE(std::vector<uint8_t> &data, uint32_t value, int bytes)
+{
+  for (int i = 0; i < bytes; i++)
+    data.push_back((value >> (8 * i)) & 0xff);
+}
+
+/* 16 bit stereo wav file with a different value in every frame, so lost or
+ * repeated audio shows up in the decoded data. */
+bool WriteWav(XFILE::CFile *file, int seconds)
+{
+  uint32_t frames = seconds * SAMPLE_RATE;
+  uint32_t dataSize = frames * CHANNELS * 2;
+
+  std::vector<uint8_t> data;
+  data.insert(data.end(), { 'R', 'I', 'F', 'F' });
+  PutLE(data, 36 + dataSize, 4);
+  data.insert(data.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' });
+  PutLE(data, 16, 4);
+  PutLE(data, 1, 2);
+  PutLE(data, CHANNELS, 2);
+  PutLE(data, SAMPLE_RATE, 4);
+  PutLE(data, SAMPLE_RATE * CHANNELS * 2, 4);
+  PutLE(data, CHANNELS * 2, 2);
+  PutLE(data, 16, 2);
+  data.insert(data.end(), { 'd', 'a', 't', 'a' });
+  PutLE(data, dataSize, 4);
+
+  for (uint32_t i = 0; i < frames; i++)
+  {
+    PutLE(data, i & 0xffff, 2);
+    PutLE(data, (i >> 16) & 0xffff, 2);
+  }
+
+  bool ret = file->Write(data.data(), data.size()) == static_cast<ssize_t>(data.size());
+  file->Close();
+  return ret;
+}
+
+/* Read all data that is buffered in the decoder, without decoding more. */
+void Drain(CAudioDecoder &decoder, std::vector<uint8_t> &out)
+{
+  unsigned int bytesPerSample = decoder.GetCodec()->m_bitsPerSample >> 3;
+  unsigned int samples;
+  while ((samples = decoder.GetDataSize()) > 0)
+  {
+    uint8_t *data = static_cast<uint8_t*>(decoder.GetData(samples));
+    ASSERT_TRUE(data != NULL);
+    out.insert(out.end(), data, data + samples * bytesPerSample);
+    if (decoder.GetStatus() == STATUS_ENDED)
+      break;
+  }
+}
+
+/* Decode a file to the end. */
+void DecodeAll(CAudioDecoder &decoder, std::vector<uint8_t> &out)
+{
+  decoder.Start();
+  while (decoder.GetStatus() != STATUS_ENDED && decoder.GetStatus() != STATUS_NO_FILE)
+  {
+    int ret = decoder.ReadSamples(PACKET_SIZE);
+    ASSERT_NE(RET_ERROR, ret);
+    Drain(decoder, out);
+  }
+}
+
+bool WaitReady(CAudioPrefetcher &prefetcher, const CFileItem &item)
+{
+  XbmcThreads::EndTime timeout(10000);
+  while (!prefetcher.IsReady(item))
+  {
+    if (timeout.IsTimePast())
+      return false;
+    XbmcThreads::ThreadSleep(10);
+  }
+  return true;
+}
+
+class TestAudioPrefetcher : public testing::Test
+{
+protected:
+  TestAudioPrefetcher()
+  {
+    m_seconds = g_advancedSettings.m_audioPrefetchSeconds;
+    m_memory = g_advancedSettings.m_audioPrefetchMemory;
+  }
+
+  ~TestAudioPrefetcher()
+  {
+    g_advancedSettings.m_audioPrefetchSeconds = m_seconds;
+    g_advancedSettings.m_audioPrefetchMemory = m_memory;
+    for (XFILE::CFile *file : m_files)
+      XBMC_DELETETEMPFILE(file);
+  }
+
+  CFileItemPtr CreateTrack(int seconds)
+  {
+    XFILE::CFile *file = XBMC_CREATETEMPFILE(".wav");
+    if (!file)
+      return CFileItemPtr();
+    m_files.push_back(file);
+    if (!WriteWav(file, seconds))
+      return CFileItemPtr();
+    return CFileItemPtr(new CFileItem(XBMC_TEMPFILEPATH(file), false));
+  }
+
+  std::vector<XFILE::CFile*> m_files;
+  int m_seconds;
+  int m_memory;
+};
+
+}
+
+/* The start of a prefetched track has to be playable without touching its
+ * source, so a slow source can't cause a gap at the track boundary, and the
+ * track has to continue from the source without losing or repeating audio. */
+TEST_F(TestAudioPrefetcher, GaplessHandOver)
+{
+  g_advancedSettings.m_audioPrefetchSeconds = 2;
+  g_advancedSettings.m_audioPrefetchMemory = 32;
+
+  CFileItemPtr track = CreateTrack(6);
+  ASSERT_TRUE(track.get() != NULL);
+
+  std::vector<uint8_t> expected;
+  CAudioDecoder reference;
+  ASSERT_TRUE(reference.Create(*track, 0));
+  unsigned int bytesPerSecond = reference.GetBytesPerSecond();
+  DecodeAll(reference, expected);
+  ASSERT_GT(expected.size(), 5u * bytesPerSecond);
+
+  CAudioPrefetcher prefetcher;
+  prefetcher.SetUpcoming({ track });
+  ASSERT_TRUE(WaitReady(prefetcher, *track));
+
+  CAudioDecoder decoder;
+  ASSERT_TRUE(prefetcher.Take(*track, decoder));
+  EXPECT_FALSE(prefetcher.Take(*track, decoder));
+
+  // everything read from the source so far is still buffered
+  uint64_t prefetched = decoder.GetDecodedSize();
+  EXPECT_EQ(prefetched, decoder.GetBufferedSize());
+
+  decoder.Start();
+  std::vector<uint8_t> decoded;
+  Drain(decoder, decoded);
+  EXPECT_GE(decoded.size(), 9 * 2 * bytesPerSecond / 10);
+  EXPECT_EQ(prefetched, decoder.GetDecodedSize());
+
+  // the adopted data is not read from the source a second time
+  DecodeAll(decoder, decoded);
+  EXPECT_EQ(expected.size(), decoder.GetDecodedSize());
+  ASSERT_EQ(expected.size(), decoded.size());
+  EXPECT_TRUE(memcmp(expected.data(), decoded.data(), expected.size()) == 0);
+}
+
+TEST_F(TestAudioPrefetcher, BoundedPool)
+{
+  // three seconds of 16 bit stereo are 517 KB, so the second track gets
+  // only part of what it asks for and the third nothing
+  g_advancedSettings.m_audioPrefetchSeconds = 3;
+  g_advancedSettings.m_audioPrefetchMemory = 1;
+
+  std::vector<CFileItemPtr> tracks;
+  for (int i = 0; i < 3; i++)
+  {
+    tracks.push_back(CreateTrack(10));
+    ASSERT_TRUE(tracks.back().get() != NULL);
+  }
+
+  CAudioPrefetcher prefetcher;
+  prefetcher.SetUpcoming(tracks);
+  for (const CFileItemPtr &track : tracks)
+    ASSERT_TRUE(WaitReady(prefetcher, *track));
+
+  EXPECT_GT(CAudioPrefetcher::GetPoolUsed(), 0u);
+  EXPECT_LE(CAudioPrefetcher::GetPoolUsed(), 1024u * 1024u);
+
+  // tracks dropped from the list give their memory back
+  unsigned int used = CAudioPrefetcher::GetPoolUsed();
+  prefetcher.SetUpcoming({ tracks[0] });
+  CAudioDecoder decoder;
+  ASSERT_TRUE(prefetcher.Take(*tracks[0], decoder));
+
+  XbmcThreads::EndTime timeout(1000);
+  while (CAudioPrefetcher::GetPoolUsed() == used && !timeout.IsTimePast())
+    XbmcThreads::ThreadSleep(10);
+
+  // the taken track's buffer is still counted while its stream is open
+  unsigned int taken = CAudioPrefetcher::GetPoolUsed();
+  EXPECT_GT(taken, 0u);
+  EXPECT_LT(taken, used);
+  EXPECT_GE(decoder.GetBufferSize(), taken);
+
+  decoder.Destroy();
+  EXPECT_EQ(0u, CAudioPrefetcher::GetPoolUsed());
+}
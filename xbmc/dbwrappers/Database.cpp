@@ -23,6 +23,11 @@
 #include "filesystem/SpecialProtocol.h"
 #include "filesystem/File.h"
 #include "profiles/ProfilesManager.h"
+#include "threads/CriticalSection.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/Job.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 #include "utils/SortUtils.h"
 #include "utils/StringUtils.h"
@@ -38,9 +43,67 @@
 #include "linux/ConvUtils.h"
 #endif
 
+#include <algorithm>
+#include <map>
+#include <set>
+
 using namespace dbiplus;
 
 #define MAX_COMPRESS_COUNT 20
+#define SEARCH_INDEX_BATCH 500
+
+namespace
+{
+// databases with a search index update waiting for a job worker
+CCriticalSection searchIndexSection;
+std::set<std::string> searchIndexPending;
+
+/* Tokens of the current row of the dataset, which holds the id followed by the
+ * text columns of the source. Each token is kept once with its best weight, the
+ * first word of a column weighs a little more than the others. */
+std::map<std::string, int> GetTokenWeights(const CSearchIndex::Source &source, Dataset *ds)
+{
+  std::map<std::string, int> weights;
+  for (size_t i = 0; i < source.columns.size(); i++)
+  {
+    std::vector<std::string> tokens = CSearchIndex::Tokenize(ds->fv(static_cast<int>(i + 1)).get_asString());
+    for (size_t t = 0; t < tokens.size(); t++)
+    {
+      int &weight = weights[tokens[t]];
+      weight = std::max(weight, source.columns[i].second * 2 + (t == 0 ? 1 : 0));
+    }
+  }
+  return weights;
+}
+}
+
+/* Indexes the queued changes of a database with a connection of its own, so
+ * searches never write to the database they read from. */
+class CSearchIndexJob : public CJob
+{
+public:
+  explicit CSearchIndexJob(CDatabase *database) : m_database(database) {}
+
+  virtual bool DoWork() override
+  {
+    // changes queued from now on need another run
+    {
+      CSingleLock lock(searchIndexSection);
+      searchIndexPending.erase(m_database->GetBaseDBName());
+    }
+
+    if (!m_database->Open())
+      return false;
+    bool result = m_database->UpdateSearchIndex();
+    m_database->Close();
+    return result;
+  }
+
+  virtual const char *GetType() const override { return "searchindex"; }
+
+private:
+  std::unique_ptr<CDatabase> m_database;
+};
 
 void CDatabase::Filter::AppendField(const std::string &strField)
 {
@@ -107,6 +170,12 @@ CDatabase::CDatabase(void)
   m_sqlite = true;
   m_bMultiWrite = false;
   m_multipleExecute = false;
+  m_pooled = false;
+  m_readOnly = false;
+  m_replica = false;
+  m_batch = false;
+  m_savepoints = 0;
+  m_discard = false;
 }
 
 CDatabase::~CDatabase(void)
@@ -323,7 +392,50 @@ bool CDatabase::Open(const DatabaseSettings &settings)
 
   std::string dbName = dbSettings.name;
   dbName += StringUtils::Format("%d", GetSchemaVersion());
-  return Connect(dbName, dbSettings, false);
+
+  CDatabaseConnectionPool &pool = CDatabaseManager::GetInstance().GetConnectionPool();
+  if (m_readOnly && !m_sqlite && !dbSettings.replicahost.empty())
+  {
+    DatabaseSettings replicaSettings = dbSettings;
+    replicaSettings.host = dbSettings.replicahost;
+    replicaSettings.port = dbSettings.replicaport;
+    m_pDB.reset(pool.Acquire(GetBaseDBName(), replicaSettings, dbName));
+    m_replica = NULL != m_pDB.get();
+    if (!m_replica)
+      CLog::Log(LOGWARNING, "Unable to connect to replica %s of database %s, reading from the database itself",
+                dbSettings.replicahost.c_str(), dbName.c_str());
+  }
+  if (NULL == m_pDB.get())
+    m_pDB.reset(pool.Acquire(GetBaseDBName(), dbSettings, dbName));
+  if (NULL == m_pDB.get())
+    return false;
+
+  // create the datasets
+  m_pDS.reset(m_pDB->CreateDataset());
+  m_pDS2.reset(m_pDB->CreateDataset());
+
+  m_pooled = true;
+  m_openCount = 1; // our database is open
+  return true;
+}
+
+bool CDatabase::OpenForReading()
+{
+  bool wasOpen = IsOpen();
+  if (!wasOpen)
+    m_readOnly = true;
+
+  if (Open())
+    return true;
+
+  if (!wasOpen)
+    m_readOnly = false;
+  return false;
+}
+
+CDatabaseConnectionPool::Stats CDatabase::GetConnectionPoolStats() const
+{
+  return CDatabaseManager::GetInstance().GetConnectionPool().GetStats(GetBaseDBName());
 }
 
 void CDatabase::InitSettings(DatabaseSettings &dbSettings)
@@ -426,44 +538,10 @@ bool CDatabase::Update(const DatabaseSettings &settings)
 bool CDatabase::Connect(const std::string &dbName, const DatabaseSettings &dbSettings, bool create)
 {
   // create the appropriate database structure
-  if (dbSettings.type == "sqlite3")
-  {
-    m_pDB.reset( new SqliteDatabase() ) ;
-  }
-#ifdef HAS_MYSQL
-  else if (dbSettings.type == "mysql")
-  {
-    m_pDB.reset( new MysqlDatabase() ) ;
-  }
-#endif
-  else
-  {
-    CLog::Log(LOGERROR, "Unable to determine database type: %s", dbSettings.type.c_str());
+  m_pDB.reset(CDatabaseConnectionPool::CreateConnection(dbSettings, dbName));
+  if (NULL == m_pDB.get())
     return false;
-  }
-
-  // host name is always required
-  m_pDB->setHostName(dbSettings.host.c_str());
-
-  if (!dbSettings.port.empty())
-    m_pDB->setPort(dbSettings.port.c_str());
-
-  if (!dbSettings.user.empty())
-    m_pDB->setLogin(dbSettings.user.c_str());
-
-  if (!dbSettings.pass.empty())
-    m_pDB->setPasswd(dbSettings.pass.c_str());
-
-  // database name is always required
-  m_pDB->setDatabase(dbName.c_str());
-
-  // set configuration regardless if any are empty
-  m_pDB->setConfig(dbSettings.key.c_str(),
-                   dbSettings.cert.c_str(),
-                   dbSettings.ca.c_str(),
-                   dbSettings.capath.c_str(),
-                   dbSettings.ciphers.c_str(),
-                   dbSettings.compression);
+  m_pooled = false;
 
   // create the datasets
   m_pDS.reset(m_pDB->CreateDataset());
@@ -589,9 +667,27 @@ void CDatabase::Close()
 
   m_openCount = 0;
   m_multipleExecute = false;
+  m_readOnly = false;
+  m_replica = false;
+  m_batch = false;
+  m_savepoints = 0;
+  bool discard = m_discard;
+  m_discard = false;
 
   if (NULL == m_pDB.get() ) return ;
   if (NULL != m_pDS.get()) m_pDS->close();
+
+  if (m_pooled)
+  {
+    // a connection with an unfinished transaction is dropped, which rolls it back
+    bool reuse = !m_pDB->in_transaction() && !discard;
+    m_pDS.reset();
+    m_pDS2.reset();
+    CDatabaseManager::GetInstance().GetConnectionPool().Release(m_pDB.release(), reuse);
+    m_pooled = false;
+    return;
+  }
+
   m_pDB->disconnect();
   m_pDB.reset();
   m_pDS.reset();
@@ -644,7 +740,12 @@ void CDatabase::BeginTransaction()
   try
   {
     if (NULL != m_pDB.get())
-      m_pDB->start_transaction();
+    {
+      if (m_batch)
+        ExecuteTransactionStatement(StringUtils::Format("SAVEPOINT sp%u", ++m_savepoints));
+      else
+        m_pDB->start_transaction();
+    }
   }
   catch (...)
   {
@@ -657,7 +758,12 @@ bool CDatabase::CommitTransaction()
   try
   {
     if (NULL != m_pDB.get())
-      m_pDB->commit_transaction();
+    {
+      if (!m_batch)
+        m_pDB->commit_transaction();
+      else if (m_savepoints > 0)
+        ExecuteTransactionStatement(StringUtils::Format("RELEASE SAVEPOINT sp%u", m_savepoints--));
+    }
   }
   catch (...)
   {
@@ -672,7 +778,16 @@ void CDatabase::RollbackTransaction()
   try
   {
     if (NULL != m_pDB.get())
-      m_pDB->rollback_transaction();
+    {
+      if (!m_batch)
+        m_pDB->rollback_transaction();
+      else if (m_savepoints > 0)
+      {
+        unsigned int savepoint = m_savepoints--;
+        ExecuteTransactionStatement(StringUtils::Format("ROLLBACK TO SAVEPOINT sp%u", savepoint));
+        ExecuteTransactionStatement(StringUtils::Format("RELEASE SAVEPOINT sp%u", savepoint));
+      }
+    }
   }
   catch (...)
   {
@@ -680,6 +795,44 @@ void CDatabase::RollbackTransaction()
   }
 }
 
+bool CDatabase::BeginBatch()
+{
+  if (NULL == m_pDB.get() || m_batch)
+    return false;
+
+  BeginTransaction();
+  m_batch = true;
+  m_savepoints = 0;
+  return true;
+}
+
+bool CDatabase::CommitBatch()
+{
+  if (!m_batch)
+    return false;
+
+  m_batch = false;
+  m_savepoints = 0;
+  return CommitTransaction();
+}
+
+void CDatabase::RollbackBatch()
+{
+  if (!m_batch)
+    return;
+
+  m_batch = false;
+  m_savepoints = 0;
+  RollbackTransaction();
+}
+
+void CDatabase::ExecuteTransactionStatement(const std::string &statement)
+{
+  // not run through m_pDS, callers may be iterating over one of its results
+  std::unique_ptr<Dataset> ds(m_pDB->CreateDataset());
+  ds->exec(statement);
+}
+
 bool CDatabase::InTransaction()
 {
   if (NULL != m_pDB.get()) return false;
@@ -748,3 +901,328 @@ bool CDatabase::BuildSQL(const std::string &strBaseDir, const std::string &strQu
 
   return BuildSQL(strQuery, filter, strSQL);
 }
+
+void CDatabase::CreateSearchIndexTables()
+{
+  CLog::Log(LOGINFO, "create search index tables");
+  m_pDS->exec("CREATE TABLE searchindex (token TEXT, media_type TEXT, media_id INTEGER, weight INTEGER)");
+  m_pDS->exec("CREATE TABLE searchqueue (media_type TEXT, media_id INTEGER)");
+}
+
+void CDatabase::CreateSearchIndexAnalytics()
+{
+  m_pDS->exec("CREATE INDEX ix_searchindex_1 ON searchindex (media_type(20), token(200))");
+  m_pDS->exec("CREATE INDEX ix_searchindex_2 ON searchindex (media_type(20), media_id)");
+  m_pDS->exec("CREATE INDEX ix_searchqueue ON searchqueue (media_type(20), media_id)");
+
+  // rows are tokenized when the index is used, the triggers only note what changed
+  for (const CSearchIndex::Source &source : GetSearchSources())
+  {
+    std::string changed;
+    for (const auto &column : source.columns)
+    {
+      if (!changed.empty())
+        changed += " OR ";
+      changed += PrepareSQL("COALESCE(old.%s, '') <> COALESCE(new.%s, '')", column.first.c_str(), column.first.c_str());
+    }
+
+    m_pDS->exec(PrepareSQL("CREATE TRIGGER searchindex_insert_%s AFTER INSERT ON %s FOR EACH ROW BEGIN "
+                           "INSERT INTO searchqueue (media_type, media_id) VALUES ('%s', new.%s); "
+                           "END", source.table.c_str(), source.table.c_str(), source.mediaType.c_str(), source.idColumn.c_str()));
+    m_pDS->exec(PrepareSQL("CREATE TRIGGER searchindex_update_%s AFTER UPDATE ON %s FOR EACH ROW BEGIN "
+                           "INSERT INTO searchqueue (media_type, media_id) SELECT '%s', new.%s FROM %s WHERE %s = new.%s AND (",
+                           source.table.c_str(), source.table.c_str(), source.mediaType.c_str(), source.idColumn.c_str(),
+                           source.table.c_str(), source.idColumn.c_str(), source.idColumn.c_str()) + changed + "); END");
+  }
+}
+
+void CDatabase::QueueSearchIndexRebuild()
+{
+  for (const CSearchIndex::Source &source : GetSearchSources())
+  {
+    m_pDS->exec(PrepareSQL("DELETE FROM searchindex WHERE media_type = '%s'", source.mediaType.c_str()));
+    m_pDS->exec(PrepareSQL("DELETE FROM searchqueue WHERE media_type = '%s'", source.mediaType.c_str()));
+    m_pDS->exec(PrepareSQL("INSERT INTO searchqueue (media_type, media_id) SELECT '%s', %s FROM %s",
+                           source.mediaType.c_str(), source.idColumn.c_str(), source.table.c_str()));
+  }
+}
+
+bool CDatabase::UpdateSearchIndex()
+{
+  std::vector<CSearchIndex::Source> sources = GetSearchSources();
+  if (sources.empty())
+    return true;
+
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    for (const CSearchIndex::Source &source : sources)
+    {
+      std::vector<int> ids;
+      m_pDS->query(PrepareSQL("SELECT DISTINCT media_id FROM searchqueue WHERE media_type = '%s'", source.mediaType.c_str()));
+      while (!m_pDS->eof())
+      {
+        ids.push_back(m_pDS->fv(0).get_asInt());
+        m_pDS->next();
+      }
+      m_pDS->close();
+      if (ids.empty())
+        continue;
+
+      unsigned int time = XbmcThreads::SystemClockMillis();
+      for (size_t start = 0; start < ids.size(); start += SEARCH_INDEX_BATCH)
+      {
+        std::vector<int> batch(ids.begin() + start, ids.begin() + std::min(ids.size(), start + SEARCH_INDEX_BATCH));
+        if (!UpdateSearchIndex(source, batch))
+          return false;
+      }
+      CLog::Log(LOGDEBUG, "%s - indexed %u items of type %s in %u ms", __FUNCTION__,
+                (unsigned int)ids.size(), source.mediaType.c_str(), XbmcThreads::SystemClockMillis() - time);
+    }
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+  }
+  return false;
+}
+
+bool CDatabase::UpdateSearchIndex(const CSearchIndex::Source &source, const std::vector<int> &ids)
+{
+  std::string idList = PrepareSearchCondition(source.idColumn, ids);
+  std::string columns;
+  for (const auto &column : source.columns)
+    columns += ", " + column.first;
+
+  bool transaction = !InTransaction();
+  if (transaction)
+    BeginTransaction();
+
+  try
+  {
+    // remove the queue entries first, so changes made while indexing are queued again
+    std::string mediaIds = PrepareSearchCondition("media_id", ids);
+    m_pDS->exec(PrepareSQL("DELETE FROM searchqueue WHERE media_type = '%s' AND ", source.mediaType.c_str()) + mediaIds);
+    m_pDS->exec(PrepareSQL("DELETE FROM searchindex WHERE media_type = '%s' AND ", source.mediaType.c_str()) + mediaIds);
+
+    std::vector<std::string> inserts;
+    m_pDS->query(PrepareSQL("SELECT %s%s FROM %s WHERE ", source.idColumn.c_str(), columns.c_str(), source.table.c_str()) + idList);
+    while (!m_pDS->eof())
+    {
+      int id = m_pDS->fv(0).get_asInt();
+      for (const auto &token : GetTokenWeights(source, m_pDS.get()))
+        inserts.push_back(PrepareSQL("INSERT INTO searchindex (token, media_type, media_id, weight) VALUES ('%s', '%s', %i, %i)",
+                                     token.first.c_str(), source.mediaType.c_str(), id, token.second));
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    for (const std::string &insert : inserts)
+      QueueInsertQuery(insert);
+    if (!CommitInsertQueries())
+      throw DbErrors("search index insert failed");
+
+    if (transaction)
+      CommitTransaction();
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s - updating the search index of %s failed", __FUNCTION__, source.mediaType.c_str());
+  }
+
+  if (transaction)
+    RollbackTransaction();
+  return false;
+}
+
+void CDatabase::UpdateSearchIndexAsync()
+{
+  std::unique_ptr<CDatabase> database(CreateSearchIndexDatabase());
+  if (!database)
+    return;
+
+  {
+    CSingleLock lock(searchIndexSection);
+    if (!searchIndexPending.insert(GetBaseDBName()).second)
+      return;
+  }
+  CJobManager::GetInstance().AddJob(new CSearchIndexJob(database.release()), NULL, CJob::PRIORITY_LOW);
+}
+
+void CDatabase::GetSearchScores(const CSearchIndex::Source &source, const std::vector<int> &ids,
+                                const std::vector<std::string> &terms, std::vector<std::pair<int, int> > &scores)
+{
+  std::string columns;
+  for (const auto &column : source.columns)
+    columns += ", " + column.first;
+
+  m_pDS->query(PrepareSQL("SELECT %s%s FROM %s WHERE ", source.idColumn.c_str(), columns.c_str(), source.table.c_str())
+               + PrepareSearchCondition(source.idColumn, ids));
+  while (!m_pDS->eof())
+  {
+    // the same scoring as the query on the index
+    std::map<std::string, int> weights = GetTokenWeights(source, m_pDS.get());
+    int total = 0;
+    for (const std::string &term : terms)
+    {
+      int score = 0;
+      for (auto token = weights.lower_bound(term); token != weights.end() && token->first.compare(0, term.size(), term) == 0; ++token)
+        score = std::max(score, token->first == term ? token->second * 2 : token->second);
+      if (score == 0)
+      {
+        total = 0;
+        break;
+      }
+      total += score;
+    }
+    if (total > 0)
+      scores.push_back(std::make_pair(m_pDS->fv(0).get_asInt(), total));
+    m_pDS->next();
+  }
+  m_pDS->close();
+}
+
+bool CDatabase::GetSearchResults(const std::string &mediaType, const std::string &search, std::vector<int> &ids, unsigned int limit /* = 0 */)
+{
+  ids.clear();
+
+  std::vector<std::string> terms = CSearchIndex::Tokenize(search);
+  if (terms.empty())
+    return false;
+  if (terms.size() > CSearchIndex::MaxTerms)
+    terms.resize(CSearchIndex::MaxTerms);
+  if (limit == 0 || limit > CSearchIndex::MaxResults)
+    limit = CSearchIndex::MaxResults;
+
+  std::vector<CSearchIndex::Source> sources = GetSearchSources();
+  auto source = std::find_if(sources.begin(), sources.end(),
+                             [&mediaType](const CSearchIndex::Source &s) { return s.mediaType == mediaType; });
+  if (source == sources.end())
+    return false;
+
+  std::string strSQL;
+  try
+  {
+    if (NULL == m_pDB.get()) return false;
+    if (NULL == m_pDS.get()) return false;
+
+    // rows changed since the last update aren't in the index yet, or only with
+    // their old text. They are scored from their table, while a job brings the
+    // index up to date. On a replica the job writes to the primary.
+    std::vector<int> queued;
+    m_pDS->query(PrepareSQL("SELECT DISTINCT media_id FROM searchqueue WHERE media_type = '%s'", mediaType.c_str()));
+    while (!m_pDS->eof())
+    {
+      queued.push_back(m_pDS->fv(0).get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+    if (!queued.empty())
+      UpdateSearchIndexAsync();
+
+    // every term matches the start of a token, whole tokens count double.
+    // Items have to match all terms.
+    std::string matches;
+    for (const std::string &term : terms)
+    {
+      if (!matches.empty())
+        matches += " UNION ALL ";
+      matches += PrepareSQL("SELECT media_id, MAX(CASE WHEN token = '%s' THEN weight * 2 ELSE weight END) AS score "
+                            "FROM searchindex WHERE media_type = '%s' AND token >= '%s' AND token < '%s' ",
+                            term.c_str(), mediaType.c_str(), term.c_str(), CSearchIndex::GetPrefixEnd(term).c_str());
+      if (!queued.empty())
+        matches += PrepareSQL("AND media_id NOT IN (SELECT media_id FROM searchqueue WHERE media_type = '%s') ", mediaType.c_str());
+      matches += "GROUP BY media_id";
+    }
+    strSQL = "SELECT media_id, SUM(score) AS total FROM (" + matches + ") AS matches "
+             + StringUtils::Format("GROUP BY media_id HAVING COUNT(*) = %u ORDER BY total DESC, media_id LIMIT %u",
+                                   (unsigned int)terms.size(), limit);
+
+    std::vector<std::pair<int, int> > scores;
+    if (!m_pDS->query(strSQL))
+      return false;
+    while (!m_pDS->eof())
+    {
+      scores.push_back(std::make_pair(m_pDS->fv(0).get_asInt(), m_pDS->fv(1).get_asInt()));
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    if (!queued.empty())
+    {
+      for (size_t start = 0; start < queued.size(); start += SEARCH_INDEX_BATCH)
+      {
+        std::vector<int> batch(queued.begin() + start, queued.begin() + std::min(queued.size(), start + SEARCH_INDEX_BATCH));
+        GetSearchScores(*source, batch, terms, scores);
+      }
+      std::sort(scores.begin(), scores.end(), [](const std::pair<int, int> &a, const std::pair<int, int> &b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+      });
+      if (scores.size() > limit)
+        scores.resize(limit);
+    }
+
+    for (const auto &score : scores)
+      ids.push_back(score.first);
+    return true;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, strSQL.c_str());
+  }
+  return false;
+}
+
+std::string CDatabase::PrepareSearchCondition(const std::string &column, const std::vector<int> &ids) const
+{
+  if (ids.empty())
+    return "0 = 1";
+
+  std::string condition = column + " IN (";
+  for (size_t i = 0; i < ids.size(); i++)
+    condition += StringUtils::Format(i == 0 ? "%i" : ",%i", ids[i]);
+  return condition + ")";
+}
+
+std::string CDatabase::PrepareSearchOrder(const std::string &column, const std::vector<int> &ids) const
+{
+  if (ids.empty())
+    return column;
+
+  std::string order = "CASE " + column;
+  for (size_t i = 0; i < ids.size(); i++)
+    order += StringUtils::Format(" WHEN %i THEN %u", ids[i], (unsigned int)i);
+  return order + " END";
+}
+
+void CDatabase::LogQueryPlan(const std::string &sql)
+{
+  if (NULL == m_pDB.get() || NULL == m_pDS2.get())
+    return;
+
+  try
+  {
+    std::string explain = (m_sqlite ? "EXPLAIN QUERY PLAN " : "EXPLAIN ") + sql;
+    if (!m_pDS2->query(explain))
+      return;
+
+    CLog::Log(LOGDEBUG, "%s: %s", __FUNCTION__, explain.c_str());
+    while (!m_pDS2->eof())
+    {
+      std::vector<std::string> columns;
+      for (int i = 0; i < m_pDS2->fieldCount(); i++)
+        columns.push_back(m_pDS2->fv(i).get_asString());
+      CLog::Log(LOGDEBUG, "%s:   %s", __FUNCTION__, StringUtils::Join(columns, " | ").c_str());
+      m_pDS2->next();
+    }
+    m_pDS2->close();
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s failed for %s", __FUNCTION__, sql.c_str());
+  }
+}
@@ -29,6 +29,9 @@ namespace dbiplus {
 #include <string>
 #include <vector>
 
+#include "DatabaseConnectionPool.h"
+#include "SearchIndex.h"
+
 class DatabaseSettings; // forward
 class CDbUrl;
 struct SortDescription;
@@ -66,11 +69,47 @@ public:
 
   bool Open(const DatabaseSettings &db);
 
+  /*!
+   * @brief Open the database for reading only.
+   * Uses the replica of the database if one is configured and falls back to
+   * the database itself. The replica may lag behind, so this is meant for
+   * listings and other reads that don't follow a write of the same caller.
+   * If the database is already open, it is opened again the usual way.
+   * @return true if the database is open
+   */
+  bool OpenForReading();
+
+  /*!
+   * @brief Get the stats of the pooled connections to this database and its replica.
+   */
+  CDatabaseConnectionPool::Stats GetConnectionPoolStats() const;
+
   void BeginTransaction();
   virtual bool CommitTransaction();
   void RollbackTransaction();
   bool InTransaction();
 
+  /*!
+   * @brief Start a transaction that holds the transactions of many calls.
+   * Bulk writes like library imports run a transaction per item, which costs
+   * a sync to disk each. Within a batch, BeginTransaction() and its commit and
+   * rollback set, release and roll back to savepoints instead, so a failed
+   * item still only reverts its own changes while everything is written by
+   * CommitBatch() at once.
+   * @return false if a batch is already running or the database isn't open
+   */
+  bool BeginBatch();
+
+  /*!
+   * @brief Commit the changes of the running batch.
+   */
+  bool CommitBatch();
+
+  /*!
+   * @brief Revert the changes of the running batch.
+   */
+  void RollbackBatch();
+
   std::string PrepareSQL(std::string strStmt, ...) const;
 
   /*!
@@ -151,12 +190,48 @@ public:
    */
   bool CommitInsertQueries();
 
+  /*!
+   * @brief Bring the search index up to date with the changes queued since the last update.
+   * @return True if the index was updated successfully, false otherwise.
+   */
+  bool UpdateSearchIndex();
+
+  /*!
+   * @brief Look up items in the search index.
+   *        Every word of the search string has to match the start of a word of the
+   *        item, ignoring case and diacritics. Whole words and words in more
+   *        important columns rank higher.
+   * @param mediaType The media type of the items to search.
+   * @param search The search string.
+   * @param ids The ids of the matching items, best match first.
+   *        Items changed since the last update of the index are matched as well,
+   *        without writing to the database, and the index is updated in the background.
+   * @param limit The maximum number of results, at most and by default CSearchIndex::MaxResults.
+   * @return True if the search could be done, false otherwise.
+   */
+  bool GetSearchResults(const std::string &mediaType, const std::string &search, std::vector<int> &ids, unsigned int limit = 0);
+
+  /*!
+   * @brief SQL condition and order for the results of GetSearchResults().
+   * @param column The id column of the searched table.
+   * @param ids The ids returned by GetSearchResults().
+   */
+  std::string PrepareSearchCondition(const std::string &column, const std::vector<int> &ids) const;
+  std::string PrepareSearchOrder(const std::string &column, const std::vector<int> &ids) const;
+
+  /*!
+   * @brief Write the plan of the backend for a query to the debug log.
+   * @param sql The query to explain, it is not run.
+   */
+  void LogQueryPlan(const std::string &sql);
+
   virtual bool GetFilter(CDbUrl &dbUrl, Filter &filter, SortDescription &sorting) { return true; }
   virtual bool BuildSQL(const std::string &strBaseDir, const std::string &strQuery, Filter &filter, std::string &strSQL, CDbUrl &dbUrl);
   virtual bool BuildSQL(const std::string &strBaseDir, const std::string &strQuery, Filter &filter, std::string &strSQL, CDbUrl &dbUrl, SortDescription &sorting);
 
 protected:
   friend class CDatabaseManager;
+  friend class CSearchIndexJob;
   bool Update(const DatabaseSettings &db);
 
   void Split(const std::string& strFileNameAndPath, std::string& strPath, std::string& strFileName);
@@ -196,8 +271,40 @@ protected:
   int GetDBVersion();
   bool UpdateVersion(const std::string &dbName);
 
+  bool InBatch() const { return m_batch; }
+
+  /* \brief Disconnect on Close() instead of keeping the connection in the pool.
+   For connections left in a state the next user must not see, like temporary
+   tables that weren't dropped after an error.
+   */
+  void DiscardConnection() { m_discard = true; }
+
   bool BuildSQL(const std::string &strQuery, const Filter &filter, std::string &strSQL);
 
+  /* \brief The tables that are kept in the search index.
+   Deleting a row has to delete its tokens from the searchindex table, which is
+   left to the delete triggers of the child classes.
+   */
+  virtual std::vector<CSearchIndex::Source> GetSearchSources() const { return std::vector<CSearchIndex::Source>(); }
+
+  /* \brief Create the tables of the search index.
+   */
+  void CreateSearchIndexTables();
+
+  /* \brief Create the indices of the search index and the triggers that queue
+   added and changed rows for indexing.
+   */
+  void CreateSearchIndexAnalytics();
+
+  /* \brief Queue all rows of the search sources, the index is rebuilt after the next search.
+   */
+  void QueueSearchIndexRebuild();
+
+  /* \brief A new, closed database of the same kind, used to update the search
+   index on a job worker. Databases without a search index return NULL.
+   */
+  virtual CDatabase* CreateSearchIndexDatabase() const { return NULL; }
+
   bool m_sqlite; ///< \brief whether we use sqlite (defaults to true)
 
   std::unique_ptr<dbiplus::Database> m_pDB;
@@ -206,12 +313,24 @@ protected:
 
 private:
   void InitSettings(DatabaseSettings &dbSettings);
+  bool UpdateSearchIndex(const CSearchIndex::Source &source, const std::vector<int> &ids);
+  void UpdateSearchIndexAsync();
+  void GetSearchScores(const CSearchIndex::Source &source, const std::vector<int> &ids,
+                       const std::vector<std::string> &terms, std::vector<std::pair<int, int> > &scores);
   bool Connect(const std::string &dbName, const DatabaseSettings &db, bool create);
   void UpdateVersionNumber();
+  void ExecuteTransactionStatement(const std::string &statement);
 
   bool m_bMultiWrite; /*!< True if there are any queries in the queue, false otherwise */
   unsigned int m_openCount;
 
   bool m_multipleExecute;
   std::vector<std::string> m_multipleQueries;
+
+  bool m_pooled;   ///< m_pDB was acquired from the connection pool
+  bool m_readOnly; ///< opened by OpenForReading()
+  bool m_replica;  ///< connected to the replica, which is kept up to date by its server
+  bool m_batch;    ///< BeginBatch() was called, transactions are savepoints
+  unsigned int m_savepoints; ///< savepoints set within the batch
+  bool m_discard;  ///< DiscardConnection() was called, the connection isn't reused
 };
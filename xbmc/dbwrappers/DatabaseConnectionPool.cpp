@@ -0,0 +1,290 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "system.h"
+#include "DatabaseConnectionPool.h"
+#include "settings/AdvancedSettings.h"
+#include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/log.h"
+#include "sqlitedataset.h"
+
+#ifdef HAS_MYSQL
+#include "mysqldataset.h"
+#endif
+
+#include <algorithm>
+#include <memory>
+
+using namespace dbiplus;
+
+// connections idle for longer are checked before they are handed out again
+#define HEALTH_CHECK_AFTER 10000
+
+CDatabaseConnectionPool::CDatabaseConnectionPool(unsigned int waitTimeout /* = 250 */)
+  : m_waitTimeout(waitTimeout),
+    m_generation(0)
+{
+}
+
+CDatabaseConnectionPool::~CDatabaseConnectionPool()
+{
+  Clear();
+}
+
+Database* CDatabaseConnectionPool::CreateConnection(const DatabaseSettings &settings, const std::string &dbName)
+{
+  // create the appropriate database structure
+  std::unique_ptr<Database> db;
+  if (settings.type == "sqlite3")
+  {
+    db.reset(new SqliteDatabase());
+  }
+#ifdef HAS_MYSQL
+  else if (settings.type == "mysql")
+  {
+    db.reset(new MysqlDatabase());
+  }
+#endif
+  else
+  {
+    CLog::Log(LOGERROR, "Unable to determine database type: %s", settings.type.c_str());
+    return NULL;
+  }
+
+  // host name is always required
+  db->setHostName(settings.host.c_str());
+
+  if (!settings.port.empty())
+    db->setPort(settings.port.c_str());
+
+  if (!settings.user.empty())
+    db->setLogin(settings.user.c_str());
+
+  if (!settings.pass.empty())
+    db->setPasswd(settings.pass.c_str());
+
+  // database name is always required
+  db->setDatabase(dbName.c_str());
+
+  // set configuration regardless if any are empty
+  db->setConfig(settings.key.c_str(),
+                settings.cert.c_str(),
+                settings.ca.c_str(),
+                settings.capath.c_str(),
+                settings.ciphers.c_str(),
+                settings.compression);
+
+  return db.release();
+}
+
+Database* CDatabaseConnectionPool::Acquire(const std::string &baseName, const DatabaseSettings &settings, const std::string &dbName)
+{
+  std::string key = settings.type + "|" + settings.host + "|" + settings.port + "|" + settings.user + "|" + dbName;
+  unsigned int generation;
+  Database *db = NULL;
+  bool check = false;
+  {
+    CSingleLock lock(m_section);
+    Pool &pool = m_pools[key];
+    pool.baseName = baseName;
+    pool.size = std::max(settings.poolsize, 0);
+    pool.stats.acquired++;
+
+    // wait for a connection to be released when all are in use. Opening a
+    // sqlite file is cheap, there the GUI thread shouldn't wait at all
+    if (pool.idle.empty() && pool.size > 0 && pool.inUse >= pool.size && settings.type != "sqlite3")
+    {
+      unsigned int start = XbmcThreads::SystemClockMillis();
+      unsigned int waited = 0;
+      while (pool.idle.empty() && pool.inUse >= pool.size && waited < m_waitTimeout)
+      {
+        m_released.wait(lock, m_waitTimeout - waited);
+        waited = XbmcThreads::SystemClockMillis() - start;
+      }
+      pool.stats.waited++;
+      pool.stats.waitTime += waited;
+      pool.stats.maxWait = std::max(pool.stats.maxWait, waited);
+      if (pool.idle.empty())
+        CLog::Log(LOGDEBUG, "CDatabaseConnectionPool: all %u connections to %s are in use, opening another one",
+                  static_cast<unsigned int>(pool.size), dbName.c_str());
+    }
+
+    if (!pool.idle.empty())
+    {
+      db = pool.idle.back().db;
+      check = XbmcThreads::SystemClockMillis() - pool.idle.back().released >= HEALTH_CHECK_AFTER;
+      pool.idle.pop_back();
+    }
+
+    // reserve the connection while checking or connecting
+    pool.inUse++;
+    pool.stats.peak = std::max(pool.stats.peak, static_cast<unsigned int>(pool.inUse));
+    generation = m_generation;
+  }
+
+  if (db != NULL && check && !IsHealthy(*db))
+  {
+    CLog::Log(LOGWARNING, "CDatabaseConnectionPool: dropping broken connection to %s", dbName.c_str());
+    db->disconnect();
+    delete db;
+    db = NULL;
+
+    CSingleLock lock(m_section);
+    m_pools[key].stats.healthFailures++;
+  }
+  else if (db != NULL)
+  {
+    CSingleLock lock(m_section);
+    m_pools[key].stats.reused++;
+  }
+
+  if (db == NULL)
+  {
+    std::unique_ptr<Database> connection(CreateConnection(settings, dbName));
+    if (connection && connection->connect(false) == DB_CONNECTION_OK)
+    {
+      // sqlite3 post connection operations
+      if (settings.type == "sqlite3")
+      {
+        try
+        {
+          std::unique_ptr<Dataset> ds(connection->CreateDataset());
+          ds->exec("PRAGMA cache_size=4096\n");
+          ds->exec("PRAGMA synchronous='NORMAL'\n");
+          ds->exec("PRAGMA count_changes='OFF'\n");
+        }
+        catch (DbErrors &error)
+        {
+          CLog::Log(LOGERROR, "%s failed with '%s'", __FUNCTION__, error.getMsg());
+          connection->disconnect();
+          connection.reset();
+        }
+      }
+      db = connection.release();
+    }
+
+    if (db == NULL)
+    {
+      CSingleLock lock(m_section);
+      m_pools[key].inUse--;
+      m_released.notifyAll();
+      return NULL;
+    }
+  }
+
+  CSingleLock lock(m_section);
+  Lease &lease = m_leases[db];
+  lease.key = key;
+  lease.generation = generation;
+  return db;
+}
+
+void CDatabaseConnectionPool::Release(Database *db, bool reuse /* = true */)
+{
+  if (db == NULL)
+    return;
+
+  {
+    CSingleLock lock(m_section);
+    auto lease = m_leases.find(db);
+    if (lease != m_leases.end())
+    {
+      Pool &pool = m_pools[lease->second.key];
+      pool.inUse--;
+      // keep it if the database doesn't have more connections than its pool size
+      if (reuse && lease->second.generation == m_generation && db->isActive() &&
+          pool.idle.size() + pool.inUse < pool.size)
+      {
+        pool.idle.push_back(Idle{ db, XbmcThreads::SystemClockMillis() });
+        db = NULL;
+      }
+      m_leases.erase(lease);
+      m_released.notifyAll();
+    }
+  }
+
+  if (db != NULL)
+  {
+    db->disconnect();
+    delete db;
+  }
+}
+
+void CDatabaseConnectionPool::Clear()
+{
+  std::vector<Database*> idle;
+  {
+    CSingleLock lock(m_section);
+    m_generation++;
+    for (auto &it : m_pools)
+    {
+      for (const Idle &connection : it.second.idle)
+        idle.push_back(connection.db);
+      it.second.idle.clear();
+    }
+  }
+
+  for (Database *db : idle)
+  {
+    db->disconnect();
+    delete db;
+  }
+}
+
+CDatabaseConnectionPool::Stats CDatabaseConnectionPool::GetStats(const std::string &baseName) const
+{
+  Stats stats = Stats();
+  CSingleLock lock(m_section);
+  for (const auto &it : m_pools)
+  {
+    const Pool &pool = it.second;
+    if (pool.baseName != baseName)
+      continue;
+
+    stats.size += pool.size;
+    stats.inUse += pool.inUse;
+    stats.idle += pool.idle.size();
+    stats.peak += pool.stats.peak;
+    stats.acquired += pool.stats.acquired;
+    stats.reused += pool.stats.reused;
+    stats.waited += pool.stats.waited;
+    stats.waitTime += pool.stats.waitTime;
+    stats.maxWait = std::max(stats.maxWait, pool.stats.maxWait);
+    stats.healthFailures += pool.stats.healthFailures;
+  }
+  return stats;
+}
+
+bool CDatabaseConnectionPool::IsHealthy(Database &db)
+{
+  if (db.status() != DB_CONNECTION_OK)
+    return false;
+
+  try
+  {
+    std::unique_ptr<Dataset> ds(db.CreateDataset());
+    return ds->query("SELECT 1");
+  }
+  catch (...)
+  {
+    return false;
+  }
+}
@@ -0,0 +1,138 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+
+namespace dbiplus {
+  class Database;
+}
+
+class DatabaseSettings;
+
+/*!
+ \ingroup database
+ \brief Keeps the connections of closed databases open for the next CDatabase::Open().
+
+ Every CDatabase connects on Open() and disconnects on Close(), which costs a
+ connect and handshake per call with a MySQL server. Closed connections are
+ kept here per server and database instead and handed to the next Open().
+
+ A database has at most DatabaseSettings::poolsize connections at a time.
+ When all of them are in use, Acquire() waits for one to be released for a
+ short while and opens an additional connection after that, as connections
+ are held by windows and scanners for a long time and waiting longer could
+ deadlock a thread that opens a database twice. sqlite databases get the
+ additional connection right away. Additional connections are closed on
+ release.
+
+ A connection that was idle for a while is checked with a query before it
+ is handed out again, broken connections are replaced.
+ */
+class CDatabaseConnectionPool
+{
+public:
+  struct Stats
+  {
+    unsigned int size;           ///< most connections kept at a time
+    unsigned int inUse;          ///< connections held by open databases
+    unsigned int idle;           ///< connections kept for the next open
+    unsigned int peak;           ///< most connections in use at a time
+    unsigned int acquired;       ///< opens served by the pool
+    unsigned int reused;         ///< opens served by a kept connection
+    unsigned int waited;         ///< opens that had to wait for a connection
+    unsigned int waitTime;       ///< total wait in ms
+    unsigned int maxWait;        ///< longest wait in ms
+    unsigned int healthFailures; ///< kept connections that failed their check and were replaced
+  };
+
+  /*!
+   \param waitTimeout how long Acquire() waits for a connection in ms when all are in use, sqlite databases don't wait
+   */
+  explicit CDatabaseConnectionPool(unsigned int waitTimeout = 250);
+  ~CDatabaseConnectionPool();
+
+  /*!
+   \brief Create an unconnected database for the given settings.
+   \return the database, NULL if the type isn't supported
+   */
+  static dbiplus::Database* CreateConnection(const DatabaseSettings &settings, const std::string &dbName);
+
+  /*!
+   \brief Get a connected database, kept from an earlier Release() or newly connected.
+   \param baseName the name the connection is reported under, e.g. "MyVideos"
+   \param settings the server and pool size
+   \param dbName the versioned name of the database
+   \return the database, owned by the caller until it is passed to Release(), NULL if it couldn't connect
+   */
+  dbiplus::Database* Acquire(const std::string &baseName, const DatabaseSettings &settings, const std::string &dbName);
+
+  /*!
+   \brief Give back a database returned by Acquire().
+   \param reuse false to disconnect it, e.g. when it is in an unknown state
+   */
+  void Release(dbiplus::Database *db, bool reuse = true);
+
+  /*!
+   \brief Disconnect all kept connections, connections in use are disconnected on release.
+   */
+  void Clear();
+
+  /*!
+   \brief Get the stats of all connections reported under the given name.
+   */
+  Stats GetStats(const std::string &baseName) const;
+
+private:
+  struct Idle
+  {
+    dbiplus::Database *db;
+    unsigned int released;
+  };
+
+  struct Pool
+  {
+    std::string baseName;
+    size_t size;
+    size_t inUse;
+    std::vector<Idle> idle; ///< most recently released last
+    Stats stats;
+  };
+
+  struct Lease
+  {
+    std::string key;
+    unsigned int generation;
+  };
+
+  static bool IsHealthy(dbiplus::Database &db);
+
+  unsigned int m_waitTimeout;
+  mutable CCriticalSection m_section;
+  XbmcThreads::ConditionVariable m_released;
+  std::map<std::string, Pool> m_pools;        ///< by server and database
+  std::map<dbiplus::Database*, Lease> m_leases;
+  unsigned int m_generation;                  ///< changed by Clear(), connections of older generations aren't kept
+};
@@ -0,0 +1,122 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SearchIndex.h"
+#include "utils/CharsetConverter.h"
+#include "utils/StringUtils.h"
+
+#include <algorithm>
+
+const unsigned int CSearchIndex::MaxTerms;
+const unsigned int CSearchIndex::MaxResults;
+const unsigned int CSearchIndex::MaxTokenLength;
+
+// base letters of U+00C0 to U+017F, '*' marks letters folded to two letters
+// and ' ' the multiplication and division signs
+static const char latin_base[] =
+  "aaaaaa*ceeeeiiii" "dnooooo ouuuuy**"   // U+00C0
+  "aaaaaa*ceeeeiiii" "dnooooo ouuuuy*y"   // U+00E0
+  "aaaaaaccccccccdd" "ddeeeeeeeeeegggg"   // U+0100
+  "gggghhhhiiiiiiii" "ii**jjkkklllllll"   // U+0120
+  "lllnnnnnnnnnoooo" "oo**rrrrrrssssss"   // U+0140
+  "ssttttttuuuuuuuu" "uuuuwwyyyzzzzzzs";  // U+0160
+
+static void FoldLatin(wchar_t c, std::wstring &token)
+{
+  switch (c)
+  {
+  case 0xC6: case 0xE6:   token += L"ae"; break;
+  case 0xDE: case 0xFE:   token += L"th"; break;
+  case 0xDF:              token += L"ss"; break;
+  case 0x132: case 0x133: token += L"ij"; break;
+  case 0x152: case 0x153: token += L"oe"; break;
+  default:                token += static_cast<wchar_t>(latin_base[c - 0xC0]); break;
+  }
+}
+
+static bool IsSeparator(wchar_t c)
+{
+  if (c < 0x80)
+    return !isalnum(c);
+  return (c >= 0x80 && c <= 0xBF)        // latin-1 punctuation and symbols
+      || c == 0xD7 || c == 0xF7
+      || (c >= 0x2000 && c <= 0x206F)    // general punctuation
+      || (c >= 0x3000 && c <= 0x303F)    // CJK punctuation
+      || (c >= 0xFF00 && c <= 0xFF0F);   // fullwidth punctuation
+}
+
+static bool IsApostrophe(wchar_t c)
+{
+  return c == '\'' || c == 0x2019 || c == 0x02BC;
+}
+
+std::vector<std::string> CSearchIndex::Tokenize(const std::string &text)
+{
+  std::vector<std::string> tokens;
+
+  std::wstring wide;
+  if (!g_charsetConverter.utf8ToW(text, wide, false))
+    return tokens;
+  StringUtils::ToLower(wide);
+
+  std::wstring token;
+  auto addToken = [&tokens, &token]()
+  {
+    if (token.empty())
+      return;
+    std::string utf8;
+    g_charsetConverter.wToUTF8(token.substr(0, MaxTokenLength), utf8);
+    if (std::find(tokens.begin(), tokens.end(), utf8) == tokens.end())
+      tokens.push_back(utf8);
+    token.clear();
+  };
+
+  for (wchar_t c : wide)
+  {
+    // "don't" and "dont" are the same word
+    if (IsApostrophe(c))
+      continue;
+    // combining diacritical marks of decomposed text
+    if (c >= 0x300 && c <= 0x36F)
+      continue;
+
+    if (c >= 0xC0 && c <= 0x17F && latin_base[c - 0xC0] != ' ')
+      FoldLatin(c, token);
+    else if (IsSeparator(c))
+      addToken();
+    else
+      token += c;
+  }
+  addToken();
+
+  return tokens;
+}
+
+std::string CSearchIndex::GetPrefixEnd(const std::string &prefix)
+{
+  std::wstring wide;
+  if (prefix.empty() || !g_charsetConverter.utf8ToW(prefix, wide, false) || wide.empty())
+    return std::string();
+
+  wide[wide.size() - 1]++;
+  std::string end;
+  g_charsetConverter.wToUTF8(wide, end);
+  return end;
+}
@@ -0,0 +1,74 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/*!
+ \brief Text handling of the search index kept by CDatabase.
+
+ Text is split into words that are lower cased and stripped of their
+ diacritics, so "Björk" and "bjork" are the same token. The same is done
+ for the search string, which makes the matching independent of the case,
+ the accents and the collation of the database backend.
+ */
+class CSearchIndex
+{
+public:
+  /*!
+   \brief A table whose text columns are kept in the search index.
+   */
+  struct Source
+  {
+    std::string mediaType;  ///< media_type of the rows in the index
+    std::string table;
+    std::string idColumn;
+    std::vector<std::pair<std::string, int> > columns; ///< text columns and their weight
+  };
+
+  /*!
+   \brief Split a text into normalized tokens, each token is returned once.
+   */
+  static std::vector<std::string> Tokenize(const std::string &text);
+
+  /*!
+   \brief The smallest string that is larger than all strings starting with \a prefix.
+   Used to look up tokens by prefix with a range on the index.
+   */
+  static std::string GetPrefixEnd(const std::string &prefix);
+
+  /*!
+   \brief Maximum number of search terms that are matched, further terms are ignored.
+   */
+  static const unsigned int MaxTerms = 8;
+
+  /*!
+   \brief Maximum number of items returned by a search.
+   The ids end up in an IN list of the query that fetches the items.
+   */
+  static const unsigned int MaxResults = 1000;
+
+  /*!
+   \brief Maximum length of a token in characters, longer words are cut.
+   */
+  static const unsigned int MaxTokenLength = 64;
+};
@@ -0,0 +1,124 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/DatabaseConnectionPool.h"
+#include "dbwrappers/dataset.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+class TestDatabaseConnectionPool : public testing::Test
+{
+protected:
+  TestDatabaseConnectionPool()
+  {
+    m_settings.type = "sqlite3";
+    m_settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+    m_settings.poolsize = 1;
+
+    std::unique_ptr<dbiplus::Database> db(CDatabaseConnectionPool::CreateConnection(m_settings, "TestConnectionPool"));
+    db->connect(true);
+    db->disconnect();
+  }
+
+  ~TestDatabaseConnectionPool()
+  {
+    XFILE::CFile::Delete("special://temp/TestConnectionPool.db");
+  }
+
+  DatabaseSettings m_settings;
+};
+
+TEST_F(TestDatabaseConnectionPool, Reuse)
+{
+  CDatabaseConnectionPool pool;
+  dbiplus::Database *db = pool.Acquire("Test", m_settings, "TestConnectionPool");
+  ASSERT_TRUE(db != NULL);
+  EXPECT_TRUE(db->isActive());
+  pool.Release(db);
+  EXPECT_EQ(1u, pool.GetStats("Test").idle);
+
+  EXPECT_EQ(db, pool.Acquire("Test", m_settings, "TestConnectionPool"));
+  CDatabaseConnectionPool::Stats stats = pool.GetStats("Test");
+  EXPECT_EQ(2u, stats.acquired);
+  EXPECT_EQ(1u, stats.reused);
+  EXPECT_EQ(1u, stats.inUse);
+  EXPECT_EQ(0u, stats.idle);
+  EXPECT_EQ(0u, stats.waited);
+
+  // dropped connections and connections of other databases aren't kept
+  pool.Release(db, false);
+  EXPECT_EQ(0u, pool.GetStats("Test").idle);
+  EXPECT_EQ(0u, pool.GetStats("Other").acquired);
+
+  m_settings.type = "unknown";
+  EXPECT_EQ(NULL, pool.Acquire("Test", m_settings, "TestConnectionPool"));
+  EXPECT_EQ(0u, pool.GetStats("Test").inUse);
+}
+
+TEST_F(TestDatabaseConnectionPool, Limit)
+{
+  // sqlite connections are cheap to open, so the pool doesn't wait for one
+  // to be released, even with a long timeout
+  CDatabaseConnectionPool pool(5000);
+  dbiplus::Database *first = pool.Acquire("Test", m_settings, "TestConnectionPool");
+  ASSERT_TRUE(first != NULL);
+
+  dbiplus::Database *second = pool.Acquire("Test", m_settings, "TestConnectionPool");
+  ASSERT_TRUE(second != NULL);
+  EXPECT_NE(first, second);
+
+  CDatabaseConnectionPool::Stats stats = pool.GetStats("Test");
+  EXPECT_EQ(1u, stats.size);
+  EXPECT_EQ(2u, stats.inUse);
+  EXPECT_EQ(2u, stats.peak);
+  EXPECT_EQ(0u, stats.waited);
+  EXPECT_EQ(0u, stats.maxWait);
+
+  // only one of them is kept
+  pool.Release(first);
+  pool.Release(second);
+  EXPECT_EQ(1u, pool.GetStats("Test").idle);
+  pool.Clear();
+  EXPECT_EQ(0u, pool.GetStats("Test").idle);
+}
+
+TEST_F(TestDatabaseConnectionPool, ReleasedConnectionIsReused)
+{
+  CDatabaseConnectionPool pool;
+  dbiplus::Database *first = pool.Acquire("Test", m_settings, "TestConnectionPool");
+  dbiplus::Database *second = pool.Acquire("Test", m_settings, "TestConnectionPool");
+  ASSERT_TRUE(first != NULL);
+  ASSERT_TRUE(second != NULL);
+
+  // the connection over the limit is closed, the other one is kept
+  pool.Release(second);
+  EXPECT_EQ(0u, pool.GetStats("Test").idle);
+  pool.Release(first);
+  EXPECT_EQ(1u, pool.GetStats("Test").idle);
+
+  EXPECT_EQ(first, pool.Acquire("Test", m_settings, "TestConnectionPool"));
+  EXPECT_EQ(1u, pool.GetStats("Test").reused);
+  pool.Release(first);
+}
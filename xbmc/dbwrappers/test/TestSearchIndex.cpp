@@ -0,0 +1,58 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "dbwrappers/SearchIndex.h"
+
+#include "gtest/gtest.h"
+
+typedef std::vector<std::string> Tokens;
+
+TEST(TestSearchIndex, Tokenize)
+{
+  EXPECT_EQ(Tokens({ "the", "dark", "side", "of", "moon" }), CSearchIndex::Tokenize("The Dark Side of the Moon"));
+  EXPECT_EQ(Tokens({ "ac", "dc" }), CSearchIndex::Tokenize("AC/DC"));
+  EXPECT_EQ(Tokens({ "live", "1999", "pt", "2" }), CSearchIndex::Tokenize("  Live (1999), pt. 2  "));
+  EXPECT_TRUE(CSearchIndex::Tokenize("").empty());
+  EXPECT_TRUE(CSearchIndex::Tokenize(" - ").empty());
+}
+
+TEST(TestSearchIndex, TokenizeDiacritics)
+{
+  EXPECT_EQ(Tokens({ "bjork" }), CSearchIndex::Tokenize("Bj\xc3\xb6rk"));
+  EXPECT_EQ(Tokens({ "motorhead" }), CSearchIndex::Tokenize("MOT\xc3\x96RHEAD"));
+  EXPECT_EQ(Tokens({ "aeon" }), CSearchIndex::Tokenize("\xc3\x86on"));
+  EXPECT_EQ(Tokens({ "strasse" }), CSearchIndex::Tokenize("Stra\xc3\x9f" "e"));
+  // decomposed e + combining acute accent
+  EXPECT_EQ(Tokens({ "beyonce" }), CSearchIndex::Tokenize("Beyonce\xcc\x81"));
+}
+
+TEST(TestSearchIndex, TokenizeApostrophes)
+{
+  EXPECT_EQ(Tokens({ "dont", "stop" }), CSearchIndex::Tokenize("Don't Stop"));
+  EXPECT_EQ(Tokens({ "dont", "stop" }), CSearchIndex::Tokenize("Don\xe2\x80\x99t stop"));
+}
+
+TEST(TestSearchIndex, GetPrefixEnd)
+{
+  EXPECT_EQ("abd", CSearchIndex::GetPrefixEnd("abc"));
+  EXPECT_EQ("b", CSearchIndex::GetPrefixEnd("a"));
+  EXPECT_EQ("", CSearchIndex::GetPrefixEnd(""));
+  EXPECT_LT(std::string("abcz"), CSearchIndex::GetPrefixEnd("abc"));
+}
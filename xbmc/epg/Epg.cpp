@@ -181,20 +181,28 @@ CEpgInfoTagPtr CEpg::GetTagNow(bool bUpdateIfNeeded /* = true */) const
       return it->second;
   }
 
-  if (bUpdateIfNeeded)
+  if (bUpdateIfNeeded && !m_tags.empty())
   {
     CEpgInfoTagPtr lastActiveTag;
 
-    /* one of the first items will always match if the list is sorted */
-    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+    /* tags are sorted by start time and don't overlap (see FixOverlappingEvents), so
+       the active tag is the last one that started before now. look it up directly
+       instead of walking the whole table */
+    const CDateTime now(m_tags.begin()->second->GetCurrentPlayingTime());
+    std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.upper_bound(now);
+    while (it != m_tags.begin())
     {
+      --it;
       if (it->second->IsActive())
       {
         m_nowActiveStart = it->first;
         return it->second;
       }
       else if (it->second->WasActive())
+      {
         lastActiveTag = it->second;
+        break;
+      }
     }
 
     /* there might be a gap between the last and next event. return the last if found and it ended not more than 5 minutes ago */
@@ -216,12 +224,15 @@ CEpgInfoTagPtr CEpg::GetTagNext() const
     if (it != m_tags.end() && ++it != m_tags.end())
       return it->second;
   }
-  else if (Size() > 0)
+  else
   {
-    /* return the first event that is in the future */
-    for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+    CSingleLock lock(m_critSection);
+    if (!m_tags.empty())
     {
-      if (it->second->IsUpcoming())
+      /* return the first event that is in the future */
+      const CDateTime now(m_tags.begin()->second->GetCurrentPlayingTime());
+      std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.upper_bound(now);
+      if (it != m_tags.end())
         return it->second;
     }
   }
@@ -261,9 +272,12 @@ CEpgInfoTagPtr CEpg::GetTagByBroadcastId(unsigned int iUniqueBroadcastId) const
 CEpgInfoTagPtr CEpg::GetTagBetween(const CDateTime &beginTime, const CDateTime &endTime) const
 {
   CSingleLock lock(m_critSection);
-  for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.begin(); it != m_tags.end(); ++it)
+  for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.lower_bound(beginTime); it != m_tags.end(); ++it)
   {
-    if (it->second->StartAsUTC() >= beginTime && it->second->EndAsUTC() <= endTime)
+    if (it->second->StartAsUTC() > endTime)
+      break; // no tag starting later can end before endTime
+
+    if (it->second->EndAsUTC() <= endTime)
       return it->second;
   }
 
@@ -275,15 +289,12 @@ std::vector<CEpgInfoTagPtr> CEpg::GetTagsBetween(const CDateTime &beginTime, con
   std::vector<CEpgInfoTagPtr> epgTags;
 
   CSingleLock lock(m_critSection);
-  for (const auto &infoTag : m_tags)
+  for (std::map<CDateTime, CEpgInfoTagPtr>::const_iterator it = m_tags.lower_bound(beginTime); it != m_tags.end(); ++it)
   {
-    if (infoTag.second->StartAsUTC() >= beginTime)
-    {
-      if (infoTag.second->EndAsUTC() <= endTime)
-        epgTags.emplace_back(infoTag.second);
-      else
-        break; // done.
-    }
+    if (it->second->EndAsUTC() <= endTime)
+      epgTags.emplace_back(it->second);
+    else
+      break; // done.
   }
 
   return epgTags;
@@ -343,6 +354,15 @@ bool CEpg::Load(void)
   return bReturn;
 }
 
+void CEpg::LoadFromDbIfNeeded(void)
+{
+  if (!m_bLoaded && !g_EpgContainer.IgnoreDB())
+    Load();
+
+  /* also caches the last scan time */
+  GetLastScanTime();
+}
+
 bool CEpg::UpdateEntries(const CEpg &epg, bool bStoreInDb /* = true */)
 {
   CSingleLock lock(m_critSection);
@@ -429,13 +449,14 @@ bool CEpg::UpdateEntry(const CEpgInfoTagPtr &tag, bool bUpdateDatabase /* = fals
     bNewTag = true;
   }
 
-  infoTag->Update(*tag, bNewTag);
+  bool bTagChanged = infoTag->Update(*tag, bNewTag);
   infoTag->SetEpg(this);
   infoTag->SetPVRChannel(m_pvrChannel);
   infoTag->SetTimer(g_PVRTimers->GetTimerForEpgTag(infoTag));
   infoTag->SetRecording(g_PVRRecordings->GetRecordingForEpgTag(infoTag));
 
-  if (bUpdateDatabase)
+  /* don't rewrite tags that are unchanged since they were loaded or last persisted */
+  if (bUpdateDatabase && (bNewTag || bTagChanged))
     m_changedTags.insert(std::make_pair(infoTag->UniqueBroadcastID(), infoTag));
 
   return true;
@@ -499,14 +520,13 @@ bool CEpg::UpdateEntry(const CEpgInfoTagPtr &tag, EPG_EVENT_STATE newState, bool
   return bRet;
 }
 
-bool CEpg::Update(const time_t start, const time_t end, int iUpdateTime, bool bForceUpdate /* = false */)
+bool CEpg::Update(const time_t start, const time_t end, int iUpdateTime, bool bForceUpdate /* = false */, const InterruptCheck &interrupted /* = InterruptCheck() */)
 {
   bool bGrabSuccess(true);
   bool bUpdate(false);
 
   /* load the entries from the db first */
-  if (!m_bLoaded && !g_EpgContainer.IgnoreDB())
-    Load();
+  LoadFromDbIfNeeded();
 
   /* clean up if needed */
   if (m_bLoaded)
@@ -532,7 +552,15 @@ bool CEpg::Update(const time_t start, const time_t end, int iUpdateTime, bool bF
     bUpdate = true;
 
   if (bUpdate)
-    bGrabSuccess = LoadFromClients(start, end);
+  {
+    /* an interrupted update stays pending */
+    if (interrupted && interrupted())
+      return false;
+
+    bGrabSuccess = LoadFromClients(start, end, interrupted);
+    if (!bGrabSuccess && interrupted && interrupted())
+      return false;
+  }
 
   if (bGrabSuccess)
   {
@@ -581,7 +609,7 @@ int CEpg::Get(CFileItemList &results, const EpgSearchFilter &filter) const
   return results.Size() - iInitialSize;
 }
 
-bool CEpg::Persist(void)
+bool CEpg::Persist(bool bCommit /* = true */)
 {
   if (CSettings::GetInstance().GetBool(CSettings::SETTING_EPG_IGNOREDBFORCLIENT) || !NeedsSave())
     return true;
@@ -607,7 +635,7 @@ bool CEpg::Persist(void)
     }
 
     for (std::map<int, CEpgInfoTagPtr>::iterator it = m_deletedTags.begin(); it != m_deletedTags.end(); ++it)
-      database->Delete(*it->second);
+      database->Delete(*it->second, true);
 
     for (std::map<int, CEpgInfoTagPtr>::iterator it = m_changedTags.begin(); it != m_changedTags.end(); ++it)
       it->second->Persist(false);
@@ -622,7 +650,7 @@ bool CEpg::Persist(void)
     m_bUpdateLastScanTime = false;
   }
 
-  return database->CommitInsertQueries();
+  return bCommit ? database->CommitInsertQueries() : true;
 }
 
 CDateTime CEpg::GetFirstDate(void) const
@@ -792,20 +820,20 @@ const std::string &CEpg::ConvertGenreIdToString(int iID, int iSubID)
   return g_localizeStrings.Get(iLabelId);
 }
 
-bool CEpg::LoadFromClients(time_t start, time_t end)
+bool CEpg::LoadFromClients(time_t start, time_t end, const InterruptCheck &interrupted)
 {
   bool bReturn(false);
   CPVRChannelPtr channel = Channel();
   if (channel)
   {
     CEpg tmpEpg(channel);
-    if (tmpEpg.UpdateFromScraper(start, end))
+    if (tmpEpg.UpdateFromScraper(start, end) && !(interrupted && interrupted()))
       bReturn = UpdateEntries(tmpEpg, !CSettings::GetInstance().GetBool(CSettings::SETTING_EPG_IGNOREDBFORCLIENT));
   }
   else
   {
     CEpg tmpEpg(m_iEpgID, m_strName, m_strScraperName);
-    if (tmpEpg.UpdateFromScraper(start, end))
+    if (tmpEpg.UpdateFromScraper(start, end) && !(interrupted && interrupted()))
       bReturn = UpdateEntries(tmpEpg, !CSettings::GetInstance().GetBool(CSettings::SETTING_EPG_IGNOREDBFORCLIENT));
   }
 
@@ -863,6 +891,12 @@ size_t CEpg::Size(void) const
   return m_tags.size();
 }
 
+size_t CEpg::PendingTagChanges(void) const
+{
+  CSingleLock lock(m_critSection);
+  return m_changedTags.size() + m_deletedTags.size();
+}
+
 bool CEpg::NeedsSave(void) const
 {
   CSingleLock lock(m_critSection);
@@ -27,6 +27,7 @@
 #include "EpgInfoTag.h"
 #include "EpgSearchFilter.h"
 
+#include <functional>
 #include <memory>
 
 namespace PVR
@@ -46,6 +47,11 @@ namespace EPG
     friend class CEpgDatabase;
 
   public:
+    /*!
+     * @brief Returns true when a running update should stop.
+     */
+    typedef std::function<bool(void)> InterruptCheck;
+
     /*!
      * @brief Create a new EPG instance.
      * @param iEpgID The ID of this table or <= 0 to create a new ID.
@@ -75,6 +81,12 @@ namespace EPG
      */
     bool Load(void);
 
+    /*!
+     * @brief Load all entries and the last scan time of this table from the database, if that didn't happen yet.
+     * @note The database isn't thread safe. Call this on the EPG thread before updating tables in parallel.
+     */
+    void LoadFromDbIfNeeded(void);
+
     /*!
      * @brief The channel this EPG belongs to.
      * @return The channel this EPG belongs to
@@ -220,9 +232,10 @@ namespace EPG
      * @param end The end time.
      * @param iUpdateTime Update the table after the given amount of time has passed.
      * @param bForceUpdate Force update from client even if it's not the time to
+     * @param interrupted Checked before and after the entries are requested from the client. The table isn't changed if it returns true.
      * @return True if the update was successful, false otherwise.
      */
-    bool Update(const time_t start, const time_t end, int iUpdateTime, bool bForceUpdate = false);
+    bool Update(const time_t start, const time_t end, int iUpdateTime, bool bForceUpdate = false, const InterruptCheck &interrupted = InterruptCheck());
 
     /*!
      * @brief Get all EPG entries.
@@ -241,9 +254,15 @@ namespace EPG
 
     /*!
      * @brief Persist this table in the database.
+     * @param bCommit True to commit the queued queries, false to leave them for the caller to commit.
      * @return True if the table was persisted, false otherwise.
      */
-    bool Persist(void);
+    bool Persist(bool bCommit = true);
+
+    /*!
+     * @return The amount of tags that were changed or deleted and still need to be persisted.
+     */
+    size_t PendingTagChanges(void) const;
 
     /*!
      * @brief Get the start time of the first entry in this table.
@@ -315,9 +334,10 @@ namespace EPG
      * @brief Load all EPG entries from clients into a temporary table and update this table with the contents of that temporary table.
      * @param start Only get entries after this start time. Use 0 to get all entries before "end".
      * @param end Only get entries before this end time. Use 0 to get all entries after "begin". If both "begin" and "end" are 0, all entries will be updated.
+     * @param interrupted Checked after the entries were received. This table isn't changed if it returns true.
      * @return True if the update was successful, false otherwise.
      */
-    bool LoadFromClients(time_t start, time_t end);
+    bool LoadFromClients(time_t start, time_t end, const InterruptCheck &interrupted);
 
     /*!
      * @brief Update the contents of this table with the contents provided in "epg"
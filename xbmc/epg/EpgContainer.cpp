@@ -20,6 +20,8 @@
 
 #include "EpgContainer.h"
 
+#include <algorithm>
+#include <memory>
 #include <utility>
 
 #include "Application.h"
@@ -36,12 +38,123 @@
 #include "settings/lib/Setting.h"
 #include "settings/Settings.h"
 #include "threads/SingleLock.h"
+#include "threads/SystemClock.h"
+#include "utils/JobManager.h"
 #include "utils/log.h"
 
 
 using namespace EPG;
 using namespace PVR;
 
+namespace
+{
+  /*!
+   * @brief Collects the results of the table updates that run in parallel.
+   */
+  class CEpgUpdateResult
+  {
+  public:
+    CEpgUpdateResult(void) : m_iCompleted(0), m_iUpdated(0), m_bInterrupted(false) {}
+
+    void Add(const CEpgPtr &epg, bool bSuccess)
+    {
+      CSingleLock lock(m_critSection);
+      ++m_iCompleted;
+      if (bSuccess)
+        ++m_iUpdated;
+      else
+        m_failedTables.push_back(epg);
+      m_lastTable = epg->Name();
+      m_completedEvent.Set();
+    }
+
+    /*!
+     * @brief Count a table whose update was interrupted. It is neither updated nor failed.
+     */
+    void AddInterrupted(void)
+    {
+      CSingleLock lock(m_critSection);
+      ++m_iCompleted;
+      m_completedEvent.Set();
+    }
+
+    void Interrupt(void) { CSingleLock lock(m_critSection); m_bInterrupted = true; }
+    bool IsInterrupted(void) const { CSingleLock lock(m_critSection); return m_bInterrupted; }
+
+    unsigned int Completed(std::string &strLastTable) const
+    {
+      CSingleLock lock(m_critSection);
+      strLastTable = m_lastTable;
+      return m_iCompleted;
+    }
+
+    unsigned int Updated(void) const { CSingleLock lock(m_critSection); return m_iUpdated; }
+    std::vector<CEpgPtr> FailedTables(void) const { CSingleLock lock(m_critSection); return m_failedTables; }
+    bool WaitMSec(unsigned int iMilliSeconds) { return m_completedEvent.WaitMSec(iMilliSeconds); }
+
+  private:
+    CCriticalSection m_critSection;
+    CEvent m_completedEvent;
+    unsigned int m_iCompleted;
+    unsigned int m_iUpdated;
+    bool m_bInterrupted;
+    std::string m_lastTable;
+    std::vector<CEpgPtr> m_failedTables;
+  };
+
+  /*!
+   * @brief Updates a single EPG table from its PVR client.
+   * @note The result is shared with the job, so a job that is still running when the update is interrupted can finish safely.
+   *       Such a job doesn't apply what it got from the client to the table.
+   */
+  class CEpgUpdateJob : public CJob
+  {
+  public:
+    CEpgUpdateJob(const CEpgPtr &epg, time_t start, time_t end, int iUpdateTime, bool bForceUpdate, const std::shared_ptr<CEpgUpdateResult> &result) :
+      m_epg(epg), m_start(start), m_end(end), m_iUpdateTime(iUpdateTime), m_bForceUpdate(bForceUpdate), m_result(result) {}
+
+    virtual bool DoWork(void) override
+    {
+      const std::shared_ptr<CEpgUpdateResult> result(m_result);
+      const CEpg::InterruptCheck interrupted = [result]() { return result->IsInterrupted(); };
+
+      bool bSuccess = !interrupted() && m_epg->Update(m_start, m_end, m_iUpdateTime, m_bForceUpdate, interrupted);
+      if (interrupted())
+        m_result->AddInterrupted();
+      else
+        m_result->Add(m_epg, bSuccess);
+      return bSuccess;
+    }
+
+    virtual const char *GetType(void) const override { return "epgupdate"; }
+
+  private:
+    CEpgPtr m_epg;
+    time_t m_start;
+    time_t m_end;
+    int m_iUpdateTime;
+    bool m_bForceUpdate;
+    std::shared_ptr<CEpgUpdateResult> m_result;
+  };
+
+  /*!
+   * @brief Sort order for table updates: tables of the selected channel groups first, then the most recently watched channels.
+   */
+  struct SEpgUpdatePriority
+  {
+    CEpgPtr epg;
+    bool bInSelectedGroup;
+    time_t iLastWatched;
+
+    bool operator <(const SEpgUpdatePriority &right) const
+    {
+      if (bInSelectedGroup != right.bInSelectedGroup)
+        return bInSelectedGroup;
+      return iLastWatched > right.iLastWatched;
+    }
+  };
+}
+
 CEpgContainer::CEpgContainer(void) :
   CThread("EPGUpdater"),
   m_bUpdateNotificationPending(false)
@@ -291,15 +404,31 @@ bool CEpgContainer::PersistAll(void)
   auto copy = m_epgs;
   m_critSection.unlock();
 
+  unsigned int iStart = XbmcThreads::SystemClockMillis();
+  unsigned int iTables(0);
+  size_t iTags(0);
+
+  /* queue the changes of all tables and write them in a single transaction */
   for (EPGMAP::const_iterator it = copy.begin(); it != copy.end() && !m_bStop; ++it)
   {
     CEpgPtr epg = it->second;
     if (epg && epg->NeedsSave())
     {
-      bReturn &= epg->Persist();
+      iTags += epg->PendingTagChanges();
+      bReturn &= epg->Persist(false);
+      ++iTables;
     }
   }
 
+  if (iTables > 0)
+  {
+    if (!m_bIgnoreDbForClient && m_database.IsOpen())
+      bReturn &= m_database.CommitInsertQueries();
+
+    CLog::Log(LOGDEBUG, "EpgContainer - %s - persisted %u tables (%" PRIuS" changed or deleted tags) in %u ms",
+        __FUNCTION__, iTables, iTags, XbmcThreads::SystemClockMillis() - iStart);
+  }
+
   return bReturn;
 }
 
@@ -644,9 +773,11 @@ bool CEpgContainer::UpdateEPG(bool bOnlyPending /* = false */)
   }
 
   std::vector<CEpgPtr> invalidTables;
+  std::vector<SEpgUpdatePriority> updateTables;
 
-  /* load or update all EPG tables */
-  unsigned int iCounter(0);
+  /* load all EPG tables and collect the ones that have to be updated */
+  const CPVRChannelGroupPtr selectedTvGroup(g_PVRManager.IsStarted() ? g_PVRChannelGroups->GetSelectedGroup(false) : CPVRChannelGroupPtr());
+  const CPVRChannelGroupPtr selectedRadioGroup(g_PVRManager.IsStarted() ? g_PVRChannelGroups->GetSelectedGroup(true) : CPVRChannelGroupPtr());
   for (const auto &epgEntry : m_epgs)
   {
     if (InterruptUpdate())
@@ -659,9 +790,6 @@ bool CEpgContainer::UpdateEPG(bool bOnlyPending /* = false */)
     if (!epg)
       continue;
 
-    if (bShowProgress && !bOnlyPending)
-      UpdateProgressDialog(++iCounter, m_epgs.size(), epg->Name());
-
     // we currently only support update via pvr add-ons. skip update when the pvr manager isn't started
     if (!g_PVRManager.IsStarted())
       continue;
@@ -674,12 +802,68 @@ bool CEpgContainer::UpdateEPG(bool bOnlyPending /* = false */)
         epg->SetChannel(channel);
     }
 
-    if ((!bOnlyPending || epg->UpdatePending()) && epg->Update(start, end, m_iUpdateTime, bOnlyPending))
-      iUpdatedTables++;
+    if (!bOnlyPending || epg->UpdatePending())
+    {
+      // database access isn't thread safe. read the table before it's updated from a job
+      epg->LoadFromDbIfNeeded();
+
+      const CPVRChannelPtr channel(epg->Channel());
+      const CPVRChannelGroupPtr selectedGroup(channel && channel->IsRadio() ? selectedRadioGroup : selectedTvGroup);
+      SEpgUpdatePriority table;
+      table.epg = epg;
+      table.bInSelectedGroup = channel && selectedGroup && selectedGroup->IsGroupMember(channel);
+      table.iLastWatched = channel ? channel->LastWatched() : 0;
+      updateTables.push_back(table);
+    }
     else if (!epg->IsValid())
       invalidTables.push_back(epg);
   }
 
+  /* update the tables in parallel, limiting the amount of concurrent requests per client */
+  if (!bInterrupted && !updateTables.empty())
+  {
+    std::stable_sort(updateTables.begin(), updateTables.end());
+
+    std::shared_ptr<CEpgUpdateResult> result(new CEpgUpdateResult);
+    const unsigned int iConcurrentUpdates = std::max(1, g_advancedSettings.m_iEpgConcurrentUpdatesPerClient);
+    for (const auto &table : updateTables)
+    {
+      const CPVRChannelPtr channel(table.epg->Channel());
+      /* the queues outlive the update, the job manager still calls them after a job signalled completion */
+      std::unique_ptr<CJobQueue> &queue = m_updateQueues[channel ? channel->ClientID() : -1];
+      if (!queue)
+        queue.reset(new CJobQueue(false, iConcurrentUpdates, CJob::PRIORITY_NORMAL));
+      queue->AddJob(new CEpgUpdateJob(table.epg, start, end, m_iUpdateTime, bOnlyPending, result));
+    }
+
+    std::string strLastTable;
+    unsigned int iCompleted(0);
+    while ((iCompleted = result->Completed(strLastTable)) < updateTables.size())
+    {
+      if (InterruptUpdate())
+      {
+        /* tables that are being updated right now stop once their client returned */
+        result->Interrupt();
+        for (auto &queue : m_updateQueues)
+          queue.second->CancelJobs();
+        bInterrupted = true;
+        break;
+      }
+
+      if (bShowProgress && !bOnlyPending && iCompleted > 0)
+        UpdateProgressDialog(iCompleted, updateTables.size(), strLastTable);
+
+      result->WaitMSec(100);
+    }
+
+    iUpdatedTables = result->Updated();
+    for (const auto &epg : result->FailedTables())
+    {
+      if (!epg->IsValid())
+        invalidTables.push_back(epg);
+    }
+  }
+
   for (auto it = invalidTables.begin(); it != invalidTables.end(); ++it)
     DeleteEpg(**it, true);
 
@@ -20,6 +20,7 @@
  */
 
 #include <map>
+#include <memory>
 
 #include "XBDateTime.h"
 #include "settings/lib/ISettingCallback.h"
@@ -31,6 +32,7 @@
 #include "EpgDatabase.h"
 
 class CFileItemList;
+class CJobQueue;
 class CGUIDialogProgressBarHandle;
 
 namespace EPG
@@ -300,6 +302,8 @@ namespace EPG
     std::list<SUpdateRequest> m_updateRequests; /*!< list of update requests triggered by addon */
     CCriticalSection m_updateRequestsLock;      /*!< protect update requests */
 
+    std::map<int, std::unique_ptr<CJobQueue>> m_updateQueues; /*!< table update jobs per PVR client, only used by UpdateEPG() */
+
   private:
     bool m_bUpdateNotificationPending; /*!< true while an epg updated notification to observers is pending. */
   };
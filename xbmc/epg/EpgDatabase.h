@@ -93,9 +93,10 @@ namespace EPG
     /*!
      * @brief Remove a single EPG entry.
      * @param tag The entry to remove.
+     * @param bQueueWrite Don't execute the query immediately but queue it if true.
      * @return True if it was removed successfully, false otherwise.
      */
-    virtual bool Delete(const CEpgInfoTag &tag);
+    virtual bool Delete(const CEpgInfoTag &tag, bool bQueueWrite = false);
 
     /*!
      * @brief Get all EPG tables from the database. Does not get the EPG tables' entries.
@@ -90,6 +90,11 @@ namespace EPG
      */
     bool WasActive(void) const;
 
+    /*!
+     * @brief Get current time, taking timeshifting into account.
+     */
+    CDateTime GetCurrentPlayingTime(void) const;
+
     /*!
      * @return True when this event is an upcoming event, false otherwise.
      */
@@ -412,11 +417,6 @@ namespace EPG
      */
     void UpdatePath(void);
 
-    /*!
-     * @brief Get current time, taking timeshifting into account.
-     */
-    CDateTime GetCurrentPlayingTime(void) const;
-
     /*!
      *  @brief Return the m_iFlags as an unsigned int bitfield (for database use).
      */
@@ -18,6 +18,8 @@
  *
  */
 
+#include <algorithm>
+
 #include "FileItem.h"
 #include "epg/EpgInfoTag.h"
 #include "utils/Variant.h"
@@ -150,114 +152,131 @@ void CGUIEPGGridContainerModel::Refresh(const std::unique_ptr<CFileItemList> &it
 
   ////////////////////////////////////////////////////////////////////////
   // Create epg grid
-  const CDateTimeSpan blockDuration(0, 0, MINSPERBLOCK, 0);
   const CDateTimeSpan gridDuration(m_gridEnd - m_gridStart);
   m_blocks = (gridDuration.GetDays() * 24 * 60 + gridDuration.GetHours() * 60 + gridDuration.GetMinutes()) / MINSPERBLOCK;
   if (m_blocks >= MAXBLOCKS)
     m_blocks = MAXBLOCKS;
 
-  m_gridIndex.reserve(m_channelItems.size());
-  const std::vector<GridItem> blocks(m_blocks);
+  // rows of the grid are only created once their channel is shown, see GetGridRow().
+  // for a large number of channels most of them are never scrolled to.
+  m_blockSize = fBlockSize;
+  m_gridIndex.resize(m_channelItems.size());
+}
 
-  for (size_t channel = 0; channel < m_channelItems.size(); ++channel)
+std::vector<GridItem> &CGUIEPGGridContainerModel::GetGridRow(int iChannel) const
+{
+  std::vector<GridItem> &row = m_gridIndex[iChannel];
+  if (row.empty() && m_blocks > 0)
+    CreateGridRow(iChannel, row);
+  return row;
+}
+
+void CGUIEPGGridContainerModel::CreateGridRow(size_t channel, std::vector<GridItem> &row) const
+{
+  const CDateTimeSpan blockDuration(0, 0, MINSPERBLOCK, 0);
+  row.resize(m_blocks);
+
+  CDateTime gridCursor(m_gridStart);
+  unsigned long progIdx = m_epgItemsPtr[channel].start;
+  unsigned long lastIdx = m_epgItemsPtr[channel].stop;
+  int iEpgId            = m_programmeItems[progIdx]->GetEPGInfoTag()->EpgID();
+
+  // programmes of a channel are sorted by time, so skip all programmes that ended before
+  // the grid start in one go instead of testing them block by block.
+  const auto firstProg = std::partition_point(m_programmeItems.begin() + progIdx,
+                                              m_programmeItems.begin() + lastIdx + 1,
+                                              [this](const CFileItemPtr &prog) { return prog->GetEPGInfoTag()->EndAsUTC() <= m_gridStart; });
+  progIdx = std::distance(m_programmeItems.begin(), firstProg);
+  int itemSize          = 1; // size of the programme in blocks
+  int savedBlock        = 0;
+  CFileItemPtr item;
+  CEpgInfoTagPtr tag;
+
+  for (int block = 0; block < m_blocks; ++block)
   {
-    m_gridIndex.emplace_back(blocks);
+    while (progIdx <= lastIdx)
+    {
+      item = m_programmeItems[progIdx];
+      tag = item->GetEPGInfoTag();
 
-    CDateTime gridCursor(m_gridStart); //reset cursor for new channel
-    unsigned long progIdx = m_epgItemsPtr[channel].start;
-    unsigned long lastIdx = m_epgItemsPtr[channel].stop;
-    int iEpgId            = m_programmeItems[progIdx]->GetEPGInfoTag()->EpgID();
-    int itemSize          = 1; // size of the programme in blocks
-    int savedBlock        = 0;
-    CFileItemPtr item;
-    CEpgInfoTagPtr tag;
+      if (tag->EpgID() != iEpgId || gridCursor < tag->StartAsUTC() || m_gridEnd <= tag->StartAsUTC())
+        break;
 
-    for (int block = 0; block < m_blocks; ++block)
-    {
-      while (progIdx <= lastIdx)
+      if (gridCursor < tag->EndAsUTC())
       {
-        item = m_programmeItems[progIdx];
-        tag = item->GetEPGInfoTag();
-
-        if (tag->EpgID() != iEpgId || gridCursor < tag->StartAsUTC() || m_gridEnd <= tag->StartAsUTC())
-          break;
+        row[block].item = item;
+        row[block].progIndex = progIdx;
+        break;
+      }
 
-        if (gridCursor < tag->EndAsUTC())
-        {
-          m_gridIndex[channel][block].item = item;
-          m_gridIndex[channel][block].progIndex = progIdx;
-          break;
-        }
+      progIdx++;
+    }
 
-        progIdx++;
-      }
+    gridCursor += blockDuration;
 
-      gridCursor += blockDuration;
+    if (block == 0)
+      continue;
 
-      if (block == 0)
-        continue;
+    const CFileItemPtr prevItem(row[block - 1].item);
+    const CFileItemPtr currItem(row[block].item);
 
-      const CFileItemPtr prevItem(m_gridIndex[channel][block - 1].item);
-      const CFileItemPtr currItem(m_gridIndex[channel][block].item);
+    if (block == m_blocks - 1 || prevItem != currItem)
+    {
+      // special handling for last block.
+      int blockDelta = -1;
+      int sizeDelta = 0;
+      if (block == m_blocks - 1 && prevItem == currItem)
+      {
+        itemSize++;
+        blockDelta = 0;
+        sizeDelta = 1;
+      }
 
-      if (block == m_blocks - 1 || prevItem != currItem)
+      if (prevItem)
       {
-        // special handling for last block.
-        int blockDelta = -1;
-        int sizeDelta = 0;
-        if (block == m_blocks - 1 && prevItem == currItem)
+        row[savedBlock].item->SetProperty("GenreType", prevItem->GetEPGInfoTag()->GenreType());
+      }
+      else
+      {
+        CEpgInfoTagPtr gapTag(CEpgInfoTag::CreateDefaultTag());
+        gapTag->SetPVRChannel(m_channelItems[channel]->GetPVRChannelInfoTag());
+        CFileItemPtr gapItem(new CFileItem(gapTag));
+        for (int i = block + blockDelta; i >= block - itemSize + sizeDelta; --i)
         {
-          itemSize++;
-          blockDelta = 0;
-          sizeDelta = 1;
+          row[i].item = gapItem;
         }
+      }
 
-        if (prevItem)
+      float fItemWidth = itemSize * m_blockSize;
+      row[savedBlock].originWidth = fItemWidth;
+      row[savedBlock].width = fItemWidth;
+
+      itemSize = 1;
+      savedBlock = block;
+
+      // special handling for last block.
+      if (block == m_blocks - 1 && prevItem != currItem)
+      {
+        if (currItem)
         {
-          m_gridIndex[channel][savedBlock].item->SetProperty("GenreType", prevItem->GetEPGInfoTag()->GenreType());
+          row[savedBlock].item->SetProperty("GenreType", currItem->GetEPGInfoTag()->GenreType());
         }
         else
         {
           CEpgInfoTagPtr gapTag(CEpgInfoTag::CreateDefaultTag());
           gapTag->SetPVRChannel(m_channelItems[channel]->GetPVRChannelInfoTag());
           CFileItemPtr gapItem(new CFileItem(gapTag));
-          for (int i = block + blockDelta; i >= block - itemSize + sizeDelta; --i)
-          {
-            m_gridIndex[channel][i].item = gapItem;
-          }
+          row[block].item = gapItem;
         }
 
-        float fItemWidth = itemSize * fBlockSize;
-        m_gridIndex[channel][savedBlock].originWidth = fItemWidth;
-        m_gridIndex[channel][savedBlock].width = fItemWidth;
-
-        itemSize = 1;
-        savedBlock = block;
-
-        // special handling for last block.
-        if (block == m_blocks - 1 && prevItem != currItem)
-        {
-          if (currItem)
-          {
-            m_gridIndex[channel][savedBlock].item->SetProperty("GenreType", currItem->GetEPGInfoTag()->GenreType());
-          }
-          else
-          {
-            CEpgInfoTagPtr gapTag(CEpgInfoTag::CreateDefaultTag());
-            gapTag->SetPVRChannel(m_channelItems[channel]->GetPVRChannelInfoTag());
-            CFileItemPtr gapItem(new CFileItem(gapTag));
-            m_gridIndex[channel][block].item = gapItem;
-          }
-
-          m_gridIndex[channel][savedBlock].originWidth = fBlockSize; // size always 1 block here
-          m_gridIndex[channel][savedBlock].width = fBlockSize;
-        }
-      }
-      else
-      {
-        itemSize++;
+        row[savedBlock].originWidth = m_blockSize; // size always 1 block here
+        row[savedBlock].width = m_blockSize;
       }
     }
+    else
+    {
+      itemSize++;
+    }
   }
 }
 
@@ -330,39 +349,44 @@ void CGUIEPGGridContainerModel::FreeChannelMemory(int keepStart, int keepEnd)
 
 void CGUIEPGGridContainerModel::FreeProgrammeMemory(int channel, int keepStart, int keepEnd)
 {
+  // rows that were never created hold no items
+  std::vector<GridItem> &row = m_gridIndex[channel];
+  if (row.empty())
+    return;
+
   if (keepStart < keepEnd)
   {
     // remove before keepStart and after keepEnd
     if (keepStart > 0 && keepStart < m_blocks)
     {
       // if item exist and block is not part of visible item
-      CGUIListItemPtr last(m_gridIndex[channel][keepStart].item);
+      CGUIListItemPtr last(row[keepStart].item);
       for (int i = keepStart - 1; i > 0; --i)
       {
-        if (m_gridIndex[channel][i].item && m_gridIndex[channel][i].item != last)
+        if (row[i].item && row[i].item != last)
         {
-          m_gridIndex[channel][i].item->FreeMemory();
+          row[i].item->FreeMemory();
           // FreeMemory() is smart enough to not cause any problems when called multiple times on same item
           // but we can make use of condition needed to not call FreeMemory() on item that is partially visible
           // to avoid calling FreeMemory() multiple times on item that ocupy few blocks in a row
-          last = m_gridIndex[channel][i].item;
+          last = row[i].item;
         }
       }
     }
 
     if (keepEnd > 0 && keepEnd < m_blocks)
     {
-      CGUIListItemPtr last(m_gridIndex[channel][keepEnd].item);
+      CGUIListItemPtr last(row[keepEnd].item);
       for (int i = keepEnd + 1; i < m_blocks; ++i)
       {
         // if item exist and block is not part of visible item
-        if (m_gridIndex[channel][i].item && m_gridIndex[channel][i].item != last)
+        if (row[i].item && row[i].item != last)
         {
-          m_gridIndex[channel][i].item->FreeMemory();
+          row[i].item->FreeMemory();
           // FreeMemory() is smart enough to not cause any problems when called multiple times on same item
           // but we can make use of condition needed to not call FreeMemory() on item that is partially visible
           // to avoid calling FreeMemory() multiple times on item that ocupy few blocks in a row
-          last = m_gridIndex[channel][i].item;
+          last = row[i].item;
         }
       }
     }
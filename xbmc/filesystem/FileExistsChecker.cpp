@@ -0,0 +1,209 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileExistsChecker.h"
+#include "Directory.h"
+#include "File.h"
+#include "FileItem.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+#include "utils/URIUtils.h"
+
+#include <map>
+#include <set>
+
+using namespace XFILE;
+
+CFileExistsChecker::CFileExistsChecker(unsigned int threads)
+  : m_paths(NULL),
+    m_states(NULL),
+    m_next(0),
+    m_running(0),
+    m_done(0),
+    m_quit(false)
+{
+  if (threads == 0)
+    threads = 1;
+
+  for (unsigned int i = 0; i < threads; i++)
+  {
+    m_workers.emplace_back(new CThread(this, "FileExistsChecker"));
+    m_workers.back()->Create();
+  }
+}
+
+CFileExistsChecker::~CFileExistsChecker()
+{
+  {
+    CSingleLock lock(m_section);
+    m_quit = true;
+    m_changed.notifyAll();
+  }
+  for (auto &worker : m_workers)
+    worker->StopThread();
+}
+
+bool CFileExistsChecker::Check(const std::vector<std::string> &paths, const std::vector<std::string> &roots,
+                               std::vector<State> &states, const std::function<bool(int)> &progress)
+{
+  states.assign(paths.size(), Exists);
+
+  // a file belongs to the longest root containing it, else to the share of its host
+  std::map<std::string, size_t> shareIndex;
+  std::vector<Share> shares;
+  for (size_t i = 0; i < paths.size(); i++)
+  {
+    std::string root;
+    for (const std::string &candidate : roots)
+    {
+      if (candidate.size() > root.size() && URIUtils::PathHasParent(paths[i], candidate))
+        root = candidate;
+    }
+    std::string key = root.empty() ? GetShareKey(paths[i]) : root;
+
+    auto it = shareIndex.find(key);
+    if (it == shareIndex.end())
+    {
+      it = shareIndex.insert(std::make_pair(key, shares.size())).first;
+      shares.push_back(Share());
+      shares.back().root = root;
+    }
+    shares[it->second].files.push_back(i);
+  }
+
+  CSingleLock lock(m_section);
+  m_paths = &paths;
+  m_states = &states;
+  m_shares.swap(shares);
+  m_next = 0;
+  m_done = 0;
+  m_changed.notifyAll();
+
+  bool stopped = false;
+  while (m_next < m_shares.size() || m_running > 0)
+  {
+    if (progress && !stopped)
+    {
+      int percentage = static_cast<int>(m_done * 100 / paths.size());
+      lock.Leave();
+      bool proceed = progress(percentage);
+      lock.Enter();
+      if (!proceed)
+      {
+        // skip the shares that have not been started
+        stopped = true;
+        m_next = m_shares.size();
+        continue;
+      }
+    }
+    m_changed.wait(lock, 100);
+  }
+
+  m_shares.clear();
+  m_paths = NULL;
+  m_states = NULL;
+  return !stopped;
+}
+
+std::string CFileExistsChecker::GetShareKey(const std::string &path)
+{
+  if (!URIUtils::IsRemote(path))
+    return "";
+
+  // files inside archives are on the share of the archive
+  CURL url(path);
+  while (URIUtils::HasParentInHostname(url))
+    url = CURL(url.GetHostName());
+  return url.GetProtocol() + "://" + url.GetHostName();
+}
+
+void CFileExistsChecker::Run()
+{
+  CSingleLock lock(m_section);
+  while (!m_quit)
+  {
+    if (m_next >= m_shares.size())
+    {
+      m_changed.wait(lock);
+      continue;
+    }
+
+    const Share &share = m_shares[m_next++];
+    m_running++;
+
+    lock.Leave();
+    CheckShare(share);
+    lock.Enter();
+
+    m_running--;
+    m_changed.notifyAll();
+  }
+}
+
+void CFileExistsChecker::CheckShare(const Share &share)
+{
+  const std::vector<std::string> &paths = *m_paths;
+  std::vector<State> &states = *m_states;
+
+  if (!share.root.empty() && !CDirectory::Exists(share.root, false))
+  {
+    CLog::Log(LOGWARNING, "%s: %s is not reachable, skipping its %u files", __FUNCTION__,
+              CURL::GetRedacted(share.root).c_str(), (unsigned int)share.files.size());
+    for (size_t index : share.files)
+      states[index] = Unreachable;
+    m_done += share.files.size();
+    return;
+  }
+
+  std::map<std::string, std::vector<size_t> > folders;
+  for (size_t index : share.files)
+    folders[URIUtils::GetDirectory(paths[index])].push_back(index);
+
+  for (const auto &folder : folders)
+  {
+    // a listing is only cheaper than looking up the files when there are several of them
+    std::set<std::string> names;
+    if (folder.second.size() > 1)
+    {
+      CFileItemList items;
+      if (CDirectory::GetDirectory(folder.first, items, "",
+                                   DIR_FLAG_NO_FILE_DIRS | DIR_FLAG_NO_FILE_INFO | DIR_FLAG_GET_HIDDEN | DIR_FLAG_BYPASS_CACHE))
+      {
+        for (int i = 0; i < items.Size(); i++)
+        {
+          if (!items[i]->m_bIsFolder)
+            names.insert(URIUtils::GetFileName(items[i]->GetPath()));
+        }
+      }
+    }
+
+    // files missing from the listing are looked up, a listing may not show everything
+    for (size_t index : folder.second)
+    {
+      if (names.find(URIUtils::GetFileName(paths[index])) != names.end() ||
+          CFile::Exists(paths[index], false))
+        states[index] = Exists;
+      else
+        states[index] = Missing;
+      m_done++;
+    }
+  }
+}
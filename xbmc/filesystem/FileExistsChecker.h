@@ -0,0 +1,102 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+#include "threads/Thread.h"
+
+namespace XFILE
+{
+  /*!
+   \brief Checks whether a large number of files still exist, as done by the library cleanup.
+
+   Files are grouped by the share they are on: the longest of the given roots
+   that contains them, or else their host. The root of a share is probed once,
+   if it can't be reached none of its files are touched and all of them are
+   reported as unreachable, instead of each file running into its own timeout.
+   Files of reachable shares are looked up in a single listing of their folder,
+   only files missing from the listing are checked one by one. The shares are
+   checked at the same time on a pool of worker threads, one share per thread.
+   */
+  class CFileExistsChecker : public IRunnable
+  {
+  public:
+    enum State
+    {
+      Exists = 0,
+      Missing,
+      Unreachable
+    };
+
+    /*!
+     \param threads number of shares that are checked at the same time
+     */
+    explicit CFileExistsChecker(unsigned int threads);
+    virtual ~CFileExistsChecker();
+
+    /*!
+     \brief Check the given files. Returns when all files are checked.
+     Not to be called from several threads at once.
+     \param paths the files to check
+     \param roots the sources the files are in, probed before their files are checked
+     \param states receives the state of each file, in the order of paths
+     \param progress called regularly on the calling thread with the percentage of checked files,
+     once it returns false the shares that have not been started are skipped
+     \return false if stopped before all files were checked
+     */
+    bool Check(const std::vector<std::string> &paths, const std::vector<std::string> &roots,
+               std::vector<State> &states, const std::function<bool(int)> &progress = nullptr);
+
+    /*!
+     \brief The share of a file outside of the given roots, files with the same key are checked together.
+     */
+    static std::string GetShareKey(const std::string &path);
+
+    virtual void Run() override;
+
+  private:
+    struct Share
+    {
+      std::string root;            ///< probed before the files are checked, empty to not probe
+      std::vector<size_t> files;   ///< index of the files in m_paths
+    };
+
+    void CheckShare(const Share &share);
+
+    std::vector<std::unique_ptr<CThread> > m_workers;
+
+    CCriticalSection m_section;
+    XbmcThreads::ConditionVariable m_changed; // shares were added, started or finished
+    const std::vector<std::string> *m_paths;
+    std::vector<State> *m_states;
+    std::vector<Share> m_shares;
+    size_t m_next;     // first share that has not been started
+    size_t m_running;  // shares being checked
+    std::atomic<size_t> m_done; // files checked
+    bool m_quit;
+  };
+}
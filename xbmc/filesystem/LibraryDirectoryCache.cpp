@@ -0,0 +1,120 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "LibraryDirectoryCache.h"
+#include "FileItem.h"
+#include "GUIPassword.h"
+#include "music/tags/MusicInfoTag.h"
+#include "profiles/ProfilesManager.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+#include "video/VideoInfoTag.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace ANNOUNCEMENT;
+using namespace XFILE;
+
+const size_t CLibraryDirectoryCache::MaxItems;
+const size_t CLibraryDirectoryCache::MaxEntries;
+
+CLibraryDirectoryCache::CLibraryDirectoryCache()
+  : CLibraryResultCache("CLibraryDirectoryCache", MaxEntries)
+{
+}
+
+CLibraryDirectoryCache::~CLibraryDirectoryCache()
+{
+}
+
+bool CLibraryDirectoryCache::GetItems(const std::string &path, AnnouncementFlag library, const MediaType &itemType,
+                                      const std::set<MediaType> &dependsOn, CFileItemList &items, const std::function<bool(CFileItemList&)> &query)
+{
+  if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
+    return query(items);
+
+  std::string key = StringUtils::Format("%i|%s", CProfilesManager::GetInstance().GetCurrentProfileId(), path.c_str());
+  EntryPtr entry = Find(key, library);
+  if (entry)
+  {
+    for (const auto &item : static_cast<const Result&>(*entry).items)
+      items.Add(CFileItemPtr(new CFileItem(*item)));
+    return true;
+  }
+
+  unsigned int generation = GetGeneration(library);
+  int first = items.Size();
+  if (!query(items))
+    return false;
+  if (static_cast<size_t>(items.Size() - first) > MaxItems)
+    return true;
+
+  std::shared_ptr<Result> result(new Result);
+  result->itemType = itemType;
+  result->dependsOn = dependsOn;
+  result->ids.reserve(items.Size() - first);
+  result->items.reserve(items.Size() - first);
+  for (int i = first; i < items.Size(); i++)
+  {
+    result->ids.push_back(GetDatabaseId(*items[i]));
+    result->items.push_back(std::shared_ptr<const CFileItem>(new CFileItem(*items[i])));
+  }
+  Store(key, library, result, generation);
+  return true;
+}
+
+void CLibraryDirectoryCache::Invalidate(AnnouncementFlag library, const MediaType &mediaType, int id /* = -1 */)
+{
+  if (mediaType.empty())
+  {
+    Invalidate(library);
+    return;
+  }
+
+  Drop(library, mediaType, [&mediaType, id](const Entry &entry)
+  {
+    const Result &result = static_cast<const Result&>(entry);
+    if (result.dependsOn.find(mediaType) != result.dependsOn.end())
+      return true;
+    return result.itemType == mediaType &&
+           (id < 0 || std::find(result.ids.begin(), result.ids.end(), id) != result.ids.end());
+  });
+}
+
+void CLibraryDirectoryCache::OnLibraryChanged(AnnouncementFlag library, const char *message, const CVariant &data)
+{
+  // the changed item is either given directly or as "item"
+  const CVariant &item = data.isMember("item") ? data["item"] : data;
+  if ((strcmp(message, "OnUpdate") == 0 || strcmp(message, "OnRemove") == 0) &&
+      item.isMember("type") && item.isMember("id"))
+    Invalidate(library, item["type"].asString(), static_cast<int>(item["id"].asInteger()));
+  else
+    Invalidate(library);
+}
+
+int CLibraryDirectoryCache::GetDatabaseId(const CFileItem &item)
+{
+  if (item.HasVideoInfoTag())
+    return item.GetVideoInfoTag()->m_iDbId;
+  if (item.HasMusicInfoTag())
+    return item.GetMusicInfoTag()->GetDatabaseId();
+  return -1;
+}
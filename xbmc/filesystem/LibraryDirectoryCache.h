@@ -0,0 +1,102 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "LibraryResultCache.h"
+#include "media/MediaType.h"
+
+class CFileItem;
+class CFileItemList;
+
+namespace XFILE
+{
+  /*!
+   \brief Keeps the items of grouping nodes of the music and video library (genres, years, artists, ...).
+
+   These nodes are opened over and over by the library windows, skin widgets
+   and JSON-RPC clients, while their content only changes with the library.
+   The result of a node is kept as the list of ids it returned together with
+   the items, which are copied out on a hit. It is shared by everything that
+   goes through the database directories.
+
+   A result depends on the media types it was built from, e.g. the genres of
+   movies depend on movies only. A library announcement only drops the
+   results that depend on the type of the changed item, or that contain the
+   changed item itself. Announcements without a type drop all results of
+   their library.
+   */
+  class CLibraryDirectoryCache : public CLibraryResultCache
+  {
+  public:
+    CLibraryDirectoryCache();
+    virtual ~CLibraryDirectoryCache();
+
+    /*!
+     \brief Get the items of a node, from the cache or by running the query.
+     Nothing is cached while sources are locked, as the items depend on the unlocked sources then.
+     \param path identifies the node, its filter and sorting, results are kept per profile
+     \param library the library the node belongs to
+     \param itemType the media type of the items
+     \param dependsOn the media types the items are built from
+     \param items receives the items
+     \param query fills the items from the database, only run if the result isn't cached
+     \return the result of the query, true on a hit
+     */
+    bool GetItems(const std::string &path, ANNOUNCEMENT::AnnouncementFlag library, const MediaType &itemType,
+                  const std::set<MediaType> &dependsOn, CFileItemList &items, const std::function<bool(CFileItemList&)> &query);
+
+    /*!
+     \brief Drop the results of a library that are built from or list a media type.
+     \param id only drop the results listing this item, if they list items of mediaType
+     */
+    void Invalidate(ANNOUNCEMENT::AnnouncementFlag library, const MediaType &mediaType, int id = -1);
+    using CLibraryResultCache::Invalidate;
+
+    /*!
+     \brief Largest result that is cached, larger results are loaded the usual way.
+     */
+    static const size_t MaxItems = 5000;
+
+    /*!
+     \brief Number of results that are cached, the least recently used is dropped first.
+     */
+    static const size_t MaxEntries = 128;
+
+  protected:
+    virtual void OnLibraryChanged(ANNOUNCEMENT::AnnouncementFlag library, const char *message, const CVariant &data) override;
+
+  private:
+    struct Result : public Entry
+    {
+      MediaType itemType;
+      std::set<MediaType> dependsOn;
+      std::vector<int> ids;
+      std::vector<std::shared_ptr<const CFileItem> > items;
+    };
+
+    static int GetDatabaseId(const CFileItem &item);
+  };
+}
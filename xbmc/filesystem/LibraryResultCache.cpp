@@ -0,0 +1,169 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "LibraryResultCache.h"
+#include "threads/SingleLock.h"
+#include "utils/log.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+using namespace ANNOUNCEMENT;
+using namespace XFILE;
+
+static CCriticalSection cachesSection;
+static std::vector<CLibraryResultCache*> caches;
+
+CLibraryResultCache::CLibraryResultCache(const std::string &name, size_t maxEntries)
+  : m_name(name),
+    m_maxEntries(maxEntries),
+    m_videoGeneration(0),
+    m_audioGeneration(0),
+    m_uses(0)
+{
+  m_videoStats = m_audioStats = Stats{ 0, 0, 0 };
+
+  CSingleLock lock(cachesSection);
+  caches.push_back(this);
+}
+
+CLibraryResultCache::~CLibraryResultCache()
+{
+  CSingleLock lock(cachesSection);
+  caches.erase(std::remove(caches.begin(), caches.end(), this), caches.end());
+}
+
+void CLibraryResultCache::Invalidate(AnnouncementFlag library)
+{
+  Drop(library, "all", nullptr);
+}
+
+void CLibraryResultCache::InvalidateAll(AnnouncementFlag library)
+{
+  CSingleLock lock(cachesSection);
+  for (CLibraryResultCache *cache : caches)
+    cache->Invalidate(library);
+}
+
+unsigned int CLibraryResultCache::GetGeneration(AnnouncementFlag library) const
+{
+  CSingleLock lock(m_section);
+  return library == AudioLibrary ? m_audioGeneration : m_videoGeneration;
+}
+
+CLibraryResultCache::Stats CLibraryResultCache::GetStats(AnnouncementFlag library) const
+{
+  CSingleLock lock(m_section);
+  return library == AudioLibrary ? m_audioStats : m_videoStats;
+}
+
+CLibraryResultCache::EntryPtr CLibraryResultCache::Find(const std::string &key, AnnouncementFlag library)
+{
+  CSingleLock lock(m_section);
+  Stats &stats = library == AudioLibrary ? m_audioStats : m_videoStats;
+  auto it = m_records.find(key);
+  if (it == m_records.end())
+  {
+    stats.misses++;
+    return EntryPtr();
+  }
+
+  stats.hits++;
+  it->second.lastUsed = ++m_uses;
+  return it->second.entry;
+}
+
+void CLibraryResultCache::Store(const std::string &key, AnnouncementFlag library, const EntryPtr &entry, unsigned int generation)
+{
+  CSingleLock lock(m_section);
+  // the library changed while the query was running
+  if (generation != (library == AudioLibrary ? m_audioGeneration : m_videoGeneration))
+    return;
+
+  auto it = m_records.find(key);
+  if (it != m_records.end())
+  {
+    (it->second.library == AudioLibrary ? m_audioStats : m_videoStats).entries--;
+    m_records.erase(it);
+  }
+  else if (m_records.size() >= m_maxEntries)
+  {
+    auto oldest = m_records.begin();
+    for (auto it = m_records.begin(); it != m_records.end(); ++it)
+    {
+      if (it->second.lastUsed < oldest->second.lastUsed)
+        oldest = it;
+    }
+    (oldest->second.library == AudioLibrary ? m_audioStats : m_videoStats).entries--;
+    m_records.erase(oldest);
+  }
+
+  Record &record = m_records[key];
+  record.library = library;
+  record.entry = entry;
+  record.lastUsed = ++m_uses;
+  (library == AudioLibrary ? m_audioStats : m_videoStats).entries++;
+}
+
+void CLibraryResultCache::Drop(AnnouncementFlag library, const std::string &change, const std::function<bool(const Entry&)> &depends)
+{
+  CSingleLock lock(m_section);
+  if (library == AudioLibrary)
+    m_audioGeneration++;
+  else
+    m_videoGeneration++;
+
+  Stats &stats = library == AudioLibrary ? m_audioStats : m_videoStats;
+  unsigned int dropped = 0;
+  for (auto it = m_records.begin(); it != m_records.end(); )
+  {
+    if (it->second.library == library && (!depends || depends(*it->second.entry)))
+    {
+      it = m_records.erase(it);
+      stats.entries--;
+      dropped++;
+    }
+    else
+      ++it;
+  }
+
+  if (dropped > 0)
+    CLog::Log(LOGDEBUG, "%s: %s changed (%s), dropped %u results, %u hits and %u misses so far", m_name.c_str(),
+              AnnouncementFlagToString(library), change.c_str(), dropped, stats.hits, stats.misses);
+}
+
+void CLibraryResultCache::Announce(AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data)
+{
+  if (flag != VideoLibrary && flag != AudioLibrary)
+    return;
+
+  // these don't change the library
+  if (strcmp(message, "OnScanStarted") == 0 || strcmp(message, "OnCleanStarted") == 0 ||
+      strcmp(message, "OnExport") == 0)
+    return;
+
+  OnLibraryChanged(flag, message, data);
+}
+
+void CLibraryResultCache::OnLibraryChanged(AnnouncementFlag library, const char *message, const CVariant &data)
+{
+  Invalidate(library);
+}
@@ -0,0 +1,131 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "interfaces/IAnnouncer.h"
+#include "threads/CriticalSection.h"
+
+namespace XFILE
+{
+  /*!
+   \brief Base of the caches that keep results of library queries until the library changes.
+
+   Every result belongs to the video or the audio library. Each change of a
+   library increments its generation and drops its results, a result is only
+   kept if the generation didn't change while its query was running. At most
+   a fixed number of results is kept, the least recently used is dropped first.
+
+   The results are dropped on the library announcements and when the
+   directory cache of a library is deleted, see InvalidateAll().
+   */
+  class CLibraryResultCache : public ANNOUNCEMENT::IAnnouncer
+  {
+  public:
+    struct Stats
+    {
+      unsigned int hits;
+      unsigned int misses;
+      unsigned int entries;
+    };
+
+    virtual ~CLibraryResultCache();
+
+    /*!
+     \brief Drop all results of a library.
+     */
+    void Invalidate(ANNOUNCEMENT::AnnouncementFlag library);
+
+    /*!
+     \brief Drop all results of a library from every cache.
+     */
+    static void InvalidateAll(ANNOUNCEMENT::AnnouncementFlag library);
+
+    /*!
+     \brief Number of changes of a library so far, read before the query is run and passed to Store().
+     */
+    unsigned int GetGeneration(ANNOUNCEMENT::AnnouncementFlag library) const;
+
+    Stats GetStats(ANNOUNCEMENT::AnnouncementFlag library) const;
+
+    virtual void Announce(ANNOUNCEMENT::AnnouncementFlag flag, const char *sender, const char *message, const CVariant &data) override;
+
+  protected:
+    /*!
+     \brief A result, it is not changed anymore once it is stored.
+     */
+    struct Entry
+    {
+      virtual ~Entry() {}
+    };
+    typedef std::shared_ptr<const Entry> EntryPtr;
+
+    /*!
+     \param name used in log messages
+     \param maxEntries number of results that are kept
+     */
+    CLibraryResultCache(const std::string &name, size_t maxEntries);
+
+    /*!
+     \brief Get a result, counted as hit or miss of its library.
+     \return the result or nullptr if it isn't kept
+     */
+    EntryPtr Find(const std::string &key, ANNOUNCEMENT::AnnouncementFlag library);
+
+    /*!
+     \brief Keep a result, unless its library changed since generation was read by GetGeneration().
+     */
+    void Store(const std::string &key, ANNOUNCEMENT::AnnouncementFlag library, const EntryPtr &entry, unsigned int generation);
+
+    /*!
+     \brief Drop the results of a library that depend on a change.
+     \param change describes the change for the log
+     \param depends returns whether a result depends on the change, all results are dropped if empty
+     */
+    void Drop(ANNOUNCEMENT::AnnouncementFlag library, const std::string &change, const std::function<bool(const Entry&)> &depends);
+
+    /*!
+     \brief Called for the announcements that change a library, drops all its results.
+     */
+    virtual void OnLibraryChanged(ANNOUNCEMENT::AnnouncementFlag library, const char *message, const CVariant &data);
+
+  private:
+    struct Record
+    {
+      ANNOUNCEMENT::AnnouncementFlag library;
+      EntryPtr entry;
+      unsigned int lastUsed;
+    };
+
+    const std::string m_name;
+    const size_t m_maxEntries;
+    mutable CCriticalSection m_section;
+    std::map<std::string, Record> m_records;
+    unsigned int m_videoGeneration;
+    unsigned int m_audioGeneration;
+    unsigned int m_uses;
+    Stats m_videoStats;
+    Stats m_audioStats;
+  };
+}
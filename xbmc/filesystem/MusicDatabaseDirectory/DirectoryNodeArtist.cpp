@@ -20,6 +20,8 @@
 
 #include "DirectoryNodeArtist.h"
 #include "QueryParams.h"
+#include "ServiceBroker.h"
+#include "filesystem/LibraryDirectoryCache.h"
 #include "music/MusicDatabase.h"
 #include "settings/Settings.h"
 
@@ -48,16 +50,24 @@ std::string CDirectoryNodeArtist::GetLocalizedName() const
 
 bool CDirectoryNodeArtist::GetContent(CFileItemList& items) const
 {
-  CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
-    return false;
-
   CQueryParams params;
   CollectQueryParams(params);
 
-  bool bSuccess = musicdatabase.GetArtistsNav(BuildPath(), items, !CSettings::GetInstance().GetBool(CSettings::SETTING_MUSICLIBRARY_SHOWCOMPILATIONARTISTS), params.GetGenreId());
+  std::string path = BuildPath();
+  bool albumArtistsOnly = !CSettings::GetInstance().GetBool(CSettings::SETTING_MUSICLIBRARY_SHOWCOMPILATIONARTISTS);
+  int idGenre = params.GetGenreId();
+  return CServiceBroker::GetLibraryDirectoryCache().GetItems(path + (albumArtistsOnly ? "|albumartists" : ""), ANNOUNCEMENT::AudioLibrary,
+    MediaTypeArtist, { MediaTypeSong, MediaTypeAlbum }, items,
+    [&path, albumArtistsOnly, idGenre](CFileItemList &result)
+    {
+      CMusicDatabase musicdatabase;
+      if (!musicdatabase.Open())
+        return false;
+
+      bool bSuccess = musicdatabase.GetArtistsNav(path, result, albumArtistsOnly, idGenre);
 
-  musicdatabase.Close();
+      musicdatabase.Close();
 
-  return bSuccess;
+      return bSuccess;
+    });
 }
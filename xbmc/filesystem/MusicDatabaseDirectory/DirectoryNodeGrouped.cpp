@@ -19,6 +19,8 @@
  */
 
 #include "DirectoryNodeGrouped.h"
+#include "ServiceBroker.h"
+#include "filesystem/LibraryDirectoryCache.h"
 #include "music/MusicDatabase.h"
 
 using namespace XFILE::MUSICDATABASEDIRECTORY;
@@ -45,11 +47,18 @@ std::string CDirectoryNodeGrouped::GetLocalizedName() const
 
 bool CDirectoryNodeGrouped::GetContent(CFileItemList& items) const
 {
-  CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
-    return false;
+  std::string path = BuildPath();
+  std::string itemType = GetContentType();
+  return CServiceBroker::GetLibraryDirectoryCache().GetItems(path, ANNOUNCEMENT::AudioLibrary,
+    itemType, { MediaTypeSong, MediaTypeAlbum, MediaTypeArtist }, items,
+    [&path, &itemType](CFileItemList &result)
+    {
+      CMusicDatabase musicdatabase;
+      if (!musicdatabase.Open())
+        return false;
 
-  return musicdatabase.GetItems(BuildPath(), GetContentType(), items);
+      return musicdatabase.GetItems(path, itemType, result);
+    });
 }
 
 std::string CDirectoryNodeGrouped::GetContentType() const
@@ -22,16 +22,24 @@
 
 #include "SmartPlaylistDirectory.h"
 #include "FileItem.h"
+#include "ServiceBroker.h"
 #include "filesystem/Directory.h"
 #include "filesystem/File.h"
 #include "filesystem/FileDirectoryFactory.h"
 #include "music/MusicDatabase.h"
+#include "music/tags/MusicInfoTag.h"
 #include "playlists/SmartPlayList.h"
+#include "playlists/SmartPlaylistCache.h"
 #include "settings/Settings.h"
+#include "threads/SystemClock.h"
+#include "URL.h"
+#include "utils/DatabaseUtils.h"
+#include "utils/log.h"
 #include "utils/SortUtils.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "video/VideoDatabase.h"
+#include "video/VideoInfoTag.h"
 
 #define PROPERTY_PATH_DB            "path.db"
 #define PROPERTY_SORT_ORDER         "sort.order"
@@ -41,6 +49,95 @@
 
 namespace XFILE
 {
+  static int GetDatabaseId(const CFileItem &item, const MediaType &mediaType)
+  {
+    if (item.HasVideoInfoTag() && item.GetVideoInfoTag()->m_type == mediaType)
+      return item.GetVideoInfoTag()->m_iDbId;
+    if (item.HasMusicInfoTag() && item.GetMusicInfoTag()->GetType() == mediaType)
+      return item.GetMusicInfoTag()->GetDatabaseId();
+    return -1;
+  }
+
+  /* Get the items of a playlist from the database. The ids of the items are
+   * remembered, until the library changes the next loads fetch these items
+   * from the url without the playlist options, so the rules aren't evaluated
+   * again. */
+  template<class TDatabase>
+  static bool GetItems(TDatabase &db, const CSmartPlaylist &playlist, const MediaType &mediaType, ANNOUNCEMENT::AnnouncementFlag library,
+                       const std::string &url, CFileItemList &items, const SortDescription &sorting)
+  {
+    CSmartPlaylistCache &cache = CServiceBroker::GetSmartPlaylistCache();
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    int first = items.Size();
+
+    // the rules are part of the key, as they may depend on the current date or on other playlists
+    std::set<std::string> referencedPlaylists;
+    std::string where = playlist.GetWhereClause(db, referencedPlaylists);
+    std::string idField = DatabaseUtils::GetField(FieldId, mediaType, DatabaseQueryPartWhere);
+    bool cacheable = !idField.empty() && sorting.sortBy != SortByRandom;
+    std::string key = StringUtils::Format("%s|%i|%i|%i|%i|%i|%s", url.c_str(), (int)sorting.sortBy, (int)sorting.sortOrder,
+                                          (int)sorting.sortAttributes, sorting.limitStart, sorting.limitEnd, where.c_str());
+
+    std::vector<int> ids;
+    if (cacheable && cache.Get(key, library, ids))
+    {
+      CURL playlistUrl(url);
+      CURL cachedUrl(url);
+      cachedUrl.RemoveOption("xsp");
+      cachedUrl.RemoveOption("filter");
+
+      CDatabase::Filter filter(db.PrepareSearchCondition(idField, ids));
+      SortDescription sortingAll(sorting);
+      sortingAll.limitStart = 0;
+      sortingAll.limitEnd = -1;
+      bool success = db.GetItems(cachedUrl.Get(), items, filter, sortingAll);
+
+      // the items keep the playlist options in their paths, as if the rules had been applied
+      for (int i = first; i < items.Size(); i++)
+      {
+        CURL itemUrl(items[i]->GetPath());
+        if (itemUrl.GetProtocol() != playlistUrl.GetProtocol())
+          continue;
+        for (const char *option : { "xsp", "filter" })
+        {
+          if (playlistUrl.HasOption(option))
+            itemUrl.SetOption(option, playlistUrl.GetOption(option));
+        }
+        items[i]->SetPath(itemUrl.Get());
+      }
+      CLog::Log(LOGDEBUG, "CSmartPlaylistDirectory: %s loaded %d cached items in %u ms", playlist.GetName().c_str(),
+                items.Size() - first, XbmcThreads::SystemClockMillis() - start);
+      return success;
+    }
+
+    unsigned int generation = cache.GetGeneration(library);
+    CDatabase::Filter filter;
+    if (!db.GetItems(url, items, filter, sorting))
+      return false;
+
+    if (CLog::IsLogLevelLogged(LOGDEBUG))
+    {
+      CLog::Log(LOGDEBUG, "CSmartPlaylistDirectory: %s matched %d items in %u ms with %s", playlist.GetName().c_str(),
+                items.Size() - first, XbmcThreads::SystemClockMillis() - start, where.c_str());
+      if (!idField.empty() && !where.empty())
+        db.LogQueryPlan("SELECT " + idField + " FROM " + idField.substr(0, idField.find('.')) + " WHERE " + where);
+    }
+
+    if (cacheable)
+    {
+      for (int i = first; i < items.Size(); i++)
+      {
+        int id = GetDatabaseId(*items[i], mediaType);
+        // not a list of the items themselves
+        if (id <= 0)
+          return true;
+        ids.push_back(id);
+      }
+      cache.Set(key, library, ids, generation);
+    }
+    return true;
+  }
+
   CSmartPlaylistDirectory::CSmartPlaylistDirectory()
   {
   }
@@ -141,8 +238,8 @@ namespace XFILE
         else
           videoUrl.RemoveOption(option);
         
-        CDatabase::Filter dbfilter;
-        success = db.GetItems(videoUrl.ToString(), items, dbfilter, sorting);
+        success = GetItems(db, playlist, isGrouped ? MediaTypeNone : mediaType, ANNOUNCEMENT::VideoLibrary,
+                           videoUrl.ToString(), items, sorting);
         db.Close();
 
         // if we retrieve a list of episodes and we didn't receive
@@ -201,8 +298,8 @@ namespace XFILE
         else
           musicUrl.RemoveOption(option);
 
-        CDatabase::Filter dbfilter;
-        success = db.GetItems(musicUrl.ToString(), items, dbfilter, sorting);
+        success = GetItems(db, plist, isGrouped ? MediaTypeNone : mediaType, ANNOUNCEMENT::AudioLibrary,
+                           musicUrl.ToString(), items, sorting);
         db.Close();
 
         items.SetProperty(PROPERTY_PATH_DB, musicUrl.ToString());
@@ -257,8 +354,8 @@ namespace XFILE
           videoUrl.RemoveOption(option);
         
         CFileItemList items2;
-        CDatabase::Filter dbfilter;
-        success2 = db.GetItems(videoUrl.ToString(), items2, dbfilter, sorting);
+        success2 = GetItems(db, mvidPlaylist, isGrouped ? MediaTypeNone : MediaTypeMusicVideo, ANNOUNCEMENT::VideoLibrary,
+                            videoUrl.ToString(), items2, sorting);
 
         db.Close();
         if (items.Size() <= 0)
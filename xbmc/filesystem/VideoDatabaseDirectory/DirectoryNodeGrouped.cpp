@@ -20,6 +20,9 @@
 
 #include "DirectoryNodeGrouped.h"
 #include "QueryParams.h"
+#include "ServiceBroker.h"
+#include "filesystem/LibraryDirectoryCache.h"
+#include "settings/Settings.h"
 #include "video/VideoDatabase.h"
 #include "video/VideoDbUrl.h"
 
@@ -58,10 +61,6 @@ std::string CDirectoryNodeGrouped::GetLocalizedName() const
 
 bool CDirectoryNodeGrouped::GetContent(CFileItemList& items) const
 {
-  CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
-    return false;
-
   CQueryParams params;
   CollectQueryParams(params);
 
@@ -74,7 +73,33 @@ bool CDirectoryNodeGrouped::GetContent(CFileItemList& items) const
   if (!videoUrl.FromString(BuildPath()))
     return false;
 
-  return videodatabase.GetItems(videoUrl.ToString(), (VIDEODB_CONTENT_TYPE)params.GetContentType(), itemType, items);
+  // the items are built from the videos of the content type, and show their watched state
+  VIDEODB_CONTENT_TYPE contentType = (VIDEODB_CONTENT_TYPE)params.GetContentType();
+  std::set<MediaType> dependsOn;
+  if (contentType == VIDEODB_CONTENT_MOVIES)
+    dependsOn = { MediaTypeMovie };
+  else if (contentType == VIDEODB_CONTENT_TVSHOWS)
+    dependsOn = { MediaTypeTvShow, MediaTypeSeason, MediaTypeEpisode };
+  else if (contentType == VIDEODB_CONTENT_MUSICVIDEOS)
+    dependsOn = { MediaTypeMusicVideo };
+  else
+    dependsOn = { MediaTypeMovie, MediaTypeTvShow, MediaTypeSeason, MediaTypeEpisode, MediaTypeMusicVideo };
+
+  std::string url = videoUrl.ToString();
+  std::string key = url;
+  if (itemType == "sets" && !CSettings::GetInstance().GetBool(CSettings::SETTING_VIDEOLIBRARY_GROUPSINGLEITEMSETS))
+    key += "|ignoresingle";
+
+  return CServiceBroker::GetLibraryDirectoryCache().GetItems(key, ANNOUNCEMENT::VideoLibrary,
+    itemType == "sets" ? MediaTypeVideoCollection : itemType, dependsOn, items,
+    [&url, contentType, &itemType](CFileItemList &result)
+    {
+      CVideoDatabase videodatabase;
+      if (!videodatabase.Open())
+        return false;
+
+      return videodatabase.GetItems(url, contentType, itemType, result);
+    });
 }
 
 std::string CDirectoryNodeGrouped::GetContentType() const
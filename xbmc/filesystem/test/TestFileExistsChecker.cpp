@@ -0,0 +1,101 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "URL.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "filesystem/FileExistsChecker.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+#define TEST_FOLDER "special://temp/fileexistschecker/"
+
+TEST(TestFileExistsChecker, GetShareKey)
+{
+  EXPECT_EQ("", CFileExistsChecker::GetShareKey("/movies/a.mkv"));
+  EXPECT_EQ("smb://server", CFileExistsChecker::GetShareKey("smb://server/movies/a.mkv"));
+  EXPECT_EQ("nfs://server", CFileExistsChecker::GetShareKey("nfs://server/export/b.mkv"));
+  EXPECT_EQ("smb://server", CFileExistsChecker::GetShareKey(
+    URIUtils::CreateArchivePath("zip", CURL("smb://server/movies/c.zip"), "c.mkv").Get()));
+}
+
+TEST(TestFileExistsChecker, Check)
+{
+  ASSERT_TRUE(CDirectory::Create(TEST_FOLDER));
+  ASSERT_TRUE(CDirectory::Create(TEST_FOLDER "a/"));
+  ASSERT_TRUE(CDirectory::Create(TEST_FOLDER "b/"));
+
+  std::vector<std::string> paths;
+  std::vector<CFileExistsChecker::State> expected;
+  for (int i = 0; i < 20; i++)
+  {
+    // every third file of each folder is missing
+    std::string path = StringUtils::Format(TEST_FOLDER "%s/file%02d.mkv", i % 2 ? "a" : "b", i);
+    paths.push_back(path);
+    if (i % 3 == 0)
+      expected.push_back(CFileExistsChecker::Missing);
+    else
+    {
+      CFile file;
+      ASSERT_TRUE(file.OpenForWrite(path, true));
+      file.Close();
+      expected.push_back(CFileExistsChecker::Exists);
+    }
+  }
+  // a single file in a folder, and a folder that is gone
+  paths.push_back(TEST_FOLDER "single.mkv");
+  expected.push_back(CFileExistsChecker::Missing);
+  paths.push_back(TEST_FOLDER "c/file.mkv");
+  expected.push_back(CFileExistsChecker::Missing);
+  // files of a source that can't be reached are left alone
+  paths.push_back(TEST_FOLDER "offline/d/file1.mkv");
+  expected.push_back(CFileExistsChecker::Unreachable);
+  paths.push_back(TEST_FOLDER "offline/d/file2.mkv");
+  expected.push_back(CFileExistsChecker::Unreachable);
+
+  std::vector<std::string> roots = { TEST_FOLDER, TEST_FOLDER "offline/" };
+  std::vector<CFileExistsChecker::State> states;
+  CFileExistsChecker checker(4);
+  int lastProgress = -1;
+  EXPECT_TRUE(checker.Check(paths, roots, states, [&lastProgress](int percentage)
+  {
+    EXPECT_LE(lastProgress, percentage);
+    lastProgress = percentage;
+    return true;
+  }));
+  EXPECT_EQ(expected, states);
+
+  // the checker can be used again
+  EXPECT_TRUE(checker.Check(paths, roots, states));
+  EXPECT_EQ(expected, states);
+
+  for (size_t i = 0; i < paths.size(); i++)
+  {
+    if (expected[i] == CFileExistsChecker::Exists)
+      CFile::Delete(paths[i]);
+  }
+  CDirectory::Remove(TEST_FOLDER "a/");
+  CDirectory::Remove(TEST_FOLDER "b/");
+  CDirectory::Remove(TEST_FOLDER);
+}
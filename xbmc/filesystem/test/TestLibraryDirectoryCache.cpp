@@ -0,0 +1,160 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "filesystem/LibraryDirectoryCache.h"
+#include "utils/StringUtils.h"
+#include "utils/Variant.h"
+#include "video/VideoInfoTag.h"
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+namespace
+{
+
+/* Counts the queries and returns three sets with ids 1 to 3. */
+class CSetsQuery
+{
+public:
+  CSetsQuery() : m_queries(0) {}
+
+  bool operator()(CFileItemList &items)
+  {
+    m_queries++;
+    for (int id = 1; id <= 3; id++)
+    {
+      CFileItemPtr item(new CFileItem(StringUtils::Format("Set %i", id)));
+      item->SetPath(StringUtils::Format("videodb://movies/sets/%i/", id));
+      item->GetVideoInfoTag()->m_iDbId = id;
+      item->GetVideoInfoTag()->m_type = MediaTypeVideoCollection;
+      items.Add(item);
+    }
+    return true;
+  }
+
+  int m_queries;
+};
+
+bool GetSets(CLibraryDirectoryCache &cache, CSetsQuery &query, CFileItemList &items)
+{
+  items.Clear();
+  return cache.GetItems("videodb://movies/sets/", ANNOUNCEMENT::VideoLibrary, MediaTypeVideoCollection,
+                        { MediaTypeMovie }, items, std::ref(query));
+}
+
+}
+
+TEST(TestLibraryDirectoryCache, Hit)
+{
+  CLibraryDirectoryCache cache;
+  CSetsQuery query;
+  CFileItemList items;
+
+  EXPECT_TRUE(GetSets(cache, query, items));
+  EXPECT_TRUE(GetSets(cache, query, items));
+  EXPECT_EQ(1, query.m_queries);
+  ASSERT_EQ(3, items.Size());
+  EXPECT_EQ("Set 2", items[1]->GetLabel());
+  EXPECT_EQ(2, items[1]->GetVideoInfoTag()->m_iDbId);
+
+  // changing a returned item doesn't change the cache
+  items[1]->SetLabel("Changed");
+  EXPECT_TRUE(GetSets(cache, query, items));
+  EXPECT_EQ("Set 2", items[1]->GetLabel());
+
+  CLibraryDirectoryCache::Stats stats = cache.GetStats(ANNOUNCEMENT::VideoLibrary);
+  EXPECT_EQ(2u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.entries);
+  EXPECT_EQ(0u, cache.GetStats(ANNOUNCEMENT::AudioLibrary).hits);
+}
+
+TEST(TestLibraryDirectoryCache, Announce)
+{
+  CLibraryDirectoryCache cache;
+  CSetsQuery query;
+  CFileItemList items;
+  GetSets(cache, query, items);
+
+  CVariant data;
+  // other libraries and media types the sets don't depend on
+  data["type"] = MediaTypeEpisode;
+  data["id"] = 1;
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnUpdate", data);
+  data["type"] = MediaTypeMovie;
+  cache.Announce(ANNOUNCEMENT::AudioLibrary, "xbmc", "OnUpdate", data);
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnScanStarted", CVariant());
+  // a set that isn't listed
+  data["type"] = MediaTypeVideoCollection;
+  data["id"] = 7;
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnRemove", data);
+  GetSets(cache, query, items);
+  EXPECT_EQ(1, query.m_queries);
+
+  // a listed set
+  data["id"] = 2;
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnRemove", data);
+  GetSets(cache, query, items);
+  EXPECT_EQ(2, query.m_queries);
+
+  // a movie, given as item
+  CVariant item;
+  item["item"]["type"] = MediaTypeMovie;
+  item["item"]["id"] = 5;
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnUpdate", item);
+  GetSets(cache, query, items);
+  EXPECT_EQ(3, query.m_queries);
+
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnCleanFinished", CVariant());
+  GetSets(cache, query, items);
+  EXPECT_EQ(4, query.m_queries);
+
+  cache.Invalidate(ANNOUNCEMENT::VideoLibrary);
+  GetSets(cache, query, items);
+  EXPECT_EQ(5, query.m_queries);
+  EXPECT_EQ(1u, cache.GetStats(ANNOUNCEMENT::VideoLibrary).entries);
+}
+
+TEST(TestLibraryDirectoryCache, Limits)
+{
+  CLibraryDirectoryCache cache;
+  CFileItemList items;
+
+  // failed queries aren't cached
+  int queries = 0;
+  auto failing = [&queries](CFileItemList &result) { queries++; return false; };
+  EXPECT_FALSE(cache.GetItems("videodb://movies/genres/", ANNOUNCEMENT::VideoLibrary, "genres", { MediaTypeMovie }, items, failing));
+  EXPECT_FALSE(cache.GetItems("videodb://movies/genres/", ANNOUNCEMENT::VideoLibrary, "genres", { MediaTypeMovie }, items, failing));
+  EXPECT_EQ(2, queries);
+
+  // the least recently used result is dropped
+  for (size_t i = 0; i <= CLibraryDirectoryCache::MaxEntries; i++)
+  {
+    CSetsQuery query;
+    GetSets(cache, query, items);
+    items.Clear();
+    cache.GetItems(StringUtils::Format("musicdb://genres/?id=%u", static_cast<unsigned int>(i)), ANNOUNCEMENT::AudioLibrary,
+                   "genres", { MediaTypeSong }, items, std::ref(query));
+  }
+  EXPECT_EQ(CLibraryDirectoryCache::MaxEntries - 1, cache.GetStats(ANNOUNCEMENT::AudioLibrary).entries);
+  EXPECT_EQ(1u, cache.GetStats(ANNOUNCEMENT::VideoLibrary).entries);
+}
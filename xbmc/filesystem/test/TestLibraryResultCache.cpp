@@ -0,0 +1,155 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/LibraryResultCache.h"
+#include "playlists/SmartPlaylistCache.h"
+#include "utils/Variant.h"
+
+#include "gtest/gtest.h"
+
+using namespace XFILE;
+
+namespace
+{
+
+/* Keeps a number per key. */
+class CNumberCache : public CLibraryResultCache
+{
+public:
+  CNumberCache() : CLibraryResultCache("CNumberCache", 2) {}
+
+  bool Get(const std::string &key, ANNOUNCEMENT::AnnouncementFlag library, int &number)
+  {
+    EntryPtr entry = Find(key, library);
+    if (!entry)
+      return false;
+    number = static_cast<const Number&>(*entry).number;
+    return true;
+  }
+
+  void Set(const std::string &key, ANNOUNCEMENT::AnnouncementFlag library, int number, unsigned int generation)
+  {
+    std::shared_ptr<Number> entry(new Number);
+    entry->number = number;
+    Store(key, library, entry, generation);
+  }
+
+  /* Drops the odd numbers. */
+  void DropOdd(ANNOUNCEMENT::AnnouncementFlag library)
+  {
+    Drop(library, "odd", [](const Entry &entry) { return static_cast<const Number&>(entry).number % 2 != 0; });
+  }
+
+private:
+  struct Number : public Entry
+  {
+    int number;
+  };
+};
+
+}
+
+TEST(TestLibraryResultCache, Generation)
+{
+  CNumberCache cache;
+  int number = 0;
+
+  unsigned int generation = cache.GetGeneration(ANNOUNCEMENT::VideoLibrary);
+  cache.Set("a", ANNOUNCEMENT::VideoLibrary, 1, generation);
+  EXPECT_TRUE(cache.Get("a", ANNOUNCEMENT::VideoLibrary, number));
+  EXPECT_EQ(1, number);
+
+  // the library changed while the query was running
+  generation = cache.GetGeneration(ANNOUNCEMENT::VideoLibrary);
+  cache.Invalidate(ANNOUNCEMENT::VideoLibrary);
+  cache.Set("a", ANNOUNCEMENT::VideoLibrary, 2, generation);
+  EXPECT_FALSE(cache.Get("a", ANNOUNCEMENT::VideoLibrary, number));
+
+  // the other library isn't affected
+  cache.Set("b", ANNOUNCEMENT::AudioLibrary, 3, cache.GetGeneration(ANNOUNCEMENT::AudioLibrary));
+  cache.Invalidate(ANNOUNCEMENT::VideoLibrary);
+  EXPECT_TRUE(cache.Get("b", ANNOUNCEMENT::AudioLibrary, number));
+
+  CLibraryResultCache::Stats stats = cache.GetStats(ANNOUNCEMENT::VideoLibrary);
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(0u, stats.entries);
+  EXPECT_EQ(1u, cache.GetStats(ANNOUNCEMENT::AudioLibrary).entries);
+}
+
+TEST(TestLibraryResultCache, Drop)
+{
+  CNumberCache cache;
+  int number = 0;
+  unsigned int generation = cache.GetGeneration(ANNOUNCEMENT::AudioLibrary);
+  cache.Set("odd", ANNOUNCEMENT::AudioLibrary, 1, generation);
+  cache.Set("even", ANNOUNCEMENT::AudioLibrary, 2, generation);
+
+  cache.DropOdd(ANNOUNCEMENT::AudioLibrary);
+  EXPECT_FALSE(cache.Get("odd", ANNOUNCEMENT::AudioLibrary, number));
+  EXPECT_TRUE(cache.Get("even", ANNOUNCEMENT::AudioLibrary, number));
+
+  // the least recently used is dropped
+  generation = cache.GetGeneration(ANNOUNCEMENT::AudioLibrary);
+  cache.Set("a", ANNOUNCEMENT::AudioLibrary, 4, generation);
+  cache.Get("even", ANNOUNCEMENT::AudioLibrary, number);
+  cache.Set("b", ANNOUNCEMENT::AudioLibrary, 6, generation);
+  EXPECT_FALSE(cache.Get("a", ANNOUNCEMENT::AudioLibrary, number));
+  EXPECT_TRUE(cache.Get("even", ANNOUNCEMENT::AudioLibrary, number));
+  EXPECT_TRUE(cache.Get("b", ANNOUNCEMENT::AudioLibrary, number));
+  EXPECT_EQ(2u, cache.GetStats(ANNOUNCEMENT::AudioLibrary).entries);
+}
+
+TEST(TestLibraryResultCache, Announce)
+{
+  CNumberCache cache;
+  int number = 0;
+  cache.Set("a", ANNOUNCEMENT::VideoLibrary, 1, cache.GetGeneration(ANNOUNCEMENT::VideoLibrary));
+
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnScanStarted", CVariant());
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnCleanStarted", CVariant());
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnExport", CVariant());
+  cache.Announce(ANNOUNCEMENT::Player, "xbmc", "OnPlay", CVariant());
+  cache.Announce(ANNOUNCEMENT::AudioLibrary, "xbmc", "OnScanFinished", CVariant());
+  EXPECT_TRUE(cache.Get("a", ANNOUNCEMENT::VideoLibrary, number));
+
+  cache.Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnScanFinished", CVariant());
+  EXPECT_FALSE(cache.Get("a", ANNOUNCEMENT::VideoLibrary, number));
+}
+
+TEST(TestLibraryResultCache, InvalidateAll)
+{
+  CNumberCache numbers;
+  CSmartPlaylistCache playlists;
+  int number = 0;
+  std::vector<int> ids;
+  numbers.Set("a", ANNOUNCEMENT::AudioLibrary, 1, numbers.GetGeneration(ANNOUNCEMENT::AudioLibrary));
+  playlists.Set("special://profile/playlists/music/a.xsp", ANNOUNCEMENT::AudioLibrary, { 1, 2 },
+                playlists.GetGeneration(ANNOUNCEMENT::AudioLibrary));
+
+  CLibraryResultCache::InvalidateAll(ANNOUNCEMENT::VideoLibrary);
+  EXPECT_TRUE(numbers.Get("a", ANNOUNCEMENT::AudioLibrary, number));
+  EXPECT_TRUE(playlists.Get("special://profile/playlists/music/a.xsp", ANNOUNCEMENT::AudioLibrary, ids));
+  EXPECT_EQ(2u, ids.size());
+
+  CLibraryResultCache::InvalidateAll(ANNOUNCEMENT::AudioLibrary);
+  EXPECT_FALSE(numbers.Get("a", ANNOUNCEMENT::AudioLibrary, number));
+  EXPECT_FALSE(playlists.Get("special://profile/playlists/music/a.xsp", ANNOUNCEMENT::AudioLibrary, ids));
+}
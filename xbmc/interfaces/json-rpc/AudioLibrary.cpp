@@ -21,6 +21,7 @@
 #include "AudioLibrary.h"
 #include "music/MusicDatabase.h"
 #include "FileItem.h"
+#include "ServiceBroker.h"
 #include "Util.h"
 #include "utils/SortUtils.h"
 #include "utils/StringUtils.h"
@@ -33,6 +34,7 @@
 #include "music/Artist.h"
 #include "messaging/ApplicationMessenger.h"
 #include "filesystem/Directory.h"
+#include "filesystem/LibraryDirectoryCache.h"
 #include "settings/Settings.h"
 #include "settings/AdvancedSettings.h"
 
@@ -50,6 +52,29 @@ JSONRPC_STATUS CAudioLibrary::GetProperties(const std::string &method, ITranspor
     CVariant property;
     if (propertyName == "missingartistid")
       property = (int)BLANKARTIST_ID;
+    else if (propertyName == "librarycache")
+    {
+      CLibraryDirectoryCache::Stats stats = CServiceBroker::GetLibraryDirectoryCache().GetStats(ANNOUNCEMENT::AudioLibrary);
+      property["hits"] = stats.hits;
+      property["misses"] = stats.misses;
+      property["hitrate"] = stats.hits + stats.misses > 0 ? (double)stats.hits / (stats.hits + stats.misses) : 0.0;
+      property["entries"] = stats.entries;
+    }
+    else if (propertyName == "connectionpool")
+    {
+      CDatabaseConnectionPool::Stats stats = CMusicDatabase().GetConnectionPoolStats();
+      property["size"] = stats.size;
+      property["inuse"] = stats.inUse;
+      property["idle"] = stats.idle;
+      property["peak"] = stats.peak;
+      property["utilisation"] = stats.size > 0 ? (double)stats.inUse / stats.size : 0.0;
+      property["acquired"] = stats.acquired;
+      property["reused"] = stats.reused;
+      property["waited"] = stats.waited;
+      property["averagewait"] = stats.waited > 0 ? (double)stats.waitTime / stats.waited : 0.0;
+      property["maxwait"] = stats.maxWait;
+      property["healthfailures"] = stats.healthFailures;
+    }
 
     properties[propertyName] = property;
   }
@@ -61,7 +86,7 @@ JSONRPC_STATUS CAudioLibrary::GetProperties(const std::string &method, ITranspor
 JSONRPC_STATUS CAudioLibrary::GetArtists(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   CMusicDbUrl musicUrl;
@@ -146,7 +171,7 @@ JSONRPC_STATUS CAudioLibrary::GetArtistDetails(const std::string &method, ITrans
     return InternalError;
 
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   musicUrl.AddOption("artistid", artistID);
@@ -174,7 +199,7 @@ JSONRPC_STATUS CAudioLibrary::GetArtistDetails(const std::string &method, ITrans
 JSONRPC_STATUS CAudioLibrary::GetAlbums(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   CMusicDbUrl musicUrl;
@@ -255,7 +280,7 @@ JSONRPC_STATUS CAudioLibrary::GetAlbumDetails(const std::string &method, ITransp
   int albumID = (int)parameterObject["albumid"].asInteger();
 
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   CAlbum album;
@@ -283,7 +308,7 @@ JSONRPC_STATUS CAudioLibrary::GetAlbumDetails(const std::string &method, ITransp
 JSONRPC_STATUS CAudioLibrary::GetSongs(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   CMusicDbUrl musicUrl;
@@ -367,7 +392,7 @@ JSONRPC_STATUS CAudioLibrary::GetSongDetails(const std::string &method, ITranspo
   int idSong = (int)parameterObject["songid"].asInteger();
 
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   CSong song;
@@ -390,7 +415,7 @@ JSONRPC_STATUS CAudioLibrary::GetSongDetails(const std::string &method, ITranspo
 JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedAlbums(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   VECALBUMS albums;
@@ -418,7 +443,7 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedAlbums(const std::string &method,
 JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedSongs(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   int amount = (int)parameterObject["albumlimit"].asInteger();
@@ -440,7 +465,7 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyAddedSongs(const std::string &method, I
 JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedAlbums(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   VECALBUMS albums;
@@ -468,7 +493,7 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedAlbums(const std::string &method,
 JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedSongs(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -486,7 +511,7 @@ JSONRPC_STATUS CAudioLibrary::GetRecentlyPlayedSongs(const std::string &method,
 JSONRPC_STATUS CAudioLibrary::GetGenres(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -504,7 +529,7 @@ JSONRPC_STATUS CAudioLibrary::GetGenres(const std::string &method, ITransportLay
 JSONRPC_STATUS CAudioLibrary::GetRoles(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CMusicDatabase musicdatabase;
-  if (!musicdatabase.Open())
+  if (!musicdatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -519,6 +544,54 @@ JSONRPC_STATUS CAudioLibrary::GetRoles(const std::string &method, ITransportLaye
   return OK;
 }
 
+JSONRPC_STATUS CAudioLibrary::Search(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CMusicDatabase musicdatabase;
+  if (!musicdatabase.OpenForReading())
+    return InternalError;
+
+  std::string query = parameterObject["query"].asString();
+  unsigned int limit = (unsigned int)parameterObject["limit"].asUnsignedInteger();
+
+  result["artists"] = CVariant(CVariant::VariantTypeArray);
+  result["albums"] = CVariant(CVariant::VariantTypeArray);
+  result["songs"] = CVariant(CVariant::VariantTypeArray);
+
+  std::vector<int> ids;
+  if (musicdatabase.GetSearchResults(MediaTypeArtist, query, ids, limit) && !ids.empty())
+  {
+    CDatabase::Filter filter(musicdatabase.PrepareSearchCondition("artistview.idArtist", ids));
+    filter.order = musicdatabase.PrepareSearchOrder("artistview.idArtist", ids);
+    CFileItemList items;
+    if (!musicdatabase.GetArtistsByWhere("musicdb://artists/", filter, items))
+      return InternalError;
+    HandleFileItemList("artistid", false, "artists", items, parameterObject, result, false);
+  }
+
+  if (musicdatabase.GetSearchResults(MediaTypeAlbum, query, ids, limit) && !ids.empty())
+  {
+    CDatabase::Filter filter(musicdatabase.PrepareSearchCondition("albumview.idAlbum", ids));
+    filter.order = musicdatabase.PrepareSearchOrder("albumview.idAlbum", ids);
+    CFileItemList items;
+    if (!musicdatabase.GetAlbumsByWhere("musicdb://albums/", filter, items))
+      return InternalError;
+    HandleFileItemList("albumid", false, "albums", items, parameterObject, result, false);
+  }
+
+  if (musicdatabase.GetSearchResults(MediaTypeSong, query, ids, limit) && !ids.empty())
+  {
+    CDatabase::Filter filter(musicdatabase.PrepareSearchCondition("songview.idSong", ids));
+    filter.order = musicdatabase.PrepareSearchOrder("songview.idSong", ids);
+    CFileItemList items;
+    if (!musicdatabase.GetSongsByWhere("musicdb://songs/", filter, items))
+      return InternalError;
+    HandleFileItemList("songid", true, "songs", items, parameterObject, result, false);
+  }
+
+  result.erase("limits");
+  return OK;
+}
+
 JSONRPC_STATUS CAudioLibrary::SetArtistDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   int id = (int)parameterObject["artistid"].asInteger();
@@ -19,6 +19,8 @@
  */
 
 #include "VideoLibrary.h"
+#include "ServiceBroker.h"
+#include "filesystem/LibraryDirectoryCache.h"
 #include "messaging/ApplicationMessenger.h"
 #include "TextureDatabase.h"
 #include "Util.h"
@@ -32,10 +34,48 @@
 using namespace JSONRPC;
 using namespace KODI::MESSAGING;
 
+JSONRPC_STATUS CVideoLibrary::GetProperties(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CVariant properties = CVariant(CVariant::VariantTypeObject);
+  for (CVariant::const_iterator_array it = parameterObject["properties"].begin_array(); it != parameterObject["properties"].end_array(); it++)
+  {
+    std::string propertyName = it->asString();
+    CVariant property;
+    if (propertyName == "librarycache")
+    {
+      XFILE::CLibraryDirectoryCache::Stats stats = CServiceBroker::GetLibraryDirectoryCache().GetStats(ANNOUNCEMENT::VideoLibrary);
+      property["hits"] = stats.hits;
+      property["misses"] = stats.misses;
+      property["hitrate"] = stats.hits + stats.misses > 0 ? (double)stats.hits / (stats.hits + stats.misses) : 0.0;
+      property["entries"] = stats.entries;
+    }
+    else if (propertyName == "connectionpool")
+    {
+      CDatabaseConnectionPool::Stats stats = CVideoDatabase().GetConnectionPoolStats();
+      property["size"] = stats.size;
+      property["inuse"] = stats.inUse;
+      property["idle"] = stats.idle;
+      property["peak"] = stats.peak;
+      property["utilisation"] = stats.size > 0 ? (double)stats.inUse / stats.size : 0.0;
+      property["acquired"] = stats.acquired;
+      property["reused"] = stats.reused;
+      property["waited"] = stats.waited;
+      property["averagewait"] = stats.waited > 0 ? (double)stats.waitTime / stats.waited : 0.0;
+      property["maxwait"] = stats.maxWait;
+      property["healthfailures"] = stats.healthFailures;
+    }
+
+    properties[propertyName] = property;
+  }
+
+  result = properties;
+  return OK;
+}
+
 JSONRPC_STATUS CVideoLibrary::GetMovies(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   SortDescription sorting;
@@ -94,7 +134,7 @@ JSONRPC_STATUS CVideoLibrary::GetMovieDetails(const std::string &method, ITransp
   int id = (int)parameterObject["movieid"].asInteger();
 
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   CVideoInfoTag infos;
@@ -108,7 +148,7 @@ JSONRPC_STATUS CVideoLibrary::GetMovieDetails(const std::string &method, ITransp
 JSONRPC_STATUS CVideoLibrary::GetMovieSets(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -124,7 +164,7 @@ JSONRPC_STATUS CVideoLibrary::GetMovieSetDetails(const std::string &method, ITra
   int id = (int)parameterObject["setid"].asInteger();
 
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   // Get movie set details
@@ -145,7 +185,7 @@ JSONRPC_STATUS CVideoLibrary::GetMovieSetDetails(const std::string &method, ITra
 JSONRPC_STATUS CVideoLibrary::GetTVShows(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   SortDescription sorting;
@@ -190,7 +230,7 @@ JSONRPC_STATUS CVideoLibrary::GetTVShows(const std::string &method, ITransportLa
 JSONRPC_STATUS CVideoLibrary::GetTVShowDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   int id = (int)parameterObject["tvshowid"].asInteger();
@@ -208,7 +248,7 @@ JSONRPC_STATUS CVideoLibrary::GetTVShowDetails(const std::string &method, ITrans
 JSONRPC_STATUS CVideoLibrary::GetSeasons(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   int tvshowID = (int)parameterObject["tvshowid"].asInteger();
@@ -225,7 +265,7 @@ JSONRPC_STATUS CVideoLibrary::GetSeasons(const std::string &method, ITransportLa
 JSONRPC_STATUS CVideoLibrary::GetSeasonDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   int id = (int)parameterObject["seasonid"].asInteger();
@@ -243,7 +283,7 @@ JSONRPC_STATUS CVideoLibrary::GetSeasonDetails(const std::string &method, ITrans
 JSONRPC_STATUS CVideoLibrary::GetEpisodes(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   SortDescription sorting;
@@ -300,7 +340,7 @@ JSONRPC_STATUS CVideoLibrary::GetEpisodes(const std::string &method, ITransportL
 JSONRPC_STATUS CVideoLibrary::GetEpisodeDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   int id = (int)parameterObject["episodeid"].asInteger();
@@ -325,7 +365,7 @@ JSONRPC_STATUS CVideoLibrary::GetEpisodeDetails(const std::string &method, ITran
 JSONRPC_STATUS CVideoLibrary::GetMusicVideos(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   SortDescription sorting;
@@ -372,7 +412,7 @@ JSONRPC_STATUS CVideoLibrary::GetMusicVideos(const std::string &method, ITranspo
 JSONRPC_STATUS CVideoLibrary::GetMusicVideoDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   int id = (int)parameterObject["musicvideoid"].asInteger();
@@ -388,7 +428,7 @@ JSONRPC_STATUS CVideoLibrary::GetMusicVideoDetails(const std::string &method, IT
 JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedMovies(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -401,7 +441,7 @@ JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedMovies(const std::string &method,
 JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedEpisodes(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -414,7 +454,7 @@ JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedEpisodes(const std::string &method
 JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedMusicVideos(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -427,7 +467,7 @@ JSONRPC_STATUS CVideoLibrary::GetRecentlyAddedMusicVideos(const std::string &met
 JSONRPC_STATUS CVideoLibrary::GetInProgressTVShows(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -463,7 +503,7 @@ JSONRPC_STATUS CVideoLibrary::GetGenres(const std::string &method, ITransportLay
   strPath += "/genres/";
  
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -504,7 +544,7 @@ JSONRPC_STATUS CVideoLibrary::GetTags(const std::string &method, ITransportLayer
   strPath += "/tags/";
 
   CVideoDatabase videodatabase;
-  if (!videodatabase.Open())
+  if (!videodatabase.OpenForReading())
     return InternalError;
 
   CFileItemList items;
@@ -519,6 +559,65 @@ JSONRPC_STATUS CVideoLibrary::GetTags(const std::string &method, ITransportLayer
   return OK;
 }
 
+JSONRPC_STATUS CVideoLibrary::Search(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
+{
+  CVideoDatabase videodatabase;
+  if (!videodatabase.OpenForReading())
+    return InternalError;
+
+  std::string query = parameterObject["query"].asString();
+  unsigned int limit = (unsigned int)parameterObject["limit"].asUnsignedInteger();
+
+  result["movies"] = CVariant(CVariant::VariantTypeArray);
+  result["tvshows"] = CVariant(CVariant::VariantTypeArray);
+  result["episodes"] = CVariant(CVariant::VariantTypeArray);
+  result["musicvideos"] = CVariant(CVariant::VariantTypeArray);
+
+  std::vector<int> ids;
+  if (videodatabase.GetSearchResults(MediaTypeMovie, query, ids, limit) && !ids.empty())
+  {
+    CDatabase::Filter filter(videodatabase.PrepareSearchCondition("movie_view.idMovie", ids));
+    filter.order = videodatabase.PrepareSearchOrder("movie_view.idMovie", ids);
+    CFileItemList items;
+    if (!videodatabase.GetMoviesByWhere("videodb://movies/titles/", filter, items))
+      return InternalError;
+    HandleFileItemList("movieid", true, "movies", items, parameterObject, result, false);
+  }
+
+  if (videodatabase.GetSearchResults(MediaTypeTvShow, query, ids, limit) && !ids.empty())
+  {
+    CDatabase::Filter filter(videodatabase.PrepareSearchCondition("tvshow_view.idShow", ids));
+    filter.order = videodatabase.PrepareSearchOrder("tvshow_view.idShow", ids);
+    CFileItemList items;
+    if (!videodatabase.GetTvShowsByWhere("videodb://tvshows/titles/", filter, items))
+      return InternalError;
+    HandleFileItemList("tvshowid", false, "tvshows", items, parameterObject, result, false);
+  }
+
+  if (videodatabase.GetSearchResults(MediaTypeEpisode, query, ids, limit) && !ids.empty())
+  {
+    CDatabase::Filter filter(videodatabase.PrepareSearchCondition("episode_view.idEpisode", ids));
+    filter.order = videodatabase.PrepareSearchOrder("episode_view.idEpisode", ids);
+    CFileItemList items;
+    if (!videodatabase.GetEpisodesByWhere("videodb://tvshows/titles/-1/-1/", filter, items))
+      return InternalError;
+    HandleFileItemList("episodeid", true, "episodes", items, parameterObject, result, false);
+  }
+
+  if (videodatabase.GetSearchResults(MediaTypeMusicVideo, query, ids, limit) && !ids.empty())
+  {
+    CDatabase::Filter filter(videodatabase.PrepareSearchCondition("musicvideo_view.idMVideo", ids));
+    filter.order = videodatabase.PrepareSearchOrder("musicvideo_view.idMVideo", ids);
+    CFileItemList items;
+    if (!videodatabase.GetMusicVideosByWhere("videodb://musicvideos/titles/", filter, items))
+      return InternalError;
+    HandleFileItemList("musicvideoid", true, "musicvideos", items, parameterObject, result, false);
+  }
+
+  result.erase("limits");
+  return OK;
+}
+
 JSONRPC_STATUS CVideoLibrary::SetMovieDetails(const std::string &method, ITransportLayer *transport, IClient *client, const CVariant &parameterObject, CVariant &result)
 {
   int id = (int)parameterObject["movieid"].asInteger();
@@ -1010,6 +1109,8 @@ int CVideoLibrary::RequiresAdditionalDetails(const MediaType& mediaType, const C
       details = details | VideoDbDetailsStream;
     else if (propertyValue == "tag")
       details = details | VideoDbDetailsTag;
+    else if (propertyValue == "art" || propertyValue == "thumbnail" || propertyValue == "fanart")
+      details = details | VideoDbDetailsArt;
   }
   return details;
 }
@@ -20,6 +20,8 @@
 
 #include "MusicDatabase.h"
 
+#include <algorithm>
+
 #include "addons/Addon.h"
 #include "addons/AddonManager.h"
 #include "addons/AddonSystemSettings.h"
@@ -36,6 +38,7 @@
 #include "FileItem.h"
 #include "filesystem/DirectoryCache.h"
 #include "filesystem/File.h"
+#include "filesystem/FileExistsChecker.h"
 #include "filesystem/MusicDatabaseDirectory/DirectoryNode.h"
 #include "filesystem/MusicDatabaseDirectory/QueryParams.h"
 #include "guiinfo/GUIInfoLabels.h"
@@ -51,11 +54,13 @@
 #include "profiles/ProfilesManager.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/MediaSettings.h"
+#include "settings/MediaSourceSettings.h"
 #include "settings/Settings.h"
 #include "Song.h"
 #include "storage/MediaManager.h"
 #include "system.h"
 #include "TextureCache.h"
+#include "TextureCacheJob.h"
 #include "threads/SystemClock.h"
 #include "URL.h"
 #include "utils/FileUtils.h"
@@ -63,6 +68,9 @@
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
+#include "utils/WeightedRandomPool.h"
+#include "utils/XMLStreamReader.h"
+#include "utils/XMLStreamWriter.h"
 #include "TextureCache.h"
 #include "interfaces/AnnouncementManager.h"
 #include "dbwrappers/dataset.h"
@@ -77,7 +85,6 @@ using ADDON::AddonPtr;
 using KODI::MESSAGING::HELPERS::DialogResponse;
 
 #define RECENTLY_PLAYED_LIMIT 25
-#define MIN_FULL_SEARCH_LENGTH 3
 
 #ifdef HAS_DVD_DRIVE
 using namespace CDDB;
@@ -191,6 +198,8 @@ void CMusicDatabase::CreateTables()
 
   CLog::Log(LOGINFO, "create cue table");
   m_pDS->exec("CREATE TABLE cue (idPath integer, strFileName text, strCuesheet text)");
+
+  CreateSearchIndexTables();
 }
 
 void CMusicDatabase::CreateAnalytics()
@@ -238,6 +247,8 @@ void CMusicDatabase::CreateAnalytics()
 
   m_pDS->exec("CREATE UNIQUE INDEX idxCue ON cue(idPath, strFileName(255))");
 
+  CreateSearchIndexAnalytics();
+
   CLog::Log(LOGINFO, "create triggers");
   m_pDS->exec("CREATE TRIGGER tgrDeleteAlbum AFTER delete ON album FOR EACH ROW BEGIN"
               "  DELETE FROM song WHERE song.idAlbum = old.idAlbum;"
@@ -245,17 +256,20 @@ void CMusicDatabase::CreateAnalytics()
               "  DELETE FROM album_genre WHERE album_genre.idAlbum = old.idAlbum;"
               "  DELETE FROM albuminfosong WHERE albuminfosong.idAlbumInfo=old.idAlbum;"
               "  DELETE FROM art WHERE media_id=old.idAlbum AND media_type='album';"
+              "  DELETE FROM searchindex WHERE media_id=old.idAlbum AND media_type='album';"
               " END");
   m_pDS->exec("CREATE TRIGGER tgrDeleteArtist AFTER delete ON artist FOR EACH ROW BEGIN"
               "  DELETE FROM album_artist WHERE album_artist.idArtist = old.idArtist;"
               "  DELETE FROM song_artist WHERE song_artist.idArtist = old.idArtist;"
               "  DELETE FROM discography WHERE discography.idArtist = old.idArtist;"
               "  DELETE FROM art WHERE media_id=old.idArtist AND media_type='artist';"
+              "  DELETE FROM searchindex WHERE media_id=old.idArtist AND media_type='artist';"
               " END");
   m_pDS->exec("CREATE TRIGGER tgrDeleteSong AFTER delete ON song FOR EACH ROW BEGIN"
               "  DELETE FROM song_artist WHERE song_artist.idSong = old.idSong;"
               "  DELETE FROM song_genre WHERE song_genre.idSong = old.idSong;"
               "  DELETE FROM art WHERE media_id=old.idSong AND media_type='song';"
+              "  DELETE FROM searchindex WHERE media_id=old.idSong AND media_type='song';"
               " END");
   m_pDS->exec("CREATE TRIGGER tgrDeletePath AFTER delete ON path FOR EACH ROW BEGIN"
               "  DELETE FROM cue WHERE cue.idPath = old.idPath;"
@@ -2219,16 +2233,13 @@ bool CMusicDatabase::SearchArtists(const std::string& search, CFileItemList &art
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
+    std::vector<int> ids;
+    if (!GetSearchResults(MediaTypeArtist, search, ids) || ids.empty())
+      return false;
+
     std::string strVariousArtists = g_localizeStrings.Get(340).c_str();
-    std::string strSQL;
-    if (search.size() >= MIN_FULL_SEARCH_LENGTH)
-      strSQL=PrepareSQL("select * from artist "
-                                "where (strArtist like '%s%%' or strArtist like '%% %s%%') and strArtist <> '%s' "
-                                , search.c_str(), search.c_str(), strVariousArtists.c_str() );
-    else
-      strSQL=PrepareSQL("select * from artist "
-                                "where strArtist like '%s%%' and strArtist <> '%s' "
-                                , search.c_str(), strVariousArtists.c_str() );
+    std::string strSQL = PrepareSQL("select * from artist where strArtist <> '%s' and ", strVariousArtists.c_str())
+                         + PrepareSearchCondition("idArtist", ids) + " order by " + PrepareSearchOrder("idArtist", ids);
 
     if (!m_pDS->query(strSQL)) return false;
     if (m_pDS->num_rows() == 0)
@@ -2766,11 +2777,12 @@ bool CMusicDatabase::SearchSongs(const std::string& search, CFileItemList &items
     if (!baseUrl.FromString("musicdb://songs/"))
       return false;
 
-    std::string strSQL;
-    if (search.size() >= MIN_FULL_SEARCH_LENGTH)
-      strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' or strTitle like '%% %s%%' limit 1000", search.c_str(), search.c_str());
-    else
-      strSQL=PrepareSQL("select * from songview where strTitle like '%s%%' limit 1000", search.c_str());
+    std::vector<int> ids;
+    if (!GetSearchResults(MediaTypeSong, search, ids, 1000) || ids.empty())
+      return false;
+
+    std::string strSQL = "select * from songview where " + PrepareSearchCondition("idSong", ids)
+                         + " order by " + PrepareSearchOrder("idSong", ids);
 
     if (!m_pDS->query(strSQL)) return false;
     if (m_pDS->num_rows() == 0) return false;
@@ -2802,11 +2814,12 @@ bool CMusicDatabase::SearchAlbums(const std::string& search, CFileItemList &albu
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
 
-    std::string strSQL;
-    if (search.size() >= MIN_FULL_SEARCH_LENGTH)
-      strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%' or strAlbum like '%% %s%%'", search.c_str(), search.c_str());
-    else
-      strSQL=PrepareSQL("select * from albumview where strAlbum like '%s%%'", search.c_str());
+    std::vector<int> ids;
+    if (!GetSearchResults(MediaTypeAlbum, search, ids) || ids.empty())
+      return false;
+
+    std::string strSQL = "select * from albumview where " + PrepareSearchCondition("idAlbum", ids)
+                         + " order by " + PrepareSearchOrder("idAlbum", ids);
 
     if (!m_pDS->query(strSQL)) return false;
 
@@ -2833,24 +2846,21 @@ bool CMusicDatabase::SearchAlbums(const std::string& search, CFileItemList &albu
   return false;
 }
 
-bool CMusicDatabase::CleanupSongsByIds(const std::string &strSongIds)
+bool CMusicDatabase::GetMissingSongs(std::vector<std::string> &songIds, CGUIDialogProgress *progressDialog)
 {
   try
   {
     if (NULL == m_pDB.get()) return false;
     if (NULL == m_pDS.get()) return false;
-    // ok, now find all idSong's
-    std::string strSQL=PrepareSQL("select * from song join path on song.idPath = path.idPath where song.idSong in %s", strSongIds.c_str());
-    if (!m_pDS->query(strSQL)) return false;
-    int iRowsFound = m_pDS->num_rows();
-    if (iRowsFound == 0)
-    {
-      m_pDS->close();
-      return true;
-    }
-    std::vector<std::string> songsToDelete;
+
+    // get the full path of all songs
+    if (!m_pDS->query("select song.idSong, song.strFileName, path.strPath from song join path on song.idPath = path.idPath"))
+      return false;
+
+    std::vector<std::string> ids;
+    std::vector<std::string> files;
     while (!m_pDS->eof())
-    { // get the full song path
+    {
       std::string strFileName = URIUtils::AddFileToFolder(m_pDS->fv("path.strPath").get_asString(), m_pDS->fv("song.strFileName").get_asString());
 
       //  Special case for streams inside an ogg file. (oggstream)
@@ -2863,60 +2873,56 @@ bool CMusicDatabase::CleanupSongsByIds(const std::string &strSongIds)
         URIUtils::RemoveSlashAtEnd(strFileName);
       }
 
-      if (!CFile::Exists(strFileName, false))
-      { // file no longer exists, so add to deletion list
-        songsToDelete.push_back(m_pDS->fv("song.idSong").get_asString());
-      }
+      ids.push_back(m_pDS->fv("song.idSong").get_asString());
+      files.push_back(strFileName);
       m_pDS->next();
     }
     m_pDS->close();
 
-    if (!songsToDelete.empty())
+    std::vector<std::string> sourcePaths;
+    for (const auto &source : *CMediaSourceSettings::GetInstance().GetSources("music"))
+      sourcePaths.insert(sourcePaths.end(), source.vecPaths.begin(), source.vecPaths.end());
+
+    CFileExistsChecker checker(g_advancedSettings.m_musicLibraryCleanThreads);
+    std::vector<CFileExistsChecker::State> states;
+    checker.Check(files, sourcePaths, states, [progressDialog](int percentage)
     {
-      std::string strSongsToDelete = "(" + StringUtils::Join(songsToDelete, ",") + ")";
-      // ok, now delete these songs + all references to them from the linked tables
-      strSQL = "delete from song where idSong in " + strSongsToDelete;
-      m_pDS->exec(strSQL);
-      m_pDS->close();
+      if (progressDialog)
+      {
+        progressDialog->SetPercentage(percentage / 5);
+        progressDialog->Progress();
+      }
+      return true;
+    });
+
+    for (size_t i = 0; i < states.size(); i++)
+    {
+      if (states[i] == CFileExistsChecker::Missing)
+        songIds.push_back(ids[i]);
     }
     return true;
   }
   catch (...)
   {
-    CLog::Log(LOGERROR, "Exception in CMusicDatabase::CleanupSongsFromPaths()");
+    CLog::Log(LOGERROR, "Exception in CMusicDatabase::GetMissingSongs()");
   }
   return false;
 }
 
-bool CMusicDatabase::CleanupSongs()
+bool CMusicDatabase::CleanupSongs(const std::vector<std::string> &songIds)
 {
   try
   {
-    // run through all songs and get all unique path ids
-    int iLIMIT = 1000;
-    for (int i=0;;i+=iLIMIT)
+    // delete these songs + all references to them from the linked tables
+    const size_t iLIMIT = 1000;
+    for (size_t i = 0; i < songIds.size(); i += iLIMIT)
     {
-      std::string strSQL=PrepareSQL("select song.idSong from song order by song.idSong limit %i offset %i",iLIMIT,i);
-      if (!m_pDS->query(strSQL)) return false;
-      int iRowsFound = m_pDS->num_rows();
-      // keep going until no rows are left!
-      if (iRowsFound == 0)
-      {
-        m_pDS->close();
-        return true;
-      }
-
-      std::vector<std::string> songIds;
-      while (!m_pDS->eof())
-      {
-        songIds.push_back(m_pDS->fv("song.idSong").get_asString());
-        m_pDS->next();
-      }
-      m_pDS->close();
-      std::string strSongIds = "(" + StringUtils::Join(songIds, ",") + ")";
-      CLog::Log(LOGDEBUG,"Checking songs from song ID list: %s",strSongIds.c_str());
-      if (!CleanupSongsByIds(strSongIds)) return false;
+      std::vector<std::string> ids(songIds.begin() + i, songIds.begin() + std::min(i + iLIMIT, songIds.size()));
+      std::string strSongIds = "(" + StringUtils::Join(ids, ",") + ")";
+      CLog::Log(LOGDEBUG, "Removing songs from song ID list: %s", strSongIds.c_str());
+      m_pDS->exec("delete from song where idSong in " + strSongIds);
     }
+    m_pDS->close();
     return true;
   }
   catch(...)
@@ -2976,11 +2982,16 @@ bool CMusicDatabase::CleanupPaths()
 
     // grab all paths that aren't immediately connected with a song
     std::string sql = "select * from path where idPath not in (select idPath from song)";
-    if (!m_pDS->query(sql)) return false;
+    if (!m_pDS->query(sql))
+    {
+      DiscardConnection();
+      return false;
+    }
     int iRowsFound = m_pDS->num_rows();
     if (iRowsFound == 0)
     {
       m_pDS->close();
+      m_pDS->exec("drop table songpaths");
       return true;
     }
     // and construct a list to delete
@@ -3009,6 +3020,8 @@ bool CMusicDatabase::CleanupPaths()
   catch (...)
   {
     CLog::Log(LOGERROR, "Exception in CMusicDatabase::CleanupPaths() or was aborted");
+    // the temporary table may still exist, don't hand it to the next user of the connection
+    DiscardConnection();
   }
   return false;
 }
@@ -3040,6 +3053,7 @@ bool CMusicDatabase::CleanupArtists()
   catch (...)
   {
     CLog::Log(LOGERROR, "Exception in CMusicDatabase::CleanupArtists() or was aborted");
+    DiscardConnection();
   }
   return false;
 }
@@ -3100,6 +3114,7 @@ int CMusicDatabase::Cleanup(bool bShowProgress /* = true */)
 
   int ret = ERROR_OK;
   CGUIDialogProgress* pDlgProgress = NULL;
+  std::vector<std::string> songsToDelete;
   unsigned int time = XbmcThreads::SystemClockMillis();
   CLog::Log(LOGNOTICE, "%s: Starting musicdatabase cleanup ..", __FUNCTION__);
   ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::AudioLibrary, "xbmc", "OnCleanStarted");
@@ -3119,7 +3134,15 @@ int CMusicDatabase::Cleanup(bool bShowProgress /* = true */)
       pDlgProgress->ShowProgressBar(true);
     }
   }
-  if (!CleanupSongs())
+  // the files are checked before the transaction is started, so the database
+  // isn't locked while waiting for the file systems
+  if (!GetMissingSongs(songsToDelete, pDlgProgress))
+  {
+    ret = ERROR_REORG_SONGS;
+    goto error;
+  }
+  BeginTransaction();
+  if (!CleanupSongs(songsToDelete))
   {
     ret = ERROR_REORG_SONGS;
     goto error;
@@ -4942,11 +4965,26 @@ void CMusicDatabase::UpdateTables(int version)
     m_pDS->exec("DROP INDEX idxSongArtist1 ON song_artist");
     m_pDS->exec("DROP INDEX idxAlbumArtist1 ON album_artist");
   }
+  if (version < 61)
+  {
+    // the first search indexes the library in the background
+    CreateSearchIndexTables();
+    QueueSearchIndexRebuild();
+  }
 }
 
 int CMusicDatabase::GetSchemaVersion() const
 {
-  return 60;
+  return 61;
+}
+
+std::vector<CSearchIndex::Source> CMusicDatabase::GetSearchSources() const
+{
+  std::vector<CSearchIndex::Source> sources;
+  sources.push_back({ MediaTypeArtist, "artist", "idArtist", { { "strArtist", 3 } } });
+  sources.push_back({ MediaTypeAlbum, "album", "idAlbum", { { "strAlbum", 3 } } });
+  sources.push_back({ MediaTypeSong, "song", "idSong", { { "strTitle", 3 } } });
+  return sources;
 }
 
 unsigned int CMusicDatabase::GetSongIDs(const Filter &filter, std::vector<std::pair<int,int> > &songIDs)
@@ -4983,6 +5021,38 @@ unsigned int CMusicDatabase::GetSongIDs(const Filter &filter, std::vector<std::p
   return 0;
 }
 
+unsigned int CMusicDatabase::GetSongIDs(const Filter &filter, CWeightedRandomPool &pool)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return 0;
+    if (NULL == m_pDS.get()) return 0;
+
+    std::string strSQL = "select idSong, rating, userrating, iTimesPlayed from songview ";
+    if (!CDatabase::BuildSQL(strSQL, filter, strSQL))
+      return 0;
+
+    if (!m_pDS->query(strSQL)) return 0;
+    unsigned int count = 0;
+    while (!m_pDS->eof())
+    {
+      // the user's own rating wins over the scraped one
+      int userrating = m_pDS->fv(2).get_asInt();
+      float rating = userrating > 0 ? userrating : m_pDS->fv(1).get_asFloat();
+      pool.Set(m_pDS->fv(0).get_asInt(), CWeightedRandomPool::GetWeight(rating, m_pDS->fv(3).get_asInt()));
+      count++;
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return count;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s(%s) failed", __FUNCTION__, filter.where.c_str());
+  }
+  return 0;
+}
+
 int CMusicDatabase::GetSongsCount(const Filter &filter)
 {
   try
@@ -5607,6 +5677,9 @@ bool CMusicDatabase::CommitTransaction()
 {
   if (CDatabase::CommitTransaction())
   { // number of items in the db has likely changed, so reset the infomanager cache
+    // releasing a savepoint within a batch changes nothing yet, recalculate on CommitBatch()
+    if (InBatch())
+      return true;
     g_infoManager.SetLibraryBool(LIBRARY_HAS_MUSIC, GetSongsCount() > 0);
     return true;
   }
@@ -5792,10 +5865,30 @@ std::string CMusicDatabase::GetItemById(const std::string &itemType, int id)
   return "";
 }
 
-void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bool images, bool overwrite)
+/*! \brief Advance the progress of an export or import.
+ \param callback the progress to advance, may be NULL
+ \param dialog the dialog showing the progress, may be NULL
+ \param steps the number of steps to advance by
+ \return false if it was cancelled
+ */
+static bool AdvanceProgress(IProgressCallback *callback, CGUIDialogProgress *dialog, int steps)
+{
+  if (!callback)
+    return true;
+  if (steps > 0)
+    callback->SetProgressAdvance(steps);
+  if (dialog)
+    dialog->Progress();
+  return !callback->Abort();
+}
+
+void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bool images, bool overwrite, IProgressCallback *progressCallback /* = NULL */)
 {
   int iFailCount = 0;
   CGUIDialogProgress *progress=NULL;
+  IProgressCallback *callback = progressCallback;
+  // images are copied in the background while the next items are exported
+  CTextureExportQueue exports;
   try
   {
     if (NULL == m_pDB.get()) return;
@@ -5807,10 +5900,7 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
     std::string sql = "select idAlbum FROM album WHERE lastScraped IS NOT NULL";
     m_pDS->query(sql);
 
-    int total = m_pDS->num_rows();
-    int current = 0;
-
-    albumIds.reserve(total);
+    albumIds.reserve(m_pDS->num_rows());
     while (!m_pDS->eof())
     {
       albumIds.push_back(m_pDS->fv("idAlbum").get_asInt());
@@ -5818,7 +5908,28 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
     }
     m_pDS->close();
 
-    progress = (CGUIDialogProgress *)g_windowManager.GetWindow(WINDOW_DIALOG_PROGRESS);
+    // find all artists
+    std::vector<int> artistIds;
+    std::string artistSQL = "SELECT idArtist FROM artist where lastScraped IS NOT NULL";
+    m_pDS->query(artistSQL);
+    artistIds.reserve(m_pDS->num_rows());
+    while (!m_pDS->eof())
+    {
+      artistIds.push_back(m_pDS->fv("idArtist").get_asInt());
+      m_pDS->next();
+    }
+    m_pDS->close();
+
+    // the single file is written item by item instead of being built in memory
+    CXMLStreamWriter writer;
+    if (singleFile && !writer.Open(xmlFile, "musicdb"))
+      return;
+
+    if (!callback)
+    {
+      progress = (CGUIDialogProgress *)g_windowManager.GetWindow(WINDOW_DIALOG_PROGRESS);
+      callback = progress;
+    }
     if (progress)
     {
       progress->SetHeading(CVariant{20196});
@@ -5829,19 +5940,20 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
       progress->Open();
       progress->ShowProgressBar(true);
     }
+    if (callback)
+      callback->SetProgressMax(std::max(static_cast<int>(albumIds.size() + artistIds.size()), 1));
 
     // create our xml document
     CXBMCTinyXML xmlDoc;
     TiXmlDeclaration decl("1.0", "UTF-8", "yes");
     xmlDoc.InsertEndChild(decl);
+    TiXmlElement xmlMainElement("musicdb");
     TiXmlNode *pMain = NULL;
     if (!singleFile)
       pMain = &xmlDoc;
     else
-    {
-      TiXmlElement xmlMainElement("musicdb");
-      pMain = xmlDoc.InsertEndChild(xmlMainElement);
-    }
+      pMain = &xmlMainElement;
+
     for (const auto &albumId : albumIds)
     {
       CAlbum album;
@@ -5849,7 +5961,9 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
       std::string strPath;
       GetAlbumPath(albumId, strPath);
       album.Save(pMain, "album", strPath);
-      if (!singleFile)
+      if (singleFile)
+        writer.WriteChildren(*pMain);
+      else
       {
         if (!CDirectory::Exists(strPath))
           CLog::Log(LOGDEBUG, "%s - Not exporting item %s as it does not exist", __FUNCTION__, strPath.c_str());
@@ -5871,7 +5985,7 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
             std::string thumb = GetArtForItem(album.idAlbum, MediaTypeAlbum, "thumb");
             std::string imagePath = URIUtils::AddFileToFolder(strPath, "folder.jpg");
             if (!thumb.empty() && (overwrite || !CFile::Exists(imagePath)))
-              CTextureCache::GetInstance().Export(thumb, imagePath);
+              exports.Export(thumb, imagePath);
           }
           xmlDoc.Clear();
           TiXmlDeclaration decl("1.0", "UTF-8", "yes");
@@ -5879,34 +5993,15 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
         }
       }
 
-      if ((current % 50) == 0 && progress)
-      {
+      if (progress)
         progress->SetLine(1, CVariant{album.strAlbum});
-        progress->SetPercentage(current * 100 / total);
-        progress->Progress();
-        if (progress->IsCanceled())
-        {
+      if (!AdvanceProgress(callback, progress, 1))
+      {
+        if (progress)
           progress->Close();
-          m_pDS->close();
-          return;
-        }
+        return;
       }
-      current++;
-    }
-
-    // find all artists
-    std::vector<int> artistIds;
-    std::string artistSQL = "SELECT idArtist FROM artist where lastScraped IS NOT NULL";
-    m_pDS->query(artistSQL);
-    total = m_pDS->num_rows();
-    current = 0;
-    artistIds.reserve(total);
-    while (!m_pDS->eof())
-    {
-      artistIds.push_back(m_pDS->fv("idArtist").get_asInt());
-      m_pDS->next();
     }
-    m_pDS->close();
 
     for (const auto &artistId : artistIds)
     {
@@ -5924,7 +6019,9 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
           XMLUtils::SetString(&additionalNode, i.first.c_str(), i.second);
         pMain->LastChild()->InsertEndChild(additionalNode);
       }
-      if (!singleFile)
+      if (singleFile)
+        writer.WriteChildren(*pMain);
+      else
       {
         if (!CDirectory::Exists(strPath))
           CLog::Log(LOGDEBUG, "%s - Not exporting item %s as it does not exist", __FUNCTION__, strPath.c_str());
@@ -5946,9 +6043,9 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
             std::string savedThumb = URIUtils::AddFileToFolder(strPath,"folder.jpg");
             std::string savedFanart = URIUtils::AddFileToFolder(strPath,"fanart.jpg");
             if (artwork.find("thumb") != artwork.end() && (overwrite || !CFile::Exists(savedThumb)))
-              CTextureCache::GetInstance().Export(artwork["thumb"], savedThumb);
+              exports.Export(artwork["thumb"], savedThumb);
             if (artwork.find("fanart") != artwork.end() && (overwrite || !CFile::Exists(savedFanart)))
-              CTextureCache::GetInstance().Export(artwork["fanart"], savedFanart);
+              exports.Export(artwork["fanart"], savedFanart);
           }
           xmlDoc.Clear();
           TiXmlDeclaration decl("1.0", "UTF-8", "yes");
@@ -5956,22 +6053,24 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
         }
       }
 
-      if ((current % 50) == 0 && progress)
-      {
+      if (progress)
         progress->SetLine(1, CVariant{artist.strArtist});
-        progress->SetPercentage(current * 100 / total);
-        progress->Progress();
-        if (progress->IsCanceled())
-        {
+      if (!AdvanceProgress(callback, progress, 1))
+      {
+        if (progress)
           progress->Close();
-          m_pDS->close();
-          return;
-        }
+        return;
       }
-      current++;
     }
 
-    xmlDoc.SaveFile(xmlFile);
+    exports.Wait();
+    if (singleFile && !writer.Close())
+    {
+      CLog::Log(LOGERROR, "%s: Writing '%s' failed", __FUNCTION__, xmlFile.c_str());
+      iFailCount++;
+    }
+    else if (!singleFile)
+      xmlDoc.SaveFile(xmlFile);
 
     CVariant data;
     if (singleFile)
@@ -5995,21 +6094,23 @@ void CMusicDatabase::ExportToXML(const std::string &xmlFile, bool singleFile, bo
     CGUIDialogOK::ShowAndGetInput(CVariant{20196}, CVariant{StringUtils::Format(g_localizeStrings.Get(15011).c_str(), iFailCount)});
 }
 
-void CMusicDatabase::ImportFromXML(const std::string &xmlFile)
+void CMusicDatabase::ImportFromXML(const std::string &xmlFile, IProgressCallback *progressCallback /* = NULL */)
 {
-  CGUIDialogProgress *progress = (CGUIDialogProgress *)g_windowManager.GetWindow(WINDOW_DIALOG_PROGRESS);
+  CGUIDialogProgress *progress=NULL;
+  IProgressCallback *callback = progressCallback;
   try
   {
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
-    CXBMCTinyXML xmlDoc;
-    if (!xmlDoc.LoadFile(xmlFile))
+    if (!CFile::Exists(xmlFile))
       return;
 
-    TiXmlElement *root = xmlDoc.RootElement();
-    if (!root) return;
-
+    if (!callback)
+    {
+      progress = (CGUIDialogProgress *)g_windowManager.GetWindow(WINDOW_DIALOG_PROGRESS);
+      callback = progress;
+    }
     if (progress)
     {
       progress->SetHeading(CVariant{20197});
@@ -6021,24 +6122,31 @@ void CMusicDatabase::ImportFromXML(const std::string &xmlFile)
       progress->ShowProgressBar(true);
     }
 
-    TiXmlElement *entry = root->FirstChildElement();
+    // the file is read an element at a time instead of as a whole, the
+    // transactions of the updates become savepoints of a single batch and
+    // the progress is measured in KB read
     int current = 0;
-    int total = 0;
-    // first count the number of items...
-    while (entry)
-    {
-      if (strnicmp(entry->Value(), "artist", 6)==0 ||
-          strnicmp(entry->Value(), "album", 5)==0)
-        total++;
-      entry = entry->NextSiblingElement();
-    }
+    int progressMax = -1;
+    uint64_t progressKB = 0;
+    bool cancelled = false;
+    BeginBatch();
+    bool imported = CXMLStreamReader::ReadFile(xmlFile, [&](const std::string &name, const std::string &xml)
+    {
+      const char *element = name.c_str();
+      if (strnicmp(element, "artist", 6) != 0 &&
+          strnicmp(element, "album", 5) != 0)
+        return true;
+
+      CXBMCTinyXML xmlDoc;
+      if (!xmlDoc.Parse(xml, TIXML_ENCODING_UTF8))
+      {
+        CLog::Log(LOGERROR, "CMusicDatabase::ImportFromXML: Skipping invalid %s at line %i: %s", element, xmlDoc.ErrorRow(), xmlDoc.ErrorDesc());
+        return true;
+      }
+      TiXmlElement *entry = xmlDoc.RootElement();
 
-    BeginTransaction();
-    entry = root->FirstChildElement();
-    while (entry)
-    {
       std::string strTitle;
-      if (strnicmp(entry->Value(), "artist", 6) == 0)
+      if (strnicmp(element, "artist", 6) == 0)
       {
         CArtist importedArtist;
         importedArtist.Load(entry);
@@ -6051,10 +6159,8 @@ void CMusicDatabase::ImportFromXML(const std::string &xmlFile)
           artist.MergeScrapedArtist(importedArtist, true);
           UpdateArtist(artist);
         }
-
-        current++;
       }
-      else if (strnicmp(entry->Value(), "album", 5) == 0)
+      else
       {
         CAlbum importedAlbum;
         importedAlbum.Load(entry);
@@ -6067,31 +6173,52 @@ void CMusicDatabase::ImportFromXML(const std::string &xmlFile)
           album.MergeScrapedAlbum(importedAlbum, true);
           UpdateAlbum(album); //Will replace song artists if present in xml
         }
+      }
+      current++;
 
-        current++;
+      if (progress)
+        progress->SetLine(2, CVariant{std::move(strTitle)});
+      cancelled = !AdvanceProgress(callback, progress, 0);
+      return !cancelled;
+    },
+    [&](uint64_t read, uint64_t size)
+    {
+      // without the size of the file there is nothing to measure against, only cancelling is checked
+      if (progressMax < 0)
+      {
+        progressMax = static_cast<int>((size + 1023) / 1024);
+        if (progressMax > 0 && callback)
+          callback->SetProgressMax(progressMax);
+        else if (progressMax == 0 && progress)
+          progress->ShowProgressBar(false);
       }
-      entry = entry ->NextSiblingElement();
-      if (progress && total)
+      int steps = 0;
+      if (progressMax > 0)
       {
-        progress->SetPercentage(current * 100 / total);
-        progress->SetLine(2, CVariant{std::move(strTitle)});
-        progress->Progress();
-        if (progress->IsCanceled())
-        {
-          progress->Close();
-          RollbackTransaction();
-          return;
-        }
+        steps = static_cast<int>(read / 1024 - progressKB);
+        progressKB = read / 1024;
       }
-    }
-    CommitTransaction();
+      cancelled = !AdvanceProgress(callback, progress, steps);
+      return !cancelled;
+    });
 
-    g_infoManager.ResetLibraryBools();
+    // the import is all or nothing, as it was when it ran in a single transaction
+    if (cancelled || !imported)
+    {
+      if (!imported)
+        CLog::Log(LOGERROR, "%s: Import of %s failed after %i items", __FUNCTION__, xmlFile.c_str(), current);
+      RollbackBatch();
+    }
+    else
+    {
+      CommitBatch();
+      g_infoManager.ResetLibraryBools();
+    }
   }
   catch (...)
   {
     CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
-    RollbackTransaction();
+    RollbackBatch();
   }
   if (progress)
     progress->Close();
@@ -33,6 +33,7 @@
 
 class CArtist;
 class CFileItem;
+class IProgressCallback;
 
 namespace dbiplus
 {
@@ -74,6 +75,7 @@ typedef std::set<std::string> SETPATHES;
 typedef std::set<std::string>::iterator ISETPATHES;
 
 class CGUIDialogProgress;
+class CWeightedRandomPool;
 class CFileItemList;
 
 /*!
@@ -388,6 +390,13 @@ public:
   bool GetRandomSong(CFileItem* item, int& idSong, const Filter &filter);
   int GetSongsCount(const Filter &filter = Filter());
   unsigned int GetSongIDs(const Filter &filter, std::vector<std::pair<int,int> > &songIDs);
+
+  /*! \brief Add the songs matching a filter to a random pool, weighted by their rating and play count.
+   \param filter the songs to add
+   \param pool the pool to add the songs to
+   \return the number of songs added
+   */
+  unsigned int GetSongIDs(const Filter &filter, CWeightedRandomPool &pool);
   virtual bool GetFilter(CDbUrl &musicUrl, Filter &filter, SortDescription &sorting);
 
   /////////////////////////////////////////////////
@@ -412,8 +421,19 @@ public:
   /////////////////////////////////////////////////
   // XML
   /////////////////////////////////////////////////
-  void ExportToXML(const std::string &xmlFile, bool singleFile = false, bool images=false, bool overwrite=false);
-  void ImportFromXML(const std::string &xmlFile);
+  /*! \brief Export the library to nfo files or a single musicdb.xml.
+   The single file is written an item at a time and images are copied in the background.
+   \param progress receives the progress in items and is asked whether to cancel,
+                   the progress dialog is shown if NULL
+   */
+  void ExportToXML(const std::string &xmlFile, bool singleFile = false, bool images=false, bool overwrite=false, IProgressCallback *progress = NULL);
+
+  /*! \brief Import a musicdb.xml written by ExportToXML().
+   The file is read an item at a time, nothing is changed if the import is cancelled.
+   \param progress receives the progress in KB read and is asked whether to cancel,
+                   the progress dialog is shown if NULL
+   */
+  void ImportFromXML(const std::string &xmlFile, IProgressCallback *progress = NULL);
 
   /////////////////////////////////////////////////
   // Properties
@@ -498,6 +518,8 @@ protected:
   virtual void CreateAnalytics();
   virtual int GetMinSchemaVersion() const { return 32; }
   virtual int GetSchemaVersion() const;
+  virtual std::vector<CSearchIndex::Source> GetSearchSources() const;
+  virtual CDatabase* CreateSearchIndexDatabase() const { return new CMusicDatabase(); }
 
   const char *GetBaseDBName() const { return "MyMusic"; };
 
@@ -525,8 +547,13 @@ private:
   void GetFileItemFromDataset(const dbiplus::sql_record* const record, CFileItem* item, const CMusicDbUrl &baseUrl);
   void GetFileItemFromArtistCredits(VECARTISTCREDITS& artistCredits, CFileItem* item);
   CSong GetAlbumInfoSongFromDataset(const dbiplus::sql_record* const record, int offset = 0);
-  bool CleanupSongs();
-  bool CleanupSongsByIds(const std::string &strSongIds);
+  /*!
+   \brief Find the songs whose file no longer exists, songs on sources that can't be reached are kept.
+   \param songIds [out] ids of the songs to remove
+   \param progressDialog dialog to show the progress in, may be NULL
+   */
+  bool GetMissingSongs(std::vector<std::string> &songIds, CGUIDialogProgress *progressDialog);
+  bool CleanupSongs(const std::vector<std::string> &songIds);
   bool CleanupPaths();
   bool CleanupAlbums();
   bool CleanupArtists();
@@ -46,6 +46,7 @@
 #include "music/MusicThumbLoader.h"
 #include "music/tags/MusicInfoTag.h"
 #include "music/tags/MusicInfoTagLoaderFactory.h"
+#include "music/tags/MusicTagReader.h"
 #include "MusicAlbumInfo.h"
 #include "MusicInfoScraper.h"
 #include "NfoFile.h"
@@ -126,6 +127,10 @@ void CMusicInfoScanner::Process()
       m_currentItem=0;
       m_itemCount=-1;
 
+      m_excludeRegExps = CUtil::CompileExcludeRegExps(g_advancedSettings.m_audioExcludeFromScanRegExps);
+      m_tagReader.reset(new CMusicTagReader(g_advancedSettings.m_musicTagReadThreads,
+                                            g_advancedSettings.m_musicTagReadThreadsPerSource));
+
       // Create the thread to count all files to be scanned
       SetPriority( GetMinPriority() );
       if (m_handle)
@@ -178,9 +183,13 @@ void CMusicInfoScanner::Process()
 
           m_musicDatabase.Compress(false);
         }
+
+        // index the new items now rather than on the first search
+        m_musicDatabase.UpdateSearchIndex();
       }
 
       m_fileCountReader.StopThread();
+      m_tagReader.reset();
 
       m_musicDatabase.EmptyCache();
       
@@ -458,9 +467,7 @@ bool CMusicInfoScanner::DoScan(const std::string& strDirectory)
   m_seenPaths.insert(strDirectory);
 
   // Discard all excluded files defined by m_musicExcludeRegExps
-  const std::vector<std::string> &regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
-
-  if (IsExcluded(strDirectory, regexps))
+  if (IsExcluded(strDirectory, m_excludeRegExps))
     return true;
 
   // load subfolder
@@ -534,34 +541,39 @@ bool CMusicInfoScanner::DoScan(const std::string& strDirectory)
 
 INFO_RET CMusicInfoScanner::ScanTags(const CFileItemList& items, CFileItemList& scannedItems)
 {
-  std::vector<std::string> regexps = g_advancedSettings.m_audioExcludeFromScanRegExps;
-
+  std::vector<CFileItemPtr> files;
   for (int i = 0; i < items.Size(); ++i)
   {
-    if (m_bStop)
-      return INFO_CANCELLED;
-
     CFileItemPtr pItem = items[i];
 
-    if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), regexps))
+    if (CUtil::ExcludeFileOrFolder(pItem->GetPath(), m_excludeRegExps))
       continue;
 
     if (pItem->m_bIsFolder || pItem->IsPlayList() || pItem->IsPicture() || pItem->IsLyrics())
       continue;
 
-    m_currentItem++;
+    files.push_back(pItem);
+  }
 
-    CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
-    if (!tag.Loaded())
-    {
-      std::unique_ptr<IMusicInfoTagLoader> pLoader (CMusicInfoTagLoaderFactory::CreateLoader(*pItem));
-      if (NULL != pLoader.get())
-        pLoader->Load(pItem->GetPath(), tag);
-    }
+  // the tags of all files are read in parallel, the files are then added in their original order
+  std::unique_ptr<CMusicTagReader> reader;
+  CMusicTagReader *tagReader = m_tagReader.get();
+  if (!tagReader)
+  {
+    reader.reset(new CMusicTagReader(1, 0));
+    tagReader = reader.get();
+  }
+  if (!tagReader->Read(files, m_bStop))
+    return INFO_CANCELLED;
+
+  for (const CFileItemPtr &pItem : files)
+  {
+    m_currentItem++;
 
     if (m_handle && m_itemCount>0)
       m_handle->SetPercentage(m_currentItem / (float)m_itemCount * 100);
 
+    CMusicInfoTag& tag = *pItem->GetMusicInfoTag();
     if (!tag.Loaded() && !pItem->HasCueDocument())
     {
       CLog::Log(LOGDEBUG, "%s - No tag found for: %s", __FUNCTION__, pItem->GetPath().c_str());
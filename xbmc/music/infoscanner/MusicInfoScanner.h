@@ -23,6 +23,9 @@
 #include "MusicInfoScraper.h"
 #include "music/MusicDatabase.h"
 #include "threads/Thread.h"
+#include "utils/RegExp.h"
+
+#include <memory>
 
 class CAlbum;
 class CArtist;
@@ -30,6 +33,8 @@ class CGUIDialogProgressBarHandle;
 
 namespace MUSIC_INFO
 {
+class CMusicTagReader;
+
 /*! \brief return values from the information lookup functions
  */
 enum INFO_RET 
@@ -223,5 +228,8 @@ protected:
   std::set<std::string> m_seenPaths;
   int m_flags;
   CThread m_fileCountReader;
+
+  std::vector<CRegExp> m_excludeRegExps;
+  std::unique_ptr<CMusicTagReader> m_tagReader;
 };
 }
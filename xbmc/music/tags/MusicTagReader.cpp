@@ -0,0 +1,159 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "MusicTagReader.h"
+#include "MusicInfoTag.h"
+#include "MusicInfoTagLoaderFactory.h"
+#include "URL.h"
+#include "threads/SingleLock.h"
+#include "utils/URIUtils.h"
+
+using namespace MUSIC_INFO;
+
+CMusicTagReader::CMusicTagReader(unsigned int threads, unsigned int threadsPerSource)
+  : m_threadsPerSource(threadsPerSource),
+    m_first(0),
+    m_pending(0),
+    m_running(0),
+    m_quit(false)
+{
+  if (threads == 0)
+    threads = 1;
+
+  for (unsigned int i = 0; i < threads; i++)
+  {
+    m_workers.emplace_back(new CThread(this, "MusicTagReader"));
+    m_workers.back()->Create();
+  }
+}
+
+CMusicTagReader::~CMusicTagReader()
+{
+  {
+    CSingleLock lock(m_section);
+    m_quit = true;
+    m_changed.notifyAll();
+  }
+  for (auto &worker : m_workers)
+    worker->StopThread();
+}
+
+bool CMusicTagReader::Read(const std::vector<CFileItemPtr> &items, const std::atomic<bool> &stop)
+{
+  CSingleLock lock(m_section);
+
+  for (const CFileItemPtr &item : items)
+  {
+    if (item->GetMusicInfoTag()->Loaded())
+      continue;
+    m_items.push_back(item);
+    m_sources.push_back(GetSourceKey(item->GetPath()));
+  }
+  m_started.assign(m_items.size(), false);
+  m_first = 0;
+  m_pending = m_items.size();
+  m_changed.notifyAll();
+
+  bool stopped = false;
+  while (m_pending > 0 || m_running > 0)
+  {
+    if (stop && m_pending > 0)
+    {
+      // skip the files that have not been started
+      stopped = true;
+      m_pending = 0;
+      m_first = m_items.size();
+    }
+    m_changed.wait(lock, 100);
+  }
+
+  m_items.clear();
+  m_sources.clear();
+  m_started.clear();
+  return !stopped;
+}
+
+std::string CMusicTagReader::GetSourceKey(const std::string &path)
+{
+  if (!URIUtils::IsRemote(path))
+    return "";
+
+  // files inside archives are read from the host of the archive
+  CURL url(path);
+  while (URIUtils::HasParentInHostname(url))
+    url = CURL(url.GetHostName());
+  return url.GetProtocol() + "://" + url.GetHostName();
+}
+
+void CMusicTagReader::Run()
+{
+  CSingleLock lock(m_section);
+  while (!m_quit)
+  {
+    size_t index;
+    if (!NextItem(index))
+    {
+      m_changed.wait(lock);
+      continue;
+    }
+
+    CFileItemPtr item = m_items[index];
+    std::string source = m_sources[index];
+
+    lock.Leave();
+    LoadTag(*item);
+    lock.Enter();
+
+    m_sourceRunning[source]--;
+    m_running--;
+    m_changed.notifyAll();
+  }
+}
+
+bool CMusicTagReader::NextItem(size_t &index)
+{
+  while (m_first < m_items.size() && m_started[m_first])
+    m_first++;
+
+  // files are started in order, unless their source is busy
+  for (size_t i = m_first; i < m_items.size(); i++)
+  {
+    if (m_started[i])
+      continue;
+    unsigned int &running = m_sourceRunning[m_sources[i]];
+    if (m_threadsPerSource > 0 && running >= m_threadsPerSource)
+      continue;
+
+    m_started[i] = true;
+    running++;
+    m_pending--;
+    m_running++;
+    index = i;
+    return true;
+  }
+  return false;
+}
+
+void CMusicTagReader::LoadTag(CFileItem &item)
+{
+  std::unique_ptr<IMusicInfoTagLoader> pLoader(CMusicInfoTagLoaderFactory::CreateLoader(item));
+  if (NULL != pLoader.get())
+    pLoader->Load(item.GetPath(), *item.GetMusicInfoTag());
+}
@@ -0,0 +1,86 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FileItem.h"
+#include "threads/Condition.h"
+#include "threads/CriticalSection.h"
+#include "threads/Thread.h"
+
+namespace MUSIC_INFO
+{
+  /*!
+   \brief Loads the tags of music files on a pool of worker threads.
+
+   Reading a tag is mostly waiting for the file system, so several files are
+   read at once. How many files of one source (a network host, or the local
+   file system) are read at the same time is limited separately, so a single
+   server is not flooded with requests.
+   */
+  class CMusicTagReader : public IRunnable
+  {
+  public:
+    /*!
+     \param threads number of worker threads
+     \param threadsPerSource number of files read at once from one source, 0 for no limit
+     */
+    CMusicTagReader(unsigned int threads, unsigned int threadsPerSource);
+    virtual ~CMusicTagReader();
+
+    /*!
+     \brief Load the tags of all items whose tag is not loaded yet.
+     Returns when all tags are read. Once stop is set, files that have not been
+     started are skipped. Not to be called from several threads at once.
+     \return false if stopped before all files were read
+     */
+    bool Read(const std::vector<CFileItemPtr> &items, const std::atomic<bool> &stop);
+
+    /*!
+     \brief The source a file is read from, files with the same key share the per source limit.
+     */
+    static std::string GetSourceKey(const std::string &path);
+
+    virtual void Run() override;
+
+  private:
+    bool NextItem(size_t &index);
+    static void LoadTag(CFileItem &item);
+
+    unsigned int m_threadsPerSource;
+    std::vector<std::unique_ptr<CThread> > m_workers;
+
+    CCriticalSection m_section;
+    XbmcThreads::ConditionVariable m_changed; // items were added, started or finished
+    std::vector<CFileItemPtr> m_items;
+    std::vector<std::string> m_sources;
+    std::vector<bool> m_started;
+    size_t m_first;    // first item that has not been started
+    size_t m_pending;  // items not started yet
+    size_t m_running;  // items being read
+    std::map<std::string, unsigned int> m_sourceRunning;
+    bool m_quit;
+  };
+}
@@ -22,6 +22,9 @@
 #include "filesystem/File.h"
 #include <taglib/tiostream.h>
 
+#include <algorithm>
+#include <string.h>
+
 using namespace XFILE;
 using namespace TagLib;
 using namespace MUSIC_INFO;
@@ -34,11 +37,24 @@ using namespace MUSIC_INFO;
 #endif
 #endif
 
+// size of the cached blocks
+#define BLOCK_SIZE      16384
+// number of cached blocks, larger reads bypass the cache
+#define BLOCK_COUNT     64
+// bytes read up front from the start and the end of the file
+#define PREFETCH_HEAD   65536
+#define PREFETCH_TAIL   32768
+
 /*!
  * Construct a File object and opens the \a file.  \a file should be a
  * be an XBMC Vfile.
  */
-TagLibVFSStream::TagLibVFSStream(const std::string& strFileName, bool readOnly)
+TagLibVFSStream::TagLibVFSStream(const std::string& strFileName, bool readOnly, bool buffered)
+  : m_length(0),
+    m_position(0),
+    m_filePosition(0),
+    m_vfsCalls(0),
+    m_bytesRead(0)
 {
   m_bIsOpen = true;
   if (readOnly)
@@ -53,6 +69,16 @@ TagLibVFSStream::TagLibVFSStream(const std::string& strFileName, bool readOnly)
   }
   m_strFileName = strFileName;
   m_bIsReadOnly = readOnly || !m_bIsOpen;
+
+  // the cache needs to know where the file ends
+  m_bIsBuffered = buffered && readOnly && m_bIsOpen;
+  if (m_bIsBuffered)
+  {
+    m_length = m_file.GetLength();
+    m_filePosition = m_file.GetPosition();
+    m_bIsBuffered = m_length > 0;
+  }
+  m_bPrefetched = false;
 }
 
 /*!
@@ -76,8 +102,66 @@ FileName TagLibVFSStream::name() const
  */
 ByteVector TagLibVFSStream::readBlock(TagLib::ulong length)
 {
+  if (!m_bIsBuffered)
+    return readUnbuffered(length);
+
+  if (!m_bPrefetched)
+  {
+    m_bPrefetched = true;
+    prefetch();
+  }
+
+  if (m_position >= m_length || length == 0)
+    return ByteVector();
+  length = static_cast<TagLib::ulong>(std::min<int64_t>(length, m_length - m_position));
+
+  int64_t first = m_position / BLOCK_SIZE;
+  int64_t last = (m_position + length - 1) / BLOCK_SIZE;
+  if (last - first + 1 > BLOCK_COUNT / 2)
+  {
+    // too large to cache without pushing out the tags
+    seekFile(m_position, SEEK_SET);
+    ByteVector byteVector = readUnbuffered(length);
+    m_position += byteVector.size();
+    return byteVector;
+  }
+
+  // keep the blocks we already have, then read the missing ones in one go
+  int64_t firstMissing = -1;
+  int64_t lastMissing = -1;
+  for (int64_t i = first; i <= last; i++)
+  {
+    if (findBlock(i))
+      continue;
+    if (firstMissing < 0)
+      firstMissing = i;
+    lastMissing = i;
+  }
+  if (firstMissing >= 0 && !fetchBlocks(firstMissing, lastMissing))
+    return ByteVector();
+
   ByteVector byteVector(static_cast<TagLib::uint>(length));
-  ssize_t read = m_file.Read(byteVector.data(), length);
+  TagLib::ulong copied = 0;
+  while (copied < length)
+  {
+    Block *block = findBlock(m_position / BLOCK_SIZE);
+    size_t offset = static_cast<size_t>(m_position % BLOCK_SIZE);
+    if (!block || offset >= block->second.size())
+      break;
+    size_t size = std::min<size_t>(block->second.size() - offset, length - copied);
+    memcpy(byteVector.data() + copied, block->second.data() + offset, size);
+    copied += size;
+    m_position += size;
+  }
+  byteVector.resize(static_cast<TagLib::uint>(copied));
+
+  return byteVector;
+}
+
+ByteVector TagLibVFSStream::readUnbuffered(TagLib::ulong length)
+{
+  ByteVector byteVector(static_cast<TagLib::uint>(length));
+  ssize_t read = readFile(byteVector.data(), length);
   if (read > 0)
     byteVector.resize(read);
   else
@@ -86,6 +170,99 @@ ByteVector TagLibVFSStream::readBlock(TagLib::ulong length)
   return byteVector;
 }
 
+/*!
+ * Reads the start and the end of the file into the cache, that's where
+ * TagLib looks for the tags.
+ */
+void TagLibVFSStream::prefetch()
+{
+  int64_t blocks = (m_length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  int64_t head = std::min<int64_t>(PREFETCH_HEAD / BLOCK_SIZE, blocks);
+  int64_t tail = std::min<int64_t>(PREFETCH_TAIL / BLOCK_SIZE, blocks - head);
+
+  if (head + tail >= blocks)
+    fetchBlocks(0, blocks - 1);
+  else
+  {
+    fetchBlocks(0, head - 1);
+    fetchBlocks(blocks - tail, blocks - 1);
+  }
+}
+
+/*!
+ * Reads the blocks \a first to \a last with a single read and adds them to
+ * the cache.
+ */
+bool TagLibVFSStream::fetchBlocks(int64_t first, int64_t last)
+{
+  int64_t start = first * BLOCK_SIZE;
+  size_t size = static_cast<size_t>(std::min<int64_t>((last + 1) * BLOCK_SIZE, m_length) - start);
+  std::vector<char> buffer(size);
+
+  if (seekFile(start, SEEK_SET) != start)
+    return false;
+  ssize_t read = readFile(buffer.data(), size);
+  if (read <= 0)
+    return false;
+
+  for (int64_t i = first; i <= last && (i - first) * BLOCK_SIZE < read; i++)
+  {
+    size_t offset = static_cast<size_t>((i - first) * BLOCK_SIZE);
+    size_t length = std::min<size_t>(BLOCK_SIZE, read - offset);
+    if (length < BLOCK_SIZE && start + static_cast<int64_t>(offset + length) < m_length)
+      break; // short read, only the last block of the file may be partial
+    if (findBlock(i))
+      continue;
+
+    m_blocks.push_front(Block(i, std::vector<char>(buffer.begin() + offset, buffer.begin() + offset + length)));
+    m_blockIndex[i] = m_blocks.begin();
+    if (m_blocks.size() > BLOCK_COUNT)
+    {
+      m_blockIndex.erase(m_blocks.back().first);
+      m_blocks.pop_back();
+    }
+  }
+  return true;
+}
+
+/*!
+ * Returns the cached block \a index and marks it as most recently used.
+ */
+TagLibVFSStream::Block* TagLibVFSStream::findBlock(int64_t index)
+{
+  auto it = m_blockIndex.find(index);
+  if (it == m_blockIndex.end())
+    return NULL;
+  m_blocks.splice(m_blocks.begin(), m_blocks, it->second);
+  return &m_blocks.front();
+}
+
+ssize_t TagLibVFSStream::readFile(void *buffer, size_t length)
+{
+  m_vfsCalls++;
+  ssize_t read = m_file.Read(buffer, length);
+  if (read > 0)
+  {
+    m_bytesRead += read;
+    m_filePosition += read;
+  }
+  else
+    m_filePosition = m_file.GetPosition();
+  return read;
+}
+
+int64_t TagLibVFSStream::seekFile(int64_t offset, int whence)
+{
+  // reads at the current position need no seek
+  if (m_bIsBuffered && whence == SEEK_SET && offset == m_filePosition)
+    return m_filePosition;
+
+  m_vfsCalls++;
+  int64_t position = m_file.Seek(offset, whence);
+  m_filePosition = position >= 0 ? position : m_file.GetPosition();
+  return position;
+}
+
 /*!
  * Attempts to write the block \a data at the current get pointer.  If the
  * file is currently only opened read only -- i.e. readOnly() returns true --
@@ -148,7 +325,7 @@ void TagLibVFSStream::insert(const ByteVector &data, TagLib::ulong start, TagLib
   // special case.  We're also using File::writeBlock() just for the tag.
   // That's a bit slower than using char *'s so, we're only doing it here.
   seek(readPosition);
-  ssize_t bytesRead = m_file.Read(aboutToOverwrite.data(), bufferLength);
+  ssize_t bytesRead = readFile(aboutToOverwrite.data(), bufferLength);
   if (bytesRead <= 0)
     return; // error
   readPosition += bufferLength;
@@ -167,7 +344,7 @@ void TagLibVFSStream::insert(const ByteVector &data, TagLib::ulong start, TagLib
     // Seek to the current read position and read the data that we're about
     // to overwrite.  Appropriately increment the readPosition.
     seek(readPosition);
-    bytesRead = m_file.Read(aboutToOverwrite.data(), bufferLength);
+    bytesRead = readFile(aboutToOverwrite.data(), bufferLength);
     if (bytesRead <= 0)
       return; // error
     aboutToOverwrite.resize(bytesRead);
@@ -211,7 +388,7 @@ void TagLibVFSStream::removeBlock(TagLib::ulong start, TagLib::ulong length)
   while(bytesRead != 0)
   {
     seek(readPosition);
-    ssize_t read = m_file.Read(buffer.data(), bufferLength);
+    ssize_t read = readFile(buffer.data(), bufferLength);
     if (read < 0)
       return;// explicit error
 
@@ -256,6 +433,23 @@ bool TagLibVFSStream::isOpen() const
  */
 void TagLibVFSStream::seek(long offset, Position p)
 {
+  if (m_bIsBuffered)
+  {
+    // only move the stream position, the file is seeked when a block is read.
+    // Seeks outside of the file end at the nearest valid position, as below.
+    int64_t position;
+    if (p == Beginning)
+      position = offset;
+    else if (p == Current)
+      position = m_position + offset;
+    else if (p == End)
+      position = m_length + offset;
+    else
+      return; // wrong Position value
+    m_position = std::max<int64_t>(0, std::min(position, m_length));
+    return;
+  }
+
   const long fileLen = length();
   if (m_bIsReadOnly && fileLen > 0)
   {
@@ -277,12 +471,12 @@ void TagLibVFSStream::seek(long offset, Position p)
     {
       if (offset < 0 && startPos + offset < 0)
       {
-        m_file.Seek(0, SEEK_SET);
+        seekFile(0, SEEK_SET);
         return;
       }
       if (offset > 0 && startPos + offset > fileLen)
       {
-        m_file.Seek(fileLen, SEEK_SET);
+        seekFile(fileLen, SEEK_SET);
         return;
       }
     }
@@ -291,13 +485,13 @@ void TagLibVFSStream::seek(long offset, Position p)
   switch(p)
   {
     case Beginning:
-      m_file.Seek(offset, SEEK_SET);
+      seekFile(offset, SEEK_SET);
       break;
     case Current:
-      m_file.Seek(offset, SEEK_CUR);
+      seekFile(offset, SEEK_CUR);
       break;
     case End:
-      m_file.Seek(offset, SEEK_END);
+      seekFile(offset, SEEK_END);
       break;
   }
 }
@@ -314,7 +508,7 @@ void TagLibVFSStream::clear()
  */
 long TagLibVFSStream::tell() const
 {
-  int64_t pos = m_file.GetPosition();
+  int64_t pos = m_bIsBuffered ? m_position : m_file.GetPosition();
   if(pos > LONG_MAX)
     return -1;
   else
@@ -326,6 +520,8 @@ long TagLibVFSStream::tell() const
  */
 long TagLibVFSStream::length()
 {
+  if (m_bIsBuffered)
+    return (long)m_length;
   return (long)m_file.GetLength();
 }
 
@@ -21,6 +21,11 @@
 #include "filesystem/File.h"
 #include <taglib/tiostream.h>
 
+#include <list>
+#include <map>
+#include <stdint.h>
+#include <vector>
+
 namespace MUSIC_INFO
 {
   class TagLibVFSStream : public TagLib::IOStream
@@ -29,8 +34,13 @@ namespace MUSIC_INFO
     /*!
      * Construct a File object and opens the \a file.  \a file should be a
      * be an XBMC Vfile.
+     *
+     * Read only streams are \a buffered by default: the start and the end of
+     * the file, where the tags live, are read on the first read and all reads go through
+     * a small cache of aligned blocks, so the many small reads and seeks of
+     * TagLib don't each become a round trip to the file system.
      */
-    TagLibVFSStream(const std::string& strFileName, bool readOnly);
+    TagLibVFSStream(const std::string& strFileName, bool readOnly, bool buffered = true);
 
     /*!
      * Destroys this ByteVectorStream instance.
@@ -115,18 +125,56 @@ namespace MUSIC_INFO
      */
     void truncate(long length);
 
+    /*!
+     * Returns the number of reads and seeks done on the underlying file.
+     */
+    unsigned int vfsCalls() const { return m_vfsCalls; }
+
+    /*!
+     * Returns the number of bytes read from the underlying file.
+     */
+    uint64_t bytesRead() const { return m_bytesRead; }
+
   protected:
+    /*!
+     * Reads from the underlying file, all reads of the stream end up here.
+     */
+    virtual ssize_t readFile(void *buffer, size_t length);
+
+    /*!
+     * Seeks the underlying file, all seeks of the stream end up here.
+     */
+    virtual int64_t seekFile(int64_t offset, int whence);
+
     /*!
      * Returns the buffer size that is used for internal buffering.
      */
     static TagLib::uint bufferSize() { return 1024; };
 
   private:
+    typedef std::pair<int64_t, std::vector<char> > Block;
+
+    void prefetch();
+    bool fetchBlocks(int64_t first, int64_t last);
+    Block* findBlock(int64_t index);
+    TagLib::ByteVector readUnbuffered(TagLib::ulong length);
+
     std::string   m_strFileName;
     XFILE::CFile  m_file;
     bool          m_bIsReadOnly;
     bool          m_bIsOpen;
     int           m_bufferSize;
+
+    bool          m_bIsBuffered;
+    bool          m_bPrefetched;
+    int64_t       m_length;
+    int64_t       m_position;       // position of the stream
+    int64_t       m_filePosition;   // position of the underlying file
+    std::list<Block> m_blocks;      // most recently used first
+    std::map<int64_t, std::list<Block>::iterator> m_blockIndex;
+
+    unsigned int  m_vfsCalls;
+    uint64_t      m_bytesRead;
   };
 }
 
@@ -20,6 +20,7 @@
 
 #include "TagLoaderTagLib.h"
 
+#include <inttypes.h>
 #include <vector>
 
 #include <taglib/id3v1tag.h>
@@ -64,6 +65,7 @@
 
 #include "TagLibVFSStream.h"
 #include "MusicInfoTag.h"
+#include "URL.h"
 #include "ReplayGain.h"
 #include "utils/RegExp.h"
 #include "utils/URIUtils.h"
@@ -1163,6 +1165,9 @@ bool CTagLoaderTagLib::Load(const std::string& strFileName, CMusicInfoTag& tag,
     tag.SetLoaded();
   tag.SetURL(strFileName);
 
+  CLog::Log(LOGDEBUG, "%s: tags of %s read with %u file system calls, %" PRIu64 " bytes",
+            __FUNCTION__, CURL::GetRedacted(strFileName).c_str(), stream->vfsCalls(), stream->bytesRead());
+
   delete file;
   delete stream;
 
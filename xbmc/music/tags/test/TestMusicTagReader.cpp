@@ -0,0 +1,143 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "URL.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "music/tags/MusicInfoTag.h"
+#include "music/tags/MusicTagReader.h"
+#include "utils/StringUtils.h"
+#include "utils/TimeUtils.h"
+#include "utils/URIUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <vector>
+
+#include <taglib/wavfile.h>
+
+#include "gtest/gtest.h"
+
+using namespace MUSIC_INFO;
+
+/* The benchmark generates small tagged wav files below special://temp and
+ * reads their tags once on a single worker and once on a pool, the way the
+ * music scanner reads a folder. The tracks/sec of both runs are written as
+ * json to stdout.
+ */
+
+#define BENCHMARK_FOLDER "special://temp/musictagreader/"
+#define BENCHMARK_FILES  300
+
+namespace
+{
+
+bool WriteTrack(const std::string &path, int number)
+{
+  // 0.1s of 8 bit mono silence
+  const uint32_t dataSize = 800;
+  const uint8_t header[] = {
+    'R', 'I', 'F', 'F', (36 + dataSize) & 0xff, (36 + dataSize) >> 8, 0, 0,
+    'W', 'A', 'V', 'E', 'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0,
+    0x40, 0x1f, 0, 0, 0x40, 0x1f, 0, 0, 1, 0, 8, 0,
+    'd', 'a', 't', 'a', dataSize & 0xff, dataSize >> 8, 0, 0 };
+  std::vector<uint8_t> data(header, header + sizeof(header));
+  data.resize(data.size() + dataSize, 0x80);
+
+  XFILE::CFile file;
+  if (!file.OpenForWrite(path, true) ||
+      file.Write(data.data(), data.size()) != static_cast<ssize_t>(data.size()))
+    return false;
+  file.Close();
+
+  TagLib::RIFF::WAV::File wav(CSpecialProtocol::TranslatePath(path).c_str());
+  if (!wav.isValid())
+    return false;
+  wav.tag()->setTitle(StringUtils::Format("Track %d", number));
+  wav.tag()->setArtist("Artist");
+  wav.tag()->setAlbum(StringUtils::Format("Album %d", number / 10));
+  wav.tag()->setTrack(number % 10 + 1);
+  return wav.save();
+}
+
+std::vector<CFileItemPtr> CreateItems(const std::vector<std::string> &paths)
+{
+  std::vector<CFileItemPtr> items;
+  for (const std::string &path : paths)
+    items.push_back(CFileItemPtr(new CFileItem(path, false)));
+  return items;
+}
+
+double ReadTags(CMusicTagReader &reader, const std::vector<CFileItemPtr> &items)
+{
+  std::atomic<bool> stop(false);
+  int64_t start = CurrentHostCounter();
+  EXPECT_TRUE(reader.Read(items, stop));
+  double seconds = (double)(CurrentHostCounter() - start) / CurrentHostFrequency();
+  return items.size() / std::max(seconds, 1e-6);
+}
+
+}
+
+TEST(TestMusicTagReader, GetSourceKey)
+{
+  EXPECT_EQ("", CMusicTagReader::GetSourceKey("/music/a.flac"));
+  EXPECT_EQ("smb://server", CMusicTagReader::GetSourceKey("smb://server/music/a.flac"));
+  EXPECT_EQ("nfs://server", CMusicTagReader::GetSourceKey("nfs://server/export/b.flac"));
+  EXPECT_EQ("smb://server", CMusicTagReader::GetSourceKey(
+    URIUtils::CreateArchivePath("zip", CURL("smb://server/music/album.zip"), "c.flac").Get()));
+}
+
+TEST(TestMusicTagReader, Benchmark)
+{
+  XFILE::CDirectory::Create(BENCHMARK_FOLDER);
+  std::vector<std::string> paths;
+  for (int i = 0; i < BENCHMARK_FILES; i++)
+  {
+    paths.push_back(StringUtils::Format(BENCHMARK_FOLDER "track%04d.wav", i));
+    ASSERT_TRUE(WriteTrack(paths.back(), i)) << paths.back();
+  }
+
+  std::vector<CFileItemPtr> serial = CreateItems(paths);
+  std::vector<CFileItemPtr> parallel = CreateItems(paths);
+
+  CMusicTagReader serialReader(1, 0);
+  CMusicTagReader poolReader(8, 4);
+  double serialRate = ReadTags(serialReader, serial);
+  double poolRate = ReadTags(poolReader, parallel);
+
+  // every item gets its own tag, whatever the order the files were read in
+  for (size_t i = 0; i < paths.size(); i++)
+  {
+    std::string title = StringUtils::Format("Track %d", (int)i);
+    EXPECT_EQ(title, serial[i]->GetMusicInfoTag()->GetTitle());
+    EXPECT_EQ(title, parallel[i]->GetMusicInfoTag()->GetTitle());
+  }
+
+  std::cout << StringUtils::Format("{\"files\": %d, \"serial_tracks_per_sec\": %.1f, \"pool_tracks_per_sec\": %.1f}",
+                                   BENCHMARK_FILES, serialRate, poolRate) << std::endl;
+
+  for (const std::string &path : paths)
+    XFILE::CFile::Delete(path);
+  XFILE::CDirectory::Remove(BENCHMARK_FOLDER);
+}
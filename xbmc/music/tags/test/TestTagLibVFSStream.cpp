@@ -0,0 +1,185 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "music/tags/TagLibVFSStream.h"
+#include "test/TestUtils.h"
+#include "threads/SystemClock.h"
+#include "threads/Thread.h"
+#include "utils/StringUtils.h"
+
+#include <inttypes.h>
+#include <iostream>
+#include <vector>
+
+#include <taglib/attachedpictureframe.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/wavfile.h>
+
+#include "gtest/gtest.h"
+
+using namespace MUSIC_INFO;
+
+namespace
+{
+
+/* Adds a fixed delay to every read and seek, like a network file system. */
+class CSlowStream : public TagLibVFSStream
+{
+public:
+  CSlowStream(const std::string &path, bool buffered, unsigned int latency)
+    : TagLibVFSStream(path, true, buffered), m_latency(latency) {}
+
+protected:
+  virtual ssize_t readFile(void *buffer, size_t length) override
+  {
+    XbmcThreads::ThreadSleep(m_latency);
+    return TagLibVFSStream::readFile(buffer, length);
+  }
+
+  virtual int64_t seekFile(int64_t offset, int whence) override
+  {
+    XbmcThreads::ThreadSleep(m_latency);
+    return TagLibVFSStream::seekFile(offset, whence);
+  }
+
+private:
+  unsigned int m_latency;
+};
+
+class TestTagLibVFSStream : public testing::Test
+{
+protected:
+  TestTagLibVFSStream() : m_file(NULL) {}
+
+  ~TestTagLibVFSStream()
+  {
+    if (m_file)
+      XBMC_DELETETEMPFILE(m_file);
+  }
+
+  /* 2MB of 8 bit mono audio with an id3v2 tag carrying a 200kB picture */
+  bool CreateTrack()
+  {
+    const uint32_t dataSize = 2 * 1024 * 1024;
+    std::vector<uint8_t> data = {
+      'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+      'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0,
+      0x44, 0xac, 0, 0, 0x44, 0xac, 0, 0, 1, 0, 8, 0,
+      'd', 'a', 't', 'a', 0, 0, 0, 0 };
+    for (int i = 0; i < 4; i++)
+    {
+      data[4 + i] = ((36 + dataSize) >> (8 * i)) & 0xff;
+      data[40 + i] = (dataSize >> (8 * i)) & 0xff;
+    }
+    for (uint32_t i = 0; i < dataSize; i++)
+      data.push_back(i * 7 & 0xff);
+
+    m_file = XBMC_CREATETEMPFILE(".wav");
+    if (!m_file)
+      return false;
+    bool ret = m_file->Write(data.data(), data.size()) == static_cast<ssize_t>(data.size());
+    m_file->Close();
+    if (!ret)
+      return false;
+
+    m_path = XBMC_TEMPFILEPATH(m_file);
+    TagLib::RIFF::WAV::File wav(CSpecialProtocol::TranslatePath(m_path).c_str());
+    if (!wav.isValid())
+      return false;
+    wav.ID3v2Tag()->setTitle("Title");
+    wav.ID3v2Tag()->setArtist("Artist");
+    TagLib::ID3v2::AttachedPictureFrame *picture = new TagLib::ID3v2::AttachedPictureFrame;
+    picture->setMimeType("image/jpeg");
+    picture->setPicture(TagLib::ByteVector(200 * 1024, 'x'));
+    wav.ID3v2Tag()->addFrame(picture);
+    return wav.save();
+  }
+
+  XFILE::CFile *m_file;
+  std::string m_path;
+};
+
+}
+
+/* The cache must return exactly what the file contains, wherever TagLib reads. */
+TEST_F(TestTagLibVFSStream, ReadsMatchFile)
+{
+  ASSERT_TRUE(CreateTrack());
+
+  TagLibVFSStream buffered(m_path, true);
+  TagLibVFSStream direct(m_path, true, false);
+  ASSERT_TRUE(buffered.isOpen());
+  ASSERT_EQ(direct.length(), buffered.length());
+
+  long length = buffered.length();
+  uint32_t random = 12345;
+  for (int i = 0; i < 500; i++)
+  {
+    random = random * 1103515245 + 12345;
+    long offset = (random >> 8) % (length + 100);
+    TagLib::ulong size = (i % 10 == 0) ? 800000 : (random & 0xffff);
+
+    buffered.seek(offset);
+    direct.seek(offset);
+    EXPECT_EQ(direct.tell(), buffered.tell());
+    EXPECT_TRUE(direct.readBlock(size) == buffered.readBlock(size)) << offset << " " << size;
+    EXPECT_EQ(direct.tell(), buffered.tell());
+  }
+
+  buffered.seek(-128, TagLib::IOStream::End);
+  EXPECT_EQ(length - 128, buffered.tell());
+  EXPECT_EQ(128u, buffered.readBlock(1024).size());
+  EXPECT_TRUE(buffered.readBlock(1).isEmpty());
+}
+
+/* Parse the tag over a slow file system with and without the cache and
+ * print the file system calls, bytes read and time needed as json. */
+TEST_F(TestTagLibVFSStream, Benchmark)
+{
+  ASSERT_TRUE(CreateTrack());
+
+  const unsigned int latency = 5;
+  std::string json;
+  unsigned int directCalls = 0;
+  for (int buffered = 0; buffered < 2; buffered++)
+  {
+    CSlowStream stream(m_path, buffered != 0, latency);
+    unsigned int start = XbmcThreads::SystemClockMillis();
+    {
+      TagLib::RIFF::WAV::File wav(&stream);
+      ASSERT_TRUE(wav.isValid());
+      EXPECT_EQ("Title", wav.ID3v2Tag()->title().to8Bit(true));
+      EXPECT_EQ(1u, wav.ID3v2Tag()->frameListMap()["APIC"].size());
+    }
+    unsigned int elapsed = XbmcThreads::SystemClockMillis() - start;
+
+    json += StringUtils::Format("%s\"%s\": {\"vfs_calls\": %u, \"bytes_read\": %" PRIu64 ", \"ms\": %u}",
+                                buffered ? ", " : "", buffered ? "buffered" : "direct",
+                                stream.vfsCalls(), stream.bytesRead(), elapsed);
+    if (buffered)
+      EXPECT_LT(stream.vfsCalls(), directCalls);
+    else
+      directCalls = stream.vfsCalls();
+  }
+
+  std::cout << "{\"latency_ms\": " << latency << ", " << json << "}" << std::endl;
+}
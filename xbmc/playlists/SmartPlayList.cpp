@@ -671,9 +671,9 @@ std::string CSmartPlaylistRule::GetLocalizedRule() const
   return StringUtils::Format("%s %s %s", GetLocalizedField(m_field).c_str(), GetLocalizedOperator(m_operator).c_str(), GetParameter().c_str());
 }
 
-std::string CSmartPlaylistRule::GetVideoResolutionQuery(const std::string &parameter) const
+std::string CSmartPlaylistRule::GetVideoResolutionQuery(const std::string &parameter, const std::string &table) const
 {
-  std::string retVal(" IN (SELECT DISTINCT idFile FROM streamdetails WHERE iVideoWidth ");
+  std::string retVal(" EXISTS (SELECT 1 FROM streamdetails WHERE streamdetails.idFile = " + table + ".idFile AND ");
   int iRes = (int)std::strtol(parameter.c_str(), NULL, 10);
 
   int min, max;
@@ -685,18 +685,19 @@ std::string CSmartPlaylistRule::GetVideoResolutionQuery(const std::string &param
   switch (m_operator)
   {
     case OPERATOR_EQUALS:
-      retVal += StringUtils::Format(">= %i AND iVideoWidth <= %i", min, max);
+      retVal += StringUtils::Format("iVideoWidth >= %i AND iVideoWidth <= %i", min, max);
       break;
     case OPERATOR_DOES_NOT_EQUAL:
-      retVal += StringUtils::Format("< %i OR iVideoWidth > %i", min, max);
+      retVal += StringUtils::Format("(iVideoWidth < %i OR iVideoWidth > %i)", min, max);
       break;
     case OPERATOR_LESS_THAN:
-      retVal += StringUtils::Format("< %i", min);
+      retVal += StringUtils::Format("iVideoWidth < %i", min);
       break;
     case OPERATOR_GREATER_THAN:
-      retVal += StringUtils::Format("> %i", max);
+      retVal += StringUtils::Format("iVideoWidth > %i", max);
       break;
     default:
+      retVal += "1";
       break;
   }
 
@@ -709,14 +710,14 @@ std::string CSmartPlaylistRule::GetBooleanQuery(const std::string &negate, const
   if (strType == "movies")
   {
     if (m_field == FieldInProgress)
-      return "movie_view.idFile " + negate + " IN (SELECT DISTINCT idFile FROM bookmark WHERE type = 1)";
+      return negate + " EXISTS (SELECT 1 FROM bookmark WHERE bookmark.idFile = movie_view.idFile AND bookmark.type = 1)";
     else if (m_field == FieldTrailer)
       return negate + GetField(m_field, strType) + "!= ''";
   }
   else if (strType == "episodes")
   {
     if (m_field == FieldInProgress)
-      return "episode_view.idFile " + negate + " IN (SELECT DISTINCT idFile FROM bookmark WHERE type = 1)";
+      return negate + " EXISTS (SELECT 1 FROM bookmark WHERE bookmark.idFile = episode_view.idFile AND bookmark.type = 1)";
   }
   else if (strType == "tvshows")
   {
@@ -756,13 +757,170 @@ std::string CSmartPlaylistRule::FormatParameter(const std::string &operatorStrin
   return CDatabaseQueryRule::FormatParameter(operatorString, param, db, strType);
 }
 
-std::string CSmartPlaylistRule::FormatLinkQuery(const char *field, const char *table, const MediaType& mediaType, const std::string& mediaField, const std::string& parameter)
+std::string CSmartPlaylistRule::FormatLinkQuery(const char *field, const char *table, const MediaType& mediaType, const std::string& mediaField)
 {
-  // NOTE: no need for a PrepareSQL here, as the parameter has already been formatted
+  // NOTE: the condition on the name is filled in by the caller
   return StringUtils::Format(" EXISTS (SELECT 1 FROM %s_link"
                              "         JOIN %s ON %s.%s_id=%s_link.%s_id"
-                             "         WHERE %s_link.media_id=%s AND %s.name %s AND %s_link.media_type = '%s')",
-                             field, table, table, table, field, table, field, mediaField.c_str(), table, parameter.c_str(), field, mediaType.c_str());
+                             "         WHERE %s_link.media_id=%s AND %s_link.media_type = '%s' AND %%s)",
+                             field, table, table, table, field, table, field, mediaField.c_str(), field, mediaType.c_str());
+}
+
+std::string CSmartPlaylistRule::GetLinkQuery(const std::string &strType, std::string &column) const
+{
+  // fields of the video library kept in the *_link tables
+  static const struct
+  {
+    const char *type;
+    int field;
+    const char *link;
+    const char *table;
+    const char *mediaType;
+    bool byShow;  // the field belongs to the tvshow of an episode
+  } linkFields[] = {
+    { "movies",      FieldGenre,       "genre",    "genre",   MediaTypeMovie,      false },
+    { "movies",      FieldDirector,    "director", "actor",   MediaTypeMovie,      false },
+    { "movies",      FieldActor,       "actor",    "actor",   MediaTypeMovie,      false },
+    { "movies",      FieldWriter,      "writer",   "actor",   MediaTypeMovie,      false },
+    { "movies",      FieldStudio,      "studio",   "studio",  MediaTypeMovie,      false },
+    { "movies",      FieldCountry,     "country",  "country", MediaTypeMovie,      false },
+    { "movies",      FieldTag,         "tag",      "tag",     MediaTypeMovie,      false },
+    { "musicvideos", FieldGenre,       "genre",    "genre",   MediaTypeMusicVideo, false },
+    { "musicvideos", FieldArtist,      "actor",    "actor",   MediaTypeMusicVideo, false },
+    { "musicvideos", FieldAlbumArtist, "actor",    "actor",   MediaTypeMusicVideo, false },
+    { "musicvideos", FieldStudio,      "studio",   "studio",  MediaTypeMusicVideo, false },
+    { "musicvideos", FieldDirector,    "director", "actor",   MediaTypeMusicVideo, false },
+    { "musicvideos", FieldTag,         "tag",      "tag",     MediaTypeMusicVideo, false },
+    { "tvshows",     FieldGenre,       "genre",    "genre",   MediaTypeTvShow,     false },
+    { "tvshows",     FieldDirector,    "director", "actor",   MediaTypeTvShow,     false },
+    { "tvshows",     FieldActor,       "actor",    "actor",   MediaTypeTvShow,     false },
+    { "tvshows",     FieldStudio,      "studio",   "studio",  MediaTypeTvShow,     false },
+    { "tvshows",     FieldTag,         "tag",      "tag",     MediaTypeTvShow,     false },
+    { "episodes",    FieldGenre,       "genre",    "genre",   MediaTypeTvShow,     true  },
+    { "episodes",    FieldTag,         "tag",      "tag",     MediaTypeTvShow,     true  },
+    { "episodes",    FieldDirector,    "director", "actor",   MediaTypeEpisode,    false },
+    { "episodes",    FieldActor,       "actor",    "actor",   MediaTypeEpisode,    false },
+    { "episodes",    FieldWriter,      "writer",   "actor",   MediaTypeEpisode,    false },
+    { "episodes",    FieldStudio,      "studio",   "studio",  MediaTypeTvShow,     true  },
+  };
+
+  // stream details of the file of a video
+  static const struct
+  {
+    int field;
+    const char *column;
+  } streamFields[] = {
+    { FieldAudioChannels,    "iAudioChannels" },
+    { FieldVideoCodec,       "strVideoCodec" },
+    { FieldAudioCodec,       "strAudioCodec" },
+    { FieldAudioLanguage,    "strAudioLanguage" },
+    { FieldSubtitleLanguage, "strSubtitleLanguage" },
+    { FieldVideoAspectRatio, "fVideoAspect" },
+  };
+
+  std::string id = GetField(FieldId, strType);
+  std::string table = id.substr(0, id.find('.'));
+
+  for (const auto &link : linkFields)
+  {
+    if (link.field == m_field && strType == link.type)
+    {
+      column = std::string(link.table) + ".name";
+      return FormatLinkQuery(link.link, link.table, link.mediaType, link.byShow ? table + ".idShow" : id);
+    }
+  }
+
+  for (const auto &stream : streamFields)
+  {
+    if (stream.field == m_field)
+    {
+      column = std::string("streamdetails.") + stream.column;
+      return " EXISTS (SELECT 1 FROM streamdetails WHERE streamdetails.idFile = " + table + ".idFile AND %s)";
+    }
+  }
+
+  if (strType == "songs")
+  {
+    if (m_field == FieldGenre)
+    {
+      column = "genre.strGenre";
+      return " EXISTS (SELECT 1 FROM song_genre, genre WHERE song_genre.idSong = " + id + " AND song_genre.idGenre = genre.idGenre AND %s)";
+    }
+    else if (m_field == FieldArtist)
+    {
+      column = "artist.strArtist";
+      return " EXISTS (SELECT 1 FROM song_artist, artist WHERE song_artist.idSong = " + id + " AND song_artist.idArtist = artist.idArtist AND %s)";
+    }
+    else if (m_field == FieldAlbumArtist)
+    {
+      column = "artist.strArtist";
+      return " EXISTS (SELECT 1 FROM album_artist, artist WHERE album_artist.idAlbum = " + table + ".idAlbum AND album_artist.idArtist = artist.idArtist AND %s)";
+    }
+  }
+  else if (strType == "albums")
+  {
+    if (m_field == FieldGenre)
+    {
+      column = "genre.strGenre";
+      return " EXISTS (SELECT 1 FROM song, song_genre, genre WHERE song.idAlbum = " + id + " AND song.idSong = song_genre.idSong AND song_genre.idGenre = genre.idGenre AND %s)";
+    }
+    else if (m_field == FieldArtist)
+    {
+      column = "artist.strArtist";
+      return " EXISTS (SELECT 1 FROM song, song_artist, artist WHERE song.idAlbum = " + id + " AND song.idSong = song_artist.idSong AND song_artist.idArtist = artist.idArtist AND %s)";
+    }
+    else if (m_field == FieldAlbumArtist)
+    {
+      column = "artist.strArtist";
+      return " EXISTS (SELECT 1 FROM album_artist, artist WHERE album_artist.idAlbum = " + id + " AND album_artist.idArtist = artist.idArtist AND %s)";
+    }
+    else if (m_field == FieldPath)
+    {
+      column = "path.strPath";
+      return " EXISTS (SELECT 1 FROM song JOIN path on song.idpath = path.idpath WHERE song.idAlbum = " + id + " AND %s)";
+    }
+  }
+  else if (strType == "artists")
+  {
+    if (m_field == FieldRole)
+    {
+      column = "role.strRole";
+      return " EXISTS (SELECT 1 FROM song_artist, role WHERE song_artist.idArtist = " + id + " AND song_artist.idRole = role.idRole AND %s)";
+    }
+    else if (m_field == FieldPath)
+    {
+      column = "path.strPath";
+      return " EXISTS (SELECT 1 FROM song_artist JOIN song ON song.idSong = song_artist.idSong JOIN path ON song.idpath = path.idpath "
+             "WHERE song_artist.idArtist = " + id + " AND %s)";
+    }
+  }
+
+  return "";
+}
+
+std::string CSmartPlaylistRule::GetWhereClause(const CDatabase &db, const std::string& strType) const
+{
+  // the values of a field kept in a separate table are all matched by a single
+  // subquery, instead of one subquery per value
+  std::string column;
+  std::string linkQuery = GetLinkQuery(strType, column);
+  SEARCH_OPERATOR op = GetOperator(strType);
+  if (m_parameter.size() < 2 || linkQuery.empty() ||
+      op == OPERATOR_BETWEEN || op == OPERATOR_TRUE || op == OPERATOR_FALSE)
+    return CDatabaseQueryRule::GetWhereClause(db, strType);
+
+  std::string operatorString = GetOperatorString(op);
+  std::string negate;
+  if (op == OPERATOR_DOES_NOT_CONTAIN ||
+     (op == OPERATOR_DOES_NOT_EQUAL && GetFieldType(m_field) != REAL_FIELD && GetFieldType(m_field) != NUMERIC_FIELD &&
+      GetFieldType(m_field) != SECONDS_FIELD))
+    negate = " NOT";
+
+  std::vector<std::string> conditions;
+  for (const std::string &param : m_parameter)
+    conditions.push_back(column + FormatParameter(operatorString, param, db, strType));
+
+  return negate + StringUtils::Format(linkQuery.c_str(), ("(" + StringUtils::Join(conditions, " OR ") + ")").c_str());
 }
 
 std::string CSmartPlaylistRule::FormatWhereClause(const std::string &negate, const std::string &oper, const std::string &param,
@@ -770,33 +928,23 @@ std::string CSmartPlaylistRule::FormatWhereClause(const std::string &negate, con
 {
   std::string parameter = FormatParameter(oper, param, db, strType);
 
+  std::string column;
+  std::string linkQuery = GetLinkQuery(strType, column);
+  if (!linkQuery.empty())
+    return negate + StringUtils::Format(linkQuery.c_str(), (column + parameter).c_str());
+
   std::string query;
   std::string table;
   if (strType == "songs")
   {
     table = "songview";
 
-    if (m_field == FieldGenre)
-      query = negate + " EXISTS (SELECT 1 FROM song_genre, genre WHERE song_genre.idSong = " + GetField(FieldId, strType) + " AND song_genre.idGenre = genre.idGenre AND genre.strGenre" + parameter + ")";
-    else if (m_field == FieldArtist)
-      query = negate + " EXISTS (SELECT 1 FROM song_artist, artist WHERE song_artist.idSong = " + GetField(FieldId, strType) + " AND song_artist.idArtist = artist.idArtist AND artist.strArtist" + parameter + ")";
-    else if (m_field == FieldAlbumArtist)
-      query = negate + " EXISTS (SELECT 1 FROM album_artist, artist WHERE album_artist.idAlbum = " + table + ".idAlbum AND album_artist.idArtist = artist.idArtist AND artist.strArtist" + parameter + ")";
-    else if (m_field == FieldLastPlayed && (m_operator == OPERATOR_LESS_THAN || m_operator == OPERATOR_BEFORE || m_operator == OPERATOR_NOT_IN_THE_LAST))
+    if (m_field == FieldLastPlayed && (m_operator == OPERATOR_LESS_THAN || m_operator == OPERATOR_BEFORE || m_operator == OPERATOR_NOT_IN_THE_LAST))
       query = GetField(m_field, strType) + " is NULL or " + GetField(m_field, strType) + parameter;
   }
   else if (strType == "albums")
   {
     table = "albumview";
-
-    if (m_field == FieldGenre)
-      query = negate + " EXISTS (SELECT 1 FROM song, song_genre, genre WHERE song.idAlbum = " + GetField(FieldId, strType) + " AND song.idSong = song_genre.idSong AND song_genre.idGenre = genre.idGenre AND genre.strGenre" + parameter + ")";
-    else if (m_field == FieldArtist)
-      query = negate + " EXISTS (SELECT 1 FROM song, song_artist, artist WHERE song.idAlbum = " + GetField(FieldId, strType) + " AND song.idSong = song_artist.idSong AND song_artist.idArtist = artist.idArtist AND artist.strArtist" + parameter + ")";
-    else if (m_field == FieldAlbumArtist)
-      query = negate + " EXISTS (SELECT 1 FROM album_artist, artist WHERE album_artist.idAlbum = " + GetField(FieldId, strType) + " AND album_artist.idArtist = artist.idArtist AND artist.strArtist" + parameter + ")";
-    else if (m_field == FieldPath)
-      query = negate + " EXISTS (SELECT 1 FROM song JOIN path on song.idpath = path.idpath WHERE song.idAlbum = " + GetField(FieldId, strType) + " AND path.strPath" + parameter + ")";
   }
   else if (strType == "artists")
   {
@@ -808,110 +956,43 @@ std::string CSmartPlaylistRule::FormatWhereClause(const std::string &negate, con
       query += " OR ";
       query += "EXISTS (SELECT DISTINCT album_artist.idArtist FROM album_artist, album_genre, genre WHERE album_artist.idArtist = " + GetField(FieldId, strType) + " AND album_artist.idAlbum = album_genre.idAlbum AND album_genre.idGenre = genre.idGenre AND genre.strGenre" + parameter + "))";
     }
-    else if (m_field == FieldRole)
-    {
-      query = negate + " (EXISTS (SELECT DISTINCT song_artist.idArtist FROM song_artist, role WHERE song_artist.idArtist = " + GetField(FieldId, strType) + " AND song_artist.idRole = role.idRole AND role.strRole" + parameter + "))";
-    }
-    else if (m_field == FieldPath)
-    {
-      query = negate + " (EXISTS (SELECT DISTINCT song_artist.idArtist FROM song_artist JOIN song ON song.idSong = song_artist.idSong JOIN path ON song.idpath = path.idpath ";
-      query += "WHERE song_artist.idArtist = " + GetField(FieldId, strType) + " AND path.strPath" + parameter + "))";
-    }
   }
   else if (strType == "movies")
   {
     table = "movie_view";
 
-    if (m_field == FieldGenre)
-      query = negate + FormatLinkQuery("genre", "genre", MediaTypeMovie, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldDirector)
-      query = negate + FormatLinkQuery("director", "actor", MediaTypeMovie, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldActor)
-      query = negate + FormatLinkQuery("actor", "actor", MediaTypeMovie, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldWriter)
-      query = negate + FormatLinkQuery("writer", "actor", MediaTypeMovie, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldStudio)
-      query = negate + FormatLinkQuery("studio", "studio", MediaTypeMovie, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldCountry)
-      query = negate + FormatLinkQuery("country", "country", MediaTypeMovie, GetField(FieldId, strType), parameter);
-    else if ((m_field == FieldLastPlayed || m_field == FieldDateAdded) && (m_operator == OPERATOR_LESS_THAN || m_operator == OPERATOR_BEFORE || m_operator == OPERATOR_NOT_IN_THE_LAST))
+    if ((m_field == FieldLastPlayed || m_field == FieldDateAdded) && (m_operator == OPERATOR_LESS_THAN || m_operator == OPERATOR_BEFORE || m_operator == OPERATOR_NOT_IN_THE_LAST))
       query = GetField(m_field, strType) + " IS NULL OR " + GetField(m_field, strType) + parameter;
-    else if (m_field == FieldTag)
-      query = negate + FormatLinkQuery("tag", "tag", MediaTypeMovie, GetField(FieldId, strType), parameter);
   }
   else if (strType == "musicvideos")
   {
     table = "musicvideo_view";
 
-    if (m_field == FieldGenre)
-      query = negate + FormatLinkQuery("genre", "genre", MediaTypeMusicVideo, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldArtist || m_field == FieldAlbumArtist)
-      query = negate + FormatLinkQuery("actor", "actor", MediaTypeMusicVideo, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldStudio)
-      query = negate + FormatLinkQuery("studio", "studio", MediaTypeMusicVideo, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldDirector)
-      query = negate + FormatLinkQuery("director", "actor", MediaTypeMusicVideo, GetField(FieldId, strType), parameter);
-    else if ((m_field == FieldLastPlayed || m_field == FieldDateAdded) && (m_operator == OPERATOR_LESS_THAN || m_operator == OPERATOR_BEFORE || m_operator == OPERATOR_NOT_IN_THE_LAST))
+    if ((m_field == FieldLastPlayed || m_field == FieldDateAdded) && (m_operator == OPERATOR_LESS_THAN || m_operator == OPERATOR_BEFORE || m_operator == OPERATOR_NOT_IN_THE_LAST))
       query = GetField(m_field, strType) + " IS NULL OR " + GetField(m_field, strType) + parameter;
-    else if (m_field == FieldTag)
-      query = negate + FormatLinkQuery("tag", "tag", MediaTypeMusicVideo, GetField(FieldId, strType), parameter);
   }
   else if (strType == "tvshows")
   {
     table = "tvshow_view";
 
-    if (m_field == FieldGenre)
-      query = negate + FormatLinkQuery("genre", "genre", MediaTypeTvShow, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldDirector)
-      query = negate + FormatLinkQuery("director", "actor", MediaTypeTvShow, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldActor)
-      query = negate + FormatLinkQuery("actor", "actor", MediaTypeTvShow, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldStudio)
-      query = negate + FormatLinkQuery("studio", "studio", MediaTypeTvShow, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldMPAA)
+    if (m_field == FieldMPAA)
       query = negate + " (" + GetField(m_field, strType) + parameter + ")";
     else if ((m_field == FieldLastPlayed || m_field == FieldDateAdded) && (m_operator == OPERATOR_LESS_THAN || m_operator == OPERATOR_BEFORE || m_operator == OPERATOR_NOT_IN_THE_LAST))
       query = GetField(m_field, strType) + " IS NULL OR " + GetField(m_field, strType) + parameter;
     else if (m_field == FieldPlaycount)
       query = "CASE WHEN COALESCE(" + GetField(FieldNumberOfEpisodes, strType) + " - " + GetField(FieldNumberOfWatchedEpisodes, strType) + ", 0) > 0 THEN 0 ELSE 1 END " + parameter;
-    else if (m_field == FieldTag)
-      query = negate + FormatLinkQuery("tag", "tag", MediaTypeTvShow, GetField(FieldId, strType), parameter);
   }
   else if (strType == "episodes")
   {
     table = "episode_view";
 
-    if (m_field == FieldGenre)
-      query = negate + FormatLinkQuery("genre", "genre", MediaTypeTvShow, (table + ".idShow").c_str(), parameter);
-    else if (m_field == FieldTag)
-      query = negate + FormatLinkQuery("tag", "tag", MediaTypeTvShow, (table + ".idShow").c_str(), parameter);
-    else if (m_field == FieldDirector)
-      query = negate + FormatLinkQuery("director", "actor", MediaTypeEpisode, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldActor)
-      query = negate + FormatLinkQuery("actor", "actor", MediaTypeEpisode, GetField(FieldId, strType), parameter);
-    else if (m_field == FieldWriter)
-      query = negate + FormatLinkQuery("writer", "actor", MediaTypeEpisode, GetField(FieldId, strType), parameter);
-    else if ((m_field == FieldLastPlayed || m_field == FieldDateAdded) && (m_operator == OPERATOR_LESS_THAN || m_operator == OPERATOR_BEFORE || m_operator == OPERATOR_NOT_IN_THE_LAST))
+    if ((m_field == FieldLastPlayed || m_field == FieldDateAdded) && (m_operator == OPERATOR_LESS_THAN || m_operator == OPERATOR_BEFORE || m_operator == OPERATOR_NOT_IN_THE_LAST))
       query = GetField(m_field, strType) + " IS NULL OR " + GetField(m_field, strType) + parameter;
-    else if (m_field == FieldStudio)
-      query = negate + FormatLinkQuery("studio", "studio", MediaTypeTvShow, (table + ".idShow").c_str(), parameter);
     else if (m_field == FieldMPAA)
       query = negate + " (" + GetField(m_field, strType) +  parameter + ")";
   }
   if (m_field == FieldVideoResolution)
-    query = table + ".idFile" + negate + GetVideoResolutionQuery(param);
-  else if (m_field == FieldAudioChannels)
-    query = negate + " EXISTS (SELECT 1 FROM streamdetails WHERE streamdetails.idFile = " + table + ".idFile AND iAudioChannels " + parameter + ")";
-  else if (m_field == FieldVideoCodec)
-    query = negate + " EXISTS (SELECT 1 FROM streamdetails WHERE streamdetails.idFile = " + table + ".idFile AND strVideoCodec " + parameter + ")";
-  else if (m_field == FieldAudioCodec)
-    query = negate + " EXISTS (SELECT 1 FROM streamdetails WHERE streamdetails.idFile = " + table + ".idFile AND strAudioCodec " + parameter + ")";
-  else if (m_field == FieldAudioLanguage)
-    query = negate + " EXISTS (SELECT 1 FROM streamdetails WHERE streamdetails.idFile = " + table + ".idFile AND strAudioLanguage " + parameter + ")";
-  else if (m_field == FieldSubtitleLanguage)
-    query = negate + " EXISTS (SELECT 1 FROM streamdetails WHERE streamdetails.idFile = " + table + ".idFile AND strSubtitleLanguage " + parameter + ")";
-  else if (m_field == FieldVideoAspectRatio)
-    query = negate + " EXISTS (SELECT 1 FROM streamdetails WHERE streamdetails.idFile = " + table + ".idFile AND fVideoAspect " + parameter + ")";
+    query = negate + GetVideoResolutionQuery(param, table);
   else if (m_field == FieldAudioCount)
     query = db.PrepareSQL(negate + " EXISTS (SELECT 1 FROM streamdetails WHERE streamdetails.idFile = " + table + ".idFile AND streamdetails.iStreamtype = %i GROUP BY streamdetails.idFile HAVING COUNT(streamdetails.iStreamType) " + parameter + ")",CStreamDetail::AUDIO);
   else if (m_field == FieldSubtitleCount)
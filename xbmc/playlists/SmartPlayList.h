@@ -38,6 +38,7 @@ public:
   virtual ~CSmartPlaylistRule() { }
 
   std::string                 GetLocalizedRule() const;
+  virtual std::string         GetWhereClause(const CDatabase &db, const std::string& strType) const override;
 
   static SortBy               TranslateOrder(const char *order);
   static std::string          TranslateOrder(SortBy order);
@@ -76,8 +77,14 @@ protected:
                                               const std::string &strType) const;
 
 private:
-  std::string GetVideoResolutionQuery(const std::string &parameter) const;
-  static std::string FormatLinkQuery(const char *field, const char *table, const MediaType& mediaType, const std::string& mediaField, const std::string& parameter);
+  std::string GetVideoResolutionQuery(const std::string &parameter, const std::string &table) const;
+  /*!
+   \brief The subquery for a field whose values are kept in a separate table.
+   \param column [out] the column holding the values
+   \return the subquery with a %s for the condition on the column, empty if the field isn't kept in a separate table
+   */
+  std::string GetLinkQuery(const std::string &strType, std::string &column) const;
+  static std::string FormatLinkQuery(const char *field, const char *table, const MediaType& mediaType, const std::string& mediaField);
 };
 
 class CSmartPlaylistRuleCombination : public CDatabaseQueryRuleCombination
@@ -0,0 +1,55 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "SmartPlaylistCache.h"
+
+using namespace ANNOUNCEMENT;
+
+const size_t CSmartPlaylistCache::MaxItems;
+const size_t CSmartPlaylistCache::MaxEntries;
+
+CSmartPlaylistCache::CSmartPlaylistCache()
+  : CLibraryResultCache("CSmartPlaylistCache", MaxEntries)
+{
+}
+
+CSmartPlaylistCache::~CSmartPlaylistCache()
+{
+}
+
+bool CSmartPlaylistCache::Get(const std::string &key, AnnouncementFlag library, std::vector<int> &ids)
+{
+  EntryPtr entry = Find(key, library);
+  if (!entry)
+    return false;
+
+  ids = static_cast<const Result&>(*entry).ids;
+  return true;
+}
+
+void CSmartPlaylistCache::Set(const std::string &key, AnnouncementFlag library, const std::vector<int> &ids, unsigned int generation)
+{
+  if (ids.size() > MaxItems)
+    return;
+
+  std::shared_ptr<Result> result(new Result);
+  result->ids = ids;
+  Store(key, library, result, generation);
+}
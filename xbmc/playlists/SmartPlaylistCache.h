@@ -0,0 +1,71 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include "filesystem/LibraryResultCache.h"
+
+/*!
+ \brief Remembers which items the queries of smart playlists returned.
+
+ Smart playlists are shown over and over, e.g. as widgets of the home screen,
+ while the library rarely changes. The ids of the items a query returned are
+ kept, so the next time only these items have to be loaded instead of the
+ rules being matched against the whole library. All results of a library are
+ dropped as soon as the library announces a change.
+ */
+class CSmartPlaylistCache : public XFILE::CLibraryResultCache
+{
+public:
+  CSmartPlaylistCache();
+  virtual ~CSmartPlaylistCache();
+
+  /*!
+   \brief Get the ids of the items a query returned the last time.
+   \param key identifies the query, including its sorting and limits
+   \return false if the result of the query isn't known
+   */
+  bool Get(const std::string &key, ANNOUNCEMENT::AnnouncementFlag library, std::vector<int> &ids);
+
+  /*!
+   \brief Remember the result of a query.
+   The result is dropped if the library changed since the generation was read
+   by GetGeneration() before the query was run.
+   */
+  void Set(const std::string &key, ANNOUNCEMENT::AnnouncementFlag library, const std::vector<int> &ids, unsigned int generation);
+
+  /*!
+   \brief Largest result that is cached, larger results are loaded the usual way.
+   */
+  static const size_t MaxItems = 1000;
+
+  /*!
+   \brief Number of results that are cached, the least recently used is dropped first.
+   */
+  static const size_t MaxEntries = 64;
+
+private:
+  struct Result : public Entry
+  {
+    std::vector<int> ids;
+  };
+};
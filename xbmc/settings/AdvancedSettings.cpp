@@ -125,6 +125,9 @@ void CAdvancedSettings::Initialize()
 
   m_audioDefaultPlayer = "paplayer";
   m_audioPlayCountMinimumPercent = 90.0f;
+  m_audioPrefetchTracks = 1;
+  m_audioPrefetchSeconds = 10;
+  m_audioPrefetchMemory = 32;
 
   m_videoSubsDelayRange = 60;
   m_videoAudioDelayRange = 10;
@@ -275,9 +278,12 @@ void CAdvancedSettings::Initialize()
 
   m_bMusicLibraryAllItemsOnBottom = false;
   m_bMusicLibraryCleanOnUpdate = false;
+  m_musicLibraryCleanThreads = 4;
   m_iMusicLibraryRecentlyAddedItems = 25;
   m_strMusicLibraryAlbumFormat = "";
   m_prioritiseAPEv2tags = false;
+  m_musicTagReadThreads = 8;
+  m_musicTagReadThreadsPerSource = 4;
   m_musicItemSeparator = " / ";
   m_musicArtistSeparators = { ";", ":", "|", " feat. ", " ft. " };
   m_videoItemSeparator = " / ";
@@ -286,6 +292,7 @@ void CAdvancedSettings::Initialize()
   m_bVideoLibraryAllItemsOnBottom = false;
   m_iVideoLibraryRecentlyAddedItems = 25;
   m_bVideoLibraryCleanOnUpdate = false;
+  m_videoLibraryCleanThreads = 4;
   m_bVideoLibraryUseFastHash = true;
   m_bVideoLibraryExportAutoThumbs = false;
   m_bVideoLibraryImportWatchedState = false;
@@ -301,6 +308,7 @@ void CAdvancedSettings::Initialize()
   m_iEpgUpdateEmptyTagsInterval = 60; /* override user selectable EPG update interval for empty EPG tags */
   m_bEpgDisplayUpdatePopup = true; /* display a progress popup while updating EPG data from clients */
   m_bEpgDisplayIncrementalUpdatePopup = false; /* also display a progress popup while doing incremental EPG updates */
+  m_iEpgConcurrentUpdatesPerClient = 1; /* amount of EPG tables that are requested from a single client at the same time */
 
   m_bEdlMergeShortCommBreaks = false;      // Off by default
   m_iEdlMaxCommBreakLength = 8 * 30 + 10;  // Just over 8 * 30 second commercial break.
@@ -398,6 +406,7 @@ void CAdvancedSettings::Initialize()
   m_useDisplayControlHWStereo = false;
 
   m_videoAssFixedWorks = false;
+  m_videoFramePacingLog = false;
 
   m_logLevelHint = m_logLevel = LOG_LEVEL_NORMAL;
   m_extraLogEnabled = false;
@@ -466,6 +475,9 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pElement, "defaultplayer", m_audioDefaultPlayer);
     // 101 on purpose - can be used to never automark as watched
     XMLUtils::GetFloat(pElement, "playcountminimumpercent", m_audioPlayCountMinimumPercent, 0.0f, 101.0f);
+    XMLUtils::GetInt(pElement, "prefetchtracks", m_audioPrefetchTracks, 0, 10);
+    XMLUtils::GetInt(pElement, "prefetchseconds", m_audioPrefetchSeconds, 1, 60);
+    XMLUtils::GetInt(pElement, "prefetchmemory", m_audioPrefetchMemory, 0, 512);
 
     XMLUtils::GetBoolean(pElement, "usetimeseeking", m_musicUseTimeSeeking);
     XMLUtils::GetInt(pElement, "timeseekforward", m_musicTimeSeekForward, 0, 6000);
@@ -503,6 +515,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   if (pElement)
   {
     XMLUtils::GetBoolean(pElement, "assfixedworks", m_videoAssFixedWorks);
+    XMLUtils::GetBoolean(pElement, "framepacinglog", m_videoFramePacingLog);
     XMLUtils::GetString(pElement, "stereoscopicregex3d", m_stereoscopicregex_3d);
     XMLUtils::GetString(pElement, "stereoscopicregexsbs", m_stereoscopicregex_sbs);
     XMLUtils::GetString(pElement, "stereoscopicregextab", m_stereoscopicregex_tab);
@@ -695,8 +708,11 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
   {
     XMLUtils::GetInt(pElement, "recentlyaddeditems", m_iMusicLibraryRecentlyAddedItems, 1, INT_MAX);
     XMLUtils::GetBoolean(pElement, "prioritiseapetags", m_prioritiseAPEv2tags);
+    XMLUtils::GetInt(pElement, "tagreadthreads", m_musicTagReadThreads, 1, 32);
+    XMLUtils::GetInt(pElement, "tagreadthreadspersource", m_musicTagReadThreadsPerSource, 0, 32);
     XMLUtils::GetBoolean(pElement, "allitemsonbottom", m_bMusicLibraryAllItemsOnBottom);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", m_bMusicLibraryCleanOnUpdate);
+    XMLUtils::GetInt(pElement, "cleanthreads", m_musicLibraryCleanThreads, 1, 32);
     XMLUtils::GetString(pElement, "albumformat", m_strMusicLibraryAlbumFormat);
     XMLUtils::GetString(pElement, "itemseparator", m_musicItemSeparator);
     XMLUtils::GetInt(pElement, "dateadded", m_iMusicLibraryDateAdded);
@@ -721,6 +737,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetBoolean(pElement, "allitemsonbottom", m_bVideoLibraryAllItemsOnBottom);
     XMLUtils::GetInt(pElement, "recentlyaddeditems", m_iVideoLibraryRecentlyAddedItems, 1, INT_MAX);
     XMLUtils::GetBoolean(pElement, "cleanonupdate", m_bVideoLibraryCleanOnUpdate);
+    XMLUtils::GetInt(pElement, "cleanthreads", m_videoLibraryCleanThreads, 1, 32);
     XMLUtils::GetBoolean(pElement, "usefasthash", m_bVideoLibraryUseFastHash);
     XMLUtils::GetString(pElement, "itemseparator", m_videoItemSeparator);
     XMLUtils::GetBoolean(pElement, "exportautothumbs", m_bVideoLibraryExportAutoThumbs);
@@ -847,6 +864,7 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetInt(pElement, "updateemptytagsinterval", m_iEpgUpdateEmptyTagsInterval);
     XMLUtils::GetBoolean(pElement, "displayupdatepopup", m_bEpgDisplayUpdatePopup);
     XMLUtils::GetBoolean(pElement, "displayincrementalupdatepopup", m_bEpgDisplayIncrementalUpdatePopup);
+    XMLUtils::GetInt(pElement, "concurrentupdatesperclient", m_iEpgConcurrentUpdatesPerClient, 1, 16);
   }
 
   // EDL commercial break handling
@@ -1055,6 +1073,9 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pDatabase, "capath", m_databaseVideo.capath);
     XMLUtils::GetString(pDatabase, "ciphers", m_databaseVideo.ciphers);
     XMLUtils::GetBoolean(pDatabase, "compression", m_databaseVideo.compression);
+    XMLUtils::GetString(pDatabase, "replicahost", m_databaseVideo.replicahost);
+    XMLUtils::GetString(pDatabase, "replicaport", m_databaseVideo.replicaport);
+    XMLUtils::GetInt(pDatabase, "poolsize", m_databaseVideo.poolsize, 0, 64);
   }
 
   pDatabase = pRootElement->FirstChildElement("musicdatabase");
@@ -1072,6 +1093,9 @@ void CAdvancedSettings::ParseSettingsFile(const std::string &file)
     XMLUtils::GetString(pDatabase, "capath", m_databaseMusic.capath);
     XMLUtils::GetString(pDatabase, "ciphers", m_databaseMusic.ciphers);
     XMLUtils::GetBoolean(pDatabase, "compression", m_databaseMusic.compression);
+    XMLUtils::GetString(pDatabase, "replicahost", m_databaseMusic.replicahost);
+    XMLUtils::GetString(pDatabase, "replicaport", m_databaseMusic.replicaport);
+    XMLUtils::GetInt(pDatabase, "poolsize", m_databaseMusic.poolsize, 0, 64);
   }
 
   pDatabase = pRootElement->FirstChildElement("tvdatabase");
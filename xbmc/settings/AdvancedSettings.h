@@ -61,6 +61,9 @@ public:
     capath.clear();
     ciphers.clear();
     compression = false;
+    replicahost.clear();
+    replicaport.clear();
+    poolsize = 8;
   };
   std::string type;
   std::string host;
@@ -74,6 +77,9 @@ public:
   std::string capath;
   std::string ciphers;
   bool compression;
+  std::string replicahost; ///< read only copy of the database used by CDatabase::OpenForReading(), same user and name
+  std::string replicaport;
+  int poolsize;            ///< connections kept open per database, 0 to connect on every Open()
 };
 
 struct TVShowRegexp
@@ -140,6 +146,9 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     float m_ac3Gain;
     std::string m_audioDefaultPlayer;
     float m_audioPlayCountMinimumPercent;
+    int m_audioPrefetchTracks;     ///< upcoming tracks paplayer opens and pre-decodes, 0 to disable
+    int m_audioPrefetchSeconds;    ///< seconds of audio pre-decoded per track
+    int m_audioPrefetchMemory;     ///< MB shared by all pre-decoded tracks
     bool m_VideoPlayerIgnoreDTSinWAV;
     float m_limiterHold;
     float m_limiterRelease;
@@ -256,8 +265,11 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_iMusicLibraryDateAdded;
     bool m_bMusicLibraryAllItemsOnBottom;
     bool m_bMusicLibraryCleanOnUpdate;
+    int m_musicLibraryCleanThreads;
     std::string m_strMusicLibraryAlbumFormat;
     bool m_prioritiseAPEv2tags;
+    int m_musicTagReadThreads;
+    int m_musicTagReadThreadsPerSource;
     std::string m_musicItemSeparator;
     std::vector<std::string> m_musicArtistSeparators;
     std::string m_videoItemSeparator;
@@ -266,6 +278,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     bool m_bVideoLibraryAllItemsOnBottom;
     int m_iVideoLibraryRecentlyAddedItems;
     bool m_bVideoLibraryCleanOnUpdate;
+    int m_videoLibraryCleanThreads;
     bool m_bVideoLibraryUseFastHash;
     bool m_bVideoLibraryExportAutoThumbs;
     bool m_bVideoLibraryImportWatchedState;
@@ -284,6 +297,7 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     int m_iEpgUpdateEmptyTagsInterval; // seconds
     bool m_bEpgDisplayUpdatePopup;
     bool m_bEpgDisplayIncrementalUpdatePopup;
+    int m_iEpgConcurrentUpdatesPerClient;
 
     // EDL Commercial Break
     bool m_bEdlMergeShortCommBreaks;
@@ -380,6 +394,9 @@ class CAdvancedSettings : public ISettingCallback, public ISettingsHandler
     False to show at the bottom of video (default) */
     bool m_videoAssFixedWorks;
 
+    /*!< @brief write the frame timing of the last video to framepacing.json in the log folder */
+    bool m_videoFramePacingLog;
+
     std::string m_userAgent;
 
   private:
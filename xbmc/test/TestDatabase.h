@@ -0,0 +1,73 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#pragma once
+
+#include "DatabaseManager.h"
+#include "FileItem.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "filesystem/SpecialProtocol.h"
+#include "settings/AdvancedSettings.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+
+#include <string>
+
+/* A database of type T in a new sqlite file called name in the temp folder
+ * instead of the profile's database, e.g. CTestDatabase<CVideoDatabase>.
+ * settings are the advanced settings T opens with, they point to the test
+ * database until it is destroyed. The file is deleted with the database.
+ */
+template<class T>
+class CTestDatabase : public T
+{
+public:
+  CTestDatabase(DatabaseSettings &settings, const std::string &name)
+    : m_settings(settings)
+    , m_saved(settings)
+  {
+    m_settings.type = "sqlite3";
+    m_settings.host = CSpecialProtocol::TranslatePath("special://temp/");
+    m_settings.name = name;
+    CDatabaseManager::GetInstance().UpdateDatabase(*this, &m_settings);
+  }
+
+  ~CTestDatabase()
+  {
+    this->Close();
+    // the pool keeps the connection open
+    CDatabaseManager::GetInstance().GetConnectionPool().Clear();
+
+    // the file name has the schema version appended
+    CFileItemList items;
+    XFILE::CDirectory::GetDirectory("special://temp/", items, ".db", XFILE::DIR_FLAG_NO_FILE_DIRS);
+    for (int i = 0; i < items.Size(); i++)
+    {
+      if (StringUtils::StartsWith(URIUtils::GetFileName(items[i]->GetPath()), m_settings.name))
+        XFILE::CFile::Delete(items[i]->GetPath());
+    }
+    m_settings = m_saved;
+  }
+
+private:
+  DatabaseSettings &m_settings;
+  DatabaseSettings m_saved;
+};
@@ -230,6 +230,31 @@ std::vector<std::string> &CXBMCTestUtils::getGUISettingsFiles()
   return GUISettingsFiles;
 }
 
+std::vector<std::string> &CXBMCTestUtils::getVideoPlayerBenchmarkFiles()
+{
+  return VideoPlayerBenchmarkFiles;
+}
+
+std::string &CXBMCTestUtils::getVideoPlayerBenchmarkOutput()
+{
+  return VideoPlayerBenchmarkOutput;
+}
+
+std::vector<std::string> &CXBMCTestUtils::getThumbExtractBenchmarkFiles()
+{
+  return ThumbExtractBenchmarkFiles;
+}
+
+std::string &CXBMCTestUtils::getThumbExtractBenchmarkOutput()
+{
+  return ThumbExtractBenchmarkOutput;
+}
+
+std::vector<std::string> &CXBMCTestUtils::getStreamDetailsProbeFiles()
+{
+  return StreamDetailsProbeFiles;
+}
+
 static const char usage[] =
 "XBMC Test Suite\n"
 "Usage: xbmc-test [options]\n"
@@ -267,6 +292,25 @@ static const char usage[] =
 "    Add multiple GUI settings files from a ',' delimited string of\n"
 "    files to be loaded in test cases that use them.\n"
 "\n"
+"  --add-videoplayer-benchmark-file [FILE]\n"
+"    Add a media file to be played in the VideoPlayer benchmark.\n"
+"\n"
+"  --set-videoplayer-benchmark-output [FILE]\n"
+"    Set the file the VideoPlayer benchmark results are written to as json.\n"
+"    The results are written to stdout if no file is set.\n"
+"\n"
+"  --add-thumbextract-benchmark-file [FILE]\n"
+"    Add a media file to extract a thumb from in the thumb extraction\n"
+"    benchmark.\n"
+"\n"
+"  --set-thumbextract-benchmark-output [FILE]\n"
+"    Set the file the thumb extraction benchmark results are written to as\n"
+"    json. The results are written to stdout if no file is set.\n"
+"\n"
+"  --add-streamdetails-probe-file [FILE]\n"
+"    Add a media file whose probed stream details are compared to the ones\n"
+"    read with a full open of the file.\n"
+"\n"
 "  --set-probability [PROBABILITY]\n"
 "    Set the probability variable used by the file corrupting functions.\n"
 "    The variable should be a double type from 0.0 to 1.0. Values given\n"
@@ -333,6 +377,26 @@ void CXBMCTestUtils::ParseArgs(int argc, char **argv)
       for (it = urls.begin(); it < urls.end(); ++it)
         GUISettingsFiles.push_back(*it);
     }
+    else if (arg == "--add-videoplayer-benchmark-file")
+    {
+      VideoPlayerBenchmarkFiles.push_back(argv[++i]);
+    }
+    else if (arg == "--set-videoplayer-benchmark-output")
+    {
+      VideoPlayerBenchmarkOutput = argv[++i];
+    }
+    else if (arg == "--add-thumbextract-benchmark-file")
+    {
+      ThumbExtractBenchmarkFiles.push_back(argv[++i]);
+    }
+    else if (arg == "--set-thumbextract-benchmark-output")
+    {
+      ThumbExtractBenchmarkOutput = argv[++i];
+    }
+    else if (arg == "--add-streamdetails-probe-file")
+    {
+      StreamDetailsProbeFiles.push_back(argv[++i]);
+    }
     else if (arg == "--set-probability")
     {
       probability = atof(argv[++i]);
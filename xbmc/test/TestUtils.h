@@ -76,6 +76,22 @@ public:
   /* Function to get GUI settings files. */
   std::vector<std::string> &getGUISettingsFiles();
 
+  /* Function to get the media files used in the VideoPlayer benchmark. */
+  std::vector<std::string> &getVideoPlayerBenchmarkFiles();
+
+  /* Function to get the file the VideoPlayer benchmark result is written to. */
+  std::string &getVideoPlayerBenchmarkOutput();
+
+  /* Function to get the media files used in the thumb extraction benchmark. */
+  std::vector<std::string> &getThumbExtractBenchmarkFiles();
+
+  /* Function to get the file the thumb extraction benchmark result is written to. */
+  std::string &getThumbExtractBenchmarkOutput();
+
+  /* Function to get the media files whose probed stream details are compared
+   * to the ones of a full open. */
+  std::vector<std::string> &getStreamDetailsProbeFiles();
+
   /* Function used in creating a corrupted file. The parameters are a URL
    * to the original file to be corrupted and a suffix to append to the
    * path of the newly created file. This will return a XFILE::CFile
@@ -102,6 +118,12 @@ private:
   std::vector<std::string> AdvancedSettingsFiles;
   std::vector<std::string> GUISettingsFiles;
 
+  std::vector<std::string> VideoPlayerBenchmarkFiles;
+  std::string VideoPlayerBenchmarkOutput;
+  std::vector<std::string> ThumbExtractBenchmarkFiles;
+  std::string ThumbExtractBenchmarkOutput;
+  std::vector<std::string> StreamDetailsProbeFiles;
+
   double probability;
 };
 
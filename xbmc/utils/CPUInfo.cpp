@@ -71,8 +71,11 @@
 // Bitmasks for the values returned by a call to cpuid with eax=0x00000001
 #define CPUID_00000001_ECX_SSE3  (1<<0)
 #define CPUID_00000001_ECX_SSSE3 (1<<9)
+#define CPUID_00000001_ECX_FMA3  (1<<12)
 #define CPUID_00000001_ECX_SSE4  (1<<19)
 #define CPUID_00000001_ECX_SSE42 (1<<20)
+#define CPUID_00000001_ECX_OSXSAVE (1<<27)
+#define CPUID_00000001_ECX_AVX   (1<<28)
 
 #define CPUID_00000001_EDX_MMX   (1<<23)
 #define CPUID_00000001_EDX_SSE   (1<<25)
@@ -85,6 +88,9 @@
 #define CPUID_80000001_EDX_3DNOWEXT (1<<30)
 #define CPUID_80000001_EDX_3DNOW    (1<<31)
 
+// Bitmasks for the values returned by a call to cpuid with eax=0x00000007, ecx=0
+#define CPUID_00000007_EBX_AVX2     (1<<5)
+
 
 // Help with the __cpuid intrinsic of MSVC
 #define CPUINFO_EAX 0
@@ -409,6 +415,12 @@ CCPUInfo::CCPUInfo(void)
               m_cpuFeatures |= CPU_FEATURE_3DNOW;
             else if (0 == strcmp(tok, "3dnowext"))
               m_cpuFeatures |= CPU_FEATURE_3DNOWEXT;
+            else if (0 == strcmp(tok, "avx"))
+              m_cpuFeatures |= CPU_FEATURE_AVX;
+            else if (0 == strcmp(tok, "avx2"))
+              m_cpuFeatures |= CPU_FEATURE_AVX2;
+            else if (0 == strcmp(tok, "fma"))
+              m_cpuFeatures |= CPU_FEATURE_FMA3;
             tok = strtok_r(NULL, " ", &save);
           }
         }
@@ -882,6 +894,21 @@ void CCPUInfo::ReadCPUFeatures()
       m_cpuFeatures |= CPU_FEATURE_SSE4;
     if (CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_SSE42)
       m_cpuFeatures |= CPU_FEATURE_SSE42;
+    // AVX also needs the OS to save the extended registers on context switches
+    if ((CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_AVX) && (CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_OSXSAVE) &&
+        (_xgetbv(0) & 0x6) == 0x6)
+    {
+      m_cpuFeatures |= CPU_FEATURE_AVX;
+      if (CPUInfo[CPUINFO_ECX] & CPUID_00000001_ECX_FMA3)
+        m_cpuFeatures |= CPU_FEATURE_FMA3;
+
+      if (MaxStdInfoType >= 7)
+      {
+        __cpuidex(CPUInfo, 7, 0);
+        if (CPUInfo[CPUINFO_EBX] & CPUID_00000007_EBX_AVX2)
+          m_cpuFeatures |= CPU_FEATURE_AVX2;
+      }
+    }
   }
 
   __cpuid(CPUInfo, 0x80000000);
@@ -932,6 +959,8 @@ void CCPUInfo::ReadCPUFeatures()
         m_cpuFeatures |= CPU_FEATURE_3DNOW;
       if (strstr(buffer,"3DNOWEXT "))
        m_cpuFeatures |= CPU_FEATURE_3DNOWEXT;
+      if (strstr(buffer,"AVX1.0 "))
+        m_cpuFeatures |= CPU_FEATURE_AVX;
     }
     else
       m_cpuFeatures |= CPU_FEATURE_MMX;
@@ -955,6 +984,10 @@ bool CCPUInfo::HasNeon()
 #elif defined(TARGET_DARWIN_IOS)
   has_neon = 1;
 
+#elif defined(__aarch64__)
+  // advanced simd is mandatory on armv8-a
+  has_neon = 1;
+
 #elif defined(TARGET_LINUX) && defined(__ARM_NEON__)
   if (has_neon == -1)
   {
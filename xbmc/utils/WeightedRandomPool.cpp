@@ -0,0 +1,198 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "WeightedRandomPool.h"
+
+#include <algorithm>
+
+const float CWeightedRandomPool::MinWeight = 0.001f;
+
+// number of draws before falling back to a scan of the ids that are not excluded
+#define MAX_DRAWS 32
+
+CWeightedRandomPool::CWeightedRandomPool(unsigned int seed /* = std::random_device()() */)
+  : m_outdated(false),
+    m_random(seed)
+{
+}
+
+void CWeightedRandomPool::Set(int id, float weight)
+{
+  weight = std::max(weight, MinWeight);
+  auto it = m_index.find(id);
+  if (it != m_index.end())
+  {
+    if (m_weights[it->second] == weight)
+      return;
+    m_weights[it->second] = weight;
+  }
+  else
+  {
+    m_index.insert(std::make_pair(id, m_ids.size()));
+    m_ids.push_back(id);
+    m_weights.push_back(weight);
+  }
+  m_outdated = true;
+}
+
+void CWeightedRandomPool::Remove(int id)
+{
+  auto it = m_index.find(id);
+  if (it == m_index.end())
+    return;
+
+  // move the last id into the gap
+  size_t pos = it->second;
+  m_index.erase(it);
+  if (pos != m_ids.size() - 1)
+  {
+    m_ids[pos] = m_ids.back();
+    m_weights[pos] = m_weights.back();
+    m_index[m_ids[pos]] = pos;
+  }
+  m_ids.pop_back();
+  m_weights.pop_back();
+  m_outdated = true;
+}
+
+void CWeightedRandomPool::Clear()
+{
+  m_ids.clear();
+  m_weights.clear();
+  m_index.clear();
+  m_probability.clear();
+  m_alias.clear();
+  m_outdated = false;
+}
+
+bool CWeightedRandomPool::Contains(int id) const
+{
+  return m_index.find(id) != m_index.end();
+}
+
+unsigned int CWeightedRandomPool::Random(unsigned int range)
+{
+  if (range == 0)
+    return 0;
+  return std::uniform_int_distribution<unsigned int>(0, range - 1)(m_random);
+}
+
+int CWeightedRandomPool::Pick(const std::unordered_set<int> &exclude /* = std::unordered_set<int>() */)
+{
+  if (m_ids.empty())
+    return -1;
+  if (m_outdated)
+    Build();
+
+  std::uniform_int_distribution<size_t> column(0, m_ids.size() - 1);
+  std::uniform_real_distribution<float> coin(0.0f, 1.0f);
+  for (int i = 0; i < MAX_DRAWS; i++)
+  {
+    size_t pos = column(m_random);
+    if (coin(m_random) >= m_probability[pos])
+      pos = m_alias[pos];
+    if (exclude.find(m_ids[pos]) == exclude.end())
+      return m_ids[pos];
+  }
+
+  // most of the weight is excluded, pick from the remaining ids directly
+  double total = 0;
+  for (size_t i = 0; i < m_ids.size(); i++)
+  {
+    if (exclude.find(m_ids[i]) == exclude.end())
+      total += m_weights[i];
+  }
+  if (total <= 0)
+    return -1;
+
+  double target = std::uniform_real_distribution<double>(0.0, total)(m_random);
+  int last = -1;
+  for (size_t i = 0; i < m_ids.size(); i++)
+  {
+    if (exclude.find(m_ids[i]) != exclude.end())
+      continue;
+    last = m_ids[i];
+    target -= m_weights[i];
+    if (target < 0)
+      break;
+  }
+  return last;
+}
+
+float CWeightedRandomPool::GetWeight(float rating, int playCount)
+{
+  rating = std::min(std::max(rating, 0.0f), 10.0f);
+  playCount = std::max(playCount, 0);
+  return (1.0f + rating / 5.0f) / (1.0f + playCount / 10.0f);
+}
+
+void CWeightedRandomPool::Build()
+{
+  size_t count = m_ids.size();
+  double total = 0;
+  for (float weight : m_weights)
+    total += weight;
+
+  m_probability.resize(count);
+  m_alias.resize(count);
+
+  // scale the weights to an average of 1, then pair every column below 1
+  // with one above 1 that fills it up
+  std::vector<size_t> small, large;
+  std::vector<double> scaled(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    scaled[i] = m_weights[i] * count / total;
+    if (scaled[i] < 1.0)
+      small.push_back(i);
+    else
+      large.push_back(i);
+  }
+
+  while (!small.empty() && !large.empty())
+  {
+    size_t less = small.back();
+    small.pop_back();
+    size_t more = large.back();
+
+    m_probability[less] = static_cast<float>(scaled[less]);
+    m_alias[less] = more;
+    scaled[more] -= 1.0 - scaled[less];
+    if (scaled[more] < 1.0)
+    {
+      large.pop_back();
+      small.push_back(more);
+    }
+  }
+
+  // what is left is 1 except for rounding errors
+  for (size_t i : large)
+  {
+    m_probability[i] = 1.0f;
+    m_alias[i] = i;
+  }
+  for (size_t i : small)
+  {
+    m_probability[i] = 1.0f;
+    m_alias[i] = i;
+  }
+
+  m_outdated = false;
+}
@@ -0,0 +1,88 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*!
+ \brief Picks ids at random, each with a probability proportional to its weight.
+
+ Picks are done in constant time with an alias table (Vose's alias method).
+ Adding, updating or removing an id only marks the table as outdated, it is
+ rebuilt in linear time by the next pick. Excluded ids are handled by
+ drawing again, so excluding a few ids out of a large pool costs nothing.
+ */
+class CWeightedRandomPool
+{
+public:
+  explicit CWeightedRandomPool(unsigned int seed = std::random_device()());
+
+  /*!
+   \brief Add an id to the pool or change its weight.
+   \param weight relative weight of the id, values below MinWeight are raised to it
+   */
+  void Set(int id, float weight);
+  void Remove(int id);
+  void Clear();
+
+  bool Contains(int id) const;
+  size_t Size() const { return m_ids.size(); }
+  bool IsEmpty() const { return m_ids.empty(); }
+
+  /*!
+   \brief Pick a random id that is not in exclude.
+   \return the id, -1 if all ids are excluded or the pool is empty
+   */
+  int Pick(const std::unordered_set<int> &exclude = std::unordered_set<int>());
+
+  /*!
+   \brief A random number from 0 to range - 1, drawn from the generator of the pool.
+   \return the number, 0 if range is 0
+   */
+  unsigned int Random(unsigned int range);
+
+  /*!
+   \brief The weight of a song or music video in party mode.
+   An item rated 10 is picked three times as often as an unrated one, an item
+   played 10 times half as often as one never played.
+   \param rating the rating from 0 to 10
+   \param playCount the number of times the item was played
+   */
+  static float GetWeight(float rating, int playCount);
+
+  static const float MinWeight;
+
+private:
+  void Build();
+
+  std::vector<int> m_ids;
+  std::vector<float> m_weights;
+  std::unordered_map<int, size_t> m_index;  // id -> position in m_ids
+
+  // alias table, valid unless m_outdated
+  std::vector<float> m_probability;
+  std::vector<size_t> m_alias;
+  bool m_outdated;
+
+  std::mt19937 m_random;
+};
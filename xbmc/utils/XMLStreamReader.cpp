@@ -0,0 +1,354 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "XMLStreamReader.h"
+#include "URL.h"
+#include "filesystem/File.h"
+#include "utils/log.h"
+
+#include <string.h>
+#include <algorithm>
+
+#define READ_CHUNK_SIZE 65536
+
+namespace
+{
+
+bool IsNameEnd(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '>' || c == '/';
+}
+
+}
+
+CXMLStreamReader::CXMLStreamReader(const ElementCallback &callback)
+  : m_callback(callback),
+    m_pos(0),
+    m_elementStart(std::string::npos),
+    m_maxBuffer(0),
+    m_complete(false),
+    m_stopped(false),
+    m_error(false)
+{
+}
+
+bool CXMLStreamReader::Feed(const char *data, size_t size)
+{
+  if (m_error || m_stopped)
+    return false;
+
+  m_buffer.append(data, size);
+  m_maxBuffer = std::max(m_maxBuffer, m_buffer.size());
+
+  while (m_pos < m_buffer.size())
+  {
+    if (m_buffer[m_pos] != '<')
+    { // character data is only kept as part of an element
+      size_t next = m_buffer.find('<', m_pos);
+      m_pos = next == std::string::npos ? m_buffer.size() : next;
+      continue;
+    }
+
+    size_t end;
+    std::string name;
+    TokenType type = ParseToken(m_pos, end, name);
+    if (type == TokenIncomplete)
+      break;
+    if (type == TokenInvalid)
+      return Fail("invalid markup");
+
+    bool elementEnd = false;
+    if (type == TokenStartTag || type == TokenEmptyTag)
+    {
+      if (m_open.empty())
+      {
+        if (!m_rootName.empty())
+          return Fail("more than one root element");
+        m_rootName = name;
+        if (type == TokenEmptyTag)
+          m_complete = true;
+        else
+          m_open.push_back(name);
+      }
+      else
+      {
+        if (m_open.size() == 1)
+        {
+          m_elementStart = m_pos;
+          m_elementName = name;
+        }
+        if (type == TokenStartTag)
+          m_open.push_back(name);
+        else
+          elementEnd = m_open.size() == 1;
+      }
+    }
+    else if (type == TokenEndTag)
+    {
+      if (m_open.empty() || m_open.back() != name)
+        return Fail("mismatched end tag");
+      m_open.pop_back();
+      if (m_open.empty())
+        m_complete = true;
+      else
+        elementEnd = m_open.size() == 1;
+    }
+
+    m_pos = end;
+    if (elementEnd)
+    {
+      std::string xml(m_buffer, m_elementStart, end - m_elementStart);
+      m_elementStart = std::string::npos;
+      if (!m_callback(m_elementName, xml))
+      {
+        m_stopped = true;
+        return false;
+      }
+    }
+  }
+
+  // drop everything that was processed and isn't part of the current element
+  size_t processed = m_elementStart != std::string::npos ? m_elementStart : m_pos;
+  m_buffer.erase(0, processed);
+  m_pos -= processed;
+  if (m_elementStart != std::string::npos)
+    m_elementStart = 0;
+
+  return true;
+}
+
+CXMLStreamReader::TokenType CXMLStreamReader::ParseToken(size_t pos, size_t &end, std::string &name) const
+{
+  int match;
+  if ((match = StartsWith(pos, "<?")) != 0)
+  {
+    end = match < 0 ? std::string::npos : FindEnd(pos + 2, "?>");
+    return end == std::string::npos ? TokenIncomplete : TokenSkipped;
+  }
+  if ((match = StartsWith(pos, "<!--")) != 0)
+  {
+    end = match < 0 ? std::string::npos : FindEnd(pos + 4, "-->");
+    return end == std::string::npos ? TokenIncomplete : TokenSkipped;
+  }
+  if ((match = StartsWith(pos, "<![CDATA[")) != 0)
+  {
+    end = match < 0 ? std::string::npos : FindEnd(pos + 9, "]]>");
+    return end == std::string::npos ? TokenIncomplete : TokenSkipped;
+  }
+  if (StartsWith(pos, "<!") == 1)
+  { // doctype, skip its internal subset
+    int brackets = 0;
+    char quote = 0;
+    for (size_t i = pos + 2; i < m_buffer.size(); ++i)
+    {
+      char c = m_buffer[i];
+      if (quote)
+      {
+        if (c == quote)
+          quote = 0;
+      }
+      else if (c == '"' || c == '\'')
+        quote = c;
+      else if (c == '[')
+        brackets++;
+      else if (c == ']')
+        brackets--;
+      else if (c == '>' && brackets <= 0)
+      {
+        end = i + 1;
+        return TokenSkipped;
+      }
+    }
+    return TokenIncomplete;
+  }
+
+  bool endTag = StartsWith(pos, "</") == 1;
+  size_t nameStart = pos + (endTag ? 2 : 1);
+
+  // find the closing '>', which may be part of an attribute value
+  char quote = 0;
+  end = std::string::npos;
+  for (size_t i = nameStart; i < m_buffer.size(); ++i)
+  {
+    char c = m_buffer[i];
+    if (quote)
+    {
+      if (c == quote)
+        quote = 0;
+    }
+    else if (c == '"' || c == '\'')
+      quote = c;
+    else if (c == '<')
+      return TokenInvalid;
+    else if (c == '>')
+    {
+      end = i + 1;
+      break;
+    }
+  }
+  if (end == std::string::npos)
+    return TokenIncomplete;
+
+  size_t nameEnd = nameStart;
+  while (nameEnd < end && !IsNameEnd(m_buffer[nameEnd]))
+    nameEnd++;
+  if (nameEnd == nameStart)
+    return TokenInvalid;
+  name.assign(m_buffer, nameStart, nameEnd - nameStart);
+
+  if (endTag)
+    return TokenEndTag;
+  return m_buffer[end - 2] == '/' ? TokenEmptyTag : TokenStartTag;
+}
+
+int CXMLStreamReader::StartsWith(size_t pos, const char *markup) const
+{
+  for (size_t i = 0; markup[i] != '\0'; ++i)
+  {
+    if (pos + i >= m_buffer.size())
+      return -1;
+    if (m_buffer[pos + i] != markup[i])
+      return 0;
+  }
+  return 1;
+}
+
+size_t CXMLStreamReader::FindEnd(size_t pos, const char *terminator) const
+{
+  size_t found = m_buffer.find(terminator, pos);
+  return found == std::string::npos ? std::string::npos : found + strlen(terminator);
+}
+
+bool CXMLStreamReader::Fail(const char *reason)
+{
+  CLog::Log(LOGERROR, "CXMLStreamReader: %s in <%s>", reason, m_rootName.c_str());
+  m_error = true;
+  return false;
+}
+
+bool CXMLStreamReader::ReadFile(const std::string &path, const ElementCallback &callback, const ProgressCallback &progress /* = ProgressCallback() */)
+{
+  XFILE::CFile file;
+  if (!file.Open(path))
+  {
+    CLog::Log(LOGERROR, "%s - unable to open %s", __FUNCTION__, CURL::GetRedacted(path).c_str());
+    return false;
+  }
+
+  int64_t length = file.GetLength();
+  uint64_t size = length > 0 ? length : 0;
+  uint64_t read = 0;
+
+  CXMLStreamReader reader(callback);
+  std::vector<char> buffer(READ_CHUNK_SIZE);
+  while (!reader.IsComplete())
+  {
+    ssize_t bytes = file.Read(buffer.data(), buffer.size());
+    if (bytes < 0)
+    {
+      CLog::Log(LOGERROR, "%s - error reading %s", __FUNCTION__, CURL::GetRedacted(path).c_str());
+      return false;
+    }
+    if (bytes == 0)
+      break;
+
+    read += bytes;
+    if (!reader.Feed(buffer.data(), bytes))
+      return reader.IsStopped();
+    if (progress && !progress(read, size))
+      return true;
+  }
+
+  if (!reader.IsComplete())
+  {
+    CLog::Log(LOGERROR, "%s - %s ends within its root element", __FUNCTION__, CURL::GetRedacted(path).c_str());
+    return false;
+  }
+  return true;
+}
+
+bool CXMLStreamReader::ReadLastElement(const std::string &path, const std::string &name, const ElementCallback &callback)
+{
+  XFILE::CFile file;
+  if (!file.Open(path))
+  {
+    CLog::Log(LOGERROR, "%s - unable to open %s", __FUNCTION__, CURL::GetRedacted(path).c_str());
+    return false;
+  }
+
+  int64_t length = file.GetLength();
+  if (length <= 0)
+    return false;
+
+  // prepend chunks from the end until the tail holds the start tag, only the
+  // new chunk has to be searched as the ones after it had no start tag
+  const std::string tag = "<" + name;
+  std::string tail;
+  size_t start = std::string::npos;
+  int64_t pos = length;
+  while (pos > 0 && start == std::string::npos)
+  {
+    size_t chunk = static_cast<size_t>(std::min<int64_t>(pos, READ_CHUNK_SIZE));
+    pos -= chunk;
+    std::string data(chunk, '\0');
+    if (file.Seek(pos, SEEK_SET) != pos || file.Read(&data[0], chunk) != static_cast<ssize_t>(chunk))
+    {
+      CLog::Log(LOGERROR, "%s - error reading %s", __FUNCTION__, CURL::GetRedacted(path).c_str());
+      return false;
+    }
+    tail.insert(0, data);
+
+    size_t found = tail.rfind(tag, chunk - 1);
+    while (found != std::string::npos && start == std::string::npos)
+    {
+      if (found + tag.size() < tail.size() && IsNameEnd(tail[found + tag.size()]))
+        start = found;
+      else if (found > 0)
+        found = tail.rfind(tag, found - 1);
+      else
+        found = std::string::npos;
+    }
+  }
+  if (start == std::string::npos)
+    return true;
+
+  // the tail ends with the end tag of the root, read it as if the element was its only child
+  size_t rootEnd = tail.rfind("</");
+  size_t rootNameEnd = rootEnd != std::string::npos ? tail.find('>', rootEnd) : std::string::npos;
+  if (rootEnd == std::string::npos || rootEnd < start || rootNameEnd == std::string::npos)
+    return false;
+  std::string root = "<" + tail.substr(rootEnd + 2, rootNameEnd - rootEnd - 2) + ">";
+
+  // only handed to the callback once the tail turned out to be well formed,
+  // a last element that is nested deeper must not be reported
+  std::string element;
+  CXMLStreamReader reader([&name, &element](const std::string &child, const std::string &xml) {
+    if (child == name)
+      element = xml;
+    return true;
+  });
+  if (!reader.Feed(root.c_str(), root.size()) ||
+      !reader.Feed(tail.c_str() + start, tail.size() - start) ||
+      !reader.IsComplete() || element.empty())
+    return false;
+
+  callback(name, element);
+  return true;
+}
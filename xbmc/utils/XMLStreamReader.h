@@ -0,0 +1,157 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*!
+ \brief Splits an XML document into the elements below its root while it is read.
+
+ Library exports hold one element per movie, show or album below the root,
+ which grows to hundreds of MB for large libraries. Instead of loading the
+ whole document, the data is fed in chunks and every direct child of the root
+ is handed to a callback as soon as its end tag was read, as text that can be
+ parsed on its own. Only the element being read is kept, so memory stays
+ bounded by the largest element.
+
+ Only the structure is checked: tags have to be nested properly, everything
+ else is left to the parser of the elements. Comments, processing
+ instructions, CDATA sections and quoted attribute values are skipped as a
+ whole, so markup inside them doesn't count.
+ */
+class CXMLStreamReader
+{
+public:
+  /*!
+   \brief Called for every direct child of the root.
+   \param name the tag name of the element
+   \param xml the element from its start to its end tag
+   \return false to stop reading
+   */
+  typedef std::function<bool(const std::string &name, const std::string &xml)> ElementCallback;
+
+  /*!
+   \brief Called after every chunk read by ReadFile().
+   \param read the number of bytes read so far
+   \param size the size of the file, 0 if unknown
+   \return false to stop reading
+   */
+  typedef std::function<bool(uint64_t read, uint64_t size)> ProgressCallback;
+
+  explicit CXMLStreamReader(const ElementCallback &callback);
+
+  /*!
+   \brief Process the next chunk of the document, which may end anywhere.
+   \return false if the document is malformed or reading was stopped by the callback
+   */
+  bool Feed(const char *data, size_t size);
+
+  /*!
+   \brief Whether the end tag of the root was read.
+   */
+  bool IsComplete() const { return m_complete; }
+
+  /*!
+   \brief Whether the callback stopped reading.
+   */
+  bool IsStopped() const { return m_stopped; }
+
+  bool HasError() const { return m_error; }
+
+  /*!
+   \brief The tag name of the root, empty until its start tag was read.
+   */
+  const std::string& GetRootName() const { return m_rootName; }
+
+  /*!
+   \brief Most bytes that were buffered at a time.
+   */
+  size_t GetMaxBufferSize() const { return m_maxBuffer; }
+
+  /*!
+   \brief Read a file through a CXMLStreamReader.
+   \param path the file to read
+   \param callback called for every direct child of the root
+   \param progress called after every chunk, may be empty
+   \return false if the file couldn't be read or is malformed, true if it was
+           read completely or reading was stopped by one of the callbacks
+   */
+  static bool ReadFile(const std::string &path, const ElementCallback &callback, const ProgressCallback &progress = ProgressCallback());
+
+  /*!
+   \brief Read the last direct child of the root with the given name, reading the file from its end.
+   For documents that end with a small element after a large number of others,
+   like the paths of library exports written by older versions.
+   \param path the file to read
+   \param name the tag name of the element
+   \param callback called for the element if it was found
+   \return false if the file couldn't be read from its end, e.g. as its size is
+           unknown, or the last element with that name is not a direct child of
+           the root, true if it was read or the file has no such element
+   */
+  static bool ReadLastElement(const std::string &path, const std::string &name, const ElementCallback &callback);
+
+private:
+  enum TokenType
+  {
+    TokenIncomplete,
+    TokenInvalid,
+    TokenSkipped,    ///< declaration, processing instruction, comment, CDATA or doctype
+    TokenStartTag,
+    TokenEndTag,
+    TokenEmptyTag
+  };
+
+  /*!
+   \brief Find the end of the markup starting at pos.
+   \param end receives the position after the closing '>'
+   \param name receives the tag name of start, end and empty tags
+   */
+  TokenType ParseToken(size_t pos, size_t &end, std::string &name) const;
+
+  /*!
+   \brief Check whether the buffer at pos starts with the given markup.
+   \return 1 if it does, 0 if it doesn't and -1 if the buffer ends before it can be told
+   */
+  int StartsWith(size_t pos, const char *markup) const;
+
+  /*!
+   \brief Find the end of the markup starting at pos that ends with terminator.
+   \return the position after the terminator, std::string::npos if it wasn't read yet
+   */
+  size_t FindEnd(size_t pos, const char *terminator) const;
+
+  bool Fail(const char *reason);
+
+  ElementCallback m_callback;
+  std::string m_buffer;
+  size_t m_pos;                   ///< the first unprocessed byte in m_buffer
+  size_t m_elementStart;          ///< start of the current child of the root in m_buffer, npos outside
+  std::string m_elementName;
+  std::vector<std::string> m_open; ///< names of the open tags, the root first
+  std::string m_rootName;
+  size_t m_maxBuffer;
+  bool m_complete;
+  bool m_stopped;
+  bool m_error;
+};
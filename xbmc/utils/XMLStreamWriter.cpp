@@ -0,0 +1,90 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "XMLStreamWriter.h"
+#include "URL.h"
+#include "utils/log.h"
+#include "utils/XBMCTinyXML.h"
+
+CXMLStreamWriter::CXMLStreamWriter()
+  : m_failed(false)
+{
+}
+
+CXMLStreamWriter::~CXMLStreamWriter()
+{
+  Close();
+}
+
+bool CXMLStreamWriter::Open(const std::string &path, const std::string &rootName)
+{
+  Close();
+  if (rootName.empty() || !m_file.OpenForWrite(path, true))
+  {
+    CLog::Log(LOGERROR, "%s - unable to create %s", __FUNCTION__, CURL::GetRedacted(path).c_str());
+    return false;
+  }
+
+  m_rootName = rootName;
+  m_failed = false;
+  std::string start = "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\" ?>\n<" + m_rootName + ">\n";
+  return WriteString(start.c_str(), start.size());
+}
+
+bool CXMLStreamWriter::Write(const TiXmlNode &node)
+{
+  if (!IsOpen())
+    return false;
+
+  TiXmlPrinter printer;
+  node.Accept(&printer);
+  return WriteString(printer.CStr(), printer.Size());
+}
+
+bool CXMLStreamWriter::WriteChildren(TiXmlNode &parent)
+{
+  bool result = true;
+  while (TiXmlNode *child = parent.FirstChild())
+  {
+    if (!Write(*child))
+      result = false;
+    parent.RemoveChild(child);
+  }
+  return result;
+}
+
+bool CXMLStreamWriter::Close()
+{
+  if (!IsOpen())
+    return false;
+
+  std::string end = "</" + m_rootName + ">\n";
+  WriteString(end.c_str(), end.size());
+  m_file.Close();
+  m_rootName.clear();
+  return !m_failed;
+}
+
+bool CXMLStreamWriter::WriteString(const char *data, size_t size)
+{
+  if (m_file.Write(data, size) != static_cast<ssize_t>(size))
+    m_failed = true;
+  return !m_failed;
+}
@@ -0,0 +1,71 @@
+#pragma once
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string>
+
+#include "filesystem/File.h"
+
+class TiXmlNode;
+
+/*!
+ \brief Writes an XML document one element below its root at a time.
+
+ The counterpart of CXMLStreamReader: instead of building the whole document
+ before saving it, the elements below the root are written as soon as they
+ are complete, so only one of them is held in memory. The result holds the
+ same document CXBMCTinyXML::SaveFile() writes, indented per element.
+ */
+class CXMLStreamWriter
+{
+public:
+  CXMLStreamWriter();
+  ~CXMLStreamWriter();
+
+  /*!
+   \brief Create the file and write the declaration and start tag of the root.
+   */
+  bool Open(const std::string &path, const std::string &rootName);
+
+  /*!
+   \brief Write a node below the root.
+   */
+  bool Write(const TiXmlNode &node);
+
+  /*!
+   \brief Write the children of a node below the root and remove them from the node.
+   */
+  bool WriteChildren(TiXmlNode &parent);
+
+  /*!
+   \brief Write the end tag of the root and close the file.
+   \return false if any of the writes failed
+   */
+  bool Close();
+
+  bool IsOpen() const { return !m_rootName.empty(); }
+
+private:
+  bool WriteString(const char *data, size_t size);
+
+  XFILE::CFile m_file;
+  std::string m_rootName;
+  bool m_failed;
+};
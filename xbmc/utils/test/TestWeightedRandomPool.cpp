@@ -0,0 +1,234 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "XBDateTime.h"
+#include "music/MusicDatabase.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestDatabase.h"
+#include "threads/SystemClock.h"
+#include "utils/StringUtils.h"
+#include "utils/WeightedRandomPool.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(TestWeightedRandomPool, Distribution)
+{
+  CWeightedRandomPool pool(1234);
+  for (int id = 1; id <= 4; id++)
+    pool.Set(id, static_cast<float>(id));
+
+  const int picks = 100000;
+  std::map<int, int> counts;
+  for (int i = 0; i < picks; i++)
+    counts[pool.Pick()]++;
+
+  EXPECT_EQ(4u, counts.size());
+  for (int id = 1; id <= 4; id++)
+    EXPECT_NEAR(id / 10.0, counts[id] / static_cast<double>(picks), 0.01) << id;
+}
+
+TEST(TestWeightedRandomPool, Exclude)
+{
+  CWeightedRandomPool pool(1234);
+  EXPECT_EQ(-1, pool.Pick());
+
+  for (int id = 1; id <= 100; id++)
+    pool.Set(id, 1.0f);
+  pool.Set(100, 1000.0f);
+
+  std::unordered_set<int> exclude;
+  for (int id = 2; id <= 100; id++)
+    exclude.insert(id);
+  for (int i = 0; i < 100; i++)
+    EXPECT_EQ(1, pool.Pick(exclude));
+
+  exclude.insert(1);
+  EXPECT_EQ(-1, pool.Pick(exclude));
+}
+
+TEST(TestWeightedRandomPool, Update)
+{
+  CWeightedRandomPool pool(1234);
+  pool.Set(1, 1.0f);
+  pool.Set(2, 1.0f);
+  pool.Set(3, 1.0f);
+  EXPECT_EQ(3u, pool.Size());
+  pool.Pick();
+
+  pool.Remove(1);
+  pool.Remove(4);
+  pool.Set(2, 0.0f);
+  EXPECT_EQ(2u, pool.Size());
+  EXPECT_FALSE(pool.Contains(1));
+  EXPECT_TRUE(pool.Contains(2));
+
+  int counts[4] = { 0 };
+  for (int i = 0; i < 10000; i++)
+    counts[pool.Pick()]++;
+  EXPECT_EQ(0, counts[1]);
+  EXPECT_LT(counts[2], 100);
+  EXPECT_GT(counts[3], 9900);
+
+  pool.Clear();
+  EXPECT_TRUE(pool.IsEmpty());
+  EXPECT_EQ(-1, pool.Pick());
+}
+
+TEST(TestWeightedRandomPool, Random)
+{
+  CWeightedRandomPool pool(1234);
+  EXPECT_EQ(0u, pool.Random(0));
+  EXPECT_EQ(0u, pool.Random(1));
+
+  int counts[3] = { 0 };
+  for (int i = 0; i < 3000; i++)
+  {
+    unsigned int value = pool.Random(3);
+    ASSERT_LT(value, 3u);
+    counts[value]++;
+  }
+  for (int i = 0; i < 3; i++)
+    EXPECT_NEAR(1000, counts[i], 100) << i;
+}
+
+TEST(TestWeightedRandomPool, GetWeight)
+{
+  EXPECT_FLOAT_EQ(1.0f, CWeightedRandomPool::GetWeight(0.0f, 0));
+  EXPECT_FLOAT_EQ(3.0f, CWeightedRandomPool::GetWeight(10.0f, 0));
+  EXPECT_FLOAT_EQ(0.5f, CWeightedRandomPool::GetWeight(0.0f, 10));
+  EXPECT_FLOAT_EQ(3.0f, CWeightedRandomPool::GetWeight(20.0f, -1));
+}
+
+/* Party mode on a music library of 100000 songs with the last 200 songs
+ * excluded. Before the pool, party mode ran CMusicDatabase::GetRandomSong()
+ * with an ORDER BY RANDOM() query for every song it added. Now it loads the
+ * pool once with CMusicDatabase::GetSongIDs() and fetches the picked songs
+ * with GetSongsByWhere(). The rates and times are recorded as properties of
+ * the test, run it with --gtest_also_run_disabled_tests
+ * --gtest_filter=*PartyModeBenchmark.
+ */
+TEST(TestWeightedRandomPool, DISABLED_PartyModeBenchmark)
+{
+  const int songs = 100000;
+  const int history = 200;
+
+  CTestDatabase<CMusicDatabase> db(g_advancedSettings.m_databaseMusic, "TestMyMusic");
+  ASSERT_TRUE(db.Open());
+  ASSERT_TRUE(db.BeginBatch());
+  std::vector<int> ids;
+  int idAlbum = -1;
+  for (int i = 0; i < songs; i++)
+  {
+    if (i % 10 == 0)
+    {
+      idAlbum = db.AddAlbum(StringUtils::Format("Album %i", i / 10), "", StringUtils::Format("Artist %i", i / 100),
+                            "Rock", 2000 + i % 17, false, CAlbum::Album);
+      ASSERT_GE(idAlbum, 0);
+    }
+    int idSong = db.AddSong(idAlbum, StringUtils::Format("Song %i", i), "",
+                            StringUtils::Format("/music/%i/%i.mp3", i / 10, i), "", "", "",
+                            StringUtils::Format("Artist %i", i / 100), std::vector<std::string>{ "Rock" },
+                            i % 10 + 1, 200, 2000 + i % 17, i % 23, 0, 0, CDateTime(),
+                            static_cast<float>(i % 11), i % 7 == 0 ? i % 10 : 0, 0);
+    ASSERT_GE(idSong, 0);
+    ids.push_back(idSong);
+  }
+  ASSERT_TRUE(db.CommitBatch());
+
+  std::vector<std::string> historyIds;
+  std::unordered_set<int> exclude;
+  for (int i = 0; i < history; i++)
+  {
+    int id = ids[i * (songs / history)];
+    historyIds.push_back(StringUtils::Format("%i", id));
+    exclude.insert(id);
+  }
+
+  // the query party mode ran for every song
+  const int queryPicks = 20;
+  CDatabase::Filter filter("songview.idSong not in (" + StringUtils::Join(historyIds, ", ") + ")");
+  int queryFailures = 0;
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < queryPicks; i++)
+  {
+    CFileItem item;
+    int idSong;
+    if (!db.GetRandomSong(&item, idSong, filter) || exclude.find(idSong) != exclude.end())
+      queryFailures++;
+  }
+  unsigned int queryMs = std::max(XbmcThreads::SystemClockMillis() - start, 1u);
+  EXPECT_EQ(0, queryFailures);
+
+  // loading the pool once
+  CWeightedRandomPool pool;
+  start = XbmcThreads::SystemClockMillis();
+  EXPECT_EQ(static_cast<unsigned int>(songs), db.GetSongIDs(CDatabase::Filter(), pool));
+  pool.Pick();
+  unsigned int loadMs = XbmcThreads::SystemClockMillis() - start;
+
+  // a pick and the fetch of the picked song, for every song
+  const int fetchPicks = 200;
+  int fetchFailures = 0;
+  start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < fetchPicks; i++)
+  {
+    int idSong = pool.Pick(exclude);
+    CFileItemList items;
+    db.GetSongsByWhere("musicdb://songs/", StringUtils::Format("songview.idSong IN (%i)", idSong), items);
+    if (items.Size() != 1 || exclude.find(idSong) != exclude.end())
+      fetchFailures++;
+  }
+  unsigned int fetchMs = std::max(XbmcThreads::SystemClockMillis() - start, 1u);
+  EXPECT_EQ(0, fetchFailures);
+
+  // the picks alone
+  const int poolPicks = 1000000;
+  int pickFailures = 0;
+  start = XbmcThreads::SystemClockMillis();
+  for (int i = 0; i < poolPicks; i++)
+  {
+    if (exclude.find(pool.Pick(exclude)) != exclude.end())
+      pickFailures++;
+  }
+  unsigned int pickMs = std::max(XbmcThreads::SystemClockMillis() - start, 1u);
+  EXPECT_EQ(0, pickFailures);
+
+  // an update of the library rebuilds the table on the next pick
+  pool.Set(ids[0], 10.0f);
+  start = XbmcThreads::SystemClockMillis();
+  pool.Pick(exclude);
+  unsigned int rebuildMs = XbmcThreads::SystemClockMillis() - start;
+
+  RecordProperty("songs", songs);
+  RecordProperty("history", history);
+  RecordProperty("query_songs_per_sec", static_cast<int>(queryPicks * 1000.0 / queryMs));
+  RecordProperty("pool_load_ms", static_cast<int>(loadMs));
+  RecordProperty("pool_songs_per_sec", static_cast<int>(fetchPicks * 1000.0 / fetchMs));
+  RecordProperty("pool_picks_per_sec", static_cast<int>(poolPicks * 1000.0 / pickMs));
+  RecordProperty("pool_rebuild_ms", static_cast<int>(rebuildMs));
+  db.Close();
+}
@@ -0,0 +1,403 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "IProgressCallback.h"
+#include "XBDateTime.h"
+#include "filesystem/Directory.h"
+#include "filesystem/File.h"
+#include "music/MusicDatabase.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestDatabase.h"
+#include "utils/StringUtils.h"
+#include "utils/URIUtils.h"
+#include "utils/XBMCTinyXML.h"
+#include "utils/XMLStreamReader.h"
+#include "utils/XMLStreamWriter.h"
+#include "utils/XMLUtils.h"
+#include "video/VideoDatabase.h"
+#include "video/VideoInfoTag.h"
+
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+typedef std::vector<std::pair<std::string, std::string> > Elements;
+
+const std::string document =
+  "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\" ?>\n"
+  "<!-- <notanelement> -->\n"
+  "<videodb>\n"
+  "  <version>1</version>\n"
+  "  <movie id=\"1\" note='a > b'>\n"
+  "    <title>First</title>\n"
+  "    <plot><![CDATA[ends with </movie> ]]></plot>\n"
+  "    <!-- </movie> -->\n"
+  "    <movie><title>Nested</title></movie>\n"
+  "    <empty/>\n"
+  "  </movie>\n"
+  "  <paths />\n"
+  "</videodb>\n";
+
+CXMLStreamReader::ElementCallback Collect(Elements &elements)
+{
+  return [&elements](const std::string &name, const std::string &xml) {
+    elements.push_back(std::make_pair(name, xml));
+    return true;
+  };
+}
+
+/* A movie as CVideoInfoTag::Save() writes it, with the usual amount of cast and art. */
+void AddMovie(TiXmlNode *parent, int id)
+{
+  TiXmlElement movie("movie");
+  XMLUtils::SetString(&movie, "title", StringUtils::Format("Movie %i", id));
+  XMLUtils::SetString(&movie, "plot", std::string(600, 'p'));
+  XMLUtils::SetInt(&movie, "year", 1950 + id % 70);
+  XMLUtils::SetString(&movie, "genre", "Drama");
+  XMLUtils::SetString(&movie, "genre", "Comedy");
+  XMLUtils::SetString(&movie, "file", StringUtils::Format("smb://server/movies/Movie %i (%i).mkv", id, 1950 + id % 70));
+  for (int i = 0; i < 8; i++)
+  {
+    TiXmlElement actor("actor");
+    XMLUtils::SetString(&actor, "name", StringUtils::Format("Actor %i", (id + i) % 5000));
+    XMLUtils::SetString(&actor, "role", StringUtils::Format("Role %i", i));
+    XMLUtils::SetString(&actor, "thumb", StringUtils::Format("http://image.tmdb.org/t/p/original/actor%i.jpg", (id + i) % 5000));
+    movie.InsertEndChild(actor);
+  }
+  TiXmlElement art("art");
+  XMLUtils::SetString(&art, "poster", StringUtils::Format("http://image.tmdb.org/t/p/original/poster%i.jpg", id));
+  XMLUtils::SetString(&art, "fanart", StringUtils::Format("http://image.tmdb.org/t/p/original/fanart%i.jpg", id));
+  movie.InsertEndChild(art);
+  parent->InsertEndChild(movie);
+}
+
+bool WriteFile(const std::string &file, const std::string &data)
+{
+  XFILE::CFile out;
+  if (!out.OpenForWrite(file, true))
+    return false;
+  bool written = out.Write(data.c_str(), data.size()) == static_cast<ssize_t>(data.size());
+  out.Close();
+  return written;
+}
+
+class CCountingProgress : public IProgressCallback
+{
+public:
+  CCountingProgress() : m_max(0), m_steps(0) {}
+  virtual void SetProgressMax(int max) override { m_max = max; m_steps = 0; }
+  virtual void SetProgressAdvance(int nSteps = 1) override { m_steps += nSteps; }
+  virtual bool Abort() override { return false; }
+
+  int m_max;
+  int m_steps;
+};
+
+}
+
+TEST(TestXMLStreamReader, Elements)
+{
+  Elements elements;
+  CXMLStreamReader reader(Collect(elements));
+  EXPECT_TRUE(reader.Feed(document.c_str(), document.size()));
+  EXPECT_TRUE(reader.IsComplete());
+  EXPECT_EQ("videodb", reader.GetRootName());
+
+  ASSERT_EQ(3u, elements.size());
+  EXPECT_EQ("version", elements[0].first);
+  EXPECT_EQ("<version>1</version>", elements[0].second);
+  EXPECT_EQ("movie", elements[1].first);
+  EXPECT_EQ(0u, elements[1].second.find("<movie id=\"1\""));
+  EXPECT_NE(std::string::npos, elements[1].second.find("<empty/>\n  </movie>"));
+  EXPECT_EQ("paths", elements[2].first);
+  EXPECT_EQ("<paths />", elements[2].second);
+
+  // each element can be parsed on its own
+  CXBMCTinyXML movie;
+  EXPECT_TRUE(movie.Parse(elements[1].second, TIXML_ENCODING_UTF8));
+  std::string title;
+  EXPECT_TRUE(XMLUtils::GetString(movie.RootElement(), "title", title));
+  EXPECT_EQ("First", title);
+}
+
+TEST(TestXMLStreamReader, Chunks)
+{
+  Elements whole;
+  CXMLStreamReader wholeReader(Collect(whole));
+  wholeReader.Feed(document.c_str(), document.size());
+
+  Elements bytes;
+  CXMLStreamReader reader(Collect(bytes));
+  for (size_t i = 0; i < document.size(); i++)
+    EXPECT_TRUE(reader.Feed(document.c_str() + i, 1));
+  EXPECT_TRUE(reader.IsComplete());
+  EXPECT_EQ(whole, bytes);
+
+  // the buffer only holds the current element
+  EXPECT_LT(reader.GetMaxBufferSize(), whole[1].second.size() + 8);
+}
+
+TEST(TestXMLStreamReader, Stop)
+{
+  int count = 0;
+  CXMLStreamReader reader([&count](const std::string &name, const std::string &xml) {
+    count++;
+    return name != "movie";
+  });
+  EXPECT_FALSE(reader.Feed(document.c_str(), document.size()));
+  EXPECT_TRUE(reader.IsStopped());
+  EXPECT_FALSE(reader.HasError());
+  EXPECT_EQ(2, count);
+
+  // nothing is read after stopping
+  EXPECT_FALSE(reader.Feed("<paths/>", 8));
+  EXPECT_EQ(2, count);
+}
+
+TEST(TestXMLStreamReader, Malformed)
+{
+  Elements elements;
+  CXMLStreamReader mismatched(Collect(elements));
+  EXPECT_FALSE(mismatched.Feed("<root><a><b></a></b></root>", 27));
+  EXPECT_TRUE(mismatched.HasError());
+  EXPECT_TRUE(elements.empty());
+
+  CXMLStreamReader roots(Collect(elements));
+  EXPECT_FALSE(roots.Feed("<root/><root/>", 14));
+
+  CXMLStreamReader truncated(Collect(elements));
+  EXPECT_TRUE(truncated.Feed("<root><a>1</a><b>", 17));
+  EXPECT_FALSE(truncated.IsComplete());
+  EXPECT_EQ(1u, elements.size());
+}
+
+TEST(TestXMLStreamReader, ReadLastElement)
+{
+  // an export with the paths after the items, larger than a chunk
+  const std::string file = "special://temp/TestXMLStreamReaderLast.xml";
+  TiXmlElement root("videodb");
+  for (int id = 0; id < 200; id++)
+    AddMovie(&root, id);
+  std::string items;
+  for (const TiXmlElement *movie = root.FirstChildElement(); movie; movie = movie->NextSiblingElement())
+    items << *movie;
+  ASSERT_GT(items.size(), 65536u * 2);
+
+  const std::string paths = "<paths><path><url>smb://server/movies/</url></path></paths>";
+  ASSERT_TRUE(WriteFile(file, "<videodb>\n<version>1</version>\n" + items + "\n<pathsettings/>" + paths + "\n</videodb>\n"));
+  Elements elements;
+  EXPECT_TRUE(CXMLStreamReader::ReadLastElement(file, "paths", Collect(elements)));
+  ASSERT_EQ(1u, elements.size());
+  EXPECT_EQ("paths", elements[0].first);
+  EXPECT_EQ(paths, elements[0].second);
+
+  // no such element
+  elements.clear();
+  ASSERT_TRUE(WriteFile(file, "<videodb>\n" + items + "\n</videodb>\n"));
+  EXPECT_TRUE(CXMLStreamReader::ReadLastElement(file, "paths", Collect(elements)));
+  EXPECT_TRUE(elements.empty());
+
+  // the last one is not a child of the root
+  ASSERT_TRUE(WriteFile(file, "<videodb>\n" + paths + items + "<movie>" + paths + "</movie>\n</videodb>\n"));
+  EXPECT_FALSE(CXMLStreamReader::ReadLastElement(file, "paths", Collect(elements)));
+  EXPECT_TRUE(elements.empty());
+
+  XFILE::CFile::Delete(file);
+}
+
+TEST(TestXMLStreamReader, Benchmark)
+{
+  // round trip of a generated videodb.xml through the streaming writer and
+  // reader, the database export and import are not part of it
+  const int items = 10000;
+  const std::string file = "special://temp/TestXMLStreamReader.xml";
+  typedef std::chrono::steady_clock clock;
+
+  clock::time_point start = clock::now();
+  CXMLStreamWriter writer;
+  ASSERT_TRUE(writer.Open(file, "videodb"));
+  TiXmlElement root("videodb");
+  for (int id = 0; id < items; id++)
+  {
+    AddMovie(&root, id);
+    EXPECT_TRUE(writer.WriteChildren(root));
+  }
+  EXPECT_TRUE(writer.Close());
+  auto writeTime = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+  // fed in the same chunks as ReadFile() uses, to see how much was buffered
+  start = clock::now();
+  int movies = 0;
+  CXMLStreamReader reader([&movies](const std::string &name, const std::string &xml) {
+    CXBMCTinyXML movie;
+    if (name == "movie" && movie.Parse(xml, TIXML_ENCODING_UTF8) && movie.RootElement()->FirstChildElement("actor"))
+      movies++;
+    return true;
+  });
+  XFILE::CFile input;
+  ASSERT_TRUE(input.Open(file));
+  uint64_t size = 0;
+  std::vector<char> buffer(64 * 1024);
+  ssize_t bytes;
+  while ((bytes = input.Read(buffer.data(), buffer.size())) > 0)
+  {
+    size += bytes;
+    ASSERT_TRUE(reader.Feed(buffer.data(), bytes));
+  }
+  input.Close();
+  auto readTime = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+  EXPECT_TRUE(reader.IsComplete());
+  EXPECT_EQ(items, movies);
+
+  // the same file as a whole document
+  start = clock::now();
+  CXBMCTinyXML whole;
+  EXPECT_TRUE(whole.LoadFile(file));
+  auto loadTime = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+  RecordProperty("items", items);
+  RecordProperty("bytes", static_cast<int>(size));
+  RecordProperty("max_buffered_bytes", static_cast<int>(reader.GetMaxBufferSize()));
+  RecordProperty("stream_write_ms", static_cast<int>(writeTime));
+  RecordProperty("stream_read_ms", static_cast<int>(readTime));
+  RecordProperty("document_load_ms", static_cast<int>(loadTime));
+
+  XFILE::CFile::Delete(file);
+}
+
+/* Export and import of a generated library through CVideoDatabase and
+ * CMusicDatabase, with the streaming writer and reader and the batched
+ * inserts. The times are recorded as properties of the test, run it with
+ * --gtest_also_run_disabled_tests --gtest_filter=*LibraryExportImport.
+ */
+TEST(TestXMLStreamReader, DISABLED_LibraryExportImport)
+{
+  const int movies = 2000;
+  const int albums = 1000;
+  const std::string exportDir = "special://temp/TestLibraryExport/";
+  typedef std::chrono::steady_clock clock;
+  ASSERT_TRUE(XFILE::CDirectory::Create(exportDir));
+
+  CCountingProgress progress;
+  clock::time_point start;
+  {
+    CTestDatabase<CVideoDatabase> db(g_advancedSettings.m_databaseVideo, "TestMyVideos");
+    ASSERT_TRUE(db.Open());
+    ASSERT_TRUE(db.BeginBatch());
+    for (int id = 0; id < movies; id++)
+    {
+      CVideoInfoTag movie;
+      movie.m_strTitle = StringUtils::Format("Movie %i", id);
+      movie.m_strPlot = std::string(600, 'p');
+      movie.SetYear(1950 + id % 70);
+      movie.m_genre = { "Drama", "Comedy" };
+      for (int i = 0; i < 8; i++)
+      {
+        SActorInfo actor;
+        actor.strName = StringUtils::Format("Actor %i", (id + i) % 5000);
+        actor.strRole = StringUtils::Format("Role %i", i);
+        actor.order = i;
+        movie.m_cast.push_back(actor);
+      }
+      movie.SetUniqueID(StringUtils::Format("tt%07i", id), "imdb", true);
+      ASSERT_GE(db.SetDetailsForMovie(StringUtils::Format("/movies/Movie %i.mkv", id), movie, std::map<std::string, std::string>()), 0);
+    }
+    ASSERT_TRUE(db.CommitBatch());
+
+    start = clock::now();
+    db.ExportToXML(exportDir, true, false, false, false, &progress);
+    RecordProperty("video_export_ms", static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count()));
+    db.Close();
+  }
+
+  std::string videoDir = URIUtils::AddFileToFolder(exportDir, "xbmc_videodb_" + CDateTime::GetCurrentDateTime().GetAsDBDate());
+  ASSERT_TRUE(XFILE::CFile::Exists(URIUtils::AddFileToFolder(videoDir, "videodb.xml")));
+  {
+    // into an empty library
+    CTestDatabase<CVideoDatabase> db(g_advancedSettings.m_databaseVideo, "TestMyVideos");
+    ASSERT_TRUE(db.Open());
+    start = clock::now();
+    db.ImportFromXML(videoDir, &progress);
+    RecordProperty("video_import_ms", static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count()));
+    EXPECT_GT(progress.m_max, 0);
+    EXPECT_LE(progress.m_steps, progress.m_max);
+
+    CFileItemList items;
+    EXPECT_TRUE(db.GetMoviesByWhere("videodb://movies/titles/", CDatabase::Filter(), items));
+    EXPECT_EQ(movies, items.Size());
+    db.Close();
+  }
+
+  {
+    CTestDatabase<CMusicDatabase> db(g_advancedSettings.m_databaseMusic, "TestMyMusic");
+    ASSERT_TRUE(db.Open());
+    ASSERT_TRUE(db.BeginBatch());
+    std::vector<int> albumIds;
+    for (int id = 0; id < albums; id++)
+    {
+      std::string album = StringUtils::Format("Album %i", id);
+      std::string artist = StringUtils::Format("Artist %i", id / 10);
+      int idAlbum = db.AddAlbum(album, "", artist, "Rock", 1970 + id % 50, false, CAlbum::Album);
+      ASSERT_GE(idAlbum, 0);
+      // only scraped albums are exported
+      db.UpdateAlbum(idAlbum, album, "", artist, "Rock", "Calm", "Pop", "Love", std::string(400, 'r'),
+                     "", "Label", "", 7.5f, 0, 10, 1970 + id % 50, false, CAlbum::Album);
+      for (int track = 1; track <= 10; track++)
+        db.AddSong(idAlbum, StringUtils::Format("Song %i", track), "",
+                   StringUtils::Format("/music/%i/%02i.mp3", id, track), "", "", "", artist,
+                   std::vector<std::string>{ "Rock" }, track, 200, 1970 + id % 50, 0, 0, 0, CDateTime(), 0.0f, 0, 0);
+      albumIds.push_back(idAlbum);
+    }
+    ASSERT_TRUE(db.CommitBatch());
+
+    std::string musicFile = URIUtils::AddFileToFolder(exportDir, "musicdb.xml");
+    start = clock::now();
+    db.ExportToXML(musicFile, true, false, false, &progress);
+    RecordProperty("music_export_ms", static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count()));
+
+    // the import updates the albums that are in the library
+    for (int idAlbum : albumIds)
+      db.ClearAlbumLastScrapedTime(idAlbum);
+    start = clock::now();
+    db.ImportFromXML(musicFile, &progress);
+    RecordProperty("music_import_ms", static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count()));
+    EXPECT_LE(progress.m_steps, progress.m_max);
+
+    int scraped = 0;
+    for (int idAlbum : albumIds)
+    {
+      if (db.HasAlbumBeenScraped(idAlbum))
+        scraped++;
+    }
+    EXPECT_EQ(albums, scraped);
+    db.Close();
+  }
+
+  RecordProperty("movies", movies);
+  RecordProperty("albums", albums);
+  XFILE::CDirectory::RemoveRecursive(exportDir);
+}
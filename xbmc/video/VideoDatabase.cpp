@@ -42,6 +42,7 @@
 #include "FileItem.h"
 #include "filesystem/Directory.h"
 #include "filesystem/File.h"
+#include "filesystem/FileExistsChecker.h"
 #include "filesystem/MultiPathDirectory.h"
 #include "filesystem/StackDirectory.h"
 #include "guiinfo/GUIInfoLabels.h"
@@ -58,6 +59,7 @@
 #include "settings/Settings.h"
 #include "storage/MediaManager.h"
 #include "TextureCache.h"
+#include "TextureCacheJob.h"
 #include "threads/SystemClock.h"
 #include "URL.h"
 #include "Util.h"
@@ -68,8 +70,12 @@
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
 #include "utils/Variant.h"
+#include "utils/WeightedRandomPool.h"
+#include "utils/XMLStreamReader.h"
+#include "utils/XMLStreamWriter.h"
 #include "utils/XMLUtils.h"
 #include "video/VideoDbUrl.h"
+#include "video/VideoThumbLoader.h"
 #include "video/windows/GUIWindowVideoBase.h"
 #include "VideoInfoScanner.h"
 #include "XBDateTime.h"
@@ -206,6 +212,8 @@ void CVideoDatabase::CreateTables()
 
   CLog::Log(LOGINFO, "create uniqueid table");
   m_pDS->exec("CREATE TABLE uniqueid (uniqueid_id INTEGER PRIMARY KEY, media_id INTEGER, media_type TEXT, value TEXT, type TEXT)");
+
+  CreateSearchIndexTables();
 }
 
 void CVideoDatabase::CreateLinkIndex(const char *table)
@@ -285,6 +293,8 @@ void CVideoDatabase::CreateAnalytics()
   CreateLinkIndex("genre");
   CreateLinkIndex("country");
 
+  CreateSearchIndexAnalytics();
+
   CLog::Log(LOGINFO, "%s - creating triggers", __FUNCTION__);
   m_pDS->exec("CREATE TRIGGER delete_movie AFTER DELETE ON movie FOR EACH ROW BEGIN "
               "DELETE FROM genre_link WHERE media_id=old.idMovie AND media_type='movie'; "
@@ -298,6 +308,7 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM tag_link WHERE media_id=old.idMovie AND media_type='movie'; "
               "DELETE FROM rating WHERE media_id=old.idMovie AND media_type='movie'; "
               "DELETE FROM uniqueid WHERE media_id=old.idMovie AND media_type='movie'; "
+              "DELETE FROM searchindex WHERE media_id=old.idMovie AND media_type='movie'; "
               "END");
   m_pDS->exec("CREATE TRIGGER delete_tvshow AFTER DELETE ON tvshow FOR EACH ROW BEGIN "
               "DELETE FROM actor_link WHERE media_id=old.idShow AND media_type='tvshow'; "
@@ -311,6 +322,7 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM tag_link WHERE media_id=old.idShow AND media_type='tvshow'; "
               "DELETE FROM rating WHERE media_id=old.idShow AND media_type='tvshow'; "
               "DELETE FROM uniqueid WHERE media_id=old.idShow AND media_type='tvshow'; "
+              "DELETE FROM searchindex WHERE media_id=old.idShow AND media_type='tvshow'; "
               "END");
   m_pDS->exec("CREATE TRIGGER delete_musicvideo AFTER DELETE ON musicvideo FOR EACH ROW BEGIN "
               "DELETE FROM actor_link WHERE media_id=old.idMVideo AND media_type='musicvideo'; "
@@ -319,6 +331,7 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM studio_link WHERE media_id=old.idMVideo AND media_type='musicvideo'; "
               "DELETE FROM art WHERE media_id=old.idMVideo AND media_type='musicvideo'; "
               "DELETE FROM tag_link WHERE media_id=old.idMVideo AND media_type='musicvideo'; "
+              "DELETE FROM searchindex WHERE media_id=old.idMVideo AND media_type='musicvideo'; "
               "END");
   m_pDS->exec("CREATE TRIGGER delete_episode AFTER DELETE ON episode FOR EACH ROW BEGIN "
               "DELETE FROM actor_link WHERE media_id=old.idEpisode AND media_type='episode'; "
@@ -327,6 +340,7 @@ void CVideoDatabase::CreateAnalytics()
               "DELETE FROM art WHERE media_id=old.idEpisode AND media_type='episode'; "
               "DELETE FROM rating WHERE media_id=old.idEpisode AND media_type='episode'; "
               "DELETE FROM uniqueid WHERE media_id=old.idEpisode AND media_type='episode'; "
+              "DELETE FROM searchindex WHERE media_id=old.idEpisode AND media_type='episode'; "
               "END");
   m_pDS->exec("CREATE TRIGGER delete_season AFTER DELETE ON seasons FOR EACH ROW BEGIN "
               "DELETE FROM art WHERE media_id=old.idSeason AND media_type='season'; "
@@ -3621,6 +3635,47 @@ bool CVideoDatabase::GetStreamDetails(CFileItem& item)
   return GetStreamDetails(*item.GetVideoInfoTag());
 }
 
+static bool AddStreamDetail(const dbiplus::sql_record* const record, CStreamDetails &details)
+{
+  CStreamDetail::StreamType e = (CStreamDetail::StreamType)record->at(1).get_asInt();
+  switch (e)
+  {
+  case CStreamDetail::VIDEO:
+    {
+      CStreamDetailVideo *p = new CStreamDetailVideo();
+      p->m_strCodec = record->at(2).get_asString();
+      p->m_fAspect = record->at(3).get_asFloat();
+      p->m_iWidth = record->at(4).get_asInt();
+      p->m_iHeight = record->at(5).get_asInt();
+      p->m_iDuration = record->at(10).get_asInt();
+      p->m_strStereoMode = record->at(11).get_asString();
+      p->m_strLanguage = record->at(12).get_asString();
+      details.AddStream(p);
+      return true;
+    }
+  case CStreamDetail::AUDIO:
+    {
+      CStreamDetailAudio *p = new CStreamDetailAudio();
+      p->m_strCodec = record->at(6).get_asString();
+      if (record->at(7).get_isNull())
+        p->m_iChannels = -1;
+      else
+        p->m_iChannels = record->at(7).get_asInt();
+      p->m_strLanguage = record->at(8).get_asString();
+      details.AddStream(p);
+      return true;
+    }
+  case CStreamDetail::SUBTITLE:
+    {
+      CStreamDetailSubtitle *p = new CStreamDetailSubtitle();
+      p->m_strLanguage = record->at(9).get_asString();
+      details.AddStream(p);
+      return true;
+    }
+  }
+  return false;
+}
+
 bool CVideoDatabase::GetStreamDetails(CVideoInfoTag& tag) const
 {
   if (tag.m_iFileId < 0)
@@ -3639,46 +3694,8 @@ bool CVideoDatabase::GetStreamDetails(CVideoInfoTag& tag) const
 
     while (!pDS->eof())
     {
-      CStreamDetail::StreamType e = (CStreamDetail::StreamType)pDS->fv(1).get_asInt();
-      switch (e)
-      {
-      case CStreamDetail::VIDEO:
-        {
-          CStreamDetailVideo *p = new CStreamDetailVideo();
-          p->m_strCodec = pDS->fv(2).get_asString();
-          p->m_fAspect = pDS->fv(3).get_asFloat();
-          p->m_iWidth = pDS->fv(4).get_asInt();
-          p->m_iHeight = pDS->fv(5).get_asInt();
-          p->m_iDuration = pDS->fv(10).get_asInt();
-          p->m_strStereoMode = pDS->fv(11).get_asString();
-          p->m_strLanguage = pDS->fv(12).get_asString();
-          details.AddStream(p);
-          retVal = true;
-          break;
-        }
-      case CStreamDetail::AUDIO:
-        {
-          CStreamDetailAudio *p = new CStreamDetailAudio();
-          p->m_strCodec = pDS->fv(6).get_asString();
-          if (pDS->fv(7).get_isNull())
-            p->m_iChannels = -1;
-          else
-            p->m_iChannels = pDS->fv(7).get_asInt();
-          p->m_strLanguage = pDS->fv(8).get_asString();
-          details.AddStream(p);
-          retVal = true;
-          break;
-        }
-      case CStreamDetail::SUBTITLE:
-        {
-          CStreamDetailSubtitle *p = new CStreamDetailSubtitle();
-          p->m_strLanguage = pDS->fv(9).get_asString();
-          details.AddStream(p);
-          retVal = true;
-          break;
-        }
-      }
-
+      if (AddStreamDetail(pDS->get_sql_record(), details))
+        retVal = true;
       pDS->next();
     }
 
@@ -4146,6 +4163,276 @@ void CVideoDatabase::GetUniqueIDs(int media_id, const std::string &media_type, C
   }
 }
 
+#define VIDEODB_DETAILS_BATCH_SIZE 500
+
+static std::string JoinIds(const std::vector<int> &ids)
+{
+  std::string list;
+  for (const auto &id : ids)
+    list += StringUtils::Format(list.empty() ? "%i" : ",%i", id);
+  return list;
+}
+
+static void AppendCast(const std::vector<SActorInfo> &from, std::vector<SActorInfo> &cast)
+{
+  for (const auto &actor : from)
+  {
+    bool found = false;
+    for (const auto &i : cast)
+    {
+      if (i.strName == actor.strName)
+      {
+        found = true;
+        break;
+      }
+    }
+    if (!found)
+      cast.push_back(actor);
+  }
+}
+
+int CVideoDatabase::GetBatchedDetails(const MediaType &mediaType)
+{
+  if (mediaType == MediaTypeMovie)
+    return VideoDbDetailsCast | VideoDbDetailsTag | VideoDbDetailsRating | VideoDbDetailsUniqueID | VideoDbDetailsStream | VideoDbDetailsArt;
+  if (mediaType == MediaTypeTvShow)
+    return VideoDbDetailsCast | VideoDbDetailsTag | VideoDbDetailsRating | VideoDbDetailsUniqueID | VideoDbDetailsArt;
+  if (mediaType == MediaTypeEpisode)
+    return VideoDbDetailsCast | VideoDbDetailsRating | VideoDbDetailsUniqueID | VideoDbDetailsStream | VideoDbDetailsArt;
+  if (mediaType == MediaTypeMusicVideo)
+    return VideoDbDetailsTag | VideoDbDetailsStream | VideoDbDetailsArt;
+  return VideoDbDetailsNone;
+}
+
+void CVideoDatabase::GetDetailsForItems(CFileItemList &items, int start, const MediaType &mediaType, int getDetails)
+{
+  int batched = getDetails & GetBatchedDetails(mediaType);
+  if (batched == VideoDbDetailsNone || start >= items.Size())
+    return;
+
+  // the details that were not loaded with the item itself, see GetDetailsForMovie() and friends
+  bool parsed = (getDetails & ~batched) != VideoDbDetailsNone;
+
+  std::string sql;
+  try
+  {
+    if (!m_pDB.get()) return;
+    if (!m_pDS2.get()) return;
+
+    for (int first = start; first < items.Size(); first += VIDEODB_DETAILS_BATCH_SIZE)
+    {
+      int last = std::min(items.Size(), first + VIDEODB_DETAILS_BATCH_SIZE);
+
+      std::map<int, CFileItemPtr> byId;
+      std::map<int, std::vector<CVideoInfoTag*> > byFile; // episodes of a multi-episode file share it
+      std::set<int> showIds, seasonIds;
+      std::vector<int> ids, fileIds;
+      for (int i = first; i < last; i++)
+      {
+        CFileItemPtr item = items[i];
+        CVideoInfoTag *tag = item->GetVideoInfoTag();
+        // ids of different media types overlap, in a mixed list only load the ones of mediaType
+        if (tag->m_iDbId < 0 || tag->m_type != mediaType)
+          continue;
+
+        byId[tag->m_iDbId] = item;
+        ids.push_back(tag->m_iDbId);
+        if (tag->m_iFileId >= 0)
+        {
+          std::vector<CVideoInfoTag*> &tags = byFile[tag->m_iFileId];
+          if (tags.empty())
+            fileIds.push_back(tag->m_iFileId);
+          tags.push_back(tag);
+        }
+        if (tag->m_iIdShow >= 0)
+          showIds.insert(tag->m_iIdShow);
+        if (tag->m_iSeason > -1 && tag->m_iIdSeason >= 0)
+          seasonIds.insert(tag->m_iIdSeason);
+
+        if (!parsed)
+          tag->m_strPictureURL.Parse();
+        tag->m_parsedDetails = getDetails;
+      }
+      if (ids.empty())
+        continue;
+      std::string idList = JoinIds(ids);
+
+      if (batched & VideoDbDetailsCast)
+      {
+        // episodes get the cast of the episode followed by the cast of the show
+        std::vector<std::pair<MediaType, std::string> > sources;
+        sources.push_back(std::make_pair(mediaType, idList));
+        if (mediaType == MediaTypeEpisode && !showIds.empty())
+          sources.push_back(std::make_pair(MediaTypeTvShow, JoinIds(std::vector<int>(showIds.begin(), showIds.end()))));
+
+        std::map<int, std::vector<SActorInfo> > cast, showCast;
+        for (const auto &source : sources)
+        {
+          std::map<int, std::vector<SActorInfo> > &target = source.first == mediaType ? cast : showCast;
+          sql = PrepareSQL("SELECT actor_link.media_id,"
+                           "  actor.name,"
+                           "  actor_link.role,"
+                           "  actor_link.cast_order,"
+                           "  actor.art_urls,"
+                           "  art.url "
+                           "FROM actor_link"
+                           "  JOIN actor ON"
+                           "    actor_link.actor_id=actor.actor_id"
+                           "  LEFT JOIN art ON"
+                           "    art.media_id=actor.actor_id AND art.media_type='actor' AND art.type='thumb' "
+                           "WHERE actor_link.media_type='%s' AND actor_link.media_id IN (", source.first.c_str())
+                + source.second + ") ORDER BY actor_link.cast_order";
+          m_pDS2->query(sql);
+          while (!m_pDS2->eof())
+          {
+            SActorInfo info;
+            info.strName = m_pDS2->fv(1).get_asString();
+            info.strRole = m_pDS2->fv(2).get_asString();
+            info.order = m_pDS2->fv(3).get_asInt();
+            info.thumbUrl.ParseString(m_pDS2->fv(4).get_asString());
+            info.thumb = m_pDS2->fv(5).get_asString();
+            target[m_pDS2->fv(0).get_asInt()].emplace_back(std::move(info));
+            m_pDS2->next();
+          }
+          m_pDS2->close();
+        }
+
+        for (const auto &item : byId)
+        {
+          CVideoInfoTag *tag = item.second->GetVideoInfoTag();
+          AppendCast(cast[item.first], tag->m_cast);
+          if (mediaType == MediaTypeEpisode)
+            AppendCast(showCast[tag->m_iIdShow], tag->m_cast);
+        }
+      }
+
+      if (batched & VideoDbDetailsTag)
+      {
+        sql = PrepareSQL("SELECT tag_link.media_id, tag.name FROM tag INNER JOIN tag_link ON tag_link.tag_id = tag.tag_id "
+                         "WHERE tag_link.media_type = '%s' AND tag_link.media_id IN (", mediaType.c_str()) + idList + ") ORDER BY tag.tag_id";
+        m_pDS2->query(sql);
+        while (!m_pDS2->eof())
+        {
+          byId[m_pDS2->fv(0).get_asInt()]->GetVideoInfoTag()->m_tags.emplace_back(m_pDS2->fv(1).get_asString());
+          m_pDS2->next();
+        }
+        m_pDS2->close();
+      }
+
+      if (batched & VideoDbDetailsRating)
+      {
+        sql = PrepareSQL("SELECT rating.media_id, rating.rating_type, rating.rating, rating.votes FROM rating "
+                         "WHERE rating.media_type = '%s' AND rating.media_id IN (", mediaType.c_str()) + idList + ")";
+        m_pDS2->query(sql);
+        while (!m_pDS2->eof())
+        {
+          byId[m_pDS2->fv(0).get_asInt()]->GetVideoInfoTag()->m_ratings[m_pDS2->fv(1).get_asString()] = CRating(m_pDS2->fv(2).get_asFloat(), m_pDS2->fv(3).get_asInt());
+          m_pDS2->next();
+        }
+        m_pDS2->close();
+      }
+
+      if (batched & VideoDbDetailsUniqueID)
+      {
+        sql = PrepareSQL("SELECT media_id, type, value FROM uniqueid WHERE media_type = '%s' AND media_id IN (", mediaType.c_str()) + idList + ")";
+        m_pDS2->query(sql);
+        while (!m_pDS2->eof())
+        {
+          byId[m_pDS2->fv(0).get_asInt()]->GetVideoInfoTag()->SetUniqueID(m_pDS2->fv(2).get_asString(), m_pDS2->fv(1).get_asString());
+          m_pDS2->next();
+        }
+        m_pDS2->close();
+      }
+
+      if ((batched & VideoDbDetailsStream) && !fileIds.empty())
+      {
+        for (const auto &file : byFile)
+        {
+          for (CVideoInfoTag *tag : file.second)
+            tag->m_streamDetails.Reset();
+        }
+
+        sql = "SELECT * FROM streamdetails WHERE idFile IN (" + JoinIds(fileIds) + ")";
+        m_pDS2->query(sql);
+        while (!m_pDS2->eof())
+        {
+          auto file = byFile.find(m_pDS2->fv(0).get_asInt());
+          if (file != byFile.end())
+          {
+            for (CVideoInfoTag *tag : file->second)
+              AddStreamDetail(m_pDS2->get_sql_record(), tag->m_streamDetails);
+          }
+          m_pDS2->next();
+        }
+        m_pDS2->close();
+
+        for (const auto &file : byFile)
+        {
+          for (CVideoInfoTag *tag : file.second)
+          {
+            CStreamDetails &details = tag->m_streamDetails;
+            details.DetermineBestStreams();
+            if (details.GetVideoDuration() > 0)
+              tag->m_duration = details.GetVideoDuration();
+          }
+        }
+      }
+
+      if (batched & VideoDbDetailsArt)
+      {
+        // same as CVideoThumbLoader::FillLibraryArt(), episodes also get the art of their show and season
+        std::vector<std::pair<MediaType, std::string> > sources;
+        sources.push_back(std::make_pair(mediaType, idList));
+        if (mediaType == MediaTypeEpisode)
+        {
+          if (!showIds.empty())
+            sources.push_back(std::make_pair(MediaTypeTvShow, JoinIds(std::vector<int>(showIds.begin(), showIds.end()))));
+          if (!seasonIds.empty())
+            sources.push_back(std::make_pair(MediaTypeSeason, JoinIds(std::vector<int>(seasonIds.begin(), seasonIds.end()))));
+        }
+
+        std::map<std::string, std::map<int, std::map<std::string, std::string> > > art;
+        for (const auto &source : sources)
+        {
+          sql = PrepareSQL("SELECT media_id, type, url FROM art WHERE media_type = '%s' AND media_id IN (", source.first.c_str()) + source.second + ")";
+          m_pDS2->query(sql);
+          while (!m_pDS2->eof())
+          {
+            art[source.first][m_pDS2->fv(0).get_asInt()].insert(std::make_pair(m_pDS2->fv(1).get_asString(), m_pDS2->fv(2).get_asString()));
+            m_pDS2->next();
+          }
+          m_pDS2->close();
+        }
+
+        for (const auto &i : byId)
+        {
+          CFileItem &item = *i.second;
+          const CVideoInfoTag &tag = *item.GetVideoInfoTag();
+          const std::map<std::string, std::string> &artwork = art[mediaType][i.first];
+          if (!artwork.empty())
+            CVideoThumbLoader::SetArt(item, artwork);
+
+          if (mediaType == MediaTypeEpisode)
+          {
+            if (!item.HasArt("fanart") && tag.m_iIdShow >= 0)
+            {
+              item.AppendArt(art[MediaTypeTvShow][tag.m_iIdShow], MediaTypeTvShow);
+              item.SetArtFallback("fanart", "tvshow.fanart");
+              item.SetArtFallback("tvshow.thumb", "tvshow.poster");
+            }
+            if (!item.HasArt("season.poster") && tag.m_iSeason > -1)
+              item.AppendArt(art[MediaTypeSeason][tag.m_iIdSeason], MediaTypeSeason);
+          }
+        }
+      }
+    }
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, sql.c_str());
+  }
+}
+
 bool CVideoDatabase::GetVideoSettings(const CFileItem &item, CVideoSettings &settings)
 {
   return GetVideoSettings(GetFileId(item), settings);
@@ -5154,11 +5441,30 @@ void CVideoDatabase::UpdateTables(int iVersion)
       pDS->close();
     }
   }
+
+  if (iVersion < 108)
+  {
+    // the first search indexes the library in the background
+    CreateSearchIndexTables();
+    QueueSearchIndexRebuild();
+  }
 }
 
 int CVideoDatabase::GetSchemaVersion() const
 {
-  return 107;
+  return 108;
+}
+
+std::vector<CSearchIndex::Source> CVideoDatabase::GetSearchSources() const
+{
+  std::vector<CSearchIndex::Source> sources;
+  sources.push_back({ MediaTypeMovie, "movie", "idMovie", { { StringUtils::Format("c%02d", VIDEODB_ID_TITLE), 3 },
+                                                            { StringUtils::Format("c%02d", VIDEODB_ID_ORIGINALTITLE), 2 } } });
+  sources.push_back({ MediaTypeTvShow, "tvshow", "idShow", { { StringUtils::Format("c%02d", VIDEODB_ID_TV_TITLE), 3 },
+                                                             { StringUtils::Format("c%02d", VIDEODB_ID_TV_ORIGINALTITLE), 2 } } });
+  sources.push_back({ MediaTypeEpisode, "episode", "idEpisode", { { StringUtils::Format("c%02d", VIDEODB_ID_EPISODE_TITLE), 3 } } });
+  sources.push_back({ MediaTypeMusicVideo, "musicvideo", "idMVideo", { { StringUtils::Format("c%02d", VIDEODB_ID_MUSICVIDEO_TITLE), 3 } } });
+  return sources;
 }
 
 bool CVideoDatabase::LookupByFolders(const std::string &path, bool shows)
@@ -6661,13 +6967,14 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
 
     // get data from returned rows
     items.Reserve(results.size());
+    int start = items.Size();
     const query_data &data = m_pDS->get_result_set().records;
     for (const auto &i : results)
     {
       unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
 
-      CVideoInfoTag movie = GetDetailsForMovie(record, getDetails);
+      CVideoInfoTag movie = GetDetailsForMovie(record, getDetails & ~GetBatchedDetails(MediaTypeMovie));
       if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
           g_passwordManager.bMasterUser                                   ||
           g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::GetInstance().GetSources("video")))
@@ -6686,6 +6993,8 @@ bool CVideoDatabase::GetMoviesByWhere(const std::string& strBaseDir, const Filte
 
     // cleanup
     m_pDS->close();
+
+    GetDetailsForItems(items, start, MediaTypeMovie, getDetails);
     return true;
   }
   catch (...)
@@ -6768,6 +7077,7 @@ bool CVideoDatabase::GetTvShowsByWhere(const std::string& strBaseDir, const Filt
 
     // get data from returned rows
     items.Reserve(results.size());
+    int start = items.Size();
     const query_data &data = m_pDS->get_result_set().records;
     for (const auto &i : results)
     {
@@ -6775,7 +7085,7 @@ bool CVideoDatabase::GetTvShowsByWhere(const std::string& strBaseDir, const Filt
       const dbiplus::sql_record* const record = data.at(targetRow);
       
       CFileItemPtr pItem(new CFileItem());
-      CVideoInfoTag movie = GetDetailsForTvShow(record, getDetails, pItem.get());
+      CVideoInfoTag movie = GetDetailsForTvShow(record, getDetails & ~GetBatchedDetails(MediaTypeTvShow), pItem.get());
       if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
            g_passwordManager.bMasterUser                                     ||
            g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::GetInstance().GetSources("video")))
@@ -6794,6 +7104,8 @@ bool CVideoDatabase::GetTvShowsByWhere(const std::string& strBaseDir, const Filt
 
     // cleanup
     m_pDS->close();
+
+    GetDetailsForItems(items, start, MediaTypeTvShow, getDetails);
     return true;
   }
   catch (...)
@@ -6894,6 +7206,7 @@ bool CVideoDatabase::GetEpisodesByWhere(const std::string& strBaseDir, const Fil
     
     // get data from returned rows
     items.Reserve(results.size());
+    int start = items.Size();
     CLabelFormatter formatter("%H. %T", "");
 
     const query_data &data = m_pDS->get_result_set().records;
@@ -6902,7 +7215,7 @@ bool CVideoDatabase::GetEpisodesByWhere(const std::string& strBaseDir, const Fil
       unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
 
-      CVideoInfoTag movie = GetDetailsForEpisode(record, getDetails);
+      CVideoInfoTag movie = GetDetailsForEpisode(record, getDetails & ~GetBatchedDetails(MediaTypeEpisode));
       if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE ||
           g_passwordManager.bMasterUser                                     ||
           g_passwordManager.IsDatabasePathUnlocked(movie.m_strPath, *CMediaSourceSettings::GetInstance().GetSources("video")))
@@ -6929,6 +7242,8 @@ bool CVideoDatabase::GetEpisodesByWhere(const std::string& strBaseDir, const Fil
 
     // cleanup
     m_pDS->close();
+
+    GetDetailsForItems(items, start, MediaTypeEpisode, getDetails);
     return true;
   }
   catch (...)
@@ -7735,6 +8050,7 @@ bool CVideoDatabase::GetMusicVideosByWhere(const std::string &baseDir, const Fil
     
     // get data from returned rows
     items.Reserve(results.size());
+    int start = items.Size();
     // get songs from returned subtable
     const query_data &data = m_pDS->get_result_set().records;
     for (const auto &i : results)
@@ -7742,7 +8058,7 @@ bool CVideoDatabase::GetMusicVideosByWhere(const std::string &baseDir, const Fil
       unsigned int targetRow = (unsigned int)i.at(FieldRow).asInteger();
       const dbiplus::sql_record* const record = data.at(targetRow);
       
-      CVideoInfoTag musicvideo = GetDetailsForMusicVideo(record, getDetails);
+      CVideoInfoTag musicvideo = GetDetailsForMusicVideo(record, getDetails & ~GetBatchedDetails(MediaTypeMusicVideo));
       if (!checkLocks || CProfilesManager::GetInstance().GetMasterProfile().getLockMode() == LOCK_MODE_EVERYONE || g_passwordManager.bMasterUser ||
           g_passwordManager.IsDatabasePathUnlocked(musicvideo.m_strPath, *CMediaSourceSettings::GetInstance().GetSources("video")))
       {
@@ -7760,6 +8076,8 @@ bool CVideoDatabase::GetMusicVideosByWhere(const std::string &baseDir, const Fil
 
     // cleanup
     m_pDS->close();
+
+    GetDetailsForItems(items, start, MediaTypeMusicVideo, getDetails);
     return true;
   }
   catch (...)
@@ -7803,6 +8121,35 @@ unsigned int CVideoDatabase::GetMusicVideoIDs(const std::string& strWhere, std::
   return 0;
 }
 
+unsigned int CVideoDatabase::GetMusicVideoIDs(const std::string& strWhere, CWeightedRandomPool &pool)
+{
+  try
+  {
+    if (NULL == m_pDB.get()) return 0;
+    if (NULL == m_pDS.get()) return 0;
+
+    std::string strSQL = "select distinct idMVideo, userrating, playCount from musicvideo_view";
+    if (!strWhere.empty())
+      strSQL += " where " + strWhere;
+
+    if (!m_pDS->query(strSQL)) return 0;
+    unsigned int count = 0;
+    while (!m_pDS->eof())
+    {
+      pool.Set(m_pDS->fv(0).get_asInt(), CWeightedRandomPool::GetWeight(m_pDS->fv(1).get_asFloat(), m_pDS->fv(2).get_asInt()));
+      count++;
+      m_pDS->next();
+    }
+    m_pDS->close();
+    return count;
+  }
+  catch (...)
+  {
+    CLog::Log(LOGERROR, "%s (%s) failed", __FUNCTION__, strWhere.c_str());
+  }
+  return 0;
+}
+
 bool CVideoDatabase::GetRandomMusicVideo(CFileItem* item, int& idSong, const std::string& strWhere)
 {
   try
@@ -7895,10 +8242,16 @@ void CVideoDatabase::GetMoviesByName(const std::string& strSearch, CFileItemList
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::vector<int> ids;
+    if (!GetSearchResults(MediaTypeMovie, strSearch, ids) || ids.empty())
+      return;
+
+
     if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("SELECT movie.idMovie, movie.c%02d, path.strPath, movie.idSet FROM movie INNER JOIN files ON files.idFile=movie.idFile INNER JOIN path ON path.idPath=files.idPath WHERE movie.c%02d LIKE '%%%s%%'", VIDEODB_ID_TITLE, VIDEODB_ID_TITLE, strSearch.c_str());
+      strSQL = PrepareSQL("SELECT movie.idMovie, movie.c%02d, path.strPath, movie.idSet FROM movie INNER JOIN files ON files.idFile=movie.idFile INNER JOIN path ON path.idPath=files.idPath WHERE ", VIDEODB_ID_TITLE);
     else
-      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d, movie.idSet from movie where movie.c%02d like '%%%s%%'",VIDEODB_ID_TITLE,VIDEODB_ID_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select movie.idMovie,movie.c%02d, movie.idSet from movie where ",VIDEODB_ID_TITLE);
+    strSQL += PrepareSearchCondition("movie.idMovie", ids) + " ORDER BY " + PrepareSearchOrder("movie.idMovie", ids);
     m_pDS->query( strSQL );
 
     while (!m_pDS->eof())
@@ -7940,10 +8293,16 @@ void CVideoDatabase::GetTvShowsByName(const std::string& strSearch, CFileItemLis
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::vector<int> ids;
+    if (!GetSearchResults(MediaTypeTvShow, strSearch, ids) || ids.empty())
+      return;
+
+
     if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("SELECT tvshow.idShow, tvshow.c%02d, path.strPath FROM tvshow INNER JOIN tvshowlinkpath ON tvshowlinkpath.idShow=tvshow.idShow INNER JOIN path ON path.idPath=tvshowlinkpath.idPath WHERE tvshow.c%02d LIKE '%%%s%%'", VIDEODB_ID_TV_TITLE, VIDEODB_ID_TV_TITLE, strSearch.c_str());
+      strSQL = PrepareSQL("SELECT tvshow.idShow, tvshow.c%02d, path.strPath FROM tvshow INNER JOIN tvshowlinkpath ON tvshowlinkpath.idShow=tvshow.idShow INNER JOIN path ON path.idPath=tvshowlinkpath.idPath WHERE ", VIDEODB_ID_TV_TITLE);
     else
-      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where tvshow.c%02d like '%%%s%%'",VIDEODB_ID_TV_TITLE,VIDEODB_ID_TV_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select tvshow.idShow,tvshow.c%02d from tvshow where ",VIDEODB_ID_TV_TITLE);
+    strSQL += PrepareSearchCondition("tvshow.idShow", ids) + " ORDER BY " + PrepareSearchOrder("tvshow.idShow", ids);
     m_pDS->query( strSQL );
 
     while (!m_pDS->eof())
@@ -7981,10 +8340,16 @@ void CVideoDatabase::GetEpisodesByName(const std::string& strSearch, CFileItemLi
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::vector<int> ids;
+    if (!GetSearchResults(MediaTypeEpisode, strSearch, ids) || ids.empty())
+      return;
+
+
     if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d, path.strPath FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow INNER JOIN files ON files.idFile=episode.idFile INNER JOIN path ON path.idPath=files.idPath WHERE episode.c%02d LIKE '%%%s%%'", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, VIDEODB_ID_EPISODE_TITLE, strSearch.c_str());
+      strSQL = PrepareSQL("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d, path.strPath FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow INNER JOIN files ON files.idFile=episode.idFile INNER JOIN path ON path.idPath=files.idPath WHERE ", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE);
     else
-      strSQL = PrepareSQL("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow WHERE episode.c%02d like '%%%s%%'", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE, VIDEODB_ID_EPISODE_TITLE, strSearch.c_str());
+      strSQL = PrepareSQL("SELECT episode.idEpisode, episode.c%02d, episode.c%02d, episode.idShow, tvshow.c%02d FROM episode INNER JOIN tvshow ON tvshow.idShow=episode.idShow WHERE ", VIDEODB_ID_EPISODE_TITLE, VIDEODB_ID_EPISODE_SEASON, VIDEODB_ID_TV_TITLE);
+    strSQL += PrepareSearchCondition("episode.idEpisode", ids) + " ORDER BY " + PrepareSearchOrder("episode.idEpisode", ids);
     m_pDS->query( strSQL );
 
     while (!m_pDS->eof())
@@ -8024,10 +8389,16 @@ void CVideoDatabase::GetMusicVideosByName(const std::string& strSearch, CFileIte
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
+    std::vector<int> ids;
+    if (!GetSearchResults(MediaTypeMusicVideo, strSearch, ids) || ids.empty())
+      return;
+
+
     if (CProfilesManager::GetInstance().GetMasterProfile().getLockMode() != LOCK_MODE_EVERYONE && !g_passwordManager.bMasterUser)
-      strSQL = PrepareSQL("SELECT musicvideo.idMVideo, musicvideo.c%02d, path.strPath FROM musicvideo INNER JOIN files ON files.idFile=musicvideo.idFile INNER JOIN path ON path.idPath=files.idPath WHERE musicvideo.c%02d LIKE '%%%s%%'", VIDEODB_ID_MUSICVIDEO_TITLE, VIDEODB_ID_MUSICVIDEO_TITLE, strSearch.c_str());
+      strSQL = PrepareSQL("SELECT musicvideo.idMVideo, musicvideo.c%02d, path.strPath FROM musicvideo INNER JOIN files ON files.idFile=musicvideo.idFile INNER JOIN path ON path.idPath=files.idPath WHERE ", VIDEODB_ID_MUSICVIDEO_TITLE);
     else
-      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where musicvideo.c%02d like '%%%s%%'",VIDEODB_ID_MUSICVIDEO_TITLE,VIDEODB_ID_MUSICVIDEO_TITLE,strSearch.c_str());
+      strSQL = PrepareSQL("select musicvideo.idMVideo,musicvideo.c%02d from musicvideo where ",VIDEODB_ID_MUSICVIDEO_TITLE);
+    strSQL += PrepareSearchCondition("musicvideo.idMVideo", ids) + " ORDER BY " + PrepareSearchOrder("musicvideo.idMVideo", ids);
     m_pDS->query( strSQL );
 
     while (!m_pDS->eof())
@@ -8278,8 +8649,6 @@ void CVideoDatabase::CleanDatabase(CGUIDialogProgressBarHandle* handle, const st
     CLog::Log(LOGNOTICE, "%s: Starting videodatabase cleanup ..", __FUNCTION__);
     ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnCleanStarted");
 
-    BeginTransaction();
-
     // find all the files
     std::string sql = "SELECT files.idFile, files.strFileName, path.strPath FROM files INNER JOIN path ON path.idPath=files.idPath";
     if (!paths.empty())
@@ -8317,9 +8686,12 @@ void CVideoDatabase::CleanDatabase(CGUIDialogProgressBarHandle* handle, const st
     VECSOURCES videoSources(*CMediaSourceSettings::GetInstance().GetSources("video"));
     g_mediaManager.GetRemovableDrives(videoSources);
 
-    int total = m_pDS->num_rows();
-    int current = 0;
+    std::vector<std::string> sourcePaths;
+    for (const auto &source : videoSources)
+      sourcePaths.insert(sourcePaths.end(), source.vecPaths.begin(), source.vecPaths.end());
 
+    std::vector<std::string> filesToCheck;
+    std::vector<std::string> fileIds;
     while (!m_pDS->eof())
     {
       std::string path = m_pDS->fv("path.strPath").get_asString();
@@ -8335,35 +8707,56 @@ void CVideoDatabase::CleanDatabase(CGUIDialogProgressBarHandle* handle, const st
       if (URIUtils::IsInArchive(fullPath))
         fullPath = CURL(fullPath).GetHostName();
 
-      // remove optical, non-existing files, files with no matching source
+      // remove optical files and files with no matching source, the others are checked below
       bool bIsSource;
-      if (URIUtils::IsOnDVD(fullPath) || !CFile::Exists(fullPath, false) ||
+      if (URIUtils::IsOnDVD(fullPath) ||
           CUtil::GetMatchingSource(fullPath, videoSources, bIsSource) < 0)
         filesToTestForDelete += m_pDS->fv("files.idFile").get_asString() + ",";
+      else
+      {
+        filesToCheck.push_back(fullPath);
+        fileIds.push_back(m_pDS->fv("files.idFile").get_asString());
+      }
+
+      m_pDS->next();
+    }
+    m_pDS->close();
 
+    // remove non-existing files. Files on sources that can't be reached are
+    // tested as well, CleanMediaType decides what happens to them.
+    CFileExistsChecker checker(g_advancedSettings.m_videoLibraryCleanThreads);
+    std::vector<CFileExistsChecker::State> states;
+    bool checked = checker.Check(filesToCheck, sourcePaths, states, [handle, progress](int percentage)
+    {
       if (handle == NULL && progress != NULL)
       {
-        int percentage = current * 100 / total;
         if (percentage > progress->GetPercentage())
         {
           progress->SetPercentage(percentage);
           progress->Progress();
         }
-        if (progress->IsCanceled())
-        {
-          progress->Close();
-          m_pDS->close();
-          ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnCleanFinished");
-          return;
-        }
+        return !progress->IsCanceled();
       }
       else if (handle != NULL)
-        handle->SetPercentage(current * 100 / (float)total);
+        handle->SetPercentage(static_cast<float>(percentage));
+      return true;
+    });
+    if (!checked)
+    {
+      progress->Close();
+      ANNOUNCEMENT::CAnnouncementManager::GetInstance().Announce(ANNOUNCEMENT::VideoLibrary, "xbmc", "OnCleanFinished");
+      return;
+    }
 
-      m_pDS->next();
-      current++;
+    for (size_t i = 0; i < states.size(); i++)
+    {
+      if (states[i] != CFileExistsChecker::Exists)
+        filesToTestForDelete += fileIds[i] + ",";
     }
-    m_pDS->close();
+
+    // the files are checked before the transaction is started, so the database
+    // isn't locked while waiting for the file systems
+    BeginTransaction();
 
     std::string filesToDelete;
 
@@ -8738,10 +9131,34 @@ void CVideoDatabase::DumpToDummyFiles(const std::string &path)
   }
 }
 
-void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = true */, bool images /* = false */, bool actorThumbs /* false */, bool overwrite /*=false*/)
+// exports read the library in pages, imports commit in batches, so neither holds the whole library
+#define VIDEODB_EXPORT_PAGE_SIZE 1000
+#define VIDEODB_IMPORT_BATCH_SIZE 500
+
+/*! \brief Advance the progress of an export or import.
+ \param callback the progress to advance, may be NULL
+ \param dialog the dialog showing the progress, may be NULL
+ \param steps the number of steps to advance by
+ \return false if it was cancelled
+ */
+static bool AdvanceProgress(IProgressCallback *callback, CGUIDialogProgress *dialog, int steps)
+{
+  if (!callback)
+    return true;
+  if (steps > 0)
+    callback->SetProgressAdvance(steps);
+  if (dialog)
+    dialog->Progress();
+  return !callback->Abort();
+}
+
+void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = true */, bool images /* = false */, bool actorThumbs /* false */, bool overwrite /*=false*/, IProgressCallback *progressCallback /* = NULL */)
 {
   int iFailCount = 0;
   CGUIDialogProgress *progress=NULL;
+  IProgressCallback *callback = progressCallback;
+  // images are copied in the background while the next items are exported
+  CTextureExportQueue exports;
   try
   {
     if (NULL == m_pDB.get()) return;
@@ -8777,12 +9194,16 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
       CDirectory::Create(tvshowsDir);
     }
 
-    progress = (CGUIDialogProgress *)g_windowManager.GetWindow(WINDOW_DIALOG_PROGRESS);
-    // find all movies
-    std::string sql = "select * from movie_view";
-
-    m_pDS->query(sql);
+    // the single file is written item by item instead of being built in memory
+    CXMLStreamWriter writer;
+    if (singleFile && !writer.Open(xmlFile, "videodb"))
+      return;
 
+    if (!callback)
+    {
+      progress = (CGUIDialogProgress *)g_windowManager.GetWindow(WINDOW_DIALOG_PROGRESS);
+      callback = progress;
+    }
     if (progress)
     {
       progress->SetHeading(CVariant{647});
@@ -8794,23 +9215,54 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
       progress->ShowProgressBar(true);
     }
 
-    int total = m_pDS->num_rows();
-    int current = 0;
+    int total = atoi(GetSingleValue("select count(1) from movie").c_str()) +
+                atoi(GetSingleValue("select count(1) from musicvideo").c_str()) +
+                atoi(GetSingleValue("select count(1) from tvshow").c_str());
+    if (callback)
+      callback->SetProgressMax(std::max(total, 1));
 
     // create our xml document
     CXBMCTinyXML xmlDoc;
     TiXmlDeclaration decl("1.0", "UTF-8", "yes");
     xmlDoc.InsertEndChild(decl);
+    TiXmlElement xmlMainElement("videodb");
     TiXmlNode *pMain = NULL;
     if (!singleFile)
       pMain = &xmlDoc;
     else
     {
-      TiXmlElement xmlMainElement("videodb");
-      pMain = xmlDoc.InsertEndChild(xmlMainElement);
+      pMain = &xmlMainElement;
       XMLUtils::SetInt(pMain,"version", GetExportVersion());
+
+      // dump path info first, so an import has the scraper settings before the items
+      std::set<std::string> paths;
+      GetPaths(paths);
+      TiXmlElement xmlPathElement("paths");
+      TiXmlNode *pPaths = pMain->InsertEndChild(xmlPathElement);
+      for (const auto &i : paths)
+      {
+        bool foundDirectly = false;
+        SScanSettings settings;
+        ScraperPtr info = GetScraperForPath(i, settings, foundDirectly);
+        if (info && foundDirectly)
+        {
+          TiXmlElement xmlPathElement2("path");
+          TiXmlNode *pPath = pPaths->InsertEndChild(xmlPathElement2);
+          XMLUtils::SetString(pPath,"url", i);
+          XMLUtils::SetInt(pPath,"scanrecursive", settings.recurse);
+          XMLUtils::SetBoolean(pPath,"usefoldernames", settings.parent_name);
+          XMLUtils::SetString(pPath,"content", TranslateContent(info->Content()));
+          XMLUtils::SetString(pPath,"scraperpath", info->ID());
+        }
+      }
+      writer.WriteChildren(*pMain);
     }
 
+    // find all movies, a page at a time
+    std::string sql = "select * from movie_view where idMovie > %i order by idMovie limit %i";
+
+    m_pDS->query(PrepareSQL(sql, 0, VIDEODB_EXPORT_PAGE_SIZE));
+
     while (!m_pDS->eof())
     {
       CVideoInfoTag movie = GetDetailsForMovie(m_pDS, VideoDbDetailsAll);
@@ -8827,21 +9279,20 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
       }
       else
         movie.Save(pMain, "movie", singleFile);
+      if (singleFile)
+        writer.WriteChildren(*pMain);
 
       // reset old skip state
       bool bSkip = false;
 
       if (progress)
-      {
         progress->SetLine(1, CVariant{movie.m_strTitle});
-        progress->SetPercentage(current * 100 / total);
-        progress->Progress();
-        if (progress->IsCanceled())
-        {
+      if (!AdvanceProgress(callback, progress, 1))
+      {
+        if (progress)
           progress->Close();
-          m_pDS->close();
-          return;
-        }
+        m_pDS->close();
+        return;
       }
 
       CFileItem item(movie.m_strFileNameAndPath,false);
@@ -8893,23 +9344,24 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
         for (const auto &i : artwork)
         {
           std::string savedThumb = item.GetLocalArt(i.first, false);
-          CTextureCache::GetInstance().Export(i.second, savedThumb, overwrite);
+          exports.Export(i.second, savedThumb, overwrite);
         }
         if (actorThumbs)
-          ExportActorThumbs(actorsDir, movie, !singleFile, overwrite);
+          ExportActorThumbs(actorsDir, movie, !singleFile, overwrite, &exports);
       }
       m_pDS->next();
-      current++;
+      if (m_pDS->eof() && m_pDS->num_rows() == VIDEODB_EXPORT_PAGE_SIZE)
+      {
+        m_pDS->close();
+        m_pDS->query(PrepareSQL(sql, movie.m_iDbId, VIDEODB_EXPORT_PAGE_SIZE));
+      }
     }
     m_pDS->close();
 
     // find all musicvideos
-    sql = "select * from musicvideo_view";
+    sql = "select * from musicvideo_view where idMVideo > %i order by idMVideo limit %i";
 
-    m_pDS->query(sql);
-
-    total = m_pDS->num_rows();
-    current = 0;
+    m_pDS->query(PrepareSQL(sql, 0, VIDEODB_EXPORT_PAGE_SIZE));
 
     while (!m_pDS->eof())
     {
@@ -8924,21 +9376,20 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
       }
       else
         movie.Save(pMain, "musicvideo", singleFile);
+      if (singleFile)
+        writer.WriteChildren(*pMain);
 
       // reset old skip state
       bool bSkip = false;
 
       if (progress)
-      {
         progress->SetLine(1, CVariant{movie.m_strTitle});
-        progress->SetPercentage(current * 100 / total);
-        progress->Progress();
-        if (progress->IsCanceled())
-        {
+      if (!AdvanceProgress(callback, progress, 1))
+      {
+        if (progress)
           progress->Close();
-          m_pDS->close();
-          return;
-        }
+        m_pDS->close();
+        return;
       }
 
       CFileItem item(movie.m_strFileNameAndPath,false);
@@ -8982,20 +9433,21 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
         for (const auto &i : artwork)
         {
           std::string savedThumb = item.GetLocalArt(i.first, false);
-          CTextureCache::GetInstance().Export(i.second, savedThumb, overwrite);
+          exports.Export(i.second, savedThumb, overwrite);
         }
       }
       m_pDS->next();
-      current++;
+      if (m_pDS->eof() && m_pDS->num_rows() == VIDEODB_EXPORT_PAGE_SIZE)
+      {
+        m_pDS->close();
+        m_pDS->query(PrepareSQL(sql, movie.m_iDbId, VIDEODB_EXPORT_PAGE_SIZE));
+      }
     }
     m_pDS->close();
 
     // repeat for all tvshows
-    sql = "SELECT * FROM tvshow_view";
-    m_pDS->query(sql);
-
-    total = m_pDS->num_rows();
-    current = 0;
+    sql = "SELECT * FROM tvshow_view WHERE idShow > %i ORDER BY idShow LIMIT %i";
+    m_pDS->query(PrepareSQL(sql, 0, VIDEODB_EXPORT_PAGE_SIZE));
 
     while (!m_pDS->eof())
     {
@@ -9027,16 +9479,13 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
       bool bSkip = false;
 
       if (progress)
-      {
         progress->SetLine(1, CVariant{tvshow.m_strTitle});
-        progress->SetPercentage(current * 100 / total);
-        progress->Progress();
-        if (progress->IsCanceled())
-        {
+      if (!AdvanceProgress(callback, progress, 1))
+      {
+        if (progress)
           progress->Close();
-          m_pDS->close();
-          return;
-        }
+        m_pDS->close();
+        return;
       }
 
       CFileItem item(tvshow.m_strPath, true);
@@ -9076,11 +9525,11 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
         for (const auto &i : artwork)
         {
           std::string savedThumb = item.GetLocalArt(i.first, true);
-          CTextureCache::GetInstance().Export(i.second, savedThumb, overwrite);
+          exports.Export(i.second, savedThumb, overwrite);
         }
 
         if (actorThumbs)
-          ExportActorThumbs(actorsDir, tvshow, !singleFile, overwrite);
+          ExportActorThumbs(actorsDir, tvshow, !singleFile, overwrite, &exports);
 
         // export season thumbs
         for (const auto &i : seasonArt)
@@ -9096,14 +9545,14 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
           {
             std::string savedThumb(item.GetLocalArt(seasonThumb + "-" + j.first, true));
             if (!i.second.empty())
-              CTextureCache::GetInstance().Export(j.second, savedThumb, overwrite);
+              exports.Export(j.second, savedThumb, overwrite);
           }
         }
       }
 
       // now save the episodes from this show
-      sql = PrepareSQL("select * from episode_view where idShow=%i order by strFileName, idEpisode",tvshow.m_iDbId);
-      pDS->query(sql);
+      std::string episodeSql = PrepareSQL("select * from episode_view where idShow=%i order by strFileName, idEpisode",tvshow.m_iDbId);
+      pDS->query(episodeSql);
       std::string showDir(item.GetPath());
 
       while (!pDS->eof())
@@ -9174,15 +9623,22 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
           for (const auto &i : artwork)
           {
             std::string savedThumb = item.GetLocalArt(i.first, false);
-            CTextureCache::GetInstance().Export(i.second, savedThumb, overwrite);
+            exports.Export(i.second, savedThumb, overwrite);
           }
           if (actorThumbs)
-            ExportActorThumbs(actorsDir, episode, !singleFile, overwrite);
+            ExportActorThumbs(actorsDir, episode, !singleFile, overwrite, &exports);
         }
       }
       pDS->close();
+      // the show is complete with its episodes
+      if (singleFile)
+        writer.WriteChildren(*pMain);
       m_pDS->next();
-      current++;
+      if (m_pDS->eof() && m_pDS->num_rows() == VIDEODB_EXPORT_PAGE_SIZE)
+      {
+        m_pDS->close();
+        m_pDS->query(PrepareSQL(sql, tvshow.m_iDbId, VIDEODB_EXPORT_PAGE_SIZE));
+      }
     }
     m_pDS->close();
 
@@ -9192,30 +9648,11 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
       progress->Progress();
     }
 
-    if (singleFile)
+    exports.Wait();
+    if (singleFile && !writer.Close())
     {
-      // now dump path info
-      std::set<std::string> paths;
-      GetPaths(paths);
-      TiXmlElement xmlPathElement("paths");
-      TiXmlNode *pPaths = pMain->InsertEndChild(xmlPathElement);
-      for (const auto &i : paths)
-      {
-        bool foundDirectly = false;
-        SScanSettings settings;
-        ScraperPtr info = GetScraperForPath(i, settings, foundDirectly);
-        if (info && foundDirectly)
-        {
-          TiXmlElement xmlPathElement2("path");
-          TiXmlNode *pPath = pPaths->InsertEndChild(xmlPathElement2);
-          XMLUtils::SetString(pPath,"url", i);
-          XMLUtils::SetInt(pPath,"scanrecursive", settings.recurse);
-          XMLUtils::SetBoolean(pPath,"usefoldernames", settings.parent_name);
-          XMLUtils::SetString(pPath,"content", TranslateContent(info->Content()));
-          XMLUtils::SetString(pPath,"scraperpath", info->ID());
-        }
-      }
-      xmlDoc.SaveFile(xmlFile);
+      CLog::Log(LOGERROR, "%s: Writing '%s' failed", __FUNCTION__, xmlFile.c_str());
+      iFailCount++;
     }
     CVariant data;
     if (singleFile)
@@ -9240,7 +9677,7 @@ void CVideoDatabase::ExportToXML(const std::string &path, bool singleFile /* = t
     CGUIDialogOK::ShowAndGetInput(CVariant{647}, CVariant{StringUtils::Format(g_localizeStrings.Get(15011).c_str(), iFailCount)});
 }
 
-void CVideoDatabase::ExportActorThumbs(const std::string &strDir, const CVideoInfoTag &tag, bool singleFiles, bool overwrite /*=false*/)
+void CVideoDatabase::ExportActorThumbs(const std::string &strDir, const CVideoInfoTag &tag, bool singleFiles, bool overwrite /*=false*/, CTextureExportQueue *exports /* = NULL */)
 {
   std::string strPath(strDir);
   if (singleFiles)
@@ -9260,27 +9697,122 @@ void CVideoDatabase::ExportActorThumbs(const std::string &strDir, const CVideoIn
     if (!i.thumb.empty())
     {
       std::string thumbFile(GetSafeFile(strPath, i.strName));
-      CTextureCache::GetInstance().Export(i.thumb, thumbFile, overwrite);
+      if (exports)
+        exports->Export(i.thumb, thumbFile, overwrite);
+      else
+        CTextureCache::GetInstance().Export(i.thumb, thumbFile, overwrite);
     }
   }
 }
 
-void CVideoDatabase::ImportFromXML(const std::string &path)
+/*! \brief Whether an element below the root of a videodb.xml is an item that is imported.
+ */
+static bool IsImportedElement(const std::string &name)
+{
+  const char *element = name.c_str();
+  return strnicmp(element, MediaTypeMovie, 5) == 0 ||
+         strnicmp(element, MediaTypeMusicVideo, 10) == 0 ||
+         strnicmp(element, MediaTypeTvShow, 6) == 0;
+}
+
+void CVideoDatabase::ImportFromXML(const std::string &path, IProgressCallback *progressCallback /* = NULL */)
 {
   CGUIDialogProgress *progress=NULL;
+  IProgressCallback *callback = progressCallback;
+  CVideoInfoScanner scanner;
+  // everything is written through the database of the scanner, so its batches hold all changes
+  CVideoDatabase &database = scanner.GetDatabase();
   try
   {
     if (NULL == m_pDB.get()) return;
     if (NULL == m_pDS.get()) return;
 
-    CXBMCTinyXML xmlDoc;
-    if (!xmlDoc.LoadFile(URIUtils::AddFileToFolder(path, "videodb.xml")))
+    // the file is read an element at a time instead of as a whole
+    std::string xmlFile(URIUtils::AddFileToFolder(path, "videodb.xml"));
+    if (!CFile::Exists(xmlFile) || !database.Open())
       return;
 
-    TiXmlElement *root = xmlDoc.RootElement();
-    if (!root) return;
+    // add paths first (so we have scraper settings available)
+    auto importPaths = [&database](const std::string &xml)
+    {
+      CXBMCTinyXML xmlDoc;
+      if (!xmlDoc.Parse(xml, TIXML_ENCODING_UTF8))
+        return;
+
+      TiXmlElement *path = xmlDoc.RootElement()->FirstChildElement();
+      while (path)
+      {
+        std::string strPath;
+        if (XMLUtils::GetString(path,"url",strPath) && !strPath.empty())
+          database.AddPath(strPath);
+
+        std::string content;
+        if (XMLUtils::GetString(path,"content", content) && !content.empty())
+        { // check the scraper exists, if so store the path
+          AddonPtr addon;
+          std::string id;
+          XMLUtils::GetString(path,"scraperpath",id);
+          if (CAddonMgr::GetInstance().GetAddon(id, addon))
+          {
+            SScanSettings settings;
+            ScraperPtr scraper = std::dynamic_pointer_cast<CScraper>(addon);
+            // FIXME: scraper settings are not exported?
+            scraper->SetPathSettings(TranslateContent(content), "");
+            XMLUtils::GetInt(path,"scanrecursive",settings.recurse);
+            XMLUtils::GetBoolean(path,"usefoldernames",settings.parent_name);
+            database.SetScraperForPath(strPath,scraper,settings);
+          }
+        }
+        path = path->NextSiblingElement();
+      }
+    };
 
-    progress = (CGUIDialogProgress *)g_windowManager.GetWindow(WINDOW_DIALOG_PROGRESS);
+    // exports put the paths before the items, older ones after them. Those
+    // are read from the end of the file instead of reading all of it twice
+    bool foundPaths = false;
+    bool foundItems = false;
+    bool imported = CXMLStreamReader::ReadFile(xmlFile, [&](const std::string &name, const std::string &xml)
+    {
+      CXBMCTinyXML xmlDoc;
+      if (name == "version" && xmlDoc.Parse(xml, TIXML_ENCODING_UTF8))
+      {
+        int iVersion = 0;
+        XMLUtils::GetInt(&xmlDoc, "version", iVersion);
+        CLog::Log(LOGDEBUG, "CVideoDatabase::ImportFromXML: Starting import (export version = %i)", iVersion);
+      }
+      if (name == "paths")
+      {
+        importPaths(xml);
+        foundPaths = true;
+        return false;
+      }
+      foundItems = IsImportedElement(name);
+      return !foundItems;
+    });
+    if (imported && !foundPaths && foundItems)
+    {
+      auto onPaths = [&importPaths](const std::string &name, const std::string &xml)
+      {
+        importPaths(xml);
+        return false;
+      };
+      if (!CXMLStreamReader::ReadLastElement(xmlFile, "paths", onPaths))
+        imported = CXMLStreamReader::ReadFile(xmlFile, [&onPaths](const std::string &name, const std::string &xml)
+        {
+          return name != "paths" || onPaths(name, xml);
+        });
+    }
+    if (!imported)
+    {
+      database.Close();
+      return;
+    }
+
+    if (!callback)
+    {
+      progress = (CGUIDialogProgress *)g_windowManager.GetWindow(WINDOW_DIALOG_PROGRESS);
+      callback = progress;
+    }
     if (progress)
     {
       progress->SetHeading(CVariant{648});
@@ -9292,66 +9824,36 @@ void CVideoDatabase::ImportFromXML(const std::string &path)
       progress->ShowProgressBar(true);
     }
 
-    int iVersion = 0;
-    XMLUtils::GetInt(root, "version", iVersion);
-
-    CLog::Log(LOGDEBUG, "%s: Starting import (export version = %i)", __FUNCTION__, iVersion);
-
-    TiXmlElement *movie = root->FirstChildElement();
-    int current = 0;
-    int total = 0;
-    // first count the number of items...
-    while (movie)
-    {
-      if (strnicmp(movie->Value(), MediaTypeMovie, 5)==0 ||
-          strnicmp(movie->Value(), MediaTypeTvShow, 6)==0 ||
-          strnicmp(movie->Value(), MediaTypeMusicVideo,10)==0 )
-        total++;
-      movie = movie->NextSiblingElement();
-    }
-
     std::string actorsDir(URIUtils::AddFileToFolder(path, "actors"));
     std::string moviesDir(URIUtils::AddFileToFolder(path, "movies"));
     std::string musicvideosDir(URIUtils::AddFileToFolder(path, "musicvideos"));
     std::string tvshowsDir(URIUtils::AddFileToFolder(path, "tvshows"));
-    CVideoInfoScanner scanner;
-    // add paths first (so we have scraper settings available)
-    TiXmlElement *path = root->FirstChildElement("paths");
-    path = path->FirstChildElement();
-    while (path)
-    {
-      std::string strPath;
-      if (XMLUtils::GetString(path,"url",strPath) && !strPath.empty())
-        AddPath(strPath);
-
-      std::string content;
-      if (XMLUtils::GetString(path,"content", content) && !content.empty())
-      { // check the scraper exists, if so store the path
-        AddonPtr addon;
-        std::string id;
-        XMLUtils::GetString(path,"scraperpath",id);
-        if (CAddonMgr::GetInstance().GetAddon(id, addon))
-        {
-          SScanSettings settings;
-          ScraperPtr scraper = std::dynamic_pointer_cast<CScraper>(addon);
-          // FIXME: scraper settings are not exported?
-          scraper->SetPathSettings(TranslateContent(content), "");
-          XMLUtils::GetInt(path,"scanrecursive",settings.recurse);
-          XMLUtils::GetBoolean(path,"usefoldernames",settings.parent_name);
-          SetScraperForPath(strPath,scraper,settings);
-        }
-      }
-      path = path->NextSiblingElement();
-    }
-    movie = root->FirstChildElement();
-    while (movie)
+
+    // items are committed in batches rather than one by one, the progress is measured in KB read
+    int current = 0;
+    int progressMax = -1;
+    uint64_t progressKB = 0;
+    database.BeginBatch();
+    imported = CXMLStreamReader::ReadFile(xmlFile, [&](const std::string &name, const std::string &xml)
     {
+      if (!IsImportedElement(name))
+        return true;
+      const char *element = name.c_str();
+
+      CXBMCTinyXML xmlDoc;
+      if (!xmlDoc.Parse(xml, TIXML_ENCODING_UTF8))
+      {
+        CLog::Log(LOGERROR, "CVideoDatabase::ImportFromXML: Skipping invalid %s at line %i: %s", element, xmlDoc.ErrorRow(), xmlDoc.ErrorDesc());
+        return true;
+      }
+      TiXmlElement *movie = xmlDoc.RootElement();
+
       CVideoInfoTag info;
-      if (strnicmp(movie->Value(), MediaTypeMovie, 5) == 0)
+      if (strnicmp(element, MediaTypeMovie, 5) == 0)
       {
         info.Load(movie);
         CFileItem item(info);
-        bool useFolders = info.m_basePath.empty() ? LookupByFolders(item.GetPath()) : false;
+        bool useFolders = info.m_basePath.empty() ? database.LookupByFolders(item.GetPath()) : false;
         std::string filename = info.m_strTitle;
         if (info.HasYear())
           filename += StringUtils::Format("_%i", info.GetYear());
@@ -9362,11 +9864,11 @@ void CVideoDatabase::ImportFromXML(const std::string &path)
         scanner.AddVideo(&item, CONTENT_MOVIES, useFolders, true, NULL, true);
         current++;
       }
-      else if (strnicmp(movie->Value(), MediaTypeMusicVideo, 10) == 0)
+      else if (strnicmp(element, MediaTypeMusicVideo, 10) == 0)
       {
         info.Load(movie);
         CFileItem item(info);
-        bool useFolders = info.m_basePath.empty() ? LookupByFolders(item.GetPath()) : false;
+        bool useFolders = info.m_basePath.empty() ? database.LookupByFolders(item.GetPath()) : false;
         std::string filename = StringUtils::Join(info.m_artist, g_advancedSettings.m_videoItemSeparator) + "." + info.m_strTitle;
         if (info.HasYear())
           filename += StringUtils::Format("_%i", info.GetYear());
@@ -9377,15 +9879,15 @@ void CVideoDatabase::ImportFromXML(const std::string &path)
         scanner.AddVideo(&item, CONTENT_MUSICVIDEOS, useFolders, true, NULL, true);
         current++;
       }
-      else if (strnicmp(movie->Value(), MediaTypeTvShow, 6) == 0)
+      else
       {
         // load the TV show in.  NOTE: This deletes all episodes under the TV Show, which may not be
         // what we desire.  It may make better sense to only delete (or even better, update) the show information
         info.Load(movie);
         URIUtils::AddSlashAtEnd(info.m_strPath);
-        DeleteTvShow(info.m_strPath);
+        database.DeleteTvShow(info.m_strPath);
         CFileItem showItem(info);
-        bool useFolders = info.m_basePath.empty() ? LookupByFolders(showItem.GetPath(), true) : false;
+        bool useFolders = info.m_basePath.empty() ? database.LookupByFolders(showItem.GetPath(), true) : false;
         CFileItem artItem(showItem);
         std::string artPath(GetSafeFile(tvshowsDir, info.m_strTitle));
         artItem.SetPath(artPath);
@@ -9398,8 +9900,8 @@ void CVideoDatabase::ImportFromXML(const std::string &path)
         scanner.GetSeasonThumbs(*artItem.GetVideoInfoTag(), seasonArt, CVideoThumbLoader::GetArtTypes(MediaTypeSeason), true);
         for (const auto &i : seasonArt)
         {
-          int seasonID = AddSeason(showID, i.first);
-          SetArtForItem(seasonID, MediaTypeSeason, i.second);
+          int seasonID = database.AddSeason(showID, i.first);
+          database.SetArtForItem(seasonID, MediaTypeSeason, i.second);
         }
         current++;
         // now load the episodes
@@ -9419,23 +9921,48 @@ void CVideoDatabase::ImportFromXML(const std::string &path)
           episode = episode->NextSiblingElement("episodedetails");
         }
       }
-      movie = movie->NextSiblingElement();
-      if (progress && total)
+
+      if (current % VIDEODB_IMPORT_BATCH_SIZE == 0)
       {
-        progress->SetPercentage(current * 100 / total);
+        database.CommitBatch();
+        database.BeginBatch();
+      }
+
+      if (progress)
         progress->SetLine(2, CVariant{info.m_strTitle});
-        progress->Progress();
-        if (progress->IsCanceled())
-        {
-          progress->Close();
-          return;
-        }
+      return AdvanceProgress(callback, progress, 0);
+    },
+    [&](uint64_t read, uint64_t size)
+    {
+      // without the size of the file there is nothing to measure against, only cancelling is checked
+      if (progressMax < 0)
+      {
+        progressMax = static_cast<int>((size + 1023) / 1024);
+        if (progressMax > 0 && callback)
+          callback->SetProgressMax(progressMax);
+        else if (progressMax == 0 && progress)
+          progress->ShowProgressBar(false);
       }
-    }
+      int steps = 0;
+      if (progressMax > 0)
+      {
+        steps = static_cast<int>(read / 1024 - progressKB);
+        progressKB = read / 1024;
+      }
+      return AdvanceProgress(callback, progress, steps);
+    });
+    // items imported before a cancel or an error are kept, as they were before they were batched
+    database.CommitBatch();
+    database.Close();
+
+    if (!imported)
+      CLog::Log(LOGERROR, "%s: Import of %s stopped after %i items", __FUNCTION__, xmlFile.c_str(), current);
   }
   catch (...)
   {
     CLog::Log(LOGERROR, "%s failed", __FUNCTION__);
+    database.RollbackBatch();
+    database.Close();
   }
   if (progress)
     progress->Close();
@@ -9502,6 +10029,9 @@ bool CVideoDatabase::CommitTransaction()
 {
   if (CDatabase::CommitTransaction())
   { // number of items in the db has likely changed, so recalculate
+    // releasing a savepoint within a batch changes nothing yet, recalculate on CommitBatch()
+    if (InBatch())
+      return true;
     g_infoManager.SetLibraryBool(LIBRARY_HAS_MOVIES, HasContent(VIDEODB_CONTENT_MOVIES));
     g_infoManager.SetLibraryBool(LIBRARY_HAS_TVSHOWS, HasContent(VIDEODB_CONTENT_TVSHOWS));
     g_infoManager.SetLibraryBool(LIBRARY_HAS_MUSICVIDEOS, HasContent(VIDEODB_CONTENT_MUSICVIDEOS));
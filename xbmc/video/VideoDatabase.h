@@ -36,6 +36,9 @@ class CFileItemList;
 class CVideoSettings;
 class CGUIDialogProgress;
 class CGUIDialogProgressBarHandle;
+class CTextureExportQueue;
+class CWeightedRandomPool;
+class IProgressCallback;
 
 namespace dbiplus
 {
@@ -78,6 +81,7 @@ enum VideoDbDetails
   VideoDbDetailsCast     = 0x10,
   VideoDbDetailsBookmark = 0x20,
   VideoDbDetailsUniqueID = 0x40,
+  VideoDbDetailsArt      = 0x80,
   VideoDbDetailsAll      = 0xFF
 } ;
 
@@ -771,9 +775,20 @@ public:
    */
   void UpdateFileDateAdded(int idFile, const std::string& strFileNameAndPathh, const CDateTime& dateAdded = CDateTime());
 
-  void ExportToXML(const std::string &path, bool singleFile = true, bool images=false, bool actorThumbs=false, bool overwrite=false);
-  void ExportActorThumbs(const std::string &path, const CVideoInfoTag& tag, bool singleFiles, bool overwrite=false);
-  void ImportFromXML(const std::string &path);
+  /*! \brief Export the library to nfo files or a single videodb.xml.
+   The single file is written an item at a time and images are copied in the background.
+   \param progress receives the progress in items and is asked whether to cancel,
+                   the progress dialog is shown if NULL
+   */
+  void ExportToXML(const std::string &path, bool singleFile = true, bool images=false, bool actorThumbs=false, bool overwrite=false, IProgressCallback *progress = NULL);
+  void ExportActorThumbs(const std::string &path, const CVideoInfoTag& tag, bool singleFiles, bool overwrite=false, CTextureExportQueue *exports = NULL);
+
+  /*! \brief Import a videodb.xml written by ExportToXML().
+   The file is read an item at a time and the items are committed in batches.
+   \param progress receives the progress in KB read and is asked whether to cancel,
+                   the progress dialog is shown if NULL
+   */
+  void ImportFromXML(const std::string &path, IProgressCallback *progress = NULL);
   void DumpToDummyFiles(const std::string &path);
   bool ImportArtFromXML(const TiXmlNode *node, std::map<std::string, std::string> &artwork);
 
@@ -796,6 +811,11 @@ public:
 
   // partymode
   unsigned int GetMusicVideoIDs(const std::string& strWhere, std::vector<std::pair<int, int> > &songIDs);
+
+  /*! \brief Add the music videos matching a where clause to a random pool, weighted by their rating and play count.
+   \return the number of music videos added
+   */
+  unsigned int GetMusicVideoIDs(const std::string& strWhere, CWeightedRandomPool &pool);
   bool GetRandomMusicVideo(CFileItem* item, int& idSong, const std::string& strWhere);
 
   static void VideoContentTypeToString(VIDEODB_CONTENT_TYPE type, std::string& out)
@@ -918,6 +938,22 @@ protected:
   void GetRatings(int media_id, const std::string &media_type, RatingMap &ratings);
   void GetUniqueIDs(int media_id, const std::string &media_type, CVideoInfoTag& details);
 
+  /*! \brief Load the details of a list of items that need additional queries.
+   Cast, tags, ratings, unique ids, stream details and art are fetched with a
+   few queries for a whole batch of items instead of a few queries per item.
+   \param items the list holding the items
+   \param start index of the first item to load the details for
+   \param mediaType the media type of the items, items of other types are skipped
+   \param getDetails the VideoDbDetails to load
+   \sa GetBatchedDetails
+   */
+  void GetDetailsForItems(CFileItemList &items, int start, const MediaType &mediaType, int getDetails);
+
+  /*! \brief The VideoDbDetails that GetDetailsForItems() loads for a media type.
+   These should be masked out of the details passed to GetDetailsForMovie() and friends.
+   */
+  static int GetBatchedDetails(const MediaType &mediaType);
+
   void GetDetailsFromDB(std::unique_ptr<dbiplus::Dataset> &pDS, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset = 2);
   void GetDetailsFromDB(const dbiplus::sql_record* const record, int min, int max, const SDbTableOffsets *offsets, CVideoInfoTag &details, int idxOffset = 2);
   std::string GetValueString(const CVideoInfoTag &details, int min, int max, const SDbTableOffsets *offsets) const;
@@ -967,6 +1003,8 @@ private:
   virtual int GetMinSchemaVersion() const { return 75; };
   virtual int GetSchemaVersion() const;
   virtual int GetExportVersion() const { return 1; };
+  virtual std::vector<CSearchIndex::Source> GetSearchSources() const;
+  virtual CDatabase* CreateSearchIndexDatabase() const { return new CVideoDatabase(); }
   const char *GetBaseDBName() const { return "MyVideos"; };
 
   void ConstructPath(std::string& strDest, const std::string& strPath, const std::string& strFileName);
@@ -22,6 +22,7 @@
 
 #include <utility>
 
+#include "cores/VideoPlayer/DVDFileInfo.h"
 #include "dialogs/GUIDialogExtendedProgressBar.h"
 #include "dialogs/GUIDialogOK.h"
 #include "dialogs/GUIDialogProgress.h"
@@ -167,6 +168,9 @@ namespace VIDEO
             m_handle->SetTitle(g_localizeStrings.Get(331));
           m_database.Compress(false);
         }
+
+        // index the new items now rather than on the first search
+        m_database.UpdateSearchIndex();
       }
 
       g_infoManager.ResetLibraryBools();
@@ -376,6 +380,8 @@ namespace VIDEO
       m_database.SetPathHash(strDirectory, hash);
     }
 
+    ExtractStreamDetails();
+
     if (m_handle)
       OnDirectoryScanned(strDirectory);
 
@@ -1289,6 +1295,12 @@ namespace VIDEO
         movieDetails.m_resumePoint.IsSet())
       m_database.AddBookMarkToFile(pItem->GetPath(), movieDetails.m_resumePoint, CBookmark::RESUME);
 
+    // multi-episode files are added once per episode, the set keeps one of them
+    if (m_bRunning && !libraryImport && lResult > -1 && !pItem->m_bIsFolder && !pItem->IsPlugin() &&
+        !movieDetails.HasStreamDetails() &&
+        CSettings::GetInstance().GetBool(CSettings::SETTING_MYVIDEOS_EXTRACTFLAGS))
+      m_streamDetailsFiles.insert(pItem->GetPath());
+
     m_database.Close();
 
     CFileItemPtr itemCopy = CFileItemPtr(new CFileItem(*pItem));
@@ -1643,6 +1655,46 @@ namespace VIDEO
     return INFO_ADDED;
   }
 
+  void CVideoInfoScanner::ExtractStreamDetails()
+  {
+    if (m_streamDetailsFiles.empty())
+      return;
+
+    std::vector<CFileItemPtr> items;
+    std::vector<CFileItem*> batch;
+    for (const std::string &file : m_streamDetailsFiles)
+    {
+      items.push_back(CFileItemPtr(new CFileItem(file, false)));
+      batch.push_back(items.back().get());
+    }
+    m_streamDetailsFiles.clear();
+
+    if (m_bStop)
+      return;
+
+    CLog::Log(LOGDEBUG, "VideoInfoScanner: Extracting stream details of %i files", (int)items.size());
+    CDVDFileInfo::GetFileStreamDetailsBatch(batch);
+
+    if (!m_database.Open())
+      return;
+
+    bool inBatch = m_database.BeginBatch();
+    for (const CFileItemPtr &item : items)
+    {
+      CVideoInfoTag *tag = item->GetVideoInfoTag();
+      if (!tag->HasStreamDetails())
+        continue;
+
+      // Don't know the total time of the stack, so set duration to zero to avoid confusion
+      if (item->IsStack())
+        tag->m_streamDetails.SetVideoDuration(0, 0);
+      m_database.SetStreamDetailsForFile(tag->m_streamDetails, item->GetPath());
+    }
+    if (inBatch)
+      m_database.CommitBatch();
+    m_database.Close();
+  }
+
   std::string CVideoInfoScanner::GetnfoFile(CFileItem *item, bool bGrabAny) const
   {
     std::string nfoFile;
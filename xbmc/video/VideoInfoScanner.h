@@ -126,6 +126,11 @@ namespace VIDEO
 
     bool EnumerateEpisodeItem(const CFileItem *item, EPISODELIST& episodeList);
 
+    /*! \brief Get the database AddVideo() writes to.
+     Keeping it open across calls lets a caller run them within a single batch.
+     */
+    CVideoDatabase& GetDatabase() { return m_database; }
+
   protected:
     virtual void Process();
     bool DoScan(const std::string& strDirectory) override;
@@ -239,6 +244,12 @@ namespace VIDEO
 
     std::string GetnfoFile(CFileItem *item, bool bGrabAny=false) const;
 
+    /*! \brief Read the stream details of the files added since the last call
+     All files are probed at once and stored in the database, so the thumb
+     loader doesn't have to open them one by one when they are first listed.
+     */
+    void ExtractStreamDetails();
+
     bool m_showDialog;
     CGUIDialogProgressBarHandle* m_handle;
     int m_currentItem;
@@ -253,6 +264,7 @@ namespace VIDEO
     std::set<std::string> m_pathsToScan;
     std::set<std::string> m_pathsToCount;
     std::set<int> m_pathsToClean;
+    std::set<std::string> m_streamDetailsFiles;
     CNfoFile m_nfoReader;
   };
 }
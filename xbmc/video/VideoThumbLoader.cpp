@@ -20,6 +20,7 @@
 
 #include "VideoThumbLoader.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <utility>
 
@@ -32,11 +33,13 @@
 #include "GUIUserMessages.h"
 #include "music/MusicDatabase.h"
 #include "rendering/RenderSystem.h"
+#include "threads/SingleLock.h"
 #include "settings/AdvancedSettings.h"
 #include "settings/Settings.h"
 #include "settings/VideoSettings.h"
 #include "TextureCache.h"
 #include "URL.h"
+#include "utils/CPUInfo.h"
 #include "utils/log.h"
 #include "utils/StringUtils.h"
 #include "utils/URIUtils.h"
@@ -83,28 +86,36 @@ bool CThumbExtractor::operator==(const CJob* job) const
   return false;
 }
 
-bool CThumbExtractor::DoWork()
+bool CThumbExtractor::CanExtract(const CFileItem& item)
 {
-  if (m_item.IsLiveTV()
+  if (item.IsLiveTV()
   // Due to a pvr addon api design flaw (no support for multiple concurrent streams
   // per addon instance), pvr recording thumbnail extraction does not work (reliably).
-  ||  m_item.IsPVRRecording()
-  ||  URIUtils::IsUPnP(m_item.GetPath())
-  ||  URIUtils::IsBluray(m_item.GetPath())
-  ||  m_item.IsBDFile()
-  ||  m_item.IsDVD()
-  ||  m_item.IsDiscImage()
-  ||  m_item.IsDVDFile(false, true)
-  ||  m_item.IsInternetStream()
-  ||  m_item.IsDiscStub()
-  ||  m_item.IsPlayList())
+  ||  item.IsPVRRecording()
+  ||  URIUtils::IsUPnP(item.GetPath())
+  ||  URIUtils::IsBluray(item.GetPath())
+  ||  item.IsBDFile()
+  ||  item.IsDVD()
+  ||  item.IsDiscImage()
+  ||  item.IsDVDFile(false, true)
+  ||  item.IsInternetStream()
+  ||  item.IsDiscStub()
+  ||  item.IsPlayList())
     return false;
 
   // For HTTP/FTP we only allow extraction when on a LAN
-  if (URIUtils::IsRemote(m_item.GetPath()) &&
-     !URIUtils::IsOnLAN(m_item.GetPath())  &&
-     (URIUtils::IsFTP(m_item.GetPath())    ||
-      URIUtils::IsHTTP(m_item.GetPath())))
+  if (URIUtils::IsRemote(item.GetPath()) &&
+     !URIUtils::IsOnLAN(item.GetPath())  &&
+     (URIUtils::IsFTP(item.GetPath())    ||
+      URIUtils::IsHTTP(item.GetPath())))
+    return false;
+
+  return true;
+}
+
+bool CThumbExtractor::DoWork()
+{
+  if (!CanExtract(m_item))
     return false;
 
   bool result=false;
@@ -116,23 +127,7 @@ bool CThumbExtractor::DoWork()
     details.file = CTextureCache::GetCacheFile(m_target) + ".jpg";
     result = CDVDFileInfo::ExtractThumb(m_item.GetPath(), details, m_fillStreamDetails ? &m_item.GetVideoInfoTag()->m_streamDetails : NULL, (int) m_pos);
     if(result)
-    {
-      CTextureCache::GetInstance().AddCachedTexture(m_target, details);
-      m_item.SetProperty("HasAutoThumb", true);
-      m_item.SetProperty("AutoThumbImage", m_target);
-      m_item.SetArt("thumb", m_target);
-
-      CVideoInfoTag* info = m_item.GetVideoInfoTag();
-      if (info->m_iDbId > 0 && !info->m_type.empty())
-      {
-        CVideoDatabase db;
-        if (db.Open())
-        {
-          db.SetArtForItem(info->m_iDbId, info->m_type, "thumb", m_item.GetArt("thumb"));
-          db.Close();
-        }
-      }
-    }
+      OnThumbExtracted(details);
   }
   else if (!m_item.IsPlugin() &&
            (!m_item.HasVideoInfoTag() ||
@@ -145,43 +140,192 @@ bool CThumbExtractor::DoWork()
 
   if (result)
   {
-    CVideoInfoTag* info = m_item.GetVideoInfoTag();
+    SaveStreamDetails();
+    return true;
+  }
+
+  return false;
+}
+
+void CThumbExtractor::OnThumbExtracted(const CTextureDetails& details)
+{
+  CTextureCache::GetInstance().AddCachedTexture(m_target, details);
+  m_item.SetProperty("HasAutoThumb", true);
+  m_item.SetProperty("AutoThumbImage", m_target);
+  m_item.SetArt("thumb", m_target);
+
+  CVideoInfoTag* info = m_item.GetVideoInfoTag();
+  if (info->m_iDbId > 0 && !info->m_type.empty())
+  {
     CVideoDatabase db;
     if (db.Open())
     {
-      if (URIUtils::IsStack(m_listpath))
-      {
-        // Don't know the total time of the stack, so set duration to zero to avoid confusion
-        info->m_streamDetails.SetVideoDuration(0, 0);
+      db.SetArtForItem(info->m_iDbId, info->m_type, "thumb", m_item.GetArt("thumb"));
+      db.Close();
+    }
+  }
+}
 
-        // Restore original stack path
-        m_item.SetPath(m_listpath);
-      }
+void CThumbExtractor::SaveStreamDetails()
+{
+  CVideoInfoTag* info = m_item.GetVideoInfoTag();
+  CVideoDatabase db;
+  if (db.Open())
+  {
+    if (URIUtils::IsStack(m_listpath))
+    {
+      // Don't know the total time of the stack, so set duration to zero to avoid confusion
+      info->m_streamDetails.SetVideoDuration(0, 0);
 
-      if (info->m_iFileId < 0)
-        db.SetStreamDetailsForFile(info->m_streamDetails, !info->m_strFileNameAndPath.empty() ? info->m_strFileNameAndPath : static_cast<const std::string&>(m_item.GetPath()));
-      else
-        db.SetStreamDetailsForFileId(info->m_streamDetails, info->m_iFileId);
+      // Restore original stack path
+      m_item.SetPath(m_listpath);
+    }
 
-      // overwrite the runtime value if the one from streamdetails is available
-      if (info->m_iDbId > 0
-          && info->m_duration > 0
-          && static_cast<size_t>(info->m_duration) != info->GetDuration())
-      {
-        info->m_duration = info->GetDuration();
+    if (info->m_iFileId < 0)
+      db.SetStreamDetailsForFile(info->m_streamDetails, !info->m_strFileNameAndPath.empty() ? info->m_strFileNameAndPath : static_cast<const std::string&>(m_item.GetPath()));
+    else
+      db.SetStreamDetailsForFileId(info->m_streamDetails, info->m_iFileId);
 
-        // store the updated information in the database
-        db.SetDetailsForItem(info->m_iDbId, info->m_type, *info, m_item.GetArt());
-      }
+    // overwrite the runtime value if the one from streamdetails is available
+    if (info->m_iDbId > 0
+        && info->m_duration > 0
+        && static_cast<size_t>(info->m_duration) != info->GetDuration())
+    {
+      info->m_duration = info->GetDuration();
 
-      db.Close();
+      // store the updated information in the database
+      db.SetDetailsForItem(info->m_iDbId, info->m_type, *info, m_item.GetArt());
     }
-    return true;
+
+    db.Close();
+  }
+}
+
+CThumbBatchExtractor::CThumbBatchExtractor(std::vector<std::unique_ptr<CThumbExtractor>>&& extractors)
+  : m_extractors(std::move(extractors))
+  , m_extracted(m_extractors.size(), false)
+{
+}
+
+CThumbBatchExtractor::~CThumbBatchExtractor()
+{
+}
+
+bool CThumbBatchExtractor::operator==(const CJob* job) const
+{
+  if (strcmp(job->GetType(), GetType()) != 0)
+    return false;
+
+  const CThumbBatchExtractor* jobExtract = dynamic_cast<const CThumbBatchExtractor*>(job);
+  if (!jobExtract || jobExtract->m_extractors.size() != m_extractors.size())
+    return false;
+
+  for (size_t i = 0; i < m_extractors.size(); i++)
+  {
+    if (!(*m_extractors[i] == jobExtract->m_extractors[i].get()))
+      return false;
+  }
+  return true;
+}
+
+bool CThumbBatchExtractor::DoWork()
+{
+  std::vector<DVDThumbRequest> requests;
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < m_extractors.size(); i++)
+  {
+    CThumbExtractor& extractor = *m_extractors[i];
+    if (!CThumbExtractor::CanExtract(extractor.m_item))
+      continue;
+
+    DVDThumbRequest request;
+    request.path = extractor.m_item.GetPath();
+    request.positions.push_back((int)extractor.m_pos);
+    request.details.resize(1);
+    request.details[0].file = CTextureCache::GetCacheFile(extractor.m_target) + ".jpg";
+    if (extractor.m_fillStreamDetails)
+      request.streamDetails = &extractor.m_item.GetVideoInfoTag()->m_streamDetails;
+    requests.push_back(request);
+    indices.push_back(i);
+  }
+
+  CLog::Log(LOGDEBUG,"%s - trying to extract thumbs from %u video files", __FUNCTION__, (unsigned int)requests.size());
+  if (CDVDFileInfo::ExtractThumbBatch(requests) == 0)
+    return false;
+
+  for (size_t i = 0; i < requests.size(); i++)
+  {
+    if (requests[i].extracted.empty() || !requests[i].extracted[0])
+      continue;
+
+    CThumbExtractor& extractor = *m_extractors[indices[i]];
+    extractor.OnThumbExtracted(requests[i].details[0]);
+    extractor.SaveStreamDetails();
+    m_extracted[indices[i]] = true;
   }
+  return true;
+}
 
+CChapterThumbExtractor::CChapterThumbExtractor(const CFileItem& item,
+                                               const std::vector<std::string>& targets,
+                                               const std::vector<int64_t>& positions)
+  : m_item(item)
+  , m_targets(targets)
+  , m_positions(positions)
+{
+  if (item.IsVideoDb() && item.HasVideoInfoTag())
+    m_item.SetPath(item.GetVideoInfoTag()->m_strFileNameAndPath);
+
+  if (m_item.IsStack())
+    m_item.SetPath(CStackDirectory::GetFirstStackedFile(m_item.GetPath()));
+}
+
+CChapterThumbExtractor::~CChapterThumbExtractor()
+{
+}
+
+bool CChapterThumbExtractor::operator==(const CJob* job) const
+{
+  if (strcmp(job->GetType(),GetType()) == 0)
+  {
+    const CChapterThumbExtractor* jobExtract = dynamic_cast<const CChapterThumbExtractor*>(job);
+    if (jobExtract && jobExtract->m_item.GetPath() == m_item.GetPath()
+                   && jobExtract->m_targets == m_targets)
+      return true;
+  }
   return false;
 }
 
+bool CChapterThumbExtractor::DoWork()
+{
+  if (!CThumbExtractor::CanExtract(m_item))
+    return false;
+
+  CLog::Log(LOGDEBUG,"%s - trying to extract %u thumbs from video file %s", __FUNCTION__, (unsigned int)m_targets.size(), CURL::GetRedacted(m_item.GetPath()).c_str());
+
+  std::vector<int> positions;
+  std::vector<CTextureDetails> details(m_targets.size());
+  for (size_t i = 0; i < m_targets.size(); i++)
+  {
+    positions.push_back((int)m_positions[i]);
+    details[i].file = CTextureCache::GetCacheFile(m_targets[i]) + ".jpg";
+  }
+
+  // every chapter that is done is reported as progress, so it can be shown right away
+  m_extracted = CDVDFileInfo::ExtractThumbs(m_item.GetPath(), positions, details, NULL, nullptr, this);
+
+  bool result = false;
+  for (size_t i = 0; i < m_targets.size(); i++)
+  {
+    if (m_extracted[i])
+    {
+      CTextureCache::GetInstance().AddCachedTexture(m_targets[i], details[i]);
+      result = true;
+    }
+  }
+  return result;
+}
+
 CVideoThumbLoader::CVideoThumbLoader() :
   CThumbLoader(), CJobQueue(true, 1, CJob::PRIORITY_LOW_PAUSABLE)
 {
@@ -204,6 +348,7 @@ void CVideoThumbLoader::OnLoaderStart()
 
 void CVideoThumbLoader::OnLoaderFinish()
 {
+  FlushThumbExtraction();
   m_videoDatabase->Close();
   m_showArt.clear();
   m_seasonArt.clear();
@@ -399,8 +544,7 @@ bool CVideoThumbLoader::LoadItemLookup(CFileItem* pItem)
         if (URIUtils::IsInRAR(item.GetPath()))
           SetupRarOptions(item,path);
 
-        CThumbExtractor* extract = new CThumbExtractor(item, path, true, thumbURL);
-        AddJob(extract);
+        QueueThumbExtraction(new CThumbExtractor(item, path, true, thumbURL));
 
         m_videoDatabase->Close();
         return true;
@@ -570,18 +714,84 @@ void CVideoThumbLoader::OnJobComplete(unsigned int jobID, bool success, CJob* jo
 {
   if (success)
   {
-    CThumbExtractor* loader = (CThumbExtractor*)job;
-    loader->m_item.SetPath(loader->m_listpath);
-
-    if (m_pObserver)
-      m_pObserver->OnItemLoaded(&loader->m_item);
-    CFileItemPtr pItem(new CFileItem(loader->m_item));
-    CGUIMessage msg(GUI_MSG_NOTIFY_ALL, 0, 0, GUI_MSG_UPDATE_ITEM, 0, pItem);
-    g_windowManager.SendThreadMessage(msg);
+    CThumbBatchExtractor* batch = dynamic_cast<CThumbBatchExtractor*>(job);
+    if (batch)
+    {
+      for (size_t i = 0; i < batch->m_extractors.size(); i++)
+      {
+        if (batch->m_extracted[i])
+          OnExtractorDone(*batch->m_extractors[i]);
+      }
+    }
+    else
+      OnExtractorDone(*static_cast<CThumbExtractor*>(job));
   }
   CJobQueue::OnJobComplete(jobID, success, job);
 }
 
+void CVideoThumbLoader::OnExtractorDone(CThumbExtractor &extractor)
+{
+  extractor.m_item.SetPath(extractor.m_listpath);
+
+  if (m_pObserver)
+    m_pObserver->OnItemLoaded(&extractor.m_item);
+  CFileItemPtr pItem(new CFileItem(extractor.m_item));
+  CGUIMessage msg(GUI_MSG_NOTIFY_ALL, 0, 0, GUI_MSG_UPDATE_ITEM, 0, pItem);
+  g_windowManager.SendThreadMessage(msg);
+}
+
+// extractions per CThumbBatchExtractor, small enough for the thumbs to show
+// up while the rest of the listing is still decoded
+static size_t GetThumbBatchSize()
+{
+  return std::max(1, g_cpuInfo.getCPUCount()) * 4;
+}
+
+void CVideoThumbLoader::QueueThumbExtraction(CThumbExtractor *extractor)
+{
+  if (!IsLoading())
+  {
+    AddJob(extractor);
+    return;
+  }
+
+  // a full batch is queued right away instead of waiting for the end of the load
+  std::vector<std::unique_ptr<CThumbExtractor>> extractors;
+  {
+    CSingleLock lock(m_pendingSection);
+    m_pendingThumbs.push_back(std::unique_ptr<CThumbExtractor>(extractor));
+    if (m_pendingThumbs.size() < GetThumbBatchSize())
+      return;
+    extractors.swap(m_pendingThumbs);
+  }
+  AddJob(new CThumbBatchExtractor(std::move(extractors)));
+}
+
+void CVideoThumbLoader::FlushThumbExtraction()
+{
+  std::vector<std::unique_ptr<CThumbExtractor>> pending;
+  {
+    CSingleLock lock(m_pendingSection);
+    pending.swap(m_pendingThumbs);
+  }
+  if (pending.empty())
+    return;
+
+  // the queue runs the last added job first, so add the batches back to front
+  // to extract the thumbs in the order of the listing
+  size_t batchSize = GetThumbBatchSize();
+  size_t batches = (pending.size() + batchSize - 1) / batchSize;
+  for (size_t batch = batches; batch-- > 0; )
+  {
+    size_t first = batch * batchSize;
+    size_t last = std::min(first + batchSize, pending.size());
+    std::vector<std::unique_ptr<CThumbExtractor>> extractors;
+    for (size_t i = first; i < last; i++)
+      extractors.push_back(std::move(pending[i]));
+    AddJob(new CThumbBatchExtractor(std::move(extractors)));
+  }
+}
+
 void CVideoThumbLoader::DetectAndAddMissingItemData(CFileItem &item)
 {
   if (item.m_bIsFolder) return;
@@ -20,12 +20,15 @@
  */
 
 #include <map>
+#include <memory>
 #include <vector>
 #include "ThumbLoader.h"
+#include "threads/CriticalSection.h"
 #include "utils/JobManager.h"
 #include "FileItem.h"
 
 class CStreamDetails;
+class CTextureDetails;
 class CVideoDatabase;
 
 /*!
@@ -54,6 +57,22 @@ public:
 
   virtual bool operator==(const CJob* job) const;
 
+  /*!
+   \brief Check whether thumbs can be extracted from the given item.
+   */
+  static bool CanExtract(const CFileItem& item);
+
+  /*!
+   \brief Cache the extracted thumb and set it as the item's thumb.
+   \param details the extracted image.
+   */
+  void OnThumbExtracted(const CTextureDetails& details);
+
+  /*!
+   \brief Store the item's stream details in the database.
+   */
+  void SaveStreamDetails();
+
   std::string m_target; ///< thumbpath
   std::string m_listpath; ///< path used in fileitem list
   CFileItem  m_item;
@@ -62,6 +81,71 @@ public:
   bool m_fillStreamDetails; ///< fill in stream details? 
 };
 
+/*!
+ \ingroup thumbs,jobs
+ \brief Chapter thumb extractor job class
+
+ Extracts the thumbs of several positions of one video file, opening the file
+ and the decoder only once.
+
+ \sa CThumbExtractor and CJob
+ */
+class CChapterThumbExtractor : public CJob
+{
+public:
+  CChapterThumbExtractor(const CFileItem& item, const std::vector<std::string>& targets, const std::vector<int64_t>& positions);
+  virtual ~CChapterThumbExtractor();
+
+  /*!
+   \brief Work function that extracts the thumbs.
+   */
+  virtual bool DoWork();
+
+  virtual const char* GetType() const
+  {
+    return kJobTypeMediaFlags;
+  }
+
+  virtual bool operator==(const CJob* job) const;
+
+  CFileItem m_item;
+  std::vector<std::string> m_targets; ///< thumbpaths
+  std::vector<int64_t> m_positions; ///< positions to extract the thumbs from
+  std::vector<bool> m_extracted; ///< thumbs that were extracted
+};
+
+/*!
+ \ingroup thumbs,jobs
+ \brief Thumb extractor job for several video files
+
+ Extracts the thumbs of all its files with CDVDFileInfo::ExtractThumbBatch,
+ which decodes several files at once and keeps the decoder open between the
+ files of a folder.
+
+ \sa CThumbExtractor and CJob
+ */
+class CThumbBatchExtractor : public CJob
+{
+public:
+  explicit CThumbBatchExtractor(std::vector<std::unique_ptr<CThumbExtractor>>&& extractors);
+  virtual ~CThumbBatchExtractor();
+
+  /*!
+   \brief Work function that extracts the thumbs.
+   */
+  virtual bool DoWork();
+
+  virtual const char* GetType() const
+  {
+    return kJobTypeMediaFlags;
+  }
+
+  virtual bool operator==(const CJob* job) const;
+
+  std::vector<std::unique_ptr<CThumbExtractor>> m_extractors;
+  std::vector<bool> m_extracted; ///< one per extractor, true if its thumb was extracted
+};
+
 class CVideoThumbLoader : public CThumbLoader, public CJobQueue
 {
 public:
@@ -137,4 +221,21 @@ protected:
    \return void
    */
   void DetectAndAddMissingItemData(CFileItem &item);
+
+  /*! \brief Queue the thumb extraction of an item.
+   During a background load the extraction is batched with the other items
+   of the listing, a batch is queued once it is full or the load finishes.
+   */
+  void QueueThumbExtraction(CThumbExtractor *extractor);
+
+  /*! \brief Queue the batched thumb extractions that are still pending.
+   */
+  void FlushThumbExtraction();
+
+  /*! \brief Update the GUI with the item of an extractor that has finished.
+   */
+  void OnExtractorDone(CThumbExtractor &extractor);
+
+  CCriticalSection m_pendingSection;
+  std::vector<std::unique_ptr<CThumbExtractor>> m_pendingThumbs;
 };
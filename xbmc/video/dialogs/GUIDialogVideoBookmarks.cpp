@@ -270,6 +270,9 @@ void CGUIDialogVideoBookmarks::OnRefreshList()
   }
 
   // add chapters if around
+  std::vector<unsigned int> jobChapters;
+  std::vector<std::string> jobTargets;
+  std::vector<int64_t> jobPositions;
   for (int i = 1; i <= g_application.m_pPlayer->GetChapterCount(); ++i)
   {
     std::string chapterName;
@@ -292,11 +295,10 @@ void CGUIDialogVideoBookmarks::OnRefreshList()
       item->SetArt("thumb", cachefile);
     else if (i > m_jobsStarted && CSettings::GetInstance().GetBool(CSettings::SETTING_MYVIDEOS_EXTRACTCHAPTERTHUMBS))
     {
-      CFileItem item(m_filePath, false);
-      CJob* job = new CThumbExtractor(item, m_filePath, true, chapterPath, pos * 1000, false);
-      AddJob(job);
-      m_mapJobsChapter[job] = i;
-      m_jobsStarted++;
+      jobChapters.push_back(i);
+      jobTargets.push_back(chapterPath);
+      jobPositions.push_back(pos * 1000);
+      m_jobsStarted = i;
     }
 
     item->SetProperty("chapter", i);
@@ -305,6 +307,23 @@ void CGUIDialogVideoBookmarks::OnRefreshList()
     items.push_back(item);
   }
 
+  // extract the missing chapter thumbs in one go, so the file is opened only once
+  if (!jobChapters.empty())
+  {
+    CFileItem item(m_filePath, false);
+    CJob* job = new CChapterThumbExtractor(item, jobTargets, jobPositions);
+    // the job reports its chapters as soon as it starts, so map them first
+    {
+      CSingleLock lock(m_refreshSection);
+      m_mapJobsChapter[job] = jobChapters;
+    }
+    if (!AddJob(job))
+    {
+      CSingleLock lock(m_refreshSection);
+      m_mapJobsChapter.erase(job);
+    }
+  }
+
   // sort items by resume point
   std::sort(items.begin(), items.end(), [](const CFileItemPtr &item1, const CFileItemPtr &item2) {
     return item1->GetProperty("resumepoint").asDouble() < item2->GetProperty("resumepoint").asDouble();
@@ -477,7 +496,10 @@ void CGUIDialogVideoBookmarks::OnWindowLoaded()
   m_viewControl.SetParentWindow(GetID());
   m_viewControl.AddView(GetControl(CONTROL_THUMBS));
   m_jobsStarted = 0;
-  m_mapJobsChapter.clear();
+  {
+    CSingleLock lock(m_refreshSection);
+    m_mapJobsChapter.clear();
+  }
   m_vecItems->Clear();
 }
 
@@ -485,7 +507,10 @@ void CGUIDialogVideoBookmarks::OnWindowUnload()
 {
   //stop running thumb extraction jobs
   CancelJobs();
-  m_mapJobsChapter.clear();
+  {
+    CSingleLock lock(m_refreshSection);
+    m_mapJobsChapter.clear();
+  }
   m_vecItems->Clear();
   CGUIDialog::OnWindowUnload();
   m_viewControl.Reset();
@@ -570,19 +595,32 @@ bool CGUIDialogVideoBookmarks::OnAddEpisodeBookmark()
   return bReturn;
 }
 
+void CGUIDialogVideoBookmarks::OnJobProgress(unsigned int jobID, unsigned int progress,
+                                             unsigned int total, const CJob* job)
+{
+  // the chapter at position progress - 1 of the job is done
+  unsigned int chapterIdx = 0;
+  {
+    CSingleLock lock(m_refreshSection);
+    MAPJOBSCHAPS::const_iterator iter = m_mapJobsChapter.find(const_cast<CJob*>(job));
+    if (iter == m_mapJobsChapter.end() || progress == 0 || progress > iter->second.size())
+      return;
+    chapterIdx = iter->second[progress - 1];
+  }
+
+  if (IsActive())
+  {
+    CGUIMessage m(GUI_MSG_REFRESH_LIST, GetID(), 0, 1, chapterIdx);
+    CApplicationMessenger::GetInstance().SendGUIMessage(m);
+  }
+}
+
 void CGUIDialogVideoBookmarks::OnJobComplete(unsigned int jobID,
                                              bool success, CJob* job)
 {
-  if (success && IsActive())
   {
-    MAPJOBSCHAPS::iterator iter = m_mapJobsChapter.find(job);
-    if (iter != m_mapJobsChapter.end())
-    {
-      unsigned int chapterIdx = (*iter).second;
-      CGUIMessage m(GUI_MSG_REFRESH_LIST, GetID(), 0, 1, chapterIdx);
-      CApplicationMessenger::GetInstance().SendGUIMessage(m);
-      m_mapJobsChapter.erase(iter);
-    }
+    CSingleLock lock(m_refreshSection);
+    m_mapJobsChapter.erase(job);
   }
   CJobQueue::OnJobComplete(jobID, success, job);
 }
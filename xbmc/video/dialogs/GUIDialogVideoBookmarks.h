@@ -29,7 +29,7 @@ class CFileItemList;
 
 class CGUIDialogVideoBookmarks : public CGUIDialog, public CJobQueue
 {
-  typedef std::map<CJob*, unsigned int> MAPJOBSCHAPS;
+  typedef std::map<CJob*, std::vector<unsigned int> > MAPJOBSCHAPS;
 
 public:
   CGUIDialogVideoBookmarks(void);
@@ -73,6 +73,7 @@ protected:
   CGUIControl *GetFirstFocusableControl(int id);
 
   void OnJobComplete(unsigned int jobID, bool success, CJob* job);
+  void OnJobProgress(unsigned int jobID, unsigned int progress, unsigned int total, const CJob* job);
 
   CFileItemList* m_vecItems;
   CGUIViewControl m_viewControl;
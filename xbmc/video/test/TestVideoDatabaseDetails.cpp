@@ -0,0 +1,310 @@
+/*
+ *      Copyright (C) 2016 Team Kodi
+ *      http://kodi.tv
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Kodi; see the file COPYING.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FileItem.h"
+#include "settings/AdvancedSettings.h"
+#include "test/TestDatabase.h"
+#include "threads/SystemClock.h"
+#include "utils/StreamDetails.h"
+#include "utils/StringUtils.h"
+#include "video/VideoDatabase.h"
+#include "video/VideoInfoTag.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/* The details of the items in a listing are loaded with a few queries for all
+ * of them by CVideoDatabase::GetDetailsForItems(), they have to be the same as
+ * the ones loaded for every item on its own.
+ */
+
+namespace
+{
+
+typedef std::map<std::string, std::string> ArtMap;
+
+class CTestVideoDatabase : public CTestDatabase<CVideoDatabase>
+{
+public:
+  CTestVideoDatabase() : CTestDatabase<CVideoDatabase>(g_advancedSettings.m_databaseVideo, "TestMyVideos") {}
+
+  using CVideoDatabase::GetDetailsForItems;
+};
+
+SActorInfo Actor(const std::string &name, const std::string &role, int order)
+{
+  SActorInfo actor;
+  actor.strName = name;
+  actor.strRole = role;
+  actor.order = order;
+  return actor;
+}
+
+CStreamDetails Streams(int width, int duration, int channels)
+{
+  CStreamDetails details;
+  CStreamDetailVideo *video = new CStreamDetailVideo();
+  video->m_strCodec = "h264";
+  video->m_iWidth = width;
+  video->m_iHeight = width * 9 / 16;
+  video->m_iDuration = duration;
+  details.AddStream(video);
+  CStreamDetailAudio *audio = new CStreamDetailAudio();
+  audio->m_strCodec = "ac3";
+  audio->m_iChannels = channels;
+  details.AddStream(audio);
+  return details;
+}
+
+CVideoInfoTag Movie(int i)
+{
+  CVideoInfoTag tag;
+  tag.m_strTitle = StringUtils::Format("Movie %i", i);
+  tag.m_cast.push_back(Actor(StringUtils::Format("Lead %i", i), "Hero", 0));
+  tag.m_cast.push_back(Actor("Supporting Actor", StringUtils::Format("Friend %i", i), 1));
+  if (i % 2)
+    tag.m_tags.push_back("odd");
+  tag.m_tags.push_back(StringUtils::Format("tag %i", i % 5));
+  tag.SetRating(5.0f + i % 5, 100 + i, "imdb", true);
+  tag.SetRating(6.0f, 10, "themoviedb");
+  tag.SetUniqueID(StringUtils::Format("tt%07i", i), "imdb", true);
+  tag.SetUniqueID(StringUtils::Format("%i", 1000 + i), "tmdb");
+  tag.m_streamDetails = Streams(1920, 5400 + i, 6);
+  return tag;
+}
+
+ArtMap MovieArt(int i)
+{
+  return ArtMap{ { "poster", StringUtils::Format("/art/movie%i-poster.jpg", i) },
+                 { "fanart", StringUtils::Format("/art/movie%i-fanart.jpg", i) } };
+}
+
+void ExpectSameDetails(const CFileItem &item, const CVideoInfoTag &single, const ArtMap &art)
+{
+  const CVideoInfoTag &batched = *item.GetVideoInfoTag();
+  std::string name = item.GetLabel();
+
+  ASSERT_EQ(single.m_cast.size(), batched.m_cast.size()) << name;
+  for (size_t i = 0; i < single.m_cast.size(); i++)
+  {
+    EXPECT_EQ(single.m_cast[i].strName, batched.m_cast[i].strName) << name;
+    EXPECT_EQ(single.m_cast[i].strRole, batched.m_cast[i].strRole) << name;
+    EXPECT_EQ(single.m_cast[i].order, batched.m_cast[i].order) << name;
+  }
+
+  EXPECT_EQ(single.m_tags, batched.m_tags) << name;
+
+  ASSERT_EQ(single.m_ratings.size(), batched.m_ratings.size()) << name;
+  for (const auto &rating : single.m_ratings)
+  {
+    auto other = batched.m_ratings.find(rating.first);
+    ASSERT_TRUE(other != batched.m_ratings.end()) << name << " " << rating.first;
+    EXPECT_FLOAT_EQ(rating.second.rating, other->second.rating) << name << " " << rating.first;
+    EXPECT_EQ(rating.second.votes, other->second.votes) << name << " " << rating.first;
+  }
+
+  EXPECT_EQ(single.GetUniqueIDs(), batched.GetUniqueIDs()) << name;
+  EXPECT_EQ(single.GetUniqueID(), batched.GetUniqueID()) << name;
+
+  EXPECT_TRUE(single.m_streamDetails == batched.m_streamDetails) << name;
+  EXPECT_EQ(single.m_duration, batched.m_duration) << name;
+
+  for (const auto &i : art)
+    EXPECT_EQ(i.second, item.GetArt(i.first)) << name << " " << i.first;
+}
+
+}
+
+class TestVideoDatabaseDetails : public testing::Test
+{
+protected:
+  virtual void SetUp() override
+  {
+    ASSERT_TRUE(m_db.Open());
+
+    for (int i = 1; i <= 3; i++)
+    {
+      CVideoInfoTag movie = Movie(i);
+      ASSERT_GE(m_db.SetDetailsForMovie(StringUtils::Format("/movies/movie%i.mkv", i), movie, MovieArt(i)), 0);
+    }
+
+    CVideoInfoTag show;
+    show.m_strTitle = "Show";
+    show.m_cast.push_back(Actor("Show Lead", "Captain", 0));
+    show.m_cast.push_back(Actor("Guest Star", "Pilot", 1));
+    std::vector<std::pair<std::string, std::string> > paths{ { "/tv/Show/", "/tv/" } };
+    std::map<int, ArtMap> seasonArt{ { 1, ArtMap{ { "poster", "/art/season1-poster.jpg" } } } };
+    int idShow = m_db.SetDetailsForTvShow(paths, show,
+                                          ArtMap{ { "poster", "/art/show-poster.jpg" }, { "fanart", "/art/show-fanart.jpg" } },
+                                          seasonArt);
+    ASSERT_GE(idShow, 0);
+
+    // a multi-episode file with two episodes and a file with one episode,
+    // the guest star is in the cast of the show and of an episode
+    struct
+    {
+      const char *file;
+      int episode;
+      bool streams;
+      bool thumb;
+    } episodes[] = {
+      { "/tv/Show/Show.S01E01E02.mkv", 1, true, true },
+      { "/tv/Show/Show.S01E01E02.mkv", 2, false, false },
+      { "/tv/Show/Show.S01E03.mkv", 3, true, true },
+    };
+    for (const auto &i : episodes)
+    {
+      CVideoInfoTag episode;
+      episode.m_strTitle = StringUtils::Format("Episode %i", i.episode);
+      episode.m_iSeason = 1;
+      episode.m_iEpisode = i.episode;
+      episode.m_cast.push_back(Actor("Guest Star", StringUtils::Format("Visitor %i", i.episode), 0));
+      episode.m_cast.push_back(Actor(StringUtils::Format("Extra %i", i.episode), "Crowd", 1));
+      episode.SetRating(7.0f + i.episode, 20, "tvdb", true);
+      episode.SetUniqueID(StringUtils::Format("%i", 500 + i.episode), "tvdb", true);
+      if (i.streams)
+        episode.m_streamDetails = Streams(1280, 1200 + i.episode, 2);
+      ArtMap art;
+      if (i.thumb)
+        art["thumb"] = StringUtils::Format("/art/episode%i-thumb.jpg", i.episode);
+      ASSERT_GE(m_db.SetDetailsForEpisode(i.file, episode, art, idShow), 0);
+    }
+  }
+
+  virtual void TearDown() override
+  {
+    m_db.Close();
+  }
+
+  void ExpectSameAsSingle(const CFileItemList &items)
+  {
+    for (int i = 0; i < items.Size(); i++)
+    {
+      const CVideoInfoTag &tag = *items[i]->GetVideoInfoTag();
+      CVideoInfoTag single;
+      ArtMap art;
+      if (tag.m_type == MediaTypeMovie)
+        ASSERT_TRUE(m_db.GetMovieInfo("", single, tag.m_iDbId, VideoDbDetailsAll));
+      else
+        ASSERT_TRUE(m_db.GetEpisodeInfo("", single, tag.m_iDbId, VideoDbDetailsAll));
+      m_db.GetArtForItem(tag.m_iDbId, tag.m_type, art);
+      ExpectSameDetails(*items[i], single, art);
+    }
+  }
+
+  CTestVideoDatabase m_db;
+};
+
+TEST_F(TestVideoDatabaseDetails, Movies)
+{
+  CFileItemList items;
+  ASSERT_TRUE(m_db.GetMoviesByWhere("videodb://movies/titles/", CDatabase::Filter(), items, SortDescription(), VideoDbDetailsAll));
+  ASSERT_EQ(3, items.Size());
+  ExpectSameAsSingle(items);
+}
+
+TEST_F(TestVideoDatabaseDetails, MultiEpisodeFile)
+{
+  CFileItemList items;
+  ASSERT_TRUE(m_db.GetEpisodesByWhere("videodb://tvshows/titles/", CDatabase::Filter(), items, true, SortDescription(), VideoDbDetailsAll));
+  ASSERT_EQ(3, items.Size());
+  ExpectSameAsSingle(items);
+
+  // both episodes of the multi-episode file have its streams
+  int withStreams = 0;
+  for (int i = 0; i < items.Size(); i++)
+  {
+    if (items[i]->GetVideoInfoTag()->m_streamDetails.GetVideoStreamCount() == 1)
+      withStreams++;
+  }
+  EXPECT_EQ(3, withStreams);
+}
+
+TEST_F(TestVideoDatabaseDetails, MixedList)
+{
+  CFileItemList movies, episodes;
+  ASSERT_TRUE(m_db.GetMoviesByWhere("videodb://movies/titles/", CDatabase::Filter(), movies));
+  ASSERT_TRUE(m_db.GetEpisodesByWhere("videodb://tvshows/titles/", CDatabase::Filter(), episodes));
+  ASSERT_EQ(3, movies.Size());
+  ASSERT_EQ(3, episodes.Size());
+
+  // movies and episodes with the same ids, one after the other
+  CFileItemList items;
+  for (int i = 0; i < 3; i++)
+  {
+    items.Add(movies[i]);
+    items.Add(episodes[i]);
+  }
+
+  m_db.GetDetailsForItems(items, 0, MediaTypeMovie, VideoDbDetailsAll);
+  m_db.GetDetailsForItems(items, 0, MediaTypeEpisode, VideoDbDetailsAll);
+  ExpectSameAsSingle(items);
+}
+
+/* Listing of many movies with all their details, once with the details of
+ * every movie loaded on its own by GetMovieInfo() and GetArtForItem(), which
+ * are the queries GetMoviesByWhere() ran per movie before GetDetailsForItems(),
+ * and once batched. The times are recorded as properties of the test, run it
+ * with --gtest_also_run_disabled_tests --gtest_filter=*GetMovies.
+ */
+TEST(TestVideoDatabaseBenchmark, DISABLED_GetMovies)
+{
+  const int movies = 2000;
+
+  CTestVideoDatabase db;
+  ASSERT_TRUE(db.Open());
+  ASSERT_TRUE(db.BeginBatch());
+  for (int i = 1; i <= movies; i++)
+  {
+    CVideoInfoTag movie = Movie(i);
+    ASSERT_GE(db.SetDetailsForMovie(StringUtils::Format("/movies/movie%i.mkv", i), movie, MovieArt(i)), 0);
+  }
+  ASSERT_TRUE(db.CommitBatch());
+
+  unsigned int start = XbmcThreads::SystemClockMillis();
+  CFileItemList single;
+  ASSERT_TRUE(db.GetMoviesByWhere("videodb://movies/titles/", CDatabase::Filter(), single));
+  for (int i = 0; i < single.Size(); i++)
+  {
+    CVideoInfoTag &tag = *single[i]->GetVideoInfoTag();
+    ArtMap art;
+    ASSERT_TRUE(db.GetMovieInfo("", tag, tag.m_iDbId, VideoDbDetailsAll));
+    db.GetArtForItem(tag.m_iDbId, MediaTypeMovie, art);
+    single[i]->SetArt(art);
+  }
+  unsigned int singleTime = XbmcThreads::SystemClockMillis() - start;
+
+  start = XbmcThreads::SystemClockMillis();
+  CFileItemList batched;
+  ASSERT_TRUE(db.GetMoviesByWhere("videodb://movies/titles/", CDatabase::Filter(), batched, SortDescription(), VideoDbDetailsAll));
+  unsigned int batchedTime = XbmcThreads::SystemClockMillis() - start;
+
+  ASSERT_EQ(movies, single.Size());
+  ASSERT_EQ(movies, batched.Size());
+  EXPECT_EQ(single[0]->GetVideoInfoTag()->m_cast.size(), batched[0]->GetVideoInfoTag()->m_cast.size());
+
+  testing::Test::RecordProperty("movies", movies);
+  testing::Test::RecordProperty("per_item_ms", singleTime);
+  testing::Test::RecordProperty("batched_ms", batchedTime);
+  db.Close();
+}